@@ -1,9 +1,18 @@
 from gurobipy import Model, GRB, quicksum
 import gurobipy as gp
 from data_formatting import read_file_to_arrays
+import os
 import sys
 
-file_names = ["matrixFile0.txt", "matrixFile1.txt", "matrixFile2.txt"]
+# size of spms, written by GraphAnalyzer::create_ilp_map. Older maps don't
+# have the file and use the default 3 spms of 32KB.
+spmSizeFile = "spmSizeFile.txt"
+if os.path.exists(spmSizeFile):
+    q = [int(size) for size in read_file_to_arrays(spmSizeFile)[0]]
+else:
+    q = [32768, 32768, 32768]
+
+file_names = ["matrixFile%d.txt" % k for k in range(len(q))]
 
 # tensors
 tensor_mappings = []
@@ -28,10 +37,6 @@ print(s)
 #for i in n:
 #    s.append(100)
 
-# size of spms
-# TODO: these values would be from a generated file
-q = [32768, 32768, 32768]
-
 
 K = len(tensor_mappings)
 M = len(tensor_mappings[0])
@@ -156,7 +161,7 @@ for k in range(K):
     x_optimal.append(spm)
     spm = []
 
-file_names = ["optimal0.txt", "optimal1.txt", "optimal2.txt"]
+file_names = ["optimal%d.txt" % k for k in range(K)]
 for k in range(K):
 	file = open(file_names[k], "w")
 	for m in range(M):
@@ -21,6 +21,7 @@
 #include "smaug/operators/my_custom_operator.h"
 #include "smaug/operators/smv/smv_batch_norm_op.h"
 #include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_depthwise_convolution_op.h"
 #include "smaug/operators/smv/smv_eltwise_add_op.h"
 #include "smaug/operators/smv/smv_eltwise_mul_op.h"
 #include "smaug/operators/smv/smv_elu_op.h"
@@ -85,6 +86,7 @@ DEF_CREATE_OP(PaddingOp, ReferenceBackend)
 DEF_CREATE_OP(MyCustomOperator, ReferenceBackend)
 
 DEF_CREATE_SMV_OP(ConvolutionOp)
+DEF_CREATE_SMV_OP(DepthwiseConvolutionOp)
 DEF_CREATE_SMV_OP(InnerProductOp)
 DEF_CREATE_SMV_OP(MaxPoolingOp)
 DEF_CREATE_SMV_OP(AvgPoolingOp)
@@ -103,7 +105,6 @@ DEF_CREATE_SMV_OP(LessEqualOp)
 DEF_CREATE_SMV_OP(GreaterOp)
 DEF_CREATE_SMV_OP(GreaterEqualOp)
 DEF_CREATE_OP(DataOp, SmvBackend)
-DEF_CREATE_OP(DepthwiseConvolutionOp, SmvBackend)
 DEF_CREATE_OP(ReorderOp, SmvBackend)
 DEF_CREATE_OP(ConcatOp, SmvBackend)
 DEF_CREATE_OP(SplitOp, SmvBackend)
@@ -136,6 +137,7 @@ const unsigned kMyCustomOperatorHw = 0x0006;
 
 namespace smv {
 int kSpadSize;
+int kNumSpads;
 // Use the same accelerator id for all hardware blocks. This means we will
 // simulate only ONE datapath instead of multiple, which means that the two
 // blocks can share the scratchpads (without any infrastructure
@@ -145,6 +147,7 @@ int kSpadSize;
 // different ids, we would have two different datapaths that could not share
 // data directly.
 const unsigned kConvolutionHw = 0x0003;
+const unsigned kDepthwiseConvolutionHw = 0x0003;
 const unsigned kInnerProductHw = 0x0003;
 const unsigned kEltwiseOpHw = 0x0003;
 const unsigned kBatchNormHw = 0x0003;
@@ -155,6 +158,7 @@ const unsigned kSystolicArrayHw = 0x0004;
 float* spad0;
 float* spad1;
 float* spad2;
+std::vector<float*> spads;
 }  // namespace smv
 
 }  // namespace smaug
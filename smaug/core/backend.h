@@ -1,7 +1,9 @@
 #ifndef _CORE_BACKEND_H_
 #define _CORE_BACKEND_H_
 
+#include <cassert>
 #include <string>
+#include <vector>
 
 #include "smaug/core/datatypes.h"
 #include "smaug/utility/utils.h"
@@ -152,8 +154,13 @@ class ReferenceBackend {
  * The smv namespace contains all code specific to the Smv backend.
  */
 namespace smv {
+/** The scratchpad geometry of the taped-out SMV accelerator. */
+const int kDefaultSpadSize = 32 * 1024;
+const int kDefaultNumSpads = 3;
 extern int kSpadSize;
+extern int kNumSpads;
 extern const unsigned kConvolutionHw;
+extern const unsigned kDepthwiseConvolutionHw;
 extern const unsigned kInnerProductHw;
 extern const unsigned kEltwiseOpHw;
 extern const unsigned kBatchNormHw;
@@ -164,10 +171,14 @@ extern const unsigned kSystolicArrayHw;
 extern float* spad0;
 extern float* spad1;
 extern float* spad2;
+// All kNumSpads scratchpads. The first three are spad0, spad1 and spad2, which
+// the kernels stream their tiles through.
+extern std::vector<float*> spads;
 }  // namespace smv
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 class SmvConvolutionOp;
+class SmvDepthwiseConvolutionOp;
 class SmvInnerProductOp;
 class SmvMaxPoolingOp;
 class SmvAvgPoolingOp;
@@ -213,24 +224,41 @@ class SmvBackend {
     static const DataLayout DefaultInputDataLayout = DataLayout::NHWC;
 
     static int SpadSize() { return smv::kSpadSize; }
-    static void initGlobals() {
-        // kSpadSize is in terms of float16 data.
-        smv::kSpadSize = 32 * 1024;
+    static int NumSpads() { return smv::kNumSpads; }
+    /**
+     * Allocates the scratchpads. The geometry defaults to that of the
+     * taped-out accelerator; any other one is used for tiling and analysis,
+     * but when simulating it has to match the gem5 configuration.
+     *
+     * @param spadSize The size of each scratchpad in bytes of float16 data.
+     * @param numSpads The number of scratchpads, at least the three the
+     * kernels use.
+     */
+    static void initGlobals(int spadSize = smv::kDefaultSpadSize,
+                            int numSpads = smv::kDefaultNumSpads) {
+        assert(spadSize > 0 && "The scratchpad size must be positive!");
+        assert(numSpads >= 3 && "The SMV kernels need three scratchpads!");
+        smv::kSpadSize = spadSize;
+        smv::kNumSpads = numSpads;
         // In SMV, all tensors store float16 data, but due to the modelling
         // restriction of Aladdin, we actually store float32 data in the
         // scratchpads. This why the allocated memory size here is double
         // kSpadSize.
-        smv::spad0 = (float*)malloc_aligned(smv::kSpadSize * 2);
-        smv::spad1 = (float*)malloc_aligned(smv::kSpadSize * 2);
-        smv::spad2 = (float*)malloc_aligned(smv::kSpadSize * 2);
+        smv::spads.resize(numSpads);
+        for (auto& spad : smv::spads)
+            spad = (float*)malloc_aligned(smv::kSpadSize * 2);
+        smv::spad0 = smv::spads[0];
+        smv::spad1 = smv::spads[1];
+        smv::spad2 = smv::spads[2];
     }
     static void freeGlobals() {
-        free(smv::spad0);
-        free(smv::spad1);
-        free(smv::spad2);
+        for (auto spad : smv::spads)
+            free(spad);
+        smv::spads.clear();
     }
 
     DECL_CREATE_SMV_OP(ConvolutionOp);
+    DECL_CREATE_SMV_OP(DepthwiseConvolutionOp);
     DECL_CREATE_SMV_OP(InnerProductOp);
     DECL_CREATE_SMV_OP(MaxPoolingOp);
     DECL_CREATE_SMV_OP(AvgPoolingOp);
@@ -249,7 +277,6 @@ class SmvBackend {
     DECL_CREATE_SMV_OP(GreaterOp);
     DECL_CREATE_SMV_OP(GreaterEqualOp);
     DECL_CREATE_OP(DataOp);
-    DECL_CREATE_OP(DepthwiseConvolutionOp);
     DECL_CREATE_OP(ReorderOp);
     DECL_CREATE_OP(ConcatOp);
     DECL_CREATE_OP(SplitOp);
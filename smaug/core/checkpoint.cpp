@@ -0,0 +1,192 @@
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "smaug/core/checkpoint.h"
+
+namespace smaug {
+
+namespace {
+
+constexpr char kMagic[8] = { 'S', 'M', 'A', 'U', 'G', 'C', 'K', '2' };
+
+/** The longest name of a tensor or operator that a checkpoint may hold. */
+constexpr int32_t kMaxNameLength = 4096;
+
+/** Returns the raw storage of the tensor. */
+char* getRawData(Tensor* tensor) {
+    switch (tensor->getDataType()) {
+        case Float16:
+            return reinterpret_cast<char*>(tensor->data<float16>());
+        case Float32:
+            return reinterpret_cast<char*>(tensor->data<float>());
+        case Float64:
+            return reinterpret_cast<char*>(tensor->data<double>());
+        case Int32:
+            return reinterpret_cast<char*>(tensor->data<int>());
+        case Int64:
+            return reinterpret_cast<char*>(tensor->data<int64_t>());
+        case Bool:
+            return reinterpret_cast<char*>(tensor->data<bool>());
+        default:
+            assert(false && "Unknown data type!");
+            return nullptr;
+    }
+}
+
+template <typename T>
+void writeValue(std::ostream& os, T value) {
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readValue(std::istream& is) {
+    T value = T();
+    is.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return value;
+}
+
+/**
+ * Reads a name written by writeName(). Returns false if its length is out of
+ * range, which only happens if the file is corrupt.
+ */
+bool readName(std::istream& is, std::string* name) {
+    int32_t length = readValue<int32_t>(is);
+    if (!is || length < 0 || length > kMaxNameLength)
+        return false;
+    name->assign(length, '\0');
+    is.read(&(*name)[0], length);
+    return bool(is);
+}
+
+void writeName(std::ostream& os, const std::string& name) {
+    writeValue<int32_t>(os, name.size());
+    os.write(name.data(), name.size());
+}
+
+}  // namespace
+
+std::string getCheckpointPath(const std::string& prefix, int boundary) {
+    return prefix + "_" + std::to_string(boundary) + ".ckpt";
+}
+
+bool saveCheckpoint(const std::string& path,
+                    int boundary,
+                    const std::vector<std::string>& opNames,
+                    const std::vector<Tensor*>& tensors) {
+    std::ofstream file(
+            path, std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open the checkpoint file: " << path << "\n";
+        return false;
+    }
+    file.write(kMagic, sizeof(kMagic));
+    writeValue<int32_t>(file, boundary);
+    writeValue<int32_t>(file, opNames.size());
+    for (const std::string& opName : opNames)
+        writeName(file, opName);
+    writeValue<int32_t>(file, tensors.size());
+    for (Tensor* tensor : tensors) {
+        writeName(file, tensor->getName());
+        writeValue<int32_t>(file, tensor->getDataType());
+        writeValue<uint8_t>(file, tensor->isDead());
+        // A dead tensor may have no data at all.
+        uint64_t bytes = 0;
+        if (tensor->containsData()) {
+            bytes = (uint64_t)tensor->getShape().storageSize() *
+                    tensor->getDataTypeSize();
+        }
+        writeValue<uint64_t>(file, bytes);
+        if (bytes > 0)
+            file.write(getRawData(tensor), bytes);
+    }
+    if (!file) {
+        std::cerr << "Failed to write the checkpoint file: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+int loadCheckpoint(const std::string& path,
+                   Workspace* workspace,
+                   std::vector<std::string>* opNames) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open the checkpoint file: " << path << "\n";
+        return -1;
+    }
+    char magic[sizeof(kMagic)];
+    file.read(magic, sizeof(magic));
+    if (!file || memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        std::cerr << "Not a checkpoint file: " << path << "\n";
+        return -1;
+    }
+    int boundary = readValue<int32_t>(file);
+    int numOps = readValue<int32_t>(file);
+    if (!file || boundary < 0 || numOps != boundary) {
+        std::cerr << "The checkpoint file is corrupt: " << path << "\n";
+        return -1;
+    }
+    std::vector<std::string> names;
+    for (int i = 0; i < numOps; i++) {
+        std::string name;
+        if (!readName(file, &name)) {
+            std::cerr << "The checkpoint file is corrupt: " << path << "\n";
+            return -1;
+        }
+        names.push_back(std::move(name));
+    }
+    int numTensors = readValue<int32_t>(file);
+    if (numTensors < 0) {
+        std::cerr << "The checkpoint file is corrupt: " << path << "\n";
+        return -1;
+    }
+    for (int i = 0; i < numTensors && file; i++) {
+        std::string name;
+        if (!readName(file, &name)) {
+            std::cerr << "The checkpoint file is corrupt: " << path << "\n";
+            return -1;
+        }
+        int32_t rawDataType = readValue<int32_t>(file);
+        if (!DataType_IsValid(rawDataType)) {
+            std::cerr << "The checkpoint file is corrupt: " << path << "\n";
+            return -1;
+        }
+        auto dataType = static_cast<DataType>(rawDataType);
+        bool dead = readValue<uint8_t>(file);
+        uint64_t bytes = readValue<uint64_t>(file);
+        Tensor* tensor = workspace->getTensor(name);
+        if (!tensor) {
+            std::cerr << "The checkpoint has an unknown tensor: " << name
+                      << "\n";
+            return -1;
+        }
+        tensor->setDead(dead);
+        if (bytes == 0)
+            continue;
+        if (tensor->containsData() && tensor->getDataType() != dataType) {
+            std::cerr << "The checkpoint doesn't match the data type of "
+                      << "tensor " << name << "!\n";
+            return -1;
+        }
+        tensor->allocateStorage(dataType);
+        if (bytes != (uint64_t)tensor->getShape().storageSize() *
+                             tensor->getDataTypeSize()) {
+            std::cerr << "The checkpoint doesn't match the shape of tensor "
+                      << name << "!\n";
+            return -1;
+        }
+        file.read(getRawData(tensor), bytes);
+        tensor->bumpDataVersion();
+    }
+    if (!file) {
+        std::cerr << "The checkpoint file is truncated: " << path << "\n";
+        return -1;
+    }
+    if (opNames)
+        *opNames = std::move(names);
+    return boundary;
+}
+
+}  // namespace smaug
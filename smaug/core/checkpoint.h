@@ -0,0 +1,51 @@
+#ifndef _CORE_CHECKPOINT_H_
+#define _CORE_CHECKPOINT_H_
+
+#include <string>
+#include <vector>
+
+#include "smaug/core/tensor.h"
+#include "smaug/core/workspace.h"
+
+namespace smaug {
+
+/**
+ * A checkpoint holds the live tensors of a network at an operator boundary,
+ * so that a later run can start from that boundary instead of from the first
+ * operator.
+ *
+ * The boundary K is the point after the first K operators (not counting the
+ * Data operators) in schedule order have run. The file is a compact binary
+ * dump: a header with the boundary and the names of those K operators,
+ * followed by the number of tensors and the name, data type, dead flag and
+ * raw storage of every tensor. The operator names let a resumed run check that
+ * it skips the same operators that ran before the checkpoint. The parameters
+ * are not part of it, as they are loaded from the model files as usual.
+ */
+
+/** Returns the path of the checkpoint at the given boundary. */
+std::string getCheckpointPath(const std::string& prefix, int boundary);
+
+/**
+ * Writes the given tensors into a checkpoint at the given boundary, after
+ * the names of the operators that ran before it in schedule order. Returns
+ * false if the file could not be written.
+ */
+bool saveCheckpoint(const std::string& path,
+                    int boundary,
+                    const std::vector<std::string>& opNames,
+                    const std::vector<Tensor*>& tensors);
+
+/**
+ * Restores the tensors of a checkpoint into the tensors of the same names in
+ * the Workspace. Returns the boundary of the checkpoint, or -1 if the file
+ * could not be read or doesn't match the tensors. If opNames is given, it is
+ * set to the names of the operators that ran before the boundary.
+ */
+int loadCheckpoint(const std::string& path,
+                   Workspace* workspace,
+                   std::vector<std::string>* opNames = nullptr);
+
+}  // namespace smaug
+
+#endif
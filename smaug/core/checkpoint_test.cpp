@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/checkpoint.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class CheckpointTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    ~CheckpointTest() {
+        for (int boundary = 0; boundary <= 3; boundary++)
+            std::remove(getCheckpointPath(kPrefix, boundary).c_str());
+    }
+
+    static constexpr const char* kPrefix = "checkpoint_test";
+
+    // Builds a chain of three FC layers, fc0 to fc2.
+    void buildLayers() {
+        TensorShape inputShape({ 1, 256 }, NC, SmvBackend::Alignment);
+        Tensor* input = new Tensor("input", inputShape);
+        input->allocateStorage<float16>();
+        fillTensorWithRandomData(input);
+        workspace()->addTensor(input);
+        Tensor* layerInput = input;
+        Operator* prev = nullptr;
+        for (int i = 0; i < 3; i++) {
+            std::string name = "fc" + std::to_string(i);
+            TensorShape shape({ 32, layerInput->getShape()[1] }, NC,
+                              SmvBackend::Alignment);
+            Tensor* weights = new Tensor(name + "/weights", shape);
+            weights->allocateStorage<float16>();
+            fillTensorWithRandomData(weights);
+            workspace()->addTensor(weights);
+            auto fcOp = new SmvInnerProductOp(name, workspace());
+            fcOp->setInput(layerInput, 0);
+            fcOp->setInput(weights, 1);
+            fcOp->setNumOutputs(32);
+            fcOp->createAllTensors();
+            fcOp->getOutput(0)->allocateStorage<float16>();
+            network()->addOperator(fcOp);
+            if (prev)
+                network()->addEdge(prev, fcOp, { 0, 0 });
+            layerInput = fcOp->getOutput(0);
+            prev = fcOp;
+        }
+    }
+
+    Tensor* getOutput(int layer) {
+        return workspace()->getTensor("fc" + std::to_string(layer));
+    }
+
+    void clearOutputs() {
+        for (int i = 0; i < 3; i++) {
+            Tensor* output = getOutput(i);
+            float16* data = output->data<float16>();
+            std::fill(data, data + output->getShape().storageSize(), 0);
+        }
+    }
+
+    bool isCleared(Tensor* tensor) {
+        const float16* data = tensor->data<float16>();
+        return std::all_of(data, data + tensor->getShape().storageSize(),
+                           [](float16 value) { return value == 0; });
+    }
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(CheckpointTest,
+                 "Checkpoints at operator boundaries",
+                 "[ckpt]") {
+    buildLayers();
+    Scheduler scheduler(network(), workspace());
+    scheduler.setCheckpoints({ 1, 2, 3 }, kPrefix);
+    scheduler.runNetwork();
+    Tensor expected("expected", getOutput(2)->getShape());
+    expected.allocateStorage<float16>();
+    copyRawTensorData(&expected, getOutput(2), 0, 0,
+                      expected.getShape().storageSize());
+    Tensor fc1Output("fc1_output", getOutput(1)->getShape());
+    fc1Output.allocateStorage<float16>();
+    copyRawTensorData(&fc1Output, getOutput(1), 0, 0,
+                      fc1Output.getShape().storageSize());
+    clearOutputs();
+
+    SECTION("Checkpoints only hold the live tensors") {
+        REQUIRE(loadCheckpoint(getCheckpointPath(kPrefix, 2), workspace()) ==
+                2);
+        verifyOutputs<float16>(getOutput(1), &fc1Output);
+        REQUIRE(isCleared(getOutput(0)));
+        REQUIRE(isCleared(getOutput(2)));
+        // The network output is live at the end.
+        REQUIRE(loadCheckpoint(getCheckpointPath(kPrefix, 3), workspace()) ==
+                3);
+        verifyOutputs<float16>(getOutput(2), &expected);
+        REQUIRE(isCleared(getOutput(0)));
+    }
+
+    SECTION("The network is resumed from a checkpoint") {
+        scheduler.setCheckpoints({}, "");
+        int boundary = loadCheckpoint(getCheckpointPath(kPrefix, 1),
+                                      workspace());
+        REQUIRE(boundary == 1);
+        scheduler.setOperatorRange(boundary, -1);
+        Tensor* output = scheduler.runNetwork();
+        REQUIRE(output == getOutput(2));
+        verifyOutputs<float16>(output, &expected);
+    }
+
+    SECTION("The skipped operators are checked on resume") {
+        scheduler.setCheckpoints({}, "");
+        std::vector<std::string> opNames;
+        int boundary = loadCheckpoint(getCheckpointPath(kPrefix, 2),
+                                      workspace(), &opNames);
+        REQUIRE(boundary == 2);
+        REQUIRE(opNames == std::vector<std::string>{ "fc0", "fc1" });
+        scheduler.setOperatorRange(boundary, -1, opNames);
+        Tensor* output = scheduler.runNetwork();
+        REQUIRE(output == getOutput(2));
+        verifyOutputs<float16>(output, &expected);
+
+        // A checkpoint of a different schedule is rejected before any
+        // operator runs.
+        clearOutputs();
+        scheduler.setOperatorRange(boundary, -1, { "fc1", "fc0" });
+        REQUIRE(scheduler.runNetwork() == nullptr);
+        REQUIRE(isCleared(getOutput(2)));
+    }
+
+    SECTION("A corrupt name length is rejected") {
+        // The name of the first operator follows the magic, the boundary and
+        // the operator count, and the name of the first tensor follows the
+        // operator name "fc0" and the tensor count.
+        std::string path = getCheckpointPath(kPrefix, 1);
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)),
+                          std::istreambuf_iterator<char>());
+        in.close();
+        int offset = GENERATE(16, 27);
+        int32_t length = GENERATE(-1, 0x7fffffff);
+        memcpy(&bytes[offset], &length, sizeof(length));
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), bytes.size());
+        out.close();
+        REQUIRE(loadCheckpoint(path, workspace()) == -1);
+    }
+
+    SECTION("The network is stopped at a boundary") {
+        scheduler.setCheckpoints({}, "");
+        scheduler.setOperatorRange(0, 2);
+        Tensor* output = scheduler.runNetwork();
+        REQUIRE(output == getOutput(1));
+        verifyOutputs<float16>(output, &fc1Output);
+        REQUIRE(isCleared(getOutput(2)));
+    }
+}
@@ -0,0 +1,296 @@
+#include <algorithm>
+#include <cstring>
+
+#include "smaug/core/csr_data.h"
+
+namespace smaug {
+
+namespace {
+
+int getDataTypeSize(DataType dataType) {
+    switch (dataType) {
+        case Float16:
+            return sizeof(float16);
+        case Float32:
+            return sizeof(float);
+        case Float64:
+            return sizeof(double);
+        case Int32:
+            return sizeof(int);
+        case Int64:
+            return sizeof(int64_t);
+        case Bool:
+            return sizeof(bool);
+        default:
+            assert(false && "Unknown data type!");
+            return 0;
+    }
+}
+
+template <typename T>
+void copyValues(void* dest,
+                const google::protobuf::RepeatedField<T>& values,
+                int numNonzeros) {
+    assert(values.size() >= numNonzeros &&
+           "The CSR data has fewer values than nonzeros!");
+    std::copy(values.begin(), values.begin() + numNonzeros,
+              reinterpret_cast<T*>(dest));
+}
+
+template <typename T>
+void copyValues(google::protobuf::RepeatedField<T>* values,
+                const void* src,
+                int numNonzeros) {
+    const T* srcPtr = reinterpret_cast<const T*>(src);
+    values->Add(srcPtr, srcPtr + numNonzeros);
+}
+
+}  // namespace
+
+CsrData::CsrData(const TensorShape& _shape, DataType _dataType)
+        : shape(_shape), dataType(_dataType),
+          dataTypeSize(getDataTypeSize(_dataType)) {
+    numCols = shape.getStorageDim(shape.ndims() - 1);
+    numRows = shape.storageSize() / numCols;
+}
+
+CsrData::CsrData(const TensorShape& _shape,
+                 DataType _dataType,
+                 const TensorData& tensorData)
+        : CsrData(_shape, _dataType) {
+    colIdx.assign(tensorData.csr_col_idx().begin(),
+                  tensorData.csr_col_idx().end());
+    rowPtr.assign(tensorData.csr_row_ptr().begin(),
+                  tensorData.csr_row_ptr().end());
+    assert(rowPtr.size() == numRows + 1 &&
+           "The CSR data has the wrong number of rows!");
+    assert(rowPtr.back() == colIdx.size() &&
+           "The CSR row pointers don't match the column indices!");
+    int numNonzeros = colIdx.size();
+    allocateValues(numNonzeros);
+    switch (dataType) {
+        case Float16:
+            // Two float16 values are packed into each int32.
+            assert(tensorData.half_data_size() * 2 >= numNonzeros &&
+                   "The CSR data has fewer values than nonzeros!");
+            memcpy(values.get(), tensorData.half_data().data(),
+                   numNonzeros * sizeof(float16));
+            break;
+        case Float32:
+            copyValues(values.get(), tensorData.float_data(), numNonzeros);
+            break;
+        case Float64:
+            copyValues(values.get(), tensorData.double_data(), numNonzeros);
+            break;
+        case Int32:
+            copyValues(values.get(), tensorData.int_data(), numNonzeros);
+            break;
+        case Int64:
+            copyValues(values.get(), tensorData.int64_data(), numNonzeros);
+            break;
+        case Bool:
+            copyValues(values.get(), tensorData.bool_data(), numNonzeros);
+            break;
+        default:
+            assert(false && "Unknown data type!");
+    }
+}
+
+void CsrData::allocateValues(int numNonzeros) {
+    // Keep the allocation valid for a tensor that is all zeros.
+    values = std::shared_ptr<void>(
+            malloc_aligned(std::max(numNonzeros, 1) * dataTypeSize, false),
+            free);
+}
+
+std::shared_ptr<CsrData> CsrData::compress(Tensor* tensor) {
+    std::shared_ptr<CsrData> csrData(
+            new CsrData(tensor->getShape(), tensor->getDataType()));
+    switch (tensor->getDataType()) {
+        case Float16:
+            csrData->compress(tensor->data<float16>());
+            break;
+        case Float32:
+            csrData->compress(tensor->data<float>());
+            break;
+        case Float64:
+            csrData->compress(tensor->data<double>());
+            break;
+        case Int32:
+            csrData->compress(tensor->data<int>());
+            break;
+        case Int64:
+            csrData->compress(tensor->data<int64_t>());
+            break;
+        case Bool:
+            csrData->compress(tensor->data<bool>());
+            break;
+        default:
+            assert(false && "Unknown data type!");
+    }
+    return csrData;
+}
+
+template <typename T>
+void CsrData::compress(const T* dense) {
+    rowPtr.assign(1, 0);
+    for (int row = 0; row < numRows; row++) {
+        for (int col = 0; col < numCols; col++) {
+            if (dense[row * numCols + col] != T(0))
+                colIdx.push_back(col);
+        }
+        rowPtr.push_back(colIdx.size());
+    }
+    allocateValues(colIdx.size());
+    T* valuesPtr = reinterpret_cast<T*>(values.get());
+    for (int row = 0; row < numRows; row++) {
+        for (int i = rowPtr[row]; i < rowPtr[row + 1]; i++)
+            valuesPtr[i] = dense[row * numCols + colIdx[i]];
+    }
+}
+
+void CsrData::toTensorData(TensorData* tensorData) const {
+    int numNonzeros = colIdx.size();
+    switch (dataType) {
+        case Float16:
+            // Add 1 to cover the case when the number of values is odd.
+            tensorData->mutable_half_data()->Resize((numNonzeros + 1) / 2, 0);
+            memcpy(tensorData->mutable_half_data()->mutable_data(),
+                   values.get(), numNonzeros * sizeof(float16));
+            break;
+        case Float32:
+            copyValues(tensorData->mutable_float_data(), values.get(),
+                       numNonzeros);
+            break;
+        case Float64:
+            copyValues(tensorData->mutable_double_data(), values.get(),
+                       numNonzeros);
+            break;
+        case Int32:
+            copyValues(tensorData->mutable_int_data(), values.get(),
+                       numNonzeros);
+            break;
+        case Int64:
+            copyValues(tensorData->mutable_int64_data(), values.get(),
+                       numNonzeros);
+            break;
+        case Bool:
+            copyValues(tensorData->mutable_bool_data(), values.get(),
+                       numNonzeros);
+            break;
+        default:
+            assert(false && "Unknown data type!");
+    }
+    *tensorData->mutable_csr_col_idx() = { colIdx.begin(), colIdx.end() };
+    *tensorData->mutable_csr_row_ptr() = { rowPtr.begin(), rowPtr.end() };
+}
+
+void CsrData::decompressRegion(Tensor* dest,
+                               const std::vector<int>& srcOrigin,
+                               const std::vector<int>& regionSize) const {
+    switch (dataType) {
+        case Float16:
+            decompressRegion<float16>(dest, srcOrigin, regionSize);
+            break;
+        case Float32:
+            decompressRegion<float>(dest, srcOrigin, regionSize);
+            break;
+        case Float64:
+            decompressRegion<double>(dest, srcOrigin, regionSize);
+            break;
+        case Int32:
+            decompressRegion<int>(dest, srcOrigin, regionSize);
+            break;
+        case Int64:
+            decompressRegion<int64_t>(dest, srcOrigin, regionSize);
+            break;
+        case Bool:
+            decompressRegion<bool>(dest, srcOrigin, regionSize);
+            break;
+        default:
+            assert(false && "Unknown data type!");
+    }
+}
+
+template <typename T>
+void CsrData::decompressRegion(Tensor* dest,
+                               const std::vector<int>& srcOrigin,
+                               const std::vector<int>& regionSize) const {
+    const TensorShape& destShape = dest->getShape();
+    T* destPtr = dest->data<T>();
+    std::fill(destPtr, destPtr + destShape.storageSize(), T(0));
+    int ndims = shape.ndims();
+    int destCols = destShape.getStorageDim(ndims - 1);
+    int colBegin = srcOrigin[ndims - 1];
+    int colEnd = colBegin + regionSize[ndims - 1];
+    const T* valuesPtr = reinterpret_cast<const T*>(values.get());
+    // Walk the rows of the region, whose coordinates in the outer dimensions
+    // are in regionIndex.
+    std::vector<int> regionIndex(ndims - 1, 0);
+    int numRegionRows = product(std::vector<int>(
+            regionSize.begin(), regionSize.begin() + ndims - 1));
+    for (int destRow = 0; destRow < numRegionRows; destRow++) {
+        int srcRow = 0;
+        for (int i = 0; i < ndims - 1; i++)
+            srcRow = srcRow * shape[i] + srcOrigin[i] + regionIndex[i];
+        auto rowBegin = colIdx.begin() + rowPtr[srcRow];
+        auto rowEnd = colIdx.begin() + rowPtr[srcRow + 1];
+        for (auto it = std::lower_bound(rowBegin, rowEnd, colBegin);
+             it != rowEnd && *it < colEnd;
+             ++it) {
+            destPtr[destRow * destCols + *it - colBegin] =
+                    valuesPtr[it - colIdx.begin()];
+        }
+        for (int i = ndims - 2; i >= 0 && ++regionIndex[i] == regionSize[i];
+             i--) {
+            regionIndex[i] = 0;
+        }
+    }
+}
+
+void CsrData::decompressRange(Tensor* dest, int srcOffset, int size) const {
+    switch (dataType) {
+        case Float16:
+            decompressRange(dest->data<float16>(), srcOffset, size);
+            break;
+        case Float32:
+            decompressRange(dest->data<float>(), srcOffset, size);
+            break;
+        case Float64:
+            decompressRange(dest->data<double>(), srcOffset, size);
+            break;
+        case Int32:
+            decompressRange(dest->data<int>(), srcOffset, size);
+            break;
+        case Int64:
+            decompressRange(dest->data<int64_t>(), srcOffset, size);
+            break;
+        case Bool:
+            decompressRange(dest->data<bool>(), srcOffset, size);
+            break;
+        default:
+            assert(false && "Unknown data type!");
+    }
+}
+
+template <typename T>
+void CsrData::decompressRange(T* dest, int srcOffset, int size) const {
+    std::fill(dest, dest + size, T(0));
+    const T* valuesPtr = reinterpret_cast<const T*>(values.get());
+    int srcEnd = srcOffset + size;
+    for (int row = srcOffset / numCols; row < numRows && row * numCols < srcEnd;
+         row++) {
+        for (int i = rowPtr[row]; i < rowPtr[row + 1]; i++) {
+            int index = row * numCols + colIdx[i];
+            if (index >= srcOffset && index < srcEnd)
+                dest[index - srcOffset] = valuesPtr[i];
+        }
+    }
+}
+
+uint64_t CsrData::getStorageBytes() const {
+    return (uint64_t)colIdx.size() * (dataTypeSize + sizeof(int)) +
+           rowPtr.size() * sizeof(int);
+}
+
+}  // namespace smaug
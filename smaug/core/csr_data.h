@@ -0,0 +1,100 @@
+#ifndef _CORE_CSR_DATA_H_
+#define _CORE_CSR_DATA_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "smaug/core/tensor.h"
+#include "smaug/core/tensor.pb.h"
+#include "smaug/core/types.pb.h"
+
+namespace smaug {
+
+/**
+ * CsrData holds the data of a Tensor stored in the CSR format, so that pruned
+ * network parameters only take memory for their nonzero elements.
+ *
+ * The Tensor's storage (including the alignment padding) is viewed as a matrix
+ * whose rows are the innermost dimension. For every row, the nonzero values
+ * and their column indices are stored in order, and rowPtr[i] is the index of
+ * the first nonzero of row i. The data is decompressed per tile, into the
+ * dense Tensors that the backends operate on, and the Scheduler frees those
+ * again after the operator has run.
+ *
+ * When serialized into a TensorData, the nonzero values are stored in the
+ * field of the data type, and the indices in csr_col_idx and csr_row_ptr.
+ */
+class CsrData {
+   public:
+    /**
+     * Parses the data of a Tensor with the given shape and data type from a
+     * serialized TensorData.
+     */
+    CsrData(const TensorShape& _shape,
+            DataType _dataType,
+            const TensorData& tensorData);
+
+    /** Compresses the dense data of the given Tensor. */
+    static std::shared_ptr<CsrData> compress(Tensor* tensor);
+
+    /** Serializes the compressed data into the TensorData. */
+    void toTensorData(TensorData* tensorData) const;
+
+    /**
+     * Decompresses a region of the Tensor into the dense Tensor dest, starting
+     * from the origin of dest. All the other elements of dest are zeroed.
+     *
+     * @param dest The dense destination Tensor.
+     * @param srcOrigin The origin of the region in the compressed Tensor.
+     * @param regionSize The size of the region.
+     */
+    void decompressRegion(Tensor* dest,
+                          const std::vector<int>& srcOrigin,
+                          const std::vector<int>& regionSize) const;
+
+    /**
+     * Decompresses a contiguous range of the Tensor's storage to the start of
+     * the storage of the dense Tensor dest.
+     *
+     * @param dest The dense destination Tensor.
+     * @param srcOffset The offset of the range in the storage.
+     * @param size The number of elements in the range.
+     */
+    void decompressRange(Tensor* dest, int srcOffset, int size) const;
+
+    int getNumNonzeros() const { return colIdx.size(); }
+
+    /** Returns the bytes taken by the values and the indices. */
+    uint64_t getStorageBytes() const;
+
+   protected:
+    CsrData(const TensorShape& _shape, DataType _dataType);
+
+    template <typename T>
+    void compress(const T* dense);
+
+    template <typename T>
+    void decompressRegion(Tensor* dest,
+                          const std::vector<int>& srcOrigin,
+                          const std::vector<int>& regionSize) const;
+
+    template <typename T>
+    void decompressRange(T* dest, int srcOffset, int size) const;
+
+    /** Allocates storage for the given number of nonzero values. */
+    void allocateValues(int numNonzeros);
+
+    TensorShape shape;
+    DataType dataType;
+    int dataTypeSize;
+    int numRows;
+    int numCols;
+    std::shared_ptr<void> values;
+    std::vector<int> colIdx;
+    std::vector<int> rowPtr;
+};
+
+}  // namespace smaug
+
+#endif
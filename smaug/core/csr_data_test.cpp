@@ -0,0 +1,186 @@
+#include <algorithm>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/csr_data.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/core/tensor_utils.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class CsrDataTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    // Creates float16 weights with random data, where at most every fourth
+    // element is nonzero and the first row is all zeros.
+    Tensor* createPrunedWeights(const std::string& name,
+                                const TensorShape& shape) {
+        Tensor* weights = new Tensor(name, shape);
+        weights->allocateStorage<float16>();
+        fillTensorWithRandomData(weights);
+        float16* data = weights->data<float16>();
+        int rowSize = shape.getStorageDim(1);
+        for (int i = 0; i < shape.storageSize(); i++) {
+            if (i % 4 != 0 || i < rowSize || i % rowSize >= shape[1])
+                data[i] = 0;
+        }
+        workspace()->addTensor(weights);
+        return weights;
+    }
+
+    // Creates a CSR Tensor from the serialized compressed data of the dense
+    // Tensor.
+    Tensor* createCsrTensor(Tensor* dense) {
+        TensorProto* tensorProto = dense->asTensorProto();
+        tensorProto->set_name(dense->getName() + "/csr");
+        tensorProto->set_data_format(CSR);
+        TensorData tensorData;
+        CsrData::compress(dense)->toTensorData(&tensorData);
+        Tensor* tensor = new Tensor(*tensorProto, tensorData);
+        delete tensorProto;
+        workspace()->addTensor(tensor);
+        return tensor;
+    }
+
+    int countNonzeros(Tensor* tensor) {
+        const float16* data = tensor->data<float16>();
+        return std::count_if(data, data + tensor->getShape().storageSize(),
+                             [](float16 value) { return value != 0; });
+    }
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(CsrDataTest, "CSR tensor data", "[csr]") {
+    // The rows are padded from 36 to 40 elements.
+    TensorShape shape({ 16, 36 }, NC, SmvBackend::Alignment);
+    Tensor* dense = createPrunedWeights("weights", shape);
+    Tensor* sparse = createCsrTensor(dense);
+    const CsrData* csrData = sparse->getCsrData();
+    REQUIRE(csrData != nullptr);
+    REQUIRE(sparse->containsData());
+    REQUIRE(sparse->getDataType() == Float16);
+    int numNonzeros = countNonzeros(dense);
+    REQUIRE(numNonzeros <= 15 * 9);
+    REQUIRE(csrData->getNumNonzeros() == numNonzeros);
+    REQUIRE(csrData->getStorageBytes() <
+            shape.storageSize() * sizeof(float16));
+
+    SECTION("Tiles are decompressed from the compressed data") {
+        TensorShape tileShape({ 8, 16 }, NC, SmvBackend::Alignment);
+        auto fcOp = new SmvInnerProductOp("fc", workspace());
+        TiledTensor denseTiles = generateTiledTensor(dense, tileShape, fcOp);
+        TiledTensor sparseTiles = generateTiledTensor(sparse, tileShape, fcOp);
+        REQUIRE(sparseTiles.size() == 6);
+        for (int i = 0; i < sparseTiles.size(); i++) {
+            verifyOutputs<float16>(sparseTiles.getTileWithData(i),
+                                   denseTiles.getTileWithData(i));
+        }
+        delete fcOp;
+    }
+
+    SECTION("Raw tiles are decompressed from the compressed data") {
+        TensorShape tileShape({ 1, 96 }, NC, SmvBackend::Alignment);
+        auto fcOp = new SmvInnerProductOp("fc", workspace());
+        TiledTensor denseTiles =
+                generateTiledTensorPerBatchNC(dense, tileShape, fcOp);
+        TiledTensor sparseTiles =
+                generateTiledTensorPerBatchNC(sparse, tileShape, fcOp);
+        REQUIRE(sparseTiles.usesRawTensor());
+        for (int i = 0; i < sparseTiles.size(); i++) {
+            verifyOutputs<float16>(sparseTiles.getTileWithData(i),
+                                   denseTiles.getTileWithData(i));
+        }
+        delete fcOp;
+    }
+
+    SECTION("The whole tensor is decompressed when it is accessed") {
+        verifyOutputs<float16>(sparse, dense);
+    }
+
+    SECTION("The tensor is serialized compressed") {
+        TensorProto* tensorProto = sparse->asTensorProto();
+        REQUIRE(tensorProto->data_format() == CSR);
+        REQUIRE(tensorProto->data().csr_col_idx_size() == numNonzeros);
+        REQUIRE(tensorProto->data().csr_row_ptr_size() == 17);
+        Tensor copy(*tensorProto, tensorProto->data());
+        REQUIRE(copy.getCsrData() != nullptr);
+        verifyOutputs<float16>(&copy, dense);
+        delete tensorProto;
+    }
+}
+
+TEST_CASE_METHOD(CsrDataTest, "Inner product with CSR weights", "[csr]") {
+    // The weights need multiple tiles.
+    TensorShape inputShape({ 1, 256 }, NC, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", inputShape);
+    input->allocateStorage<float16>();
+    fillTensorWithRandomData(input);
+    workspace()->addTensor(input);
+    TensorShape weightsShape({ 128, 256 }, NC, SmvBackend::Alignment);
+    Tensor* dense = createPrunedWeights("weights", weightsShape);
+    Tensor* sparse = createCsrTensor(dense);
+
+    std::vector<Tensor*> outputs;
+    for (Tensor* weights : { dense, sparse }) {
+        auto fcOp = new SmvInnerProductOp(weights->getName(), workspace());
+        fcOp->setInput(input, 0);
+        fcOp->setInput(weights, 1);
+        fcOp->setNumOutputs(128);
+        fcOp->createAllTensors();
+        fcOp->getOutput(0)->allocateStorage<float16>();
+        fcOp->tile();
+        fcOp->run();
+        outputs.push_back(fcOp->getOutput(0));
+        network()->addOperator(fcOp);
+    }
+    verifyOutputs<float16>(outputs[1], outputs[0]);
+}
+
+TEST_CASE_METHOD(CsrDataTest,
+                 "Decompressed CSR weights are freed after the operator runs",
+                 "[csr]") {
+    int numNeurons = GENERATE(16, 128);
+    TensorShape inputShape({ 1, 256 }, NC, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", inputShape);
+    input->allocateStorage<float16>();
+    fillTensorWithRandomData(input);
+    workspace()->addTensor(input);
+    TensorShape weightsShape({ numNeurons, 256 }, NC, SmvBackend::Alignment);
+    Tensor* dense = createPrunedWeights("weights", weightsShape);
+    Tensor* sparse = createCsrTensor(dense);
+    auto fcOp = new SmvInnerProductOp("fc", workspace());
+    fcOp->setInput(input, 0);
+    fcOp->setInput(sparse, 1);
+    fcOp->setNumOutputs(numNeurons);
+    fcOp->createAllTensors();
+    fcOp->getOutput(0)->allocateStorage<float16>();
+    network()->addOperator(fcOp);
+
+    Scheduler scheduler(network(), workspace());
+    Tensor* output = scheduler.runNetwork();
+    // Neither the weights nor their tiles keep a dense copy.
+    TiledTensor* weightTiles = fcOp->getTiledTensors()[1];
+    REQUIRE(weightTiles->size() == (numNeurons == 16 ? 1 : 2));
+    REQUIRE(!sparse->isDecompressed());
+    for (int i = 0; i < weightTiles->size(); i++) {
+        Tensor* tile = (*weightTiles)[i];
+        REQUIRE((tile == sparse || !tile->containsData()));
+    }
+
+    // The weights are decompressed again for the next run.
+    Tensor* expected = new Tensor("expected", output->getShape());
+    expected->allocateStorage<float16>();
+    copyRawTensorData(expected, output, 0, 0, output->getShape().storageSize());
+    workspace()->addTensor(expected);
+    output = scheduler.runNetwork();
+    verifyOutputs<float16>(output, expected);
+    REQUIRE(!sparse->isDecompressed());
+}
@@ -6,4 +6,9 @@ bool fastForwardMode = true;
 int numAcceleratorsAvailable;
 ThreadPool* threadPool = nullptr;
 bool useSystolicArrayWhenAvailable;
+bool fuseOperatorsWhenPossible = false;
+bool doubleBufferSpadsWhenPossible = false;
+bool reportEstimatedCycles = false;
+uint64_t paramMemoryBudget = 0;
+AccelDispatchPolicy accelDispatchPolicy = RoundRobinDispatch;
 }  // namespace smaug
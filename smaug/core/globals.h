@@ -6,6 +6,8 @@
 #ifndef _CORE_GLOBALS_H_
 #define _CORE_GLOBALS_H_
 
+#include <cstdint>
+
 namespace smaug {
 
 class ThreadPool;
@@ -39,6 +41,58 @@ extern ThreadPool* threadPool;
  * support exists.
  */
 extern bool useSystolicArrayWhenAvailable;
+
+/**
+ * If true, back-to-back operators with compatible tilings hand their data over
+ * through the accelerator scratchpads instead of through host memory.
+ */
+extern bool fuseOperatorsWhenPossible;
+
+/**
+ * If true, the SMV convolution and inner product kernels split their
+ * scratchpads into two halves, so that they can prefetch the next tiles and
+ * drain the last results while they compute.
+ */
+extern bool doubleBufferSpadsWhenPossible;
+
+/**
+ * If true, the scheduler reports the accelerator cycles of the network that
+ * the backends estimate with their analytical models, e.g. to explore the
+ * design space without simulating it.
+ */
+extern bool reportEstimatedCycles;
+
+/**
+ * If nonzero, the network parameters are loaded from the model parameters file
+ * on demand instead of all at once (see ParamStore), and the least recently
+ * used ones are evicted once they take more than this many bytes.
+ */
+extern uint64_t paramMemoryBudget;
+
+/**
+ * How an operator that splits its work across multiple accelerators picks the
+ * accelerator for the next unit of work.
+ */
+enum AccelDispatchPolicy {
+    /**
+     * The accelerators take turns. This is the only policy that doesn't depend
+     * on runtime information, so the accelerator assignments always match
+     * between dynamic trace generation and simulation.
+     */
+    RoundRobinDispatch,
+    /** Any accelerator that is already idle, without blocking on a busy one. */
+    PollingDispatch,
+    /** The accelerator with the least estimated outstanding work. */
+    LeastWorkDispatch,
+    /**
+     * The accelerator that already holds the weight tile the work reads, and
+     * otherwise the one with the least estimated outstanding work.
+     */
+    WeightAffinityDispatch,
+};
+
+/** The accelerator dispatch policy used by all operators. */
+extern AccelDispatchPolicy accelDispatchPolicy;
 }  // namespace smaug
 
 #endif
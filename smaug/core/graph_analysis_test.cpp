@@ -1,8 +1,12 @@
+#include <set>
+
 #include "catch.hpp"
 #include "smaug/core/backend.h"
 #include "smaug/core/tensor.h"
 #include "smaug/core/graph_test.h"
 #include "smaug/core/smaug_test.h"
+#include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_relu_op.h"
 
 using namespace smaug;
 
@@ -29,6 +33,64 @@ TEST_CASE_METHOD(GraphTest, "Graph tests", "[graph]") {
         //analyzer.print_tensor_map();
     }
 
+    SECTION("Create Tile Pin Map") {
+        std::cout << "==========================================================" << std::endl;
+        std::cout << "===========Create Tile Pin Map============================" << std::endl;
+        std::cout << "==========================================================" << std::endl;
+        auto analyzer = buildAnalyzer(modelPath + "cnn/cnn_smv_topo.pbtxt",
+                                   modelPath + "cnn/cnn_smv_params.pb");
+        analyzer.dry_run_network();
+        analyzer.populate_tile_pin_map();
+        // Every pinned tile must have been assigned to a spm.
+        for (const auto& [op, tiles] : tilePinMap) {
+            for (auto tile : tiles)
+                REQUIRE(tileSPMap.count(tile) == 1);
+        }
+    }
+
+    SECTION("Estimate DMA traffic") {
+        std::cout << "==========================================================" << std::endl;
+        std::cout << "===========Estimate DMA traffic===========================" << std::endl;
+        std::cout << "==========================================================" << std::endl;
+        auto analyzer = buildAnalyzer(modelPath + "cnn/cnn_smv_topo.pbtxt",
+                                   modelPath + "cnn/cnn_smv_params.pb");
+        analyzer.dry_run_network();
+        analyzer.populate_tile_pin_map();
+        DmaReport baseline = analyzer.estimate_dma_traffic(
+                analyzer.get_baseline_spm_mapping(), "baseline");
+        DmaReport pinned = analyzer.estimate_dma_traffic(
+                analyzer.get_tile_pin_spm_mapping(), "tile_pin");
+        // Pinning can only remove transfers.
+        REQUIRE(pinned.total.load_bytes <= baseline.total.load_bytes);
+        REQUIRE(pinned.total.store_bytes <= baseline.total.store_bytes);
+        REQUIRE(pinned.total.get_cycles(analyzer.get_dma_model()) <=
+                baseline.total.get_cycles(analyzer.get_dma_model()));
+        uint64_t opLoadBytes = 0;
+        for (const auto& [name, traffic] : baseline.per_op)
+            opLoadBytes += traffic.load_bytes;
+        REQUIRE(opLoadBytes == baseline.total.load_bytes);
+    }
+
+    SECTION("Optimize schedule order") {
+        std::cout << "==========================================================" << std::endl;
+        std::cout << "===========Optimize schedule order========================" << std::endl;
+        std::cout << "==========================================================" << std::endl;
+        auto analyzer = buildAnalyzer(modelPath + "cnn/cnn_smv_topo.pbtxt",
+                                   modelPath + "cnn/cnn_smv_params.pb");
+        std::vector<Operator*> fifo = analyzer.get_default_schedule();
+        std::vector<Operator*> order = analyzer.optimize_schedule(4);
+        REQUIRE(order.size() == fifo.size());
+        // estimate_schedule_traffic checks the order is topological.
+        DmaTraffic optimized = analyzer.estimate_schedule_traffic(order);
+        DmaTraffic fifoTraffic = analyzer.estimate_schedule_traffic(fifo);
+        REQUIRE(optimized.load_bytes + optimized.store_bytes <=
+                fifoTraffic.load_bytes + fifoTraffic.store_bytes);
+        // The dry run must follow the chosen order.
+        analyzer.setScheduleOrder(order);
+        analyzer.dry_run_network();
+        REQUIRE(analyzer.get_schedule() == order);
+    }
+
     /*
     SECTION("Create tensor Pin Map") {
         std::cout << "==========================================================" << std::endl;
@@ -202,3 +264,87 @@ TEST_CASE_METHOD(GraphTest, "Graph tests", "[graph]") {
                 convertFp16ToFp32Tensor(output, workspace()), refOutput);
     }
 }
+
+TEST_CASE_METHOD(GraphTest, "Tile schedule", "[graph]") {
+    // The inputs need two rowwise tiles and the weights two N-wise tiles.
+    TensorShape inputShape(
+            { 1, 36, 16, 32 }, DataLayout::NHWC, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", inputShape);
+    workspace()->addTensor(input);
+    auto convOp = new SmvConvolutionOp("conv", workspace());
+    convOp->setStride(1, 1);
+    convOp->setPadding(SamePadding);
+    convOp->setInput(input, 0);
+    convOp->setWeightDims(3, 3, 64);
+    convOp->createAllTensors();
+    allocateAllTensors<float16>(convOp);
+    network()->addOperator(convOp);
+
+    GraphAnalyzer analyzer(network(), workspace());
+    analyzer.dry_run_network();
+    analyzer.populate_tile_pin_map();
+    std::vector<TiledTensor*> tiledTensors = convOp->getTiledTensors();
+    TiledTensor& inputs = *tiledTensors[0];
+    TiledTensor& weights = *tiledTensors[1];
+    REQUIRE(inputs.size() == 2);
+    REQUIRE(weights.size() == 2);
+
+    // The dispatcher runs every weight tile against every input tile once,
+    // and consecutive invocations share one of their tiles.
+    const std::vector<TileStep>& steps = analyzer.get_tile_steps();
+    REQUIRE(steps.size() == 4);
+    std::set<std::pair<Tensor*, Tensor*>> pairs;
+    for (int i = 0; i < steps.size(); i++) {
+        REQUIRE(steps[i].op == convOp);
+        REQUIRE(steps[i].inputs.size() == 2);
+        REQUIRE(steps[i].outputs.size() == 1);
+        Tensor* inputTile = steps[i].inputs[0].tile;
+        Tensor* weightTile = steps[i].inputs[1].tile;
+        REQUIRE((inputTile == inputs[0] || inputTile == inputs[1]));
+        REQUIRE((weightTile == weights[0] || weightTile == weights[1]));
+        pairs.emplace(inputTile, weightTile);
+        if (i > 0) {
+            REQUIRE((inputTile == steps[i - 1].inputs[0].tile ||
+                     weightTile == steps[i - 1].inputs[1].tile));
+        }
+    }
+    REQUIRE(pairs.size() == 4);
+}
+
+TEST_CASE_METHOD(GraphTest, "Optimize the schedule of a branchy network", "[graph]") {
+    // Every activation takes three tiles of the shrunk scratchpads.
+    SmvBackend::freeGlobals();
+    SmvBackend::initGlobals(4 * 1024);
+    TensorShape shape({ 1, 8, 8, 96 }, DataLayout::NHWC, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", shape);
+    workspace()->addTensor(input);
+    // relu feeds two chains of two relus each.
+    auto addRelu = [&](std::string name, Operator* prev) -> Operator* {
+        auto relu = new SmvReluOp(name, workspace());
+        relu->setInput(prev ? prev->getOutput(0) : input, 0);
+        relu->createAllTensors();
+        allocateAllTensors<float16>(relu);
+        network()->addOperator(relu);
+        if (prev)
+            network()->addEdge(prev, relu, { 0, 0 });
+        return relu;
+    };
+    auto relu = addRelu("relu", nullptr);
+    auto a0 = addRelu("a0", relu);
+    auto b0 = addRelu("b0", relu);
+    auto a1 = addRelu("a1", a0);
+    auto b1 = addRelu("b1", b0);
+
+    // The fourth spm only holds pinned tiles.
+    GraphAnalyzer analyzer(network(), workspace(), 4);
+    std::vector<Operator*> fifo = analyzer.get_default_schedule();
+    REQUIRE(fifo == std::vector<Operator*>{ relu, a0, b0, a1, b1 });
+    // None of the activations fits in a spm, but running a chain to its end
+    // keeps the tiles of a0 pinned for a1 instead of across b0.
+    std::vector<Operator*> order = analyzer.optimize_schedule(4);
+    REQUIRE(order == std::vector<Operator*>{ relu, a0, a1, b0, b1 });
+    DmaTraffic optimized = analyzer.estimate_schedule_traffic(order);
+    DmaTraffic fifoTraffic = analyzer.estimate_schedule_traffic(fifo);
+    REQUIRE(optimized.load_bytes + optimized.store_bytes <
+            fifoTraffic.load_bytes + fifoTraffic.store_bytes);
+}
@@ -0,0 +1,348 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include "fp16.h"
+#include "smaug/core/globals.h"
+#include "smaug/core/input_pipeline.h"
+#include "smaug/core/param_store.h"
+#include "smaug/operators/common.h"
+#include "smaug/utility/utils.h"
+
+namespace smaug {
+
+namespace {
+
+int getDataTypeSize(DataType dataType) {
+    switch (dataType) {
+        case Float16:
+            return sizeof(float16);
+        case Float32:
+            return sizeof(float);
+        case Float64:
+            return sizeof(double);
+        case Int32:
+            return sizeof(int);
+        case Int64:
+            return sizeof(int64_t);
+        case Bool:
+            return sizeof(bool);
+        default:
+            return 0;
+    }
+}
+
+/** Returns the data type of a .npy type descriptor, e.g. "<f4". */
+DataType getNpyDataType(const std::string& descr) {
+    if (descr.size() != 3 || (descr[0] != '<' && descr[0] != '|' &&
+                              descr[0] != '='))
+        return UnknownDataType;
+    std::string type = descr.substr(1);
+    if (type == "f2")
+        return Float16;
+    if (type == "f4")
+        return Float32;
+    if (type == "f8")
+        return Float64;
+    if (type == "i4")
+        return Int32;
+    if (type == "i8")
+        return Int64;
+    if (type == "b1")
+        return Bool;
+    return UnknownDataType;
+}
+
+/**
+ * Returns the value of the given key in the dict of a .npy header, up to the
+ * next comma (or the closing parenthesis of a tuple).
+ */
+std::string getNpyHeaderValue(const std::string& header,
+                              const std::string& key) {
+    size_t pos = header.find("'" + key + "'");
+    if (pos == std::string::npos)
+        return "";
+    pos = header.find(':', pos);
+    if (pos == std::string::npos)
+        return "";
+    size_t begin = header.find_first_not_of(' ', pos + 1);
+    if (begin == std::string::npos)
+        return "";
+    size_t end = header[begin] == '(' ? header.find(')', begin) + 1
+                                      : header.find(',', begin);
+    return header.substr(begin, end - begin);
+}
+
+template <typename DstType, typename SrcType>
+DstType convertElement(SrcType value) {
+    return static_cast<DstType>(value);
+}
+
+template <>
+float16 convertElement<float16, float>(float value) {
+    return fp16_ieee_from_fp32_value(value);
+}
+
+template <>
+float convertElement<float, float16>(float16 value) {
+    return fp16_ieee_to_fp32_value(value);
+}
+
+}  // namespace
+
+InputPipeline::InputPipeline(const std::string& path,
+                             Tensor* _input,
+                             DataType rawDataType,
+                             DataLayout _sampleLayout)
+        : input(_input), sampleLayout(_sampleLayout), valid(false),
+          zeroCopy(false), mapped(nullptr), mappedSize(0), dataOffset(0),
+          fileDataType(rawDataType), sampleBytes(0), numSamples(0),
+          currentSample(-1), nextBuffer(0) {
+    // The samples replace the data of the input, which must then not be
+    // reloaded from the model parameters when it is accessed.
+    if (ParamStore* paramStore = input->getParamStore())
+        paramStore->removeTensor(input);
+    const TensorShape& shape = input->getShape();
+    if (sampleLayout == UnknownLayout)
+        sampleLayout = shape.getLayout();
+    if (sampleLayout != shape.getLayout() &&
+        !(shape.ndims() == 4 &&
+          (sampleLayout == NCHW || sampleLayout == NHWC) &&
+          (shape.getLayout() == NCHW || shape.getLayout() == NHWC))) {
+        std::cerr << "Cannot reorder the " << dataLayoutToStr(sampleLayout)
+                  << " samples to " << dataLayoutToStr(shape.getLayout())
+                  << "!\n";
+        return;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "Cannot open the dataset file: " << path << "\n";
+        return;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+        mappedSize = fileStat.st_size;
+        // A private mapping can be written (copy on write), so the input
+        // Tensor may be used like any other.
+        void* addr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED)
+            mapped = reinterpret_cast<const char*>(addr);
+    }
+    close(fd);
+    if (!mapped) {
+        std::cerr << "Cannot map the dataset file: " << path << "\n";
+        return;
+    }
+
+    uint64_t numElements;
+    bool isNpy = mappedSize >= 6 && memcmp(mapped, "\x93NUMPY", 6) == 0;
+    if (isNpy) {
+        if (!parseNpyHeader(&numElements)) {
+            std::cerr << "Unsupported .npy file: " << path << "\n";
+            return;
+        }
+    } else {
+        if (fileDataType == UnknownDataType)
+            fileDataType = input->getDataType();
+        int elementSize = getDataTypeSize(fileDataType);
+        if (elementSize == 0) {
+            std::cerr << "Unknown data type of the dataset file: " << path
+                      << "\n";
+            return;
+        }
+        numElements = mappedSize / elementSize;
+    }
+
+    int sampleSize = shape.size();
+    if (numElements < sampleSize || numElements % sampleSize != 0) {
+        std::cerr << "The dataset file " << path << " doesn't hold samples "
+                  << "of " << sampleSize << " elements!\n";
+        return;
+    }
+    numSamples = numElements / sampleSize;
+    sampleBytes = (uint64_t)sampleSize * getDataTypeSize(fileDataType);
+
+    zeroCopy = fileDataType == input->getDataType() &&
+               shape.storageSize() == sampleSize &&
+               sampleLayout == shape.getLayout() &&
+               dataOffset % CACHELINE_SIZE == 0 &&
+               sampleBytes % CACHELINE_SIZE == 0;
+    if (!zeroCopy) {
+        bool supported = fileDataType == input->getDataType() ||
+                         (fileDataType == Float32 &&
+                          input->getDataType() == Float16) ||
+                         (fileDataType == Float16 &&
+                          input->getDataType() == Float32);
+        if (!supported) {
+            std::cerr << "Cannot convert the " << DataType_Name(fileDataType)
+                      << " samples to " << DataType_Name(input->getDataType())
+                      << "!\n";
+            return;
+        }
+        int bytes = shape.storageSize() * input->getDataTypeSize();
+        for (auto& buffer : buffers) {
+            // The padding stays zero, as only the elements are prepared.
+            buffer = std::shared_ptr<void>(malloc_aligned(bytes, true), free);
+        }
+        // Prepare the first sample while the rest of the network is set up.
+        startPreparing(0, 0);
+    }
+    valid = true;
+}
+
+InputPipeline::~InputPipeline() {
+    if (preparing.valid())
+        preparing.wait();
+    if (mapped)
+        munmap(const_cast<char*>(mapped), mappedSize);
+}
+
+bool InputPipeline::parseNpyHeader(uint64_t* numElements) {
+    if (mappedSize < 10)
+        return false;
+    int majorVersion = mapped[6];
+    uint64_t headerLen;
+    uint64_t headerStart;
+    if (majorVersion == 1) {
+        headerLen = (uint8_t)mapped[8] | ((uint8_t)mapped[9] << 8);
+        headerStart = 10;
+    } else {
+        if (mappedSize < 12)
+            return false;
+        headerLen = 0;
+        for (int i = 0; i < 4; i++)
+            headerLen |= (uint64_t)(uint8_t)mapped[8 + i] << (8 * i);
+        headerStart = 12;
+    }
+    dataOffset = headerStart + headerLen;
+    if (dataOffset > mappedSize)
+        return false;
+    std::string header(mapped + headerStart, headerLen);
+
+    std::string descr = getNpyHeaderValue(header, "descr");
+    if (descr.size() < 2)
+        return false;
+    fileDataType = getNpyDataType(descr.substr(1, descr.size() - 2));
+    if (fileDataType == UnknownDataType)
+        return false;
+    if (getNpyHeaderValue(header, "fortran_order") != "False")
+        return false;
+    std::string shape = getNpyHeaderValue(header, "shape");
+    if (shape.empty())
+        return false;
+    *numElements = 1;
+    for (size_t pos = shape.find_first_of("0123456789");
+         pos != std::string::npos;
+         pos = shape.find_first_of("0123456789", pos)) {
+        size_t end;
+        *numElements *= std::stoull(shape.substr(pos), &end);
+        pos += end;
+    }
+    return (*numElements) * getDataTypeSize(fileDataType) <=
+           mappedSize - dataOffset;
+}
+
+bool InputPipeline::next() {
+    if (!valid || currentSample + 1 >= numSamples)
+        return false;
+    currentSample++;
+    if (zeroCopy) {
+        input->setExternalData(const_cast<char*>(getSamplePtr(currentSample)),
+                               fileDataType);
+        return true;
+    }
+    // The network is done with the other buffer by now, so the sample after
+    // this one can be prepared in it.
+    int buffer = nextBuffer;
+    preparing.get();
+    input->setExternalData(buffers[buffer].get(), input->getDataType());
+    if (currentSample + 1 < numSamples)
+        startPreparing(currentSample + 1, 1 - buffer);
+    return true;
+}
+
+void InputPipeline::startPreparing(int sample, int buffer) {
+    nextBuffer = buffer;
+    // In simulation, the host threads need CPUs of their own, so the sample
+    // is prepared when it is bound.
+    auto policy =
+            runningInSimulation ? std::launch::deferred : std::launch::async;
+    void* dest = buffers[buffer].get();
+    preparing = std::async(
+            policy, [this, sample, dest]() { prepareSample(sample, dest); });
+}
+
+void InputPipeline::prepareSample(int sample, void* dest) const {
+    DataType dataType = input->getDataType();
+    if (fileDataType == Float32 && dataType == Float16) {
+        prepareSample<float16, float>(sample, reinterpret_cast<float16*>(dest));
+        return;
+    }
+    if (fileDataType == Float16 && dataType == Float32) {
+        prepareSample<float, float16>(sample, reinterpret_cast<float*>(dest));
+        return;
+    }
+    switch (dataType) {
+        case Float16:
+            prepareSample<float16, float16>(
+                    sample, reinterpret_cast<float16*>(dest));
+            break;
+        case Float32:
+            prepareSample<float, float>(sample, reinterpret_cast<float*>(dest));
+            break;
+        case Float64:
+            prepareSample<double, double>(
+                    sample, reinterpret_cast<double*>(dest));
+            break;
+        case Int32:
+            prepareSample<int, int>(sample, reinterpret_cast<int*>(dest));
+            break;
+        case Int64:
+            prepareSample<int64_t, int64_t>(
+                    sample, reinterpret_cast<int64_t*>(dest));
+            break;
+        case Bool:
+            prepareSample<bool, bool>(sample, reinterpret_cast<bool*>(dest));
+            break;
+        default:
+            assert(false && "Unknown data type!");
+    }
+}
+
+template <typename DstType, typename SrcType>
+void InputPipeline::prepareSample(int sample, DstType* dest) const {
+    const SrcType* src =
+            reinterpret_cast<const SrcType*>(getSamplePtr(sample));
+    const TensorShape& shape = input->getShape();
+    int ndims = shape.ndims();
+    // The order of the Tensor's dimensions in the sample.
+    std::vector<int> sampleDims(ndims);
+    for (int i = 0; i < ndims; i++)
+        sampleDims[i] = i;
+    if (sampleLayout == NCHW && shape.getLayout() == NHWC)
+        sampleDims = { 0, 3, 1, 2 };
+    else if (sampleLayout == NHWC && shape.getLayout() == NCHW)
+        sampleDims = { 0, 2, 3, 1 };
+    // The stride of each of the Tensor's dimensions in the sample.
+    std::vector<int> srcStrides(ndims);
+    int stride = 1;
+    for (int i = ndims - 1; i >= 0; i--) {
+        srcStrides[sampleDims[i]] = stride;
+        stride *= shape[sampleDims[i]];
+    }
+    for (auto idx = input->startIndex(); !idx.end(); ++idx) {
+        int srcIndex = 0;
+        for (int i = 0; i < ndims; i++)
+            srcIndex += idx.currentIndex(i) * srcStrides[i];
+        dest[idx] = convertElement<DstType, SrcType>(src[srcIndex]);
+    }
+}
+
+}  // namespace smaug
@@ -0,0 +1,108 @@
+#ifndef _CORE_INPUT_PIPELINE_H_
+#define _CORE_INPUT_PIPELINE_H_
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "smaug/core/tensor.h"
+
+namespace smaug {
+
+/**
+ * InputPipeline streams the samples of a dataset file into an input Tensor of
+ * the network, so that the network can be run on each of them in turn.
+ *
+ * The file is memory-mapped. It is either a .npy file, whose array holds the
+ * samples back to back, or a raw file of samples with the given data type. A
+ * sample has the elements of the input Tensor, without the alignment padding.
+ *
+ * If a sample in the file can be used as is (same data type, no padding to
+ * insert, no layout change, and cacheline aligned), the input Tensor is bound
+ * to it directly, without any copy. Otherwise, the samples are prepared in two
+ * staging buffers: while the network runs on one sample, the next one is
+ * converted (e.g. from float32 to float16), reordered and padded into the
+ * other buffer on a background thread.
+ */
+class InputPipeline {
+   public:
+    /**
+     * Maps the given dataset file.
+     *
+     * @param path The path to the .npy or raw dataset file.
+     * @param _input The Tensor the samples are bound to, which must not be
+     * used by the network before the first call to next(). If its data is
+     * loaded from a ParamStore, it is removed from the store.
+     * @param rawDataType The data type of a raw file. UnknownDataType means
+     * the data type of the input Tensor. Ignored for .npy files.
+     * @param _sampleLayout The layout of the samples in the file. A 4D
+     * NCHW or NHWC sample is reordered to the layout of the input Tensor.
+     * UnknownLayout means the layout of the input Tensor.
+     */
+    InputPipeline(const std::string& path,
+                  Tensor* _input,
+                  DataType rawDataType = UnknownDataType,
+                  DataLayout _sampleLayout = UnknownLayout);
+    ~InputPipeline();
+
+    /** Returns false if the file could not be mapped or doesn't fit. */
+    bool isValid() const { return valid; }
+
+    int getNumSamples() const { return numSamples; }
+
+    /** Returns true if the samples are bound without copying. */
+    bool isZeroCopy() const { return zeroCopy; }
+
+    /**
+     * Binds the next sample to the input Tensor, and starts preparing the one
+     * after it. Returns false once all the samples have been bound.
+     */
+    bool next();
+
+    /** Returns the index of the bound sample, or -1 before the first. */
+    int getCurrentSample() const { return currentSample; }
+
+   protected:
+    /** Parses the header of a .npy file and sets the data type and offset. */
+    bool parseNpyHeader(uint64_t* numElements);
+
+    /** Returns a pointer to the given sample in the file. */
+    const char* getSamplePtr(int sample) const {
+        return mapped + dataOffset + (uint64_t)sample * sampleBytes;
+    }
+
+    /** Prepares the given sample into the staging buffer. */
+    void prepareSample(int sample, void* dest) const;
+
+    template <typename DstType, typename SrcType>
+    void prepareSample(int sample, DstType* dest) const;
+
+    /** Starts preparing the given sample into the staging buffer. */
+    void startPreparing(int sample, int buffer);
+
+    Tensor* input;
+    DataLayout sampleLayout;
+    bool valid;
+    bool zeroCopy;
+
+    const char* mapped;
+    uint64_t mappedSize;
+    /** The offset of the first sample in the file. */
+    uint64_t dataOffset;
+    DataType fileDataType;
+    uint64_t sampleBytes;
+    int numSamples;
+    int currentSample;
+
+    /** The staging buffers the samples are prepared in. */
+    std::shared_ptr<void> buffers[2];
+    /** The staging buffer the next sample is being prepared in. */
+    int nextBuffer;
+    std::future<void> preparing;
+};
+
+}  // namespace smaug
+
+#endif
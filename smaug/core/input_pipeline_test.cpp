@@ -0,0 +1,236 @@
+#include <cstdio>
+#include <fstream>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/input_pipeline.h"
+#include "smaug/core/param_store.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/common.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class InputPipelineTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    ~InputPipelineTest() {
+        std::remove(kDatasetFile);
+        std::remove(kParamsFile);
+    }
+
+    static constexpr const char* kDatasetFile = "input_pipeline_test_data";
+    static constexpr const char* kParamsFile = "input_pipeline_test_params.pb";
+
+    // Returns float32 samples, where element i of sample s is s * 100 + i.
+    std::vector<float> getSamples(int numSamples, int sampleSize) {
+        std::vector<float> samples(numSamples * sampleSize);
+        for (int i = 0; i < samples.size(); i++)
+            samples[i] = (i / sampleSize) * 100 + i % sampleSize;
+        return samples;
+    }
+
+    template <typename T>
+    void writeRaw(const std::vector<T>& data) {
+        std::ofstream file(kDatasetFile, std::ios::out | std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()),
+                   data.size() * sizeof(T));
+    }
+
+    // Writes a version 1.0 .npy file of float32 data.
+    void writeNpy(const std::vector<float>& data, const std::string& shape) {
+        std::string header = "{'descr': '<f4', 'fortran_order': False, "
+                             "'shape': " + shape + ", }";
+        // The header is padded with spaces and a newline to align the data.
+        header.resize(next_multiple(10 + header.size() + 1, 64) - 11, ' ');
+        header += '\n';
+        std::ofstream file(kDatasetFile, std::ios::out | std::ios::binary);
+        file.write("\x93NUMPY\x01\x00", 8);
+        file.put(header.size() & 0xff);
+        file.put(header.size() >> 8);
+        file << header;
+        file.write(reinterpret_cast<const char*>(data.data()),
+                   data.size() * sizeof(float));
+    }
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(InputPipelineTest,
+                 "Samples bound without copying",
+                 "[input]") {
+    // Every sample is one cacheline.
+    TensorShape shape({ 1, 16 }, NC);
+    Tensor* input = new Tensor("input", shape);
+    input->allocateStorage<float>();
+    workspace()->addTensor(input);
+    writeRaw(getSamples(3, 16));
+
+    InputPipeline pipeline(kDatasetFile, input);
+    REQUIRE(pipeline.isValid());
+    REQUIRE(pipeline.isZeroCopy());
+    REQUIRE(pipeline.getNumSamples() == 3);
+    const float* lastData = nullptr;
+    for (int s = 0; s < 3; s++) {
+        uint64_t version = input->getDataVersion();
+        REQUIRE(pipeline.next());
+        REQUIRE(pipeline.getCurrentSample() == s);
+        REQUIRE(input->getDataVersion() != version);
+        const float* data = input->data<float>();
+        // The samples are back to back in the mapped file.
+        if (lastData)
+            REQUIRE(data == lastData + 16);
+        REQUIRE(data[0] == s * 100);
+        REQUIRE(data[15] == s * 100 + 15);
+        lastData = data;
+    }
+    REQUIRE(!pipeline.next());
+}
+
+TEST_CASE_METHOD(InputPipelineTest,
+                 "Samples bound to an input loaded on demand",
+                 "[input]") {
+    // The model parameters also have data for the input, and the budget
+    // only fits one of the tensors.
+    const int size = 16;
+    TensorDataArray tensorDataArray;
+    for (const std::string name : { "input", "other" }) {
+        TensorData* tensorData = tensorDataArray.add_data_array();
+        tensorData->set_name(name);
+        for (int i = 0; i < size; i++)
+            tensorData->add_float_data(-1);
+    }
+    {
+        std::ofstream paramsFile(
+                kParamsFile, std::ios::out | std::ios::binary);
+        REQUIRE(tensorDataArray.SerializeToOstream(&paramsFile));
+    }
+    ParamStore store(kParamsFile, size * sizeof(float));
+    REQUIRE(store.isValid());
+    std::vector<Tensor*> tensors;
+    for (const std::string name : { "input", "other" }) {
+        TensorProto tensorProto;
+        tensorProto.set_name(name);
+        tensorProto.set_data_type(Float32);
+        TensorShape shape({ 1, size }, NC);
+        tensorProto.set_allocated_shape(shape.asTensorShapeProto());
+        Tensor* tensor = new Tensor(tensorProto);
+        workspace()->addTensor(tensor);
+        store.addTensor(tensor);
+        tensors.push_back(tensor);
+    }
+    Tensor* input = tensors[0];
+    Tensor* other = tensors[1];
+    writeRaw(getSamples(2, size));
+
+    InputPipeline pipeline(kDatasetFile, input);
+    REQUIRE(pipeline.isValid());
+    REQUIRE(input->getParamStore() == nullptr);
+    for (int s = 0; s < 2; s++) {
+        REQUIRE(pipeline.next());
+        // Loading the other tensor would evict the input if it were still
+        // in the store, and the input would then be reloaded from the file.
+        REQUIRE(other->data<float>()[0] == -1);
+        REQUIRE(input->data<float>()[0] == s * 100);
+        REQUIRE(input->data<float>()[size - 1] == s * 100 + size - 1);
+    }
+    REQUIRE(store.getResidentBytes() == size * sizeof(float));
+}
+
+TEST_CASE_METHOD(InputPipelineTest,
+                 "Samples converted and reordered into staging buffers",
+                 "[input]") {
+    // The channels are padded from 3 to 8.
+    TensorShape shape({ 1, 4, 4, 3 }, NHWC, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", shape);
+    input->allocateStorage<float16>();
+    workspace()->addTensor(input);
+    writeNpy(getSamples(2, 48), "(2, 1, 3, 4, 4)");
+
+    InputPipeline pipeline(kDatasetFile, input, UnknownDataType, NCHW);
+    REQUIRE(pipeline.isValid());
+    REQUIRE(!pipeline.isZeroCopy());
+    REQUIRE(pipeline.getNumSamples() == 2);
+    std::vector<const float16*> buffers;
+    for (int s = 0; s < 2; s++) {
+        REQUIRE(pipeline.next());
+        const float16* data = input->data<float16>();
+        buffers.push_back(data);
+        bool matches = true;
+        for (int h = 0; h < 4; h++) {
+            for (int w = 0; w < 4; w++) {
+                for (int c = 0; c < 8; c++) {
+                    float expected = c < 3 ? s * 100 + c * 16 + h * 4 + w : 0;
+                    matches = matches &&
+                              fp32(data[(h * 4 + w) * 8 + c]) == expected;
+                }
+            }
+        }
+        REQUIRE(matches);
+    }
+    // The samples alternate between the two staging buffers.
+    REQUIRE(buffers[0] != buffers[1]);
+    REQUIRE(!pipeline.next());
+}
+
+TEST_CASE_METHOD(InputPipelineTest,
+                 "Network run on every sample",
+                 "[input]") {
+    // The weights need multiple tiles.
+    const int numSamples = 3;
+    TensorShape inputShape({ 1, 1024 }, NC, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", inputShape);
+    input->allocateStorage<float16>();
+    workspace()->addTensor(input);
+    TensorShape weightsShape({ 32, 1024 }, NC, SmvBackend::Alignment);
+    Tensor* weights = new Tensor("weights", weightsShape);
+    weights->allocateStorage<float16>();
+    fillTensorWithRandomData(weights);
+    workspace()->addTensor(weights);
+    std::vector<float> samples(numSamples * 1024);
+    for (int i = 0; i < samples.size(); i++)
+        samples[i] = ((i * 37) % 101) / 101.0f - 0.5f;
+    writeRaw(samples);
+
+    auto fcOp = new SmvInnerProductOp("fc", workspace());
+    fcOp->setInput(input, 0);
+    fcOp->setInput(weights, 1);
+    fcOp->setNumOutputs(32);
+    fcOp->createAllTensors();
+    fcOp->getOutput(0)->allocateStorage<float16>();
+    network()->addOperator(fcOp);
+
+    InputPipeline pipeline(kDatasetFile, input, Float32);
+    REQUIRE(pipeline.isValid());
+    REQUIRE(pipeline.getNumSamples() == numSamples);
+    Network refNetwork("ref");
+    Scheduler scheduler(network(), workspace());
+    for (int s = 0; s < numSamples; s++) {
+        REQUIRE(pipeline.next());
+        Tensor* output = scheduler.runNetwork();
+
+        // The same layer run on its own on the sample.
+        std::string name = "ref" + std::to_string(s);
+        Tensor* refInput = new Tensor(name + "/input", inputShape);
+        float16* refData = refInput->allocateStorage<float16>();
+        for (int i = 0; i < 1024; i++)
+            refData[i] = fp16(samples[s * 1024 + i]);
+        workspace()->addTensor(refInput);
+        auto refOp = new SmvInnerProductOp(name + "/fc", workspace());
+        refOp->setInput(refInput, 0);
+        refOp->setInput(weights, 1);
+        refOp->setNumOutputs(32);
+        refOp->createAllTensors();
+        refOp->getOutput(0)->allocateStorage<float16>();
+        refOp->tile();
+        refOp->run();
+        refNetwork.addOperator(refOp);
+        verifyOutputs<float16>(output, refOp->getOutput(0));
+    }
+}
@@ -3,6 +3,7 @@
 
 #include <exception>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -10,6 +11,7 @@
 
 #include "smaug/core/typedefs.h"
 #include "smaug/core/operator.h"
+#include "smaug/core/param_store.h"
 #include "smaug/core/workspace.h"
 #include "smaug/operators/common.h"
 
@@ -66,6 +68,14 @@ class Network {
     }
     SamplingInfo& getSamplingInfo() { return sampling; }
 
+    /**
+     * Sets the ParamStore that the parameters are loaded from on demand. The
+     * Network takes ownership of it.
+     */
+    void setParamStore(ParamStore* store) { paramStore.reset(store); }
+    /** Returns the ParamStore, or null if all parameters are in memory. */
+    ParamStore* getParamStore() const { return paramStore.get(); }
+
    protected:
     struct OperatorInsertion {
         Operator* newOp;
@@ -82,6 +92,9 @@ class Network {
     /** The sampling information of the model. */
     SamplingInfo sampling;
 
+    /** The store of the parameters that are loaded on demand, if any. */
+    std::unique_ptr<ParamStore> paramStore;
+
     /** Name of the model. */
     std::string name;
 };
@@ -1,15 +1,18 @@
-#include <fcntl.h>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 
-#include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <google/protobuf/text_format.h>
 
 #include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
 #include "smaug/core/graph.pb.h"
 #include "smaug/core/network.h"
 #include "smaug/core/network_builder.h"
 #include "smaug/core/node.pb.h"
+#include "smaug/core/param_store.h"
 #include "smaug/core/tensor.h"
 #include "smaug/core/tensor.pb.h"
 #include "smaug/core/types.pb.h"
@@ -37,6 +40,7 @@
 #include "smaug/operators/my_custom_operator.h"
 #include "smaug/operators/smv/smv_batch_norm_op.h"
 #include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_depthwise_convolution_op.h"
 #include "smaug/operators/smv/smv_eltwise_add_op.h"
 #include "smaug/operators/smv/smv_eltwise_mul_op.h"
 #include "smaug/operators/smv/smv_elu_op.h"
@@ -52,6 +56,7 @@
 #include "smaug/operators/split_op.h"
 #include "smaug/operators/tanh_op.h"
 #include "smaug/utility/debug_stream.h"
+#include "smaug/utility/thread_pool.h"
 #include "smaug/utility/utils.h"
 
 using namespace smaug;
@@ -96,11 +101,83 @@ ActivationInfo getActivationInfo(const ActivationParams& params) {
     return actInfo;
 }
 
+// The arguments of a worker thread that reads the data of some tensors.
+struct ReadTensorsArgs {
+    ParamStore* paramStore;
+    std::vector<Tensor*> tensors;
+};
+
+static void* readTensorsWorker(void* _args) {
+    auto args = reinterpret_cast<ReadTensorsArgs*>(_args);
+    for (Tensor* tensor : args->tensors) {
+        tensor->fillData(tensor->getDataType(),
+                         args->paramStore->read(tensor->getName()));
+    }
+    return nullptr;
+}
+
+// Create the tensors of all the Data nodes in the graph and add them to the
+// workspace. Their data is read from the parameters file now, or when they are
+// first used if there is a memory budget for the parameters.
+static void createParamTensors(const GraphProto& graphProto,
+                               ParamStore* paramStore,
+                               Workspace* workspace) {
+    std::vector<Tensor*> tensors;
+    for (int i = 0; i < graphProto.nodes_size(); i++) {
+        const NodeProto& node = graphProto.nodes(i);
+        if (node.op() != OpType::Data)
+            continue;
+        const TensorProto& tensorProto = node.input_tensors(0);
+        if (tensorProto.data_format() == PackedCSR) {
+            cout << tensorProto.name()
+                 << ": the PackedCSR data format is not supported.\n";
+            exit(1);
+        }
+        Tensor* tensor = workspace->addTensor(new Tensor(tensorProto));
+        // Compressed tensors are small enough to always be in memory.
+        if (paramMemoryBudget > 0 && tensorProto.data_format() != CSR &&
+            paramStore->contains(tensorProto.name())) {
+            paramStore->addTensor(tensor);
+        } else {
+            tensors.push_back(tensor);
+        }
+    }
+
+    // Decoding the tensors is independent, so it's split across the thread
+    // pool if it is running. Every thread gets about the same number of bytes,
+    // assigning the largest tensors first.
+    int numThreads =
+            threadPool && threadPool->isInitialized() ? threadPool->size() : 1;
+    std::vector<ReadTensorsArgs> args(numThreads, { paramStore, {} });
+    std::vector<uint64_t> bytes(numThreads, 0);
+    std::sort(tensors.begin(), tensors.end(), [](Tensor* a, Tensor* b) {
+        return a->getShape().storageSize() * a->getDataTypeSize() >
+               b->getShape().storageSize() * b->getDataTypeSize();
+    });
+    for (Tensor* tensor : tensors) {
+        int thread = std::min_element(bytes.begin(), bytes.end()) -
+                     bytes.begin();
+        args[thread].tensors.push_back(tensor);
+        bytes[thread] +=
+                tensor->getShape().storageSize() * tensor->getDataTypeSize();
+    }
+    if (numThreads == 1) {
+        readTensorsWorker(&args[0]);
+        return;
+    }
+    for (auto& arg : args) {
+        if (arg.tensors.empty())
+            continue;
+        int cpuid = threadPool->dispatchThread(readTensorsWorker, (void*)&arg);
+        assert(cpuid != -1 && "Failed to dispatch thread!");
+    }
+    threadPool->joinThreadPool();
+}
+
 // Create an operator by deserializing a node in the graph, and add it to the
 // network.
 template <typename Backend>
 static void createAndAddOperator(const NodeProto& node,
-                                 const TensorDataArray& tensorDataArray,
                                  HostMemoryAccessPolicy memPolicy,
                                  Network* network,
                                  Workspace* workspace) {
@@ -110,17 +187,9 @@ static void createAndAddOperator(const NodeProto& node,
     dout(0) << "Adding " << name << " (" << OpType_Name(type) << ").\n";
 
     if (type == OpType::Data) {
-        // Find the tensor data from the tensor data array.
-        TensorData tensorData;
-        for (int i = 0; i < tensorDataArray.data_array_size(); i++) {
-            if (tensorDataArray.data_array(i).name() ==
-                node.input_tensors(0).name()) {
-                tensorData = tensorDataArray.data_array(i);
-                break;
-            }
-        }
-        auto inputTensor = workspace->addTensor(
-                new Tensor(node.input_tensors(0), tensorData));
+        // The tensor was created by createParamTensors().
+        Tensor* inputTensor =
+                workspace->getTensor(node.input_tensors(0).name());
         auto inputTensorOp = Backend::createDataOp(name, workspace);
         inputTensorOp->setData(inputTensor);
         network->addOperator(inputTensorOp);
@@ -318,19 +387,38 @@ static void createAndAddOperator(const NodeProto& node,
     }
 }
 
+// Parse the network topology. Files with a .pbtxt or .txt extension are in the
+// protobuf text format, which is much slower to parse. Any other file is a
+// binary GraphProto, unless it fails to parse as one.
+static bool parseTopology(const std::string& modelTopo,
+                          const std::string& contents,
+                          GraphProto* graph) {
+    auto endsWith = [&](const std::string& suffix) {
+        return modelTopo.size() >= suffix.size() &&
+               modelTopo.compare(modelTopo.size() - suffix.size(),
+                                 suffix.size(), suffix) == 0;
+    };
+    if (!endsWith(".pbtxt") && !endsWith(".txt")) {
+        if (graph->ParseFromString(contents))
+            return true;
+        graph->Clear();
+    }
+    return google::protobuf::TextFormat::ParseFromString(contents, graph);
+}
+
 // Create the network by deserializing the graph stored in the
 // protobuf model.
 template <typename Backend>
 static Network* createNetworkFromProto(const GraphProto& graphProto,
-                                       const TensorDataArray& tensorDataArray,
+                                       ParamStore* paramStore,
                                        SamplingInfo& sampling,
                                        Workspace* workspace) {
     Network* network = new Network(graphProto.name());
     network->setSamplingInfo(sampling);
+    createParamTensors(graphProto, paramStore, workspace);
     for (int i = 0; i < graphProto.nodes_size(); i++) {
         const NodeProto& node = graphProto.nodes(i);
         createAndAddOperator<Backend>(node,
-                                      tensorDataArray,
                                       graphProto.mem_policy(),
                                       network,
                                       workspace);
@@ -377,25 +465,29 @@ Network* smaug::buildNetwork(const std::string& modelTopo,
                              const std::string& modelParams,
                              SamplingInfo& sampling,
                              Workspace* workspace) {
-    // Parse the network topology from the protobuf text file.
+    // Parse the network topology from the protobuf binary or text file.
     GraphProto graph;
-    int modelTopoDescriptor = open(modelTopo.c_str(), O_RDONLY);
-    if (modelTopoDescriptor < 0) {
+    ifstream modelTopoInput(modelTopo, ios::in | ios::binary);
+    if (!modelTopoInput) {
         cout << modelTopo << ": network topology file not found." << endl;
         exit(1);
     }
-    google::protobuf::io::FileInputStream modelTopoInput(modelTopoDescriptor);
-    if (!google::protobuf::TextFormat::Parse(&modelTopoInput, &graph)) {
+    stringstream modelTopoContents;
+    modelTopoContents << modelTopoInput.rdbuf();
+    if (!parseTopology(modelTopo, modelTopoContents.str(), &graph)) {
         cout << "Failed to parse the network topology file!" << endl;
         exit(1);
     }
-    // Parse the network parameters from the protobuf binary file.
-    TensorDataArray tensorDataArray;
-    fstream modelParamsFile(modelParams, ios::in | ios::binary);
-    if (!modelParamsFile) {
+    // Index the network parameters in the protobuf binary file. They are read
+    // as the Data operators are created, or on demand if there is a memory
+    // budget for them.
+    if (!ifstream(modelParams, ios::in | ios::binary)) {
         cout << modelParams << ": network parameters file not found." << endl;
         exit(1);
-    } else if (!tensorDataArray.ParseFromIstream(&modelParamsFile)) {
+    }
+    std::unique_ptr<ParamStore> paramStore(
+            new ParamStore(modelParams, paramMemoryBudget));
+    if (!paramStore->isValid()) {
         cout << "Failed to parse the network parameters file.\n";
         exit(1);
     }
@@ -406,13 +498,18 @@ Network* smaug::buildNetwork(const std::string& modelTopo,
     Network* network = nullptr;
     if (graph.backend() == ReferenceBackend::Name) {
         network = createNetworkFromProto<ReferenceBackend>(
-                graph, tensorDataArray, sampling, workspace);
+                graph, paramStore.get(), sampling, workspace);
     } else if (graph.backend() == SmvBackend::Name) {
         network = createNetworkFromProto<SmvBackend>(
-                graph, tensorDataArray, sampling, workspace);
+                graph, paramStore.get(), sampling, workspace);
     } else {
         assert(false && "Unknown backend!");
     }
+    if (paramMemoryBudget > 0) {
+        cout << "Loading the parameters on demand, memory budget: "
+             << paramMemoryBudget << " bytes.\n";
+        network->setParamStore(paramStore.release());
+    }
 
     cout << "======================================================\n";
     cout << "      Summary of the network.\n";
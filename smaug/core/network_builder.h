@@ -14,7 +14,9 @@ namespace smaug {
  * simulation sampling directives and returns a populated Network that can be
  * run.
  *
- * @param modelTopoFile The path to the model topology protobuf.
+ * @param modelTopoFile The path to the model topology protobuf. Files with a
+ * .pbtxt or .txt extension are parsed as text, and others as a binary
+ * GraphProto.
  * @param modelParamsFile The path to the model parameters protobuf, which
  * contains values for all tensors in the network (weights *and* inputs).
  * @param sampling Level of simulation sampling to apply to applicable kernels.
@@ -1,11 +1,49 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <google/protobuf/text_format.h>
+
 #include "catch.hpp"
 #include "smaug/core/backend.h"
+#include "smaug/core/graph.pb.h"
+#include "smaug/core/network_builder.h"
 #include "smaug/core/tensor.h"
 #include "smaug/core/smaug_test.h"
 #include "smaug/operators/reorder_op.h"
 
 using namespace smaug;
 
+TEST_CASE_METHOD(SmaugTest, "Binary network topology", "[network]") {
+    std::string modelPath = "smaug/python/test_inputs/";
+    // Convert the text topology into a binary one.
+    std::ifstream textTopo(resolvePath(modelPath + "fp16_odd_topo.txt"));
+    std::stringstream text;
+    text << textTopo.rdbuf();
+    GraphProto graph;
+    REQUIRE(google::protobuf::TextFormat::ParseFromString(text.str(), &graph));
+    const char* binaryTopo = "network_test_topo.pb";
+    {
+        std::ofstream binary(binaryTopo, std::ios::out | std::ios::binary);
+        REQUIRE(graph.SerializeToOstream(&binary));
+    }
+
+    delete network_;
+    SamplingInfo sampling = { NoSampling, 1 };
+    network_ = smaug::buildNetwork(binaryTopo,
+                                   resolvePath(modelPath + "fp16_odd_params.pb"),
+                                   sampling,
+                                   workspace());
+    std::remove(binaryTopo);
+    auto inputTensor = network()->getOperator("input")->getInput(0);
+    std::vector<float16> expectedValues{
+        fp16(1.1), fp16(2.2),  fp16(3.3),   fp16(4.4),
+        fp16(5.5), fp16(6.6),  fp16(7.7),   fp16(8.8),
+        fp16(9.9), fp16(10.1), fp16(11.11), fp16(12.12)
+    };
+    verifyOutputs(inputTensor, expectedValues);
+}
+
 TEST_CASE_METHOD(SmaugTest, "Network tests", "[network]") {
     std::string modelPath = "experiments/models/";
 
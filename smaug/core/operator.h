@@ -1,6 +1,7 @@
 #ifndef _CORE_OPERATOR_H_
 #define _CORE_OPERATOR_H_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
@@ -29,7 +30,9 @@ class Operator {
    public:
     Operator(const std::string& _name, OpType _opType, Workspace* _workspace)
             : name(_name), opType(_opType), workspace(_workspace),
-              numPendingInputs(-1) {}
+              numPendingInputs(-1), fusedProducer(nullptr),
+              fusedConsumer(nullptr), firstAccelerator(0),
+              numAccelerators(0), estimatedCycles(0) {}
     virtual ~Operator() {}
 
     virtual void tile() {};
@@ -85,6 +88,40 @@ class Operator {
      */
     virtual std::vector<TensorBase*> getParameterizableInputs() { return {}; }
 
+    /**
+     * Return the TiledTensors this operator streams through the accelerator
+     * scratchpads, in the order the operator keeps them (inputs first, then
+     * outputs). These are only valid after tile() has been called.
+     *
+     * Operators that run on the host or do not tile their tensors return an
+     * empty list, in which case whole tensors are used for analysis.
+     */
+    virtual std::vector<TiledTensor*> getTiledTensors() { return {}; }
+
+    /**
+     * Returns the tiles every kernel invocation of run() uses, in the order
+     * run() invokes the kernels: one tile index per TiledTensor of
+     * getTiledTensors(). This is only valid after tile() has been called.
+     *
+     * An empty list means that the invocations step through all the
+     * TiledTensors together in increasing tile index, which is what
+     * operators whose tensors are all tiled alike do.
+     */
+    virtual std::vector<std::vector<int>> getTileInvocations() { return {}; }
+
+    /**
+     * Returns true if this operator can leave its (only) output in the
+     * accelerator scratchpads for the next operator instead of sending it to
+     * host memory. This is only valid after tile() has been called.
+     */
+    virtual bool canForwardOutputOnChip() const { return false; }
+
+    /**
+     * Returns true if this operator can read the given input directly from
+     * the scratchpad the producing operator left it in, given its tiling.
+     */
+    virtual bool canReadInputOnChip(TensorBase* input) const { return false; }
+
     /** This returns the number of parameterizable weights in the operator. */
     virtual int getNumParameters() const { return 0; }
     virtual bool isSamplingSupported() const { return false; }
@@ -124,6 +161,37 @@ class Operator {
     MemoryType getWeightsMemType() const { return weightsMemType; }
     MemoryType getOutputsMemType() const { return outputsMemType; }
 
+    /**
+     * Operator fusion: the producer keeps its output on-chip and the consumer
+     * reads it from there, so the tensor never goes through host memory.
+     */
+    void setFusedProducer(Operator* op) { fusedProducer = op; }
+    void setFusedConsumer(Operator* op) { fusedConsumer = op; }
+    Operator* getFusedProducer() const { return fusedProducer; }
+    Operator* getFusedConsumer() const { return fusedConsumer; }
+
+    /**
+     * Restricts the operator to the accelerators [first, first + num), e.g.
+     * to give each pipeline stage its own accelerators. By default, an
+     * operator can use all of the available accelerators.
+     */
+    void setAcceleratorRange(int first, int num) {
+        firstAccelerator = first;
+        numAccelerators = num;
+    }
+    int getFirstAccelerator() const { return firstAccelerator; }
+    int getNumAccelerators() const {
+        return numAccelerators > 0 ? numAccelerators
+                                   : numAcceleratorsAvailable;
+    }
+
+    /**
+     * The analytically estimated accelerator cycles of the last run of this
+     * operator, or 0 if its backend doesn't model them.
+     */
+    void setEstimatedCycles(uint64_t cycles) { estimatedCycles = cycles; }
+    uint64_t getEstimatedCycles() const { return estimatedCycles; }
+
    protected:
     /** An ordered list of input tensors consumed by this operator.
      *
@@ -154,6 +222,18 @@ class Operator {
     MemoryType weightsMemType;
     /** The memory interface over which outputs are expected to be delivered. */
     MemoryType outputsMemType;
+    /** The operator whose output this reads from the scratchpads, if any. */
+    Operator* fusedProducer;
+    /** The operator that reads this output from the scratchpads, if any. */
+    Operator* fusedConsumer;
+    /** The first accelerator this operator dispatches work to. */
+    int firstAccelerator;
+    /**
+     * The number of accelerators this operator dispatches work to, or 0 for
+     * all of the available ones.
+     */
+    int numAccelerators;
+    uint64_t estimatedCycles;
 };
 
 }  // namespace smaug
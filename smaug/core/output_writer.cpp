@@ -0,0 +1,185 @@
+#include <cassert>
+#include <fstream>
+#include <iostream>
+
+#include "smaug/core/output_writer.h"
+
+namespace smaug {
+
+namespace {
+
+/** Returns the raw storage of the tensor. */
+const char* getRawData(const Tensor* tensor) {
+    switch (tensor->getDataType()) {
+        case Float16:
+            return reinterpret_cast<const char*>(tensor->data<float16>());
+        case Float32:
+            return reinterpret_cast<const char*>(tensor->data<float>());
+        case Float64:
+            return reinterpret_cast<const char*>(tensor->data<double>());
+        case Int32:
+            return reinterpret_cast<const char*>(tensor->data<int>());
+        case Int64:
+            return reinterpret_cast<const char*>(tensor->data<int64_t>());
+        case Bool:
+            return reinterpret_cast<const char*>(tensor->data<bool>());
+        default:
+            assert(false && "Unknown data type!");
+            return nullptr;
+    }
+}
+
+/** Returns the .npy type descriptor of the data type. */
+std::string getNpyDescr(DataType dataType) {
+    switch (dataType) {
+        case Float16:
+            return "<f2";
+        case Float32:
+            return "<f4";
+        case Float64:
+            return "<f8";
+        case Int32:
+            return "<i4";
+        case Int64:
+            return "<i8";
+        case Bool:
+            return "|b1";
+        default:
+            assert(false && "Unknown data type!");
+            return "";
+    }
+}
+
+/** Writes a version 1.0 .npy header for the given data type and shape. */
+void writeNpyHeader(std::ostream& os,
+                    DataType dataType,
+                    const TensorShape& shape) {
+    std::string dims;
+    for (int i = 0; i < shape.ndims(); i++)
+        dims += std::to_string(shape[i]) + ", ";
+    // A tuple of one element keeps its comma.
+    dims.erase(dims.size() - (shape.ndims() > 1 ? 2 : 1));
+    std::string header = "{'descr': '" + getNpyDescr(dataType) +
+                         "', 'fortran_order': False, 'shape': (" + dims +
+                         "), }";
+    // The magic string, version and header length take 10 bytes, and the
+    // header ends with a newline. Pad it so that the data is aligned.
+    int length = 10 + header.size() + 1;
+    header.append((64 - length % 64) % 64, ' ');
+    header += '\n';
+    os.write("\x93NUMPY\x01\x00", 8);
+    os.put(header.size() & 0xff);
+    os.put(header.size() >> 8);
+    os << header;
+}
+
+}  // namespace
+
+OutputWriter::OutputWriter(const std::string& _directory,
+                           Format _format,
+                           const std::set<std::string>& _tensorNames)
+        : directory(_directory), format(_format), tensorNames(_tensorNames),
+          numPending(0), numFilesWritten(0), stopping(false) {
+    thread = std::thread(&OutputWriter::run, this);
+}
+
+OutputWriter::~OutputWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    thread.join();
+}
+
+std::string OutputWriter::getFilePath(const std::string& tensorName) const {
+    std::string fileName = tensorName;
+    for (char& c : fileName) {
+        if (c == '/')
+            c = '_';
+    }
+    return directory + "/" + fileName + fileSuffix +
+           (format == Npy ? ".npy" : ".bin");
+}
+
+void OutputWriter::write(const Tensor* tensor) {
+    Job job;
+    job.path = getFilePath(tensor->getName());
+    job.shape = tensor->getShape();
+    job.dataType = tensor->getDataType();
+    job.dataTypeSize = tensor->getDataTypeSize();
+    // Get the data here, since loading it is not thread safe.
+    job.data = getRawData(tensor);
+    job.storage = tensor->getSharedStorage();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(job);
+        numPending++;
+    }
+    cv.notify_all();
+}
+
+void OutputWriter::writeOutputs(Operator* op) {
+    if (tensorNames.empty() && op->getOpType() == OpType::Data)
+        return;
+    // The outputs of a fused producer are only in the scratchpads.
+    if (op->getFusedConsumer())
+        return;
+    for (int i = 0; i < op->getOutputs().size(); i++) {
+        Tensor* output = op->getOutput(i);
+        if (!output || output->isDead() || !output->containsData())
+            continue;
+        if (tensorNames.empty() || tensorNames.count(output->getName()))
+            write(output);
+    }
+}
+
+void OutputWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this]() { return numPending == 0; });
+}
+
+void OutputWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (queue.empty())
+            return;
+        Job job = queue.front();
+        queue.pop_front();
+        lock.unlock();
+        writeFile(job);
+        lock.lock();
+        numPending--;
+        cv.notify_all();
+    }
+}
+
+void OutputWriter::writeFile(const Job& job) {
+    std::ofstream file(job.path,
+                       std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open the tensor file: " << job.path << "\n";
+        return;
+    }
+    if (format == Npy)
+        writeNpyHeader(file, job.dataType, job.shape);
+    const TensorShape& shape = job.shape;
+    int ndims = shape.ndims();
+    int rowSize = shape[ndims - 1] * job.dataTypeSize;
+    int rowStorageSize = shape.getStorageDim(ndims - 1) * job.dataTypeSize;
+    if (rowSize == rowStorageSize) {
+        file.write(job.data, (uint64_t)shape.storageSize() * job.dataTypeSize);
+    } else {
+        // Only the innermost dimension is padded, so the elements are written
+        // one row at a time.
+        int numRows = shape.size() / shape[ndims - 1];
+        for (int row = 0; row < numRows; row++)
+            file.write(job.data + (uint64_t)row * rowStorageSize, rowSize);
+    }
+    if (!file)
+        std::cerr << "Failed to write the tensor file: " << job.path << "\n";
+    numFilesWritten++;
+}
+
+}  // namespace smaug
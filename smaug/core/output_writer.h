@@ -0,0 +1,111 @@
+#ifndef _CORE_OUTPUT_WRITER_H_
+#define _CORE_OUTPUT_WRITER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "smaug/core/operator.h"
+#include "smaug/core/tensor.h"
+
+namespace smaug {
+
+/**
+ * OutputWriter dumps the data of tensors into files, in the raw or .npy
+ * format, on a background I/O thread.
+ *
+ * Every tensor is written to its own file in the output directory, named
+ * after the tensor (with '/' replaced by '_'). The data is written straight
+ * from the tensor's storage, without formatting or an intermediate copy; only
+ * the alignment padding is skipped. A raw file holds the elements in storage
+ * order, and a .npy file adds a header with the data type and shape.
+ *
+ * Since the data is not copied, a tensor must not be changed until it has
+ * been written. The Scheduler calls flush() before it runs the network again.
+ * A queued job keeps the storage of its tensor alive, so the tensor may be
+ * freed or evicted from its ParamStore in the meantime.
+ */
+class OutputWriter {
+   public:
+    enum Format { Raw, Npy };
+
+    /**
+     * @param _directory The directory the files are written to.
+     * @param _format The file format.
+     * @param _tensorNames The names of the tensors to write when their
+     * operators run. If empty, the outputs of all the operators except the
+     * Data operators are written.
+     */
+    OutputWriter(const std::string& _directory,
+                 Format _format,
+                 const std::set<std::string>& _tensorNames = {});
+
+    /** Writes the pending tensors and stops the I/O thread. */
+    ~OutputWriter();
+
+    /**
+     * Appends the given suffix to the file names of the tensors written from
+     * now on, e.g. to tell the samples of an input dataset apart.
+     */
+    void setFileSuffix(const std::string& suffix) { fileSuffix = suffix; }
+
+    /** Queues the given tensor to be written. */
+    void write(const Tensor* tensor);
+
+    /**
+     * Queues the outputs of the Operator that should be written. The outputs
+     * of an Operator fused with its consumer are never written to memory, so
+     * they are skipped.
+     */
+    void writeOutputs(Operator* op);
+
+    /** Waits until all the queued tensors have been written. */
+    void flush();
+
+    /** Returns the path of the file the given tensor is written to. */
+    std::string getFilePath(const std::string& tensorName) const;
+
+    /** Returns the number of files written so far. */
+    int getNumFilesWritten() const { return numFilesWritten; }
+
+   protected:
+    /** A tensor queued to be written. */
+    struct Job {
+        std::string path;
+        TensorShape shape;
+        DataType dataType;
+        int dataTypeSize;
+        const char* data;
+        /** Keeps the storage that data points into alive. */
+        std::shared_ptr<const void> storage;
+    };
+
+    /** Writes the queued tensors until the writer is destroyed. */
+    void run();
+
+    /** Writes the tensor of the job into its file. */
+    void writeFile(const Job& job);
+
+    std::string directory;
+    Format format;
+    std::set<std::string> tensorNames;
+    std::string fileSuffix;
+
+    std::deque<Job> queue;
+    /** The number of queued and unfinished jobs. */
+    int numPending;
+    std::atomic<int> numFilesWritten;
+    bool stopping;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+};
+
+}  // namespace smaug
+
+#endif
@@ -0,0 +1,171 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/output_writer.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class OutputWriterTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    ~OutputWriterTest() {
+        for (const auto& path : paths)
+            std::remove(path.c_str());
+    }
+
+    // Returns the contents of the file, or an empty string if it doesn't
+    // exist. The file is removed at the end of the test.
+    std::string readFile(const std::string& path) {
+        paths.push_back(path);
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        return contents.str();
+    }
+
+    std::vector<std::string> paths;
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(OutputWriterTest, "Tensors written to files", "[output]") {
+    // The rows are padded from 3 to 8 elements.
+    TensorShape shape({ 2, 3 }, NC, SmvBackend::Alignment);
+    Tensor* tensor = new Tensor("layer/output", shape);
+    float16* data = tensor->allocateStorage<float16>();
+    for (int i = 0; i < shape.storageSize(); i++)
+        data[i] = fp16(i);
+    workspace()->addTensor(tensor);
+    // Element (i, j) is in storage at i * 8 + j.
+    std::vector<float> expected = { 0, 1, 2, 8, 9, 10 };
+
+    SECTION("Npy format") {
+        {
+            OutputWriter writer(".", OutputWriter::Npy);
+            REQUIRE(writer.getFilePath(tensor->getName()) ==
+                    "./layer_output.npy");
+            writer.write(tensor);
+            writer.flush();
+            REQUIRE(writer.getNumFilesWritten() == 1);
+        }
+        std::string contents = readFile("./layer_output.npy");
+        REQUIRE(contents.compare(0, 6, "\x93NUMPY") == 0);
+        int headerLen = (uint8_t)contents[8] | ((uint8_t)contents[9] << 8);
+        int dataOffset = 10 + headerLen;
+        REQUIRE(dataOffset % 64 == 0);
+        std::string header = contents.substr(10, headerLen);
+        REQUIRE(header.find("'descr': '<f2'") != std::string::npos);
+        REQUIRE(header.find("'shape': (2, 3)") != std::string::npos);
+        REQUIRE(contents.size() == dataOffset + 6 * sizeof(float16));
+        const float16* fileData =
+                reinterpret_cast<const float16*>(contents.data() + dataOffset);
+        for (int i = 0; i < 6; i++)
+            REQUIRE(fp32(fileData[i]) == expected[i]);
+    }
+
+    SECTION("Raw format") {
+        {
+            OutputWriter writer(".", OutputWriter::Raw);
+            writer.setFileSuffix("_3");
+            writer.write(tensor);
+        }
+        std::string contents = readFile("./layer_output_3.bin");
+        REQUIRE(contents.size() == 6 * sizeof(float16));
+        const float16* fileData =
+                reinterpret_cast<const float16*>(contents.data());
+        for (int i = 0; i < 6; i++)
+            REQUIRE(fp32(fileData[i]) == expected[i]);
+    }
+
+    SECTION("The data outlives the tensor") {
+        Tensor* copy = new Tensor("copy", shape);
+        copy->allocateStorage<float16>();
+        copyRawTensorData(copy, tensor, 0, 0, shape.storageSize());
+        {
+            OutputWriter writer(".", OutputWriter::Raw);
+            writer.write(copy);
+            // E.g. a parameter evicted from its ParamStore.
+            delete copy;
+        }
+        std::string contents = readFile("./copy.bin");
+        REQUIRE(contents.size() == 6 * sizeof(float16));
+        const float16* fileData =
+                reinterpret_cast<const float16*>(contents.data());
+        for (int i = 0; i < 6; i++)
+            REQUIRE(fp32(fileData[i]) == expected[i]);
+    }
+}
+
+TEST_CASE_METHOD(OutputWriterTest,
+                 "Operator outputs dumped while the network runs",
+                 "[output]") {
+    TensorShape inputShape({ 1, 256 }, NC, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", inputShape);
+    input->allocateStorage<float16>();
+    fillTensorWithRandomData(input);
+    workspace()->addTensor(input);
+    Tensor* layerInput = input;
+    Operator* prev = nullptr;
+    for (int i = 0; i < 2; i++) {
+        std::string name = "fc" + std::to_string(i);
+        TensorShape shape({ 16, layerInput->getShape()[1] }, NC,
+                          SmvBackend::Alignment);
+        Tensor* weights = new Tensor(name + "/weights", shape);
+        weights->allocateStorage<float16>();
+        fillTensorWithRandomData(weights);
+        workspace()->addTensor(weights);
+        auto fcOp = new SmvInnerProductOp(name, workspace());
+        fcOp->setInput(layerInput, 0);
+        fcOp->setInput(weights, 1);
+        fcOp->setNumOutputs(16);
+        fcOp->createAllTensors();
+        fcOp->getOutput(0)->allocateStorage<float16>();
+        network()->addOperator(fcOp);
+        if (prev)
+            network()->addEdge(prev, fcOp, { 0, 0 });
+        layerInput = fcOp->getOutput(0);
+        prev = fcOp;
+    }
+
+    auto verifyFile = [&](const std::string& name) {
+        std::string contents = readFile("./" + name + ".bin");
+        Tensor* output = workspace()->getTensor(name);
+        REQUIRE(contents.size() == 16 * sizeof(float16));
+        REQUIRE(memcmp(contents.data(), output->data<float16>(),
+                       contents.size()) == 0);
+    };
+
+    SECTION("All the outputs") {
+        OutputWriter writer(".", OutputWriter::Raw);
+        Scheduler scheduler(network(), workspace());
+        scheduler.setOutputWriter(&writer);
+        scheduler.runNetwork();
+        writer.flush();
+        REQUIRE(writer.getNumFilesWritten() == 2);
+        verifyFile("fc0");
+        verifyFile("fc1");
+    }
+
+    SECTION("The named outputs") {
+        OutputWriter writer(".", OutputWriter::Raw, { "fc1" });
+        Scheduler scheduler(network(), workspace());
+        scheduler.setOutputWriter(&writer);
+        scheduler.runNetwork();
+        writer.flush();
+        REQUIRE(writer.getNumFilesWritten() == 1);
+        verifyFile("fc1");
+        REQUIRE(readFile("./fc0.bin").empty());
+    }
+}
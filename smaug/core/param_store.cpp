@@ -0,0 +1,264 @@
+#include <cassert>
+#include <fstream>
+
+#include "smaug/core/param_store.h"
+
+namespace smaug {
+
+namespace {
+
+// The field numbers of TensorDataArray.data_array and TensorData.name.
+const int kDataArrayField = 1;
+const int kNameField = 1;
+
+// The protobuf wire types.
+const int kVarint = 0;
+const int kFixed64 = 1;
+const int kLengthDelimited = 2;
+const int kFixed32 = 5;
+
+// Reads a base-128 varint. Returns false at the end of the input.
+bool readVarint(std::istream& in, uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = in.get();
+        if (byte == std::char_traits<char>::eof())
+            return false;
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Skips the value of a field with the given wire type.
+bool skipField(std::istream& in, int wireType) {
+    uint64_t value;
+    switch (wireType) {
+        case kVarint:
+            return readVarint(in, &value);
+        case kFixed64:
+            return bool(in.seekg(8, std::ios::cur));
+        case kLengthDelimited:
+            return readVarint(in, &value) &&
+                   bool(in.seekg(value, std::ios::cur));
+        case kFixed32:
+            return bool(in.seekg(4, std::ios::cur));
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+ParamStore::ParamStore(const std::string& _path, uint64_t _memoryBudget)
+        : path(_path), memoryBudget(_memoryBudget), residentBytes(0),
+          numReads(0) {
+    valid = buildIndex();
+}
+
+ParamStore::~ParamStore() {
+    // Wait for the prefetches, and leave the tensors with the data they have
+    // in memory.
+    for (auto& tensorEntry : entries) {
+        Entry& entry = tensorEntry.second;
+        if (entry.prefetched.valid())
+            entry.prefetched.wait();
+        entry.tensor->paramStore = nullptr;
+    }
+}
+
+bool ParamStore::buildIndex() {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    in.seekg(0, std::ios::end);
+    uint64_t fileSize = in.tellg();
+    in.seekg(0);
+    // The file is a TensorDataArray. Instead of parsing it, we only look up
+    // where each TensorData is and read its name.
+    uint64_t tag;
+    while ((uint64_t)in.tellg() < fileSize) {
+        if (!readVarint(in, &tag))
+            return false;
+        if (tag >> 3 != kDataArrayField || (tag & 7) != kLengthDelimited) {
+            if (!skipField(in, tag & 7))
+                return false;
+            continue;
+        }
+        uint64_t size;
+        if (!readVarint(in, &size))
+            return false;
+        FileRange range = { (uint64_t)in.tellg(), size };
+        if (range.offset + range.size > fileSize)
+            return false;
+        std::string name;
+        while ((uint64_t)in.tellg() < range.offset + range.size) {
+            if (!readVarint(in, &tag))
+                return false;
+            if (tag >> 3 == kNameField && (tag & 7) == kLengthDelimited) {
+                uint64_t length;
+                if (!readVarint(in, &length))
+                    return false;
+                name.resize(length);
+                in.read(&name[0], length);
+                break;
+            }
+            if (!skipField(in, tag & 7))
+                return false;
+        }
+        // Like a lookup in the parsed array, the first tensor with the name
+        // wins.
+        index.emplace(name, range);
+        in.seekg(range.offset + range.size);
+    }
+    return (uint64_t)in.tellg() == fileSize;
+}
+
+TensorData ParamStore::readRange(const FileRange& range) const {
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(range.offset);
+    std::string bytes(range.size, 0);
+    in.read(&bytes[0], range.size);
+    TensorData tensorData;
+    bool parsed = in && tensorData.ParseFromString(bytes);
+    assert(parsed && "Failed to read the tensor data from the parameters!");
+    numReads++;
+    return tensorData;
+}
+
+TensorData ParamStore::read(const std::string& name) const {
+    auto it = index.find(name);
+    if (it == index.end())
+        return TensorData();
+    return readRange(it->second);
+}
+
+std::shared_ptr<void> ParamStore::readStorage(const Tensor* tensor,
+                                              const FileRange& range) const {
+    // This may run on a prefetch thread, so the data is unpacked into a
+    // separate Tensor.
+    Tensor staging(tensor->getName(), tensor->getShape());
+    staging.fillData(tensor->getDataType(), readRange(range));
+    return staging.tensorData;
+}
+
+void ParamStore::addTensor(Tensor* tensor) {
+    auto it = index.find(tensor->getName());
+    assert(it != index.end() && "The parameters have no data for the tensor!");
+    Entry& entry = entries[tensor];
+    entry.tensor = tensor;
+    entry.range = it->second;
+    entry.bytes = (uint64_t)tensor->getShape().storageSize() *
+                  tensor->getDataTypeSize();
+    tensor->paramStore = this;
+}
+
+void ParamStore::removeTensor(Tensor* tensor) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(tensor);
+    if (it == entries.end())
+        return;
+    Entry& entry = it->second;
+    if (entry.prefetched.valid()) {
+        tensor->tensorData = entry.prefetched.get();
+        residentBytes -= entry.bytes;
+    } else if (entry.resident) {
+        lru.erase(entry.lruPos);
+        residentBytes -= entry.bytes;
+    }
+    residentBytes -= entry.tileBytes;
+    tensor->paramStore = nullptr;
+    entries.erase(it);
+}
+
+void ParamStore::addTile(Tensor* tensor, Tensor* tile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = entries.at(tensor);
+    uint64_t bytes =
+            (uint64_t)tile->getShape().storageSize() * tile->getDataTypeSize();
+    // The Tensor is about to be read to fill the tile.
+    evictFor(bytes, &entry);
+    entry.tiles.push_back(tile);
+    entry.tileBytes += bytes;
+    residentBytes += bytes;
+}
+
+void ParamStore::load(Tensor* tensor) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = entries.at(tensor);
+    if (entry.resident) {
+        lru.splice(lru.end(), lru, entry.lruPos);
+        return;
+    }
+    if (entry.prefetched.valid()) {
+        // The prefetched bytes are already accounted for.
+        tensor->tensorData = entry.prefetched.get();
+    } else {
+        evictFor(entry.bytes);
+        tensor->tensorData = readStorage(tensor, entry.range);
+        residentBytes += entry.bytes;
+    }
+    entry.resident = true;
+    entry.lruPos = lru.insert(lru.end(), tensor);
+}
+
+void ParamStore::pin(const std::vector<TensorBase*>& tensors) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& tensorEntry : entries)
+        tensorEntry.second.pinned = false;
+    for (TensorBase* tensor : tensors) {
+        auto it = entries.find(tensor);
+        if (it != entries.end())
+            it->second.pinned = true;
+    }
+}
+
+void ParamStore::prefetch(const std::vector<TensorBase*>& tensors) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (TensorBase* tensor : tensors) {
+        auto it = entries.find(tensor);
+        if (it == entries.end())
+            continue;
+        Entry& entry = it->second;
+        if (entry.resident || entry.prefetched.valid())
+            continue;
+        evictFor(entry.bytes);
+        residentBytes += entry.bytes;
+        entry.prefetched = std::async(std::launch::async,
+                                      &ParamStore::readStorage,
+                                      this,
+                                      entry.tensor,
+                                      entry.range);
+    }
+}
+
+bool ParamStore::isResident(const Tensor* tensor) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(tensor);
+    return it != entries.end() && it->second.resident;
+}
+
+void ParamStore::evictFor(uint64_t bytes, const Entry* keep) {
+    if (memoryBudget == 0)
+        return;
+    auto it = lru.begin();
+    while (residentBytes + bytes > memoryBudget && it != lru.end()) {
+        Entry& entry = entries.at(*it);
+        if (entry.pinned || &entry == keep) {
+            ++it;
+            continue;
+        }
+        entry.tensor->tensorData.reset();
+        entry.resident = false;
+        residentBytes -= entry.bytes;
+        for (Tensor* tile : entry.tiles)
+            tile->tensorData.reset();
+        entry.tiles.clear();
+        residentBytes -= entry.tileBytes;
+        entry.tileBytes = 0;
+        it = lru.erase(it);
+    }
+}
+
+}  // namespace smaug
@@ -0,0 +1,182 @@
+#ifndef _CORE_PARAM_STORE_H_
+#define _CORE_PARAM_STORE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "smaug/core/tensor.h"
+#include "smaug/core/tensor.pb.h"
+
+namespace smaug {
+
+/**
+ * ParamStore loads the parameters of a network from the model parameters file
+ * on demand, so that models whose parameters don't fit in host memory can
+ * still run.
+ *
+ * On construction, the store only scans the serialized TensorDataArray and
+ * records where in the file the data of every tensor is. A Tensor added to
+ * the store has no data until it is first accessed through Tensor::data() (or
+ * copied into tiles, which does the same), at which point its data is read
+ * from the file. Once the loaded tensors take more than the memory budget,
+ * the least recently used ones are evicted and get reloaded when they are
+ * accessed again. The tiles filled from a Tensor in the store count towards
+ * the budget too, and are evicted along with it. Since an evicted Tensor is
+ * simply reloaded, the data of a Tensor in the store must be treated as
+ * read-only.
+ *
+ * The scheduler pins the parameters of the operator that is running, so that
+ * they are not evicted under it, and prefetches the parameters of the next
+ * operator on a background thread. The budget is a soft limit: the pinned
+ * parameters stay in memory even if they alone exceed it.
+ *
+ * Tensors in the store may be accessed from the thread pool while an operator
+ * runs, but operators running concurrently (e.g. in pipeline stages) are not
+ * supported.
+ */
+class ParamStore {
+   public:
+    /**
+     * Indexes the given model parameters file.
+     *
+     * @param path The path to the serialized TensorDataArray.
+     * @param memoryBudget The bytes the loaded tensors may take before the
+     * least recently used ones are evicted. Zero means no limit.
+     */
+    ParamStore(const std::string& path, uint64_t memoryBudget = 0);
+    ~ParamStore();
+
+    /** Returns false if the file could not be opened or parsed. */
+    bool isValid() const { return valid; }
+
+    /** Returns true if the file has data for the tensor with this name. */
+    bool contains(const std::string& name) const {
+        return index.find(name) != index.end();
+    }
+
+    /**
+     * Reads the data of the named tensor from the file. If the file has no
+     * data for it, the returned TensorData is empty.
+     */
+    TensorData read(const std::string& name) const;
+
+    /**
+     * Makes the given Tensor load its data from the file on first access. The
+     * file must have data for it.
+     */
+    void addTensor(Tensor* tensor);
+
+    /**
+     * Makes the given Tensor keep its data in memory instead, e.g. because
+     * the data is replaced by something else than the parameters. The Tensor
+     * keeps the data it has loaded, if any.
+     */
+    void removeTensor(Tensor* tensor);
+
+    /**
+     * Counts the storage of a tile filled from the given Tensor as part of the
+     * Tensor. The tile is freed when the Tensor is evicted, and filled again
+     * when it is next used.
+     */
+    void addTile(Tensor* tensor, Tensor* tile);
+
+    /**
+     * Ensures that the data of the Tensor is in memory, loading it if needed,
+     * and marks it as the most recently used. This is called by
+     * Tensor::data().
+     */
+    void load(Tensor* tensor);
+
+    /**
+     * Pins the given tensors, which are not evicted until the next call. The
+     * tensors that are not in the store are ignored.
+     */
+    void pin(const std::vector<TensorBase*>& tensors);
+
+    /**
+     * Starts loading the given tensors on a background thread, if they are
+     * not in memory already. The tensors that are not in the store are
+     * ignored.
+     */
+    void prefetch(const std::vector<TensorBase*>& tensors);
+
+    /** Returns true if the data of the Tensor is in memory. */
+    bool isResident(const Tensor* tensor) const;
+
+    /** Returns the bytes of the tensors in memory or being prefetched. */
+    uint64_t getResidentBytes() const { return residentBytes; }
+
+    uint64_t getMemoryBudget() const { return memoryBudget; }
+
+    /** Returns how many times tensor data was read from the file. */
+    int getNumReads() const { return numReads; }
+
+   protected:
+    /** Where the serialized TensorData of a tensor is in the file. */
+    struct FileRange {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    /** The residency of a Tensor added to the store. */
+    struct Entry {
+        Tensor* tensor = nullptr;
+        FileRange range;
+        /** The bytes of the Tensor's storage. */
+        uint64_t bytes = 0;
+        bool resident = false;
+        bool pinned = false;
+        /** The tiles filled from the Tensor, which are evicted with it. */
+        std::vector<Tensor*> tiles;
+        /** The bytes of the storage of the tiles. */
+        uint64_t tileBytes = 0;
+        /** The storage being read by a prefetch, if any. */
+        std::future<std::shared_ptr<void>> prefetched;
+        /** The position in the LRU list if resident. */
+        std::list<Tensor*>::iterator lruPos;
+    };
+
+    /** Scans the TensorDataArray in the file to build the index. */
+    bool buildIndex();
+
+    /** Reads and parses the serialized TensorData in the given range. */
+    TensorData readRange(const FileRange& range) const;
+
+    /** Reads the data of the Tensor into new storage. */
+    std::shared_ptr<void> readStorage(const Tensor* tensor,
+                                      const FileRange& range) const;
+
+    /**
+     * Evicts the least recently used unpinned tensors, and their tiles, until
+     * the given bytes fit in the budget, or nothing more can be evicted. The
+     * given entry, if any, is kept.
+     */
+    void evictFor(uint64_t bytes, const Entry* keep = nullptr);
+
+    std::string path;
+    uint64_t memoryBudget;
+    bool valid;
+
+    /** The file ranges of all the tensors in the file, by name. */
+    std::map<std::string, FileRange> index;
+
+    std::map<const TensorBase*, Entry> entries;
+    /** The resident tensors, from the least to the most recently used. */
+    std::list<Tensor*> lru;
+    uint64_t residentBytes;
+    mutable std::atomic<int> numReads;
+
+    /** Guards the entries, since tile copies may load from worker threads. */
+    mutable std::mutex mutex;
+};
+
+}  // namespace smaug
+
+#endif
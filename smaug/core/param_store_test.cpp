@@ -0,0 +1,308 @@
+#include <cstdio>
+#include <fstream>
+
+#include <google/protobuf/text_format.h>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/graph.pb.h"
+#include "smaug/core/network_builder.h"
+#include "smaug/core/node.pb.h"
+#include "smaug/core/param_store.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/core/tensor_utils.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+#include "smaug/utility/thread_pool.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class ParamStoreTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    ~ParamStoreTest() { std::remove(kParamsFile); }
+
+    static constexpr const char* kParamsFile = "param_store_test_params.pb";
+
+    TensorProto getTensorProto(const std::string& name,
+                               const TensorShape& shape,
+                               DataType dataType) {
+        TensorProto tensorProto;
+        tensorProto.set_name(name);
+        tensorProto.set_data_type(dataType);
+        TensorShape protoShape = shape;
+        tensorProto.set_allocated_shape(protoShape.asTensorShapeProto());
+        return tensorProto;
+    }
+
+    // Writes float32 tensors of the given size to the parameters file. The
+    // elements of the i-th tensor are i * 100 plus their index.
+    void writeFloatParams(const std::vector<std::string>& names, int size) {
+        TensorDataArray tensorDataArray;
+        for (int i = 0; i < names.size(); i++) {
+            TensorData* tensorData = tensorDataArray.add_data_array();
+            tensorData->set_name(names[i]);
+            for (int j = 0; j < size; j++)
+                tensorData->add_float_data(i * 100 + j);
+        }
+        writeParams(tensorDataArray);
+    }
+
+    void writeParams(const TensorDataArray& tensorDataArray) {
+        std::fstream paramsFile(kParamsFile,
+                                std::ios::out | std::ios::trunc |
+                                        std::ios::binary);
+        REQUIRE(tensorDataArray.SerializeToOstream(&paramsFile));
+    }
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(ParamStoreTest, "Parameters loaded on demand", "[params]") {
+    const int size = 16;
+    const uint64_t bytes = size * sizeof(float);
+    std::vector<std::string> names = { "a", "b", "c" };
+    writeFloatParams(names, size);
+    // The budget fits two of the tensors.
+    ParamStore store(kParamsFile, 2 * bytes);
+    REQUIRE(store.isValid());
+    REQUIRE(store.contains("b"));
+    REQUIRE(!store.contains("d"));
+    std::vector<Tensor*> tensors;
+    for (const auto& name : names) {
+        TensorShape shape({ 1, size }, NC);
+        Tensor* tensor = new Tensor(getTensorProto(name, shape, Float32));
+        workspace()->addTensor(tensor);
+        store.addTensor(tensor);
+        tensors.push_back(tensor);
+    }
+    Tensor* a = tensors[0];
+    Tensor* b = tensors[1];
+    Tensor* c = tensors[2];
+
+    SECTION("Tensors are read when they are first accessed") {
+        REQUIRE(store.getNumReads() == 0);
+        REQUIRE(a->containsData());
+        REQUIRE(!store.isResident(a));
+        REQUIRE(a->data<float>()[3] == 3);
+        REQUIRE(store.isResident(a));
+        REQUIRE(b->data<float>()[0] == 100);
+        REQUIRE(a->data<float>()[15] == 15);
+        REQUIRE(store.getNumReads() == 2);
+        REQUIRE(store.getResidentBytes() == 2 * bytes);
+        REQUIRE(store.read("c").float_data(1) == 201);
+    }
+
+    SECTION("The least recently used tensors are evicted") {
+        a->data<float>();
+        b->data<float>();
+        a->data<float>();
+        REQUIRE(c->data<float>()[2] == 202);
+        REQUIRE(store.isResident(a));
+        REQUIRE(!store.isResident(b));
+        REQUIRE(store.isResident(c));
+        REQUIRE(store.getResidentBytes() == 2 * bytes);
+        // An evicted tensor is read again.
+        REQUIRE(b->data<float>()[2] == 102);
+        REQUIRE(!store.isResident(a));
+        REQUIRE(store.getNumReads() == 4);
+    }
+
+    SECTION("Pinned tensors are not evicted") {
+        store.pin({ a, b });
+        c->data<float>();
+        a->data<float>();
+        b->data<float>();
+        // Only the unpinned tensor can make room.
+        REQUIRE(!store.isResident(c));
+        REQUIRE(c->data<float>()[0] == 200);
+        REQUIRE(store.isResident(a));
+        REQUIRE(store.isResident(b));
+        REQUIRE(store.getResidentBytes() == 3 * bytes);
+    }
+
+    SECTION("Prefetched tensors are read in the background") {
+        store.prefetch({ b, c });
+        REQUIRE(store.getResidentBytes() == 2 * bytes);
+        REQUIRE(c->data<float>()[5] == 205);
+        REQUIRE(b->data<float>()[5] == 105);
+        REQUIRE(store.getNumReads() == 2);
+        // Prefetching resident tensors does nothing.
+        store.prefetch({ b });
+        REQUIRE(store.getNumReads() == 2);
+    }
+
+    SECTION("Tiles are copied from the parameters on demand") {
+        TensorShape tileShape({ 1, 8 }, NC);
+        auto fcOp = new SmvInnerProductOp("fc", workspace());
+        TiledTensor tiles = generateTiledTensorPerBatchNC(b, tileShape, fcOp);
+        REQUIRE(store.getNumReads() == 0);
+        REQUIRE(tiles.getTileWithData(1)->data<float>()[0] == 108);
+        REQUIRE(store.getNumReads() == 1);
+        delete fcOp;
+    }
+
+    SECTION("Tiles are evicted together with their tensor") {
+        TensorShape tileShape({ 1, 8 }, NC);
+        auto fcOp = new SmvInnerProductOp("fc", workspace());
+        TiledTensor bTiles = generateTiledTensorPerBatchNC(b, tileShape, fcOp);
+        TiledTensor cTiles = generateTiledTensorPerBatchNC(c, tileShape, fcOp);
+        // The tiles only get storage when they are filled.
+        REQUIRE(!bTiles[0]->containsData());
+        bTiles.copyDataToAllTiles();
+        // b and its tiles take the whole budget.
+        REQUIRE(store.getResidentBytes() == 2 * bytes);
+        REQUIRE(cTiles.getTileWithData(1)->data<float>()[0] == 208);
+        REQUIRE(store.getResidentBytes() <= 2 * bytes);
+        REQUIRE(!store.isResident(b));
+        REQUIRE(!bTiles[0]->containsData());
+        REQUIRE(!bTiles[1]->containsData());
+        // The evicted tiles are filled again.
+        REQUIRE(bTiles.getTileWithData(0)->data<float>()[7] == 107);
+        REQUIRE(store.getResidentBytes() <= 2 * bytes);
+        bTiles.copyDataToAllTiles();
+        REQUIRE(bTiles[1]->data<float>()[0] == 108);
+        REQUIRE(store.getResidentBytes() <= 2 * bytes);
+        delete fcOp;
+    }
+}
+
+TEST_CASE_METHOD(ParamStoreTest,
+                 "Network with parameters loaded on demand",
+                 "[params]") {
+    // Two FC layers. The weights of the first need multiple tiles.
+    const std::vector<int> numNeurons = { 128, 64 };
+    const std::vector<int> numInputs = { 256, 128 };
+    TensorDataArray tensorDataArray;
+    std::vector<TensorProto> weightsProtos;
+    for (int i = 0; i < 2; i++) {
+        TensorShape shape({ numNeurons[i], numInputs[i] }, NC,
+                          SmvBackend::Alignment);
+        std::string name = "fc" + std::to_string(i) + "/weights";
+        Tensor weights(name, shape);
+        weights.allocateStorage<float16>();
+        fillTensorWithRandomData(&weights);
+        TensorProto* tensorProto = weights.asTensorProto();
+        TensorData* tensorData = tensorDataArray.add_data_array();
+        *tensorData = tensorProto->data();
+        tensorData->set_name(name);
+        tensorProto->clear_data();
+        weightsProtos.push_back(*tensorProto);
+        delete tensorProto;
+    }
+    writeParams(tensorDataArray);
+
+    TensorShape inputShape({ 1, 256 }, NC, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", inputShape);
+    input->allocateStorage<float16>();
+    fillTensorWithRandomData(input);
+    workspace()->addTensor(input);
+
+    // Builds the layers in the network, with the weights read from the
+    // parameters file at once, or on demand from the store.
+    auto buildLayers = [&](Network* network, ParamStore* store) {
+        std::string prefix = store ? "lazy/" : "eager/";
+        ParamStore reader(kParamsFile);
+        Tensor* layerInput = input;
+        Operator* prev = nullptr;
+        for (int i = 0; i < 2; i++) {
+            auto fcOp = new SmvInnerProductOp(
+                    prefix + "fc" + std::to_string(i), workspace());
+            Tensor* weights;
+            if (store) {
+                weights = new Tensor(weightsProtos[i]);
+                store->addTensor(weights);
+            } else {
+                TensorProto tensorProto = weightsProtos[i];
+                tensorProto.set_name(prefix + tensorProto.name());
+                weights = new Tensor(tensorProto,
+                                     reader.read(weightsProtos[i].name()));
+            }
+            workspace()->addTensor(weights);
+            fcOp->setInput(layerInput, 0);
+            fcOp->setInput(weights, 1);
+            fcOp->setNumOutputs(numNeurons[i]);
+            fcOp->createAllTensors();
+            fcOp->getOutput(0)->allocateStorage<float16>();
+            network->addOperator(fcOp);
+            if (prev)
+                network->addEdge(prev, fcOp, { 0, 0 });
+            layerInput = fcOp->getOutput(0);
+            prev = fcOp;
+        }
+    };
+
+    buildLayers(network(), nullptr);
+    Scheduler scheduler(network(), workspace());
+    Tensor* expected = scheduler.runNetwork();
+
+    Network lazyNetwork("lazy");
+    // The budget only fits the weights of the second layer.
+    ParamStore* store = new ParamStore(kParamsFile, 64 * 128 * 2);
+    lazyNetwork.setParamStore(store);
+    buildLayers(&lazyNetwork, store);
+    REQUIRE(store->getNumReads() == 0);
+    Scheduler lazyScheduler(&lazyNetwork, workspace());
+    Tensor* output = lazyScheduler.runNetwork();
+    verifyOutputs<float16>(output, expected);
+    // Every layer read its weights once: not during the tiling, and the
+    // weights of the second layer were prefetched.
+    REQUIRE(store->getNumReads() == 2);
+}
+
+TEST_CASE_METHOD(ParamStoreTest,
+                 "Parameters decoded on the thread pool",
+                 "[params]") {
+    const char* topoFile = "param_store_test_topo.pbtxt";
+    // Data nodes of different sizes, so that the threads get different
+    // numbers of them.
+    const int numTensors = 7;
+    GraphProto graph;
+    graph.set_name("params");
+    graph.set_backend(ReferenceBackend::Name);
+    graph.set_mem_policy(AllDma);
+    TensorDataArray tensorDataArray;
+    for (int i = 0; i < numTensors; i++) {
+        std::string name = "param" + std::to_string(i);
+        TensorShape shape({ 1, 8 << i }, NC);
+        NodeProto* node = graph.add_nodes();
+        node->set_name(name);
+        node->set_op(OpType::Data);
+        *node->add_input_tensors() = getTensorProto(name, shape, Float32);
+        *node->add_output_tensors() = getTensorProto(name, shape, Float32);
+        TensorData* tensorData = tensorDataArray.add_data_array();
+        tensorData->set_name(name);
+        for (int j = 0; j < shape.size(); j++)
+            tensorData->add_float_data(i * 1000 + j);
+    }
+    writeParams(tensorDataArray);
+    std::string topo;
+    google::protobuf::TextFormat::PrintToString(graph, &topo);
+    std::ofstream(topoFile) << topo;
+
+    threadPool = new ThreadPool(3);
+    threadPool->initThreadPool();
+    delete network_;
+    SamplingInfo sampling = { NoSampling, 1 };
+    network_ =
+            smaug::buildNetwork(topoFile, kParamsFile, sampling, workspace());
+    delete threadPool;
+    threadPool = nullptr;
+    std::remove(topoFile);
+
+    for (int i = 0; i < numTensors; i++) {
+        std::string name = "param" + std::to_string(i);
+        Tensor* tensor = workspace()->getTensor(name);
+        REQUIRE(network()->getOperator(name)->getInput(0) == tensor);
+        const float* data = tensor->data<float>();
+        bool matches = true;
+        for (int j = 0; j < tensor->getShape().size(); j++)
+            matches = matches && data[j] == i * 1000 + j;
+        REQUIRE(matches);
+    }
+}
@@ -6,6 +6,8 @@ opPinMap tensorPinMap{};
 opTensorMap opToTensorMap{};
 std::map<TensorBase*, spmOffset> tensorOffsetMap{};
 std::map<TensorBase*, spmId> tensorSPMap{};
+opTilePinMap tilePinMap{};
+std::map<Tensor*, spmId> tileSPMap{};
 
 SPManager::SPManager()
 {
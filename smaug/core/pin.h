@@ -14,10 +14,17 @@ using opTensorMap = std::map<std::string, std::vector<TensorBase*>>;
 using spmId = uint8_t;
 using spmOffset = uint32_t;
 
+using opTilePinMap = std::map<Operator*, std::vector<Tensor*>>;
+
 extern opPinMap tensorPinMap;
 extern opTensorMap opToTensorMap;
 extern std::map<TensorBase*, spmOffset> tensorOffsetMap;
 extern std::map<TensorBase*, spmId> tensorSPMap;
+// Tile granularity counterparts of tensorPinMap and tensorSPMap. For every
+// operator, the tiles that are already resident on a scratchpad when the
+// operator reads them, and for every pinned tile, the scratchpad it stays on.
+extern opTilePinMap tilePinMap;
+extern std::map<Tensor*, spmId> tileSPMap;
 
 class SPManager {
     public:
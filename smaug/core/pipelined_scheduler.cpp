@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "smaug/core/globals.h"
+#include "smaug/core/pipelined_scheduler.h"
+#include "smaug/core/tensor.h"
+#include "smaug/core/tensor_utils.h"
+#include "smaug/core/types.pb.h"
+#include "smaug/utility/debug_stream.h"
+
+namespace smaug {
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+Tensor* PipelinedScheduler::runNetwork() {
+    // The stages and the handoff tensors must be in place before the
+    // operators are tiled, as the consumers tile their handoff inputs.
+    createStages(getScheduleOrder());
+    createBoundaries();
+    prepareNetwork();
+    orderFusedOperators();
+
+    std::cout << "======================================================\n";
+    std::cout << "      Scheduling operators of the network in "
+              << stages.size() << " pipeline stages...\n";
+    std::cout << "======================================================\n";
+    double totalSeconds;
+    {
+        auto stats =
+                gem5::ScopedStats(stats::kNetworkStart, stats::kNetworkEnd);
+        for (Operator* op : dataOps)
+            maybeRunOperator(op);
+        Clock::time_point start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < stages.size(); i++)
+            threads.emplace_back(&PipelinedScheduler::runStage, this, i);
+        for (auto& thread : threads)
+            thread.join();
+        totalSeconds = secondsSince(start);
+    }
+    printStageReport(totalSeconds);
+    if (reportEstimatedCycles)
+        printStageCycles();
+    return getSink()->getOutput(0);
+}
+
+std::vector<Operator*> PipelinedScheduler::getScheduleOrder() {
+    readyQueue.clear();
+    for (auto nameOp : network->getOperators()) {
+        Operator* op = nameOp.second;
+        Vertex vertex = op->getVertex();
+        int numPendingInputs = boost::in_degree(vertex, network->getGraph());
+        op->setNumPendingInputs(numPendingInputs);
+        if (numPendingInputs == 0)
+            readyQueue.push_back(op);
+    }
+    sortReadyQueue(readyQueue.begin());
+    for (auto it = readyQueue.begin(); it != readyQueue.end(); ++it) {
+        updateChildren(*it);
+        sortReadyQueue(std::next(it));
+    }
+    std::vector<Operator*> order(readyQueue.begin(), readyQueue.end());
+    readyQueue.clear();
+    return order;
+}
+
+uint64_t PipelinedScheduler::getOperatorCost(Operator* op) const {
+    uint64_t cost = 0;
+    for (auto input : op->getInputs())
+        cost += input->getShape().storageSize();
+    for (auto output : op->getOutputs())
+        cost += output->getShape().storageSize();
+    return cost;
+}
+
+void PipelinedScheduler::createStages(const std::vector<Operator*>& order) {
+    std::vector<Operator*> ops;
+    for (Operator* op : order) {
+        if (op->getOpType() == OpType::Data)
+            dataOps.push_back(op);
+        else
+            ops.push_back(op);
+    }
+    int n = ops.size();
+    if (n < numStages) {
+        std::cout << "The network only has " << n
+                  << " operators to pipeline, using as many stages.\n";
+        numStages = n;
+    }
+    assert(numStages > 0 && "The network has no operators to pipeline!");
+    assert(numStages <= numAcceleratorsAvailable &&
+           "Every pipeline stage needs its own accelerator!");
+
+    // best[k][i] is the lowest cost of the most expensive stage when the
+    // first i operators are split into k stages, and the last of those stages
+    // starts at cut[k][i].
+    std::vector<uint64_t> prefix(n + 1, 0);
+    for (int i = 0; i < n; i++)
+        prefix[i + 1] = prefix[i] + getOperatorCost(ops[i]);
+    std::vector<std::vector<uint64_t>> best(
+            numStages + 1, std::vector<uint64_t>(n + 1, UINT64_MAX));
+    std::vector<std::vector<int>> cut(numStages + 1, std::vector<int>(n + 1));
+    best[0][0] = 0;
+    for (int k = 1; k <= numStages; k++) {
+        for (int i = k; i <= n; i++) {
+            for (int j = k - 1; j < i; j++) {
+                if (best[k - 1][j] == UINT64_MAX)
+                    continue;
+                uint64_t cost =
+                        std::max(best[k - 1][j], prefix[i] - prefix[j]);
+                if (cost < best[k][i]) {
+                    best[k][i] = cost;
+                    cut[k][i] = j;
+                }
+            }
+        }
+    }
+    stages.assign(numStages, Stage());
+    for (int k = numStages, i = n; k > 0; i = cut[k][i], k--) {
+        Stage& stage = stages[k - 1];
+        stage.ops.assign(ops.begin() + cut[k][i], ops.begin() + i);
+        stage.cost = prefix[i] - prefix[cut[k][i]];
+    }
+
+    // Every stage gets the same number of accelerators, and the ones left
+    // over go to the most expensive stages.
+    std::vector<int> byCost(numStages);
+    for (int i = 0; i < numStages; i++)
+        byCost[i] = i;
+    std::stable_sort(byCost.begin(), byCost.end(), [&](int a, int b) {
+        return stages[a].cost > stages[b].cost;
+    });
+    for (int i = 0; i < numStages; i++) {
+        stages[byCost[i]].numAccelerators =
+                numAcceleratorsAvailable / numStages +
+                (i < numAcceleratorsAvailable % numStages ? 1 : 0);
+    }
+    int firstAccelerator = 0;
+    for (auto& stage : stages) {
+        stage.firstAccelerator = firstAccelerator;
+        firstAccelerator += stage.numAccelerators;
+        for (Operator* op : stage.ops) {
+            op->setAcceleratorRange(
+                    stage.firstAccelerator, stage.numAccelerators);
+        }
+    }
+}
+
+void PipelinedScheduler::createBoundaries() {
+    std::map<TensorBase*, int> producerStage;
+    for (int i = 0; i < stages.size(); i++) {
+        for (Operator* op : stages[i].ops) {
+            for (auto output : op->getOutputs())
+                producerStage[output] = i;
+        }
+    }
+    for (int i = 0; i < stages.size(); i++) {
+        // All the consumers in a stage share one handoff copy.
+        std::map<TensorBase*, Tensor*> handoffs;
+        for (Operator* op : stages[i].ops) {
+            for (int j = 0; j < op->getInputs().size(); j++) {
+                TensorBase* input = op->getInputs()[j];
+                auto it = producerStage.find(input);
+                if (it == producerStage.end() || it->second == i)
+                    continue;
+                assert(it->second < i &&
+                       "Stages must follow the schedule order!");
+                Tensor*& handoff = handoffs[input];
+                if (!handoff) {
+                    Tensor* source = op->getInput(j);
+                    handoff = new Tensor(source->getName() + "_stage" +
+                                                 std::to_string(i),
+                                         source->getShape());
+                    handoff->allocateStorage(source->getDataType());
+                    workspace->addTensor(handoff);
+                    Boundary boundary;
+                    boundary.source = source;
+                    boundary.handoff = handoff;
+                    boundary.producerStage = it->second;
+                    boundary.consumerStage = i;
+                    boundaries.push_back(boundary);
+                }
+                op->setInput(handoff, j);
+            }
+        }
+    }
+}
+
+void PipelinedScheduler::orderFusedOperators() {
+    for (auto& stage : stages) {
+        std::set<Operator*> placed;
+        std::vector<Operator*> ops;
+        for (Operator* op : stage.ops) {
+            if (placed.count(op))
+                continue;
+            for (; op; op = op->getFusedConsumer()) {
+                assert(std::find(stage.ops.begin(), stage.ops.end(), op) !=
+                               stage.ops.end() &&
+                       "Fused operators must be in the same stage!");
+                ops.push_back(op);
+                placed.insert(op);
+            }
+        }
+        stage.ops = ops;
+    }
+}
+
+void PipelinedScheduler::runStage(int stageIdx) {
+    Stage& stage = stages[stageIdx];
+    for (int batch = 0; batch < numBatches; batch++) {
+        Clock::time_point waitStart = Clock::now();
+        {
+            // Wait for our inputs of this batch, and for the next stages to
+            // take their copies of our outputs of the last batch.
+            std::unique_lock<std::mutex> lock(boundaryMutex);
+            boundaryCv.wait(lock, [&]() {
+                for (const auto& boundary : boundaries) {
+                    if (boundary.consumerStage == stageIdx &&
+                        boundary.produced <= batch)
+                        return false;
+                    if (boundary.producerStage == stageIdx &&
+                        boundary.consumed < batch)
+                        return false;
+                }
+                return true;
+            });
+        }
+        stage.stallSeconds += secondsSince(waitStart);
+
+        Clock::time_point runStart = Clock::now();
+        for (auto& boundary : boundaries) {
+            if (boundary.consumerStage != stageIdx)
+                continue;
+            copyRawTensorData(boundary.handoff, boundary.source, 0, 0,
+                              boundary.source->getShape().storageSize());
+            boundary.handoff->setDead(boundary.source->isDead());
+            boundary.handoff->bumpDataVersion();
+        }
+        {
+            std::lock_guard<std::mutex> lock(boundaryMutex);
+            for (auto& boundary : boundaries) {
+                if (boundary.consumerStage == stageIdx)
+                    boundary.consumed++;
+            }
+        }
+        boundaryCv.notify_all();
+
+        std::unique_lock<std::mutex> kernelLock(
+                nativeKernelMutex, std::defer_lock);
+        for (Operator* op : stage.ops) {
+            dout(0) << "Scheduling " << op->getName() << " ("
+                    << OpType_Name(op->getOpType()) << ") in stage "
+                    << stageIdx << ", batch " << batch << ".\n";
+            if (!runningInSimulation && !kernelLock.owns_lock())
+                kernelLock.lock();
+            maybeRunOperator(op);
+            // A fused consumer finds its inputs in the scratchpads, so
+            // nothing else may run in between.
+            if (kernelLock.owns_lock() && !op->getFusedConsumer())
+                kernelLock.unlock();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(boundaryMutex);
+            for (auto& boundary : boundaries) {
+                if (boundary.producerStage == stageIdx)
+                    boundary.produced++;
+            }
+        }
+        boundaryCv.notify_all();
+        stage.busySeconds += secondsSince(runStart);
+    }
+}
+
+Operator* PipelinedScheduler::getSink() const {
+    const Graph& graph = network->getGraph();
+    for (auto stage = stages.rbegin(); stage != stages.rend(); ++stage) {
+        for (auto op = stage->ops.rbegin(); op != stage->ops.rend(); ++op) {
+            if (boost::out_degree((*op)->getVertex(), graph) == 0)
+                return *op;
+        }
+    }
+    assert(false && "The network has no output!");
+    return nullptr;
+}
+
+void PipelinedScheduler::printStageReport(double totalSeconds) const {
+    std::cout << "Ran " << numBatches << " batches through "
+              << stages.size() << " pipeline stages in " << totalSeconds
+              << " s.\n";
+    for (int i = 0; i < stages.size(); i++) {
+        const Stage& stage = stages[i];
+        std::cout << "  Stage " << i << ": " << stage.ops.size()
+                  << " operators (" << stage.ops.front()->getName() << " to "
+                  << stage.ops.back()->getName() << "), accelerators "
+                  << stage.firstAccelerator << " to "
+                  << stage.firstAccelerator + stage.numAccelerators - 1
+                  << ", cost " << stage.cost << ", busy "
+                  << stage.busySeconds << " s, stalled " << stage.stallSeconds
+                  << " s, occupancy "
+                  << (totalSeconds > 0 ? 100 * stage.busySeconds / totalSeconds
+                                       : 0)
+                  << "%.\n";
+    }
+}
+
+void PipelinedScheduler::printStageCycles() const {
+    std::list<Operator*> ops;
+    for (const auto& stage : stages)
+        ops.insert(ops.end(), stage.ops.begin(), stage.ops.end());
+    printEstimatedCycles(ops);
+    uint64_t slowestCycles = 0;
+    for (int i = 0; i < stages.size(); i++) {
+        uint64_t cycles = 0;
+        int numUnmodeledOps = 0;
+        for (Operator* op : stages[i].ops) {
+            cycles += op->getEstimatedCycles();
+            if (op->getEstimatedCycles() == 0)
+                numUnmodeledOps++;
+        }
+        std::cout << "  Stage " << i << ": " << cycles << " cycles";
+        if (numUnmodeledOps > 0)
+            std::cout << ", excluding " << numUnmodeledOps
+                      << " operators without a cycle model";
+        std::cout << "\n";
+        slowestCycles = std::max(slowestCycles, cycles);
+    }
+    std::cout << "In the steady state, a batch finishes every "
+              << slowestCycles << " cycles.\n";
+}
+
+}  // namespace smaug
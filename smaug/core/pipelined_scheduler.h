@@ -0,0 +1,145 @@
+#ifndef _CORE_PIPELINED_SCHEDULER_H_
+#define _CORE_PIPELINED_SCHEDULER_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "smaug/core/scheduler.h"
+
+namespace smaug {
+
+/**
+ * PipelinedScheduler runs the Network as a pipeline of stages, each with its
+ * own accelerators, and streams several batches through it.
+ *
+ * The operators are split in schedule order into contiguous stages of about
+ * the same cost, and the accelerators are divided among the stages. Every
+ * stage runs on its own host thread, so while a stage works on batch b, the
+ * next one works on batch b - 1. In the steady state, a batch finishes every
+ * time the slowest stage does, instead of after all the stages.
+ *
+ * A tensor that crosses a stage boundary is double-buffered: the consumers in
+ * the later stage read a handoff copy of it, which the later stage makes when
+ * it starts a batch. The producing stage can then overwrite the original with
+ * the next batch while the copy is still being used.
+ *
+ * The network only has one set of inputs, so every batch runs on the same
+ * inputs: the ones bound to the input tensors when runNetwork() is called.
+ * Binding new inputs for every batch isn't supported, as the network inputs
+ * are not double-buffered like the stage boundaries, so the first stage
+ * could overwrite them while a later stage still reads them.
+ */
+class PipelinedScheduler : public Scheduler {
+   public:
+    PipelinedScheduler(Network* _network,
+                       Workspace* _workspace,
+                       int _numStages,
+                       int _numBatches)
+            : Scheduler(_network, _workspace), numStages(_numStages),
+              numBatches(_numBatches) {}
+
+    /**
+     * Runs all the batches through the pipeline. The final output tensor of
+     * the last batch is returned: the output of the last operator to run
+     * that no other operator reads.
+     */
+    Tensor* runNetwork() override;
+
+    /** A group of operators that runs on its own accelerators and thread. */
+    struct Stage {
+        std::vector<Operator*> ops;
+        int firstAccelerator = 0;
+        int numAccelerators = 0;
+        /** The estimated cost of the operators, see getOperatorCost(). */
+        uint64_t cost = 0;
+        /** Host time spent running the operators and copying handoffs. */
+        double busySeconds = 0;
+        /** Host time spent waiting for the neighboring stages. */
+        double stallSeconds = 0;
+    };
+
+    /** A tensor produced in one stage and read in a later one. */
+    struct Boundary {
+        Tensor* source;
+        /** The copy of the source that the consumers read. */
+        Tensor* handoff;
+        int producerStage;
+        int consumerStage;
+        /** The number of batches the producer has finished. */
+        int produced = 0;
+        /** The number of batches the consumer has copied. */
+        int consumed = 0;
+    };
+
+    const std::vector<Stage>& getStages() const { return stages; }
+    const std::vector<Boundary>& getBoundaries() const { return boundaries; }
+
+   protected:
+    /**
+     * Returns the operators in the order the Scheduler would run them,
+     * without running them.
+     */
+    std::vector<Operator*> getScheduleOrder();
+
+    /**
+     * The estimated cost of an operator for balancing the stages: the number
+     * of elements it reads and writes. The SMV accelerators are mostly bound
+     * by moving the data through the scratchpads.
+     */
+    uint64_t getOperatorCost(Operator* op) const;
+
+    /**
+     * Splits the operators into contiguous stages, minimizing the cost of the
+     * most expensive stage, and divides the accelerators among them.
+     */
+    void createStages(const std::vector<Operator*>& order);
+
+    /** Gives every tensor that crosses a stage boundary a handoff copy. */
+    void createBoundaries();
+
+    /**
+     * Reorders the operators of every stage so that fused consumers run
+     * right after their producers.
+     */
+    void orderFusedOperators();
+
+    /** Runs every batch through one stage. */
+    void runStage(int stageIdx);
+
+    /**
+     * Returns the last operator of the last stage that no other operator
+     * reads, whose output is the output of the network.
+     */
+    Operator* getSink() const;
+
+    void printStageReport(double totalSeconds) const;
+
+    /**
+     * Prints the estimated cycles of every operator in the last batch, as
+     * printEstimatedCycles() does, and those of every stage. The slowest
+     * stage gives the cycles between two batches in the steady state.
+     */
+    void printStageCycles() const;
+
+    int numStages;
+    int numBatches;
+    std::vector<Stage> stages;
+    std::vector<Boundary> boundaries;
+    /** Operators that are not part of any stage and run once up front. */
+    std::vector<Operator*> dataOps;
+
+    /** Protects the produced/consumed counts of the boundaries. */
+    std::mutex boundaryMutex;
+    std::condition_variable boundaryCv;
+    /**
+     * Outside of simulation the kernels of all the accelerators share the
+     * same scratchpads on the host, so only one stage at a time may run an
+     * operator.
+     */
+    std::mutex nativeKernelMutex;
+};
+
+}  // namespace smaug
+
+#endif
@@ -0,0 +1,141 @@
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/pipelined_scheduler.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/tensor.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/operators/smv/smv_test_common.h"
+#include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_pooling_op.h"
+#include "smaug/operators/smv/smv_relu_op.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class PipelinedSchedulerTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    // Creates the tensors the operator owns, fills its parameters and chains
+    // it after the previous operator.
+    void addOp(Operator* op, Tensor* input, Operator* prev) {
+        op->setInput(input, 0);
+        op->createAllTensors();
+        for (int i = 1; i < op->getInputs().size(); i++) {
+            op->getInput(i)->allocateStorage<float16>();
+            fillTensorWithRandomData(op->getInput(i));
+        }
+        op->getOutput(0)->allocateStorage<float16>();
+        network()->addOperator(op);
+        if (prev)
+            network()->addEdge(prev, op, { 0, 0 });
+    }
+
+    // conv -> relu -> conv -> pool
+    Operator* buildNetwork() {
+        TensorShape shape({ 1, 16, 16, 16 }, NHWC, SmvBackend::Alignment);
+        Tensor* input = new Tensor("input", shape);
+        input->allocateStorage<float16>();
+        fillTensorWithRandomData(input);
+        workspace()->addTensor(input);
+
+        auto conv0 = new SmvConvolutionOp("conv0", workspace());
+        conv0->setStride(1, 1);
+        conv0->setPadding(SamePadding);
+        conv0->setWeightDims(3, 3, 16);
+        addOp(conv0, input, nullptr);
+        auto relu = new SmvReluOp("relu", workspace());
+        addOp(relu, conv0->getOutput(0), conv0);
+        auto conv1 = new SmvConvolutionOp("conv1", workspace());
+        conv1->setStride(1, 1);
+        conv1->setPadding(SamePadding);
+        conv1->setWeightDims(3, 3, 8);
+        addOp(conv1, relu->getOutput(0), relu);
+        auto pool = new SmvMaxPoolingOp("pool", workspace());
+        pool->setPoolingSize(2, 2);
+        pool->setPoolingStride(2, 2);
+        addOp(pool, conv1->getOutput(0), conv1);
+        return pool;
+    }
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(PipelinedSchedulerTest, "Pipelined scheduler", "[pipeline]") {
+    Operator* last = buildNetwork();
+
+    // The reference output runs all the operators in sequence.
+    Scheduler scheduler(network(), workspace());
+    Tensor* output = scheduler.runNetwork();
+    REQUIRE(output == last->getOutput(0));
+    Tensor* expected = new Tensor("expected", output->getShape());
+    expected->allocateStorage<float16>();
+    copyRawTensorData(
+            expected, output, 0, 0, output->getShape().storageSize());
+    workspace()->addTensor(expected);
+    fillTensorWithFixedData(output);
+
+    numAcceleratorsAvailable = 4;
+    // The estimated cycles are reported for the pipeline as well.
+    reportEstimatedCycles = true;
+    PipelinedScheduler pipeline(network(), workspace(), 3, 4);
+    output = pipeline.runNetwork();
+    REQUIRE(output == last->getOutput(0));
+    verifyOutputs<float16>(output, expected);
+    REQUIRE(network()->getOperator("conv0")->getEstimatedCycles() > 0);
+
+    const auto& stages = pipeline.getStages();
+    REQUIRE(stages.size() == 3);
+    int numOps = 0, numAccels = 0;
+    for (const auto& stage : stages) {
+        REQUIRE(stage.firstAccelerator == numAccels);
+        for (Operator* op : stage.ops) {
+            REQUIRE(op->getFirstAccelerator() == stage.firstAccelerator);
+            REQUIRE(op->getNumAccelerators() == stage.numAccelerators);
+        }
+        numOps += stage.ops.size();
+        numAccels += stage.numAccelerators;
+    }
+    REQUIRE(numOps == 4);
+    REQUIRE(numAccels == 4);
+    // Every stage reads the output of the one before through a handoff.
+    REQUIRE(pipeline.getBoundaries().size() == 2);
+    for (const auto& boundary : pipeline.getBoundaries()) {
+        REQUIRE(boundary.consumerStage == boundary.producerStage + 1);
+        REQUIRE(boundary.produced == 4);
+        REQUIRE(boundary.consumed == 4);
+    }
+}
+
+TEST_CASE_METHOD(PipelinedSchedulerTest,
+                 "Pipelined scheduler returns the network output",
+                 "[pipeline]") {
+    // conv0 feeds both relu and pool, and only the last of them to run is
+    // returned.
+    TensorShape shape({ 1, 16, 16, 16 }, NHWC, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", shape);
+    input->allocateStorage<float16>();
+    fillTensorWithRandomData(input);
+    workspace()->addTensor(input);
+    auto conv0 = new SmvConvolutionOp("conv0", workspace());
+    conv0->setStride(1, 1);
+    conv0->setPadding(SamePadding);
+    conv0->setWeightDims(3, 3, 16);
+    addOp(conv0, input, nullptr);
+    auto relu = new SmvReluOp("relu", workspace());
+    addOp(relu, conv0->getOutput(0), conv0);
+    auto pool = new SmvMaxPoolingOp("pool", workspace());
+    pool->setPoolingSize(2, 2);
+    pool->setPoolingStride(2, 2);
+    addOp(pool, conv0->getOutput(0), conv0);
+
+    Scheduler scheduler(network(), workspace());
+    Tensor* expected = scheduler.runNetwork();
+    numAcceleratorsAvailable = 2;
+    PipelinedScheduler pipeline(network(), workspace(), 2, 2);
+    Tensor* output = pipeline.runNetwork();
+    REQUIRE(output == expected);
+    Operator* sink = pipeline.getStages().back().ops.back();
+    REQUIRE(output == sink->getOutput(0));
+}
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <iostream>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "smaug/core/checkpoint.h"
+#include "smaug/core/globals.h"
 #include "smaug/utility/debug_stream.h"
 #include "smaug/utility/thread_pool.h"
 #include "smaug/core/tensor.h"
@@ -11,15 +17,57 @@
 namespace smaug {
 
 Tensor* Scheduler::runNetwork() {
+    // Running the network again (e.g. on the next input sample) reuses the
+    // tiling of the first run.
+    if (!networkPrepared)
+        prepareNetwork();
+    readyQueue.clear();
+    operatorTimes.clear();
+    // The outputs of the last run are about to be overwritten.
+    if (outputWriter)
+        outputWriter->flush();
+
+    std::cout << "======================================================\n";
+    std::cout << "      Scheduling operators of the network...\n";
+    std::cout << "======================================================\n";
+    // Initialize number of pending inputs for every operator and put Data
+    // operators into the ready queue.
+    for (auto nameOp : network->getOperators()) {
+        Operator* op = nameOp.second;
+        Vertex vertex = op->getVertex();
+        int numPendingInputs = boost::in_degree(vertex, network->getGraph());
+        op->setNumPendingInputs(numPendingInputs);
+        if (numPendingInputs == 0)
+            readyQueue.push_back(op);
+    }
+    Tensor* output;
+    {
+        auto stats =
+                gem5::ScopedStats(stats::kNetworkStart, stats::kNetworkEnd);
+        output = scheduleReady();
+    }
+    if (reportEstimatedCycles)
+        printEstimatedCycles(readyQueue);
+    return output;
+}
+
+void Scheduler::prepareNetwork() {
     std::cout << "======================================================\n";
     std::cout << "      Tiling operators of the network...\n";
     std::cout << "======================================================\n";
+    auto start = std::chrono::steady_clock::now();
     for (auto nameOp : network->getOperators()) {
         Operator* op = nameOp.second;
         dout(0) << "Tiling " << op->getName() << " ("
                 << OpType_Name(op->getOpType()) << ").\n";
         op->tile();
     }
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+    tilingTime = elapsed.count();
+
+    if (fuseOperatorsWhenPossible)
+        fuseOperators();
 
     // We have finished loading the model and building the network, as well as
     // the tiling of all the operators. Now we can stop fast forwarding.
@@ -30,54 +78,266 @@ Tensor* Scheduler::runNetwork() {
     // The fast-forwarding mode uses simpler CPUs, which will be switched to
     // OoO CPUs after it's done. Therefore, the initialization of the thread
     // pool must be after the fast-forwarding, otherwise the CPU IDs will be
-    // incorrect.
-    if (threadPool)
+    // incorrect. Outside of simulation, it may have been initialized already
+    // to build the network.
+    if (threadPool && !threadPool->isInitialized())
         threadPool->initThreadPool();
+    networkPrepared = true;
+}
 
-    std::cout << "======================================================\n";
-    std::cout << "      Scheduling operators of the network...\n";
-    std::cout << "======================================================\n";
-    // Initialize number of pending inputs for every operator and put Data
-    // operators into the ready queue.
+void Scheduler::fuseOperators() {
+    const Graph& graph = network->getGraph();
     for (auto nameOp : network->getOperators()) {
         Operator* op = nameOp.second;
         Vertex vertex = op->getVertex();
-        int numPendingInputs = boost::in_degree(vertex, network->getGraph());
-        op->setNumPendingInputs(numPendingInputs);
-        if (numPendingInputs == 0)
-            readyQueue.push_back(op);
-    }
-    Tensor* output;
-    {
-        auto stats =
-                gem5::ScopedStats(stats::kNetworkStart, stats::kNetworkEnd);
-        output = scheduleReady();
+        if (op->getOutputs().size() != 1 ||
+            boost::out_degree(vertex, graph) != 1)
+            continue;
+        Vertex childVertex = target(*out_edges(vertex, graph).first, graph);
+        Operator* child = get(boost::vertex_op, graph, childVertex);
+        // A fused consumer keeps its results in another scratchpad than the
+        // one a consumer reads its forwarded inputs from, so an operator is
+        // only fused into one pair.
+        if (op->getFusedProducer() || child->getFusedProducer() ||
+            child->getFusedConsumer())
+            continue;
+        // Nothing else may run in between and overwrite the scratchpads, so
+        // any other input of the consumer must come from a Data operator
+        // (those are all run first).
+        bool readyAfterProducer = true;
+        in_edge_iter inEdgeIt, inEdgeEnd;
+        for (boost::tie(inEdgeIt, inEdgeEnd) = in_edges(childVertex, graph);
+             inEdgeIt != inEdgeEnd;
+             ++inEdgeIt) {
+            Operator* parent =
+                    get(boost::vertex_op, graph, source(*inEdgeIt, graph));
+            if (parent != op && parent->getOpType() != OpType::Data)
+                readyAfterProducer = false;
+        }
+        if (!readyAfterProducer || !op->canForwardOutputOnChip() ||
+            !child->canReadInputOnChip(op->getOutput(0)))
+            continue;
+        op->setFusedConsumer(child);
+        child->setFusedProducer(op);
+        dout(0) << "Fusing " << op->getName() << " into "
+                << child->getName() << ".\n";
+        // The tiles were sized for double-buffered scratchpads, which fused
+        // operators don't use, so they may take whole scratchpads again. The
+        // tiles only grow, so the pair can still be fused.
+        if (doubleBufferSpadsWhenPossible) {
+            op->tile();
+            child->tile();
+        }
     }
-    return output;
+}
+
+void Scheduler::setScheduleOrder(const std::vector<Operator*>& order) {
+    schedulePriority.clear();
+    for (int i = 0; i < order.size(); i++)
+        schedulePriority[order[i]] = i;
+}
+
+void Scheduler::sortReadyQueue(std::list<Operator*>::iterator from) {
+    if (schedulePriority.empty())
+        return;
+    auto priority = [this](Operator* op) {
+        auto it = schedulePriority.find(op);
+        return it == schedulePriority.end() ? schedulePriority.size()
+                                            : it->second;
+    };
+    std::list<Operator*> ready;
+    ready.splice(ready.begin(), readyQueue, from, readyQueue.end());
+    ready.sort([&](Operator* a, Operator* b) {
+        return priority(a) < priority(b);
+    });
+    readyQueue.splice(readyQueue.end(), ready);
 }
 
 Tensor* Scheduler::scheduleReady() {
-    Tensor* output;
-    for (auto op : readyQueue) {
-        dout(0) << "Scheduling " << op->getName() << " ("
-                << OpType_Name(op->getOpType()) << ").\n";
-        maybeRunOperator(op);
+    Tensor* output = nullptr;
+    // The position of the next operator, not counting the Data operators.
+    int position = 0;
+    sortReadyQueue(readyQueue.begin());
+    for (auto it = readyQueue.begin(); it != readyQueue.end(); ++it) {
+        Operator* op = *it;
+        bool isData = op->getOpType() == OpType::Data;
+        if (!isData) {
+            if (checkpointBoundaries.count(position))
+                writeCheckpoint(position, it);
+            if (position == rangeEnd) {
+                // Leave the operators that don't run out of the ready queue.
+                readyQueue.erase(it, readyQueue.end());
+                return output;
+            }
+        }
+        if (isData || position >= rangeBegin) {
+            dout(0) << "Scheduling " << op->getName() << " ("
+                    << OpType_Name(op->getOpType()) << ").\n";
+            prepareParams(it);
+            auto start = std::chrono::steady_clock::now();
+            maybeRunOperator(op);
+            std::chrono::duration<double> elapsed =
+                    std::chrono::steady_clock::now() - start;
+            operatorTimes.emplace_back(op, elapsed.count());
+            if (outputWriter)
+                outputWriter->writeOutputs(op);
+        } else {
+            if (!skippedOps.empty() && skippedOps[position] != op->getName()) {
+                std::cerr << "The checkpoint was written with a different "
+                             "schedule: expected to skip "
+                          << skippedOps[position] << " at operator "
+                          << position << ", but the schedule has "
+                          << op->getName() << "!\n";
+                readyQueue.erase(std::next(it), readyQueue.end());
+                return nullptr;
+            }
+            dout(0) << "Skipping " << op->getName() << " ("
+                    << OpType_Name(op->getOpType()) << ").\n";
+        }
         updateChildren(op);
+        sortReadyQueue(std::next(it));
+        // A fused consumer reads this operator's output from the scratchpads,
+        // so it has to run next.
+        if (Operator* consumer = op->getFusedConsumer()) {
+            auto consumerIt =
+                    std::find(std::next(it), readyQueue.end(), consumer);
+            assert(consumerIt != readyQueue.end() &&
+                   "A fused consumer must be ready after its producer!");
+            readyQueue.splice(std::next(it), readyQueue, consumerIt);
+        }
         output = op->getOutput(0);
         dout(2) << *output << "\n";
+        if (!isData)
+            position++;
     }
+    if (checkpointBoundaries.count(position))
+        writeCheckpoint(position, readyQueue.end());
     return output;
 }
 
+std::vector<Tensor*> Scheduler::getLiveTensors(
+        std::list<Operator*>::iterator next) {
+    std::set<Operator*> done(readyQueue.begin(), next);
+    const Graph& graph = network->getGraph();
+    std::vector<Tensor*> tensors;
+    for (auto it = readyQueue.begin(); it != next; ++it) {
+        Operator* op = *it;
+        // The Data operators run again when the network is resumed.
+        if (op->getOpType() == OpType::Data)
+            continue;
+        Vertex vertex = op->getVertex();
+        bool live = boost::out_degree(vertex, graph) == 0;
+        out_edge_iter outEdgeIt, outEdgeEnd;
+        for (boost::tie(outEdgeIt, outEdgeEnd) = out_edges(vertex, graph);
+             outEdgeIt != outEdgeEnd;
+             ++outEdgeIt) {
+            Vertex childVertex = target(*outEdgeIt, graph);
+            if (!done.count(get(boost::vertex_op, graph, childVertex)))
+                live = true;
+        }
+        if (!live)
+            continue;
+        for (int i = 0; i < op->getOutputs().size(); i++)
+            tensors.push_back(op->getOutput(i));
+    }
+    return tensors;
+}
+
+void Scheduler::writeCheckpoint(int boundary,
+                                std::list<Operator*>::iterator next) {
+    std::string path = getCheckpointPath(checkpointPrefix, boundary);
+    std::vector<std::string> opNames;
+    for (auto it = readyQueue.begin(); it != next; ++it) {
+        if ((*it)->getOpType() != OpType::Data)
+            opNames.push_back((*it)->getName());
+    }
+    std::vector<Tensor*> tensors = getLiveTensors(next);
+    if (saveCheckpoint(path, boundary, opNames, tensors)) {
+        std::cout << "Wrote the checkpoint at operator " << boundary << " ("
+                  << tensors.size() << " tensors) to " << path << ".\n";
+    }
+}
+
+void Scheduler::prepareParams(std::list<Operator*>::iterator it) {
+    ParamStore* paramStore = network->getParamStore();
+    Operator* op = *it;
+    // Data operators don't read their data.
+    if (!paramStore || op->getOpType() == OpType::Data)
+        return;
+    paramStore->pin(op->getInputs());
+    // In simulation, the host threads need CPUs of their own.
+    if (runningInSimulation)
+        return;
+    Operator* next = nullptr;
+    for (auto nextIt = std::next(it); nextIt != readyQueue.end(); ++nextIt) {
+        if ((*nextIt)->getOpType() != OpType::Data) {
+            next = *nextIt;
+            break;
+        }
+    }
+    const Graph& graph = network->getGraph();
+    Vertex vertex = op->getVertex();
+    if (!next && boost::out_degree(vertex, graph) > 0) {
+        Vertex childVertex = target(*out_edges(vertex, graph).first, graph);
+        next = get(boost::vertex_op, graph, childVertex);
+    }
+    if (next)
+        paramStore->prefetch(next->getInputs());
+}
+
 void Scheduler::maybeRunOperator(Operator* op) {
+    // The outputs may be dead from an earlier run of the network.
+    for (auto output : op->getOutputs())
+        output->setDead(false);
     if (!op->isDead()) {
         op->run();
+        // Tiles copied from the outputs in an earlier run are now stale. Data
+        // operators don't change their data.
+        if (op->getOpType() != OpType::Data) {
+            for (int i = 0; i < op->getOutputs().size(); i++)
+                op->getOutput(i)->bumpDataVersion();
+        }
+        releaseDecompressedInputs(op);
     } else {
         for (auto output : op->getOutputs())
             output->setDead();
     }
 }
 
+void Scheduler::releaseDecompressedInputs(Operator* op) {
+    for (TiledTensor* tiledTensor : op->getTiledTensors())
+        tiledTensor->releaseDecompressedTiles();
+    for (int i = 0; i < op->getInputs().size(); i++) {
+        if (Tensor* input = op->getInput(i))
+            input->releaseDecompressedData();
+    }
+}
+
+void Scheduler::printEstimatedCycles(const std::list<Operator*>& ops) const {
+    std::cout << "======================================================\n";
+    std::cout << "      Estimated accelerator cycles...\n";
+    std::cout << "======================================================\n";
+    uint64_t totalCycles = 0;
+    int numUnmodeledOps = 0;
+    for (Operator* op : ops) {
+        if (op->getOpType() == OpType::Data)
+            continue;
+        uint64_t cycles = op->getEstimatedCycles();
+        if (cycles == 0) {
+            numUnmodeledOps++;
+            continue;
+        }
+        std::cout << "  " << op->getName() << " ("
+                  << OpType_Name(op->getOpType()) << "): " << cycles << "\n";
+        totalCycles += cycles;
+    }
+    std::cout << "Total: " << totalCycles << " cycles";
+    if (numUnmodeledOps > 0)
+        std::cout << ", excluding " << numUnmodeledOps
+                  << " operators without a cycle model";
+    std::cout << ".\n";
+}
+
 void Scheduler::updateChildren(Operator* op) {
     const Graph& graph = network->getGraph();
     Vertex vertex = op->getVertex();
@@ -1,9 +1,16 @@
 #ifndef _CORE_SCHEDULE_H_
 #define _CORE_SCHEDULE_H_
 
+#include <cassert>
 #include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "smaug/core/network.h"
+#include "smaug/core/output_writer.h"
 #include "smaug/core/workspace.h"
 #include "smaug/core/operator.h"
 
@@ -15,18 +22,110 @@ namespace smaug {
 class Scheduler {
    public:
     Scheduler(Network* _network, Workspace* _workspace)
-            : network(_network), workspace(_workspace) {}
+            : network(_network), workspace(_workspace),
+              outputWriter(nullptr), rangeBegin(0), rangeEnd(-1),
+              networkPrepared(false), tilingTime(0) {}
     virtual ~Scheduler(){};
-    /** Runs the Network to completion. The final output tensor is returned. */
-    Tensor* runNetwork();
+    /**
+     * Runs the Network to completion. The final output tensor is returned.
+     * The Network may be run again, e.g. after new data is bound to its
+     * inputs.
+     */
+    virtual Tensor* runNetwork();
+
+    /**
+     * Runs the operators in the given order instead of the FIFO order of the
+     * ready queue. Whenever several operators are ready, the one that comes
+     * first in the order runs first, so a topological order of the network is
+     * followed exactly. Operators missing from the order run last.
+     */
+    void setScheduleOrder(const std::vector<Operator*>& order);
+
+    /**
+     * Dumps the outputs of the operators through the given OutputWriter as
+     * soon as they have run. The writer is not owned by the Scheduler.
+     */
+    void setOutputWriter(OutputWriter* writer) { outputWriter = writer; }
+
+    /**
+     * Only runs the operators from position begin up to end (exclusive) in
+     * schedule order, where the positions count all the operators but the
+     * Data operators. The operators before begin are skipped, so their
+     * outputs must have been restored from a checkpoint. An end of -1 runs
+     * the network to the end.
+     *
+     * If the names of the skipped operators are given, as loadCheckpoint()
+     * returns them, runNetwork() checks that the schedule skips exactly those
+     * operators, and returns nullptr without running any of the others if it
+     * doesn't.
+     */
+    void setOperatorRange(int begin,
+                          int end,
+                          const std::vector<std::string>& skipped = {}) {
+        assert((skipped.empty() || skipped.size() == begin) &&
+               "The skipped operators don't match the range!");
+        rangeBegin = begin;
+        rangeEnd = end;
+        skippedOps = skipped;
+    }
+
+    /**
+     * Writes a checkpoint of the live tensors at each of the given operator
+     * boundaries (see checkpoint.h) that the run reaches, to the path that
+     * getCheckpointPath() returns for the prefix.
+     */
+    void setCheckpoints(const std::set<int>& boundaries,
+                        const std::string& prefix) {
+        checkpointBoundaries = boundaries;
+        checkpointPrefix = prefix;
+    }
+
+    /** The host time in seconds it took to tile the network. */
+    double getTilingTime() const { return tilingTime; }
+
+    /**
+     * The host time in seconds of every operator that ran in the last run of
+     * the network, in the order they ran.
+     */
+    const std::vector<std::pair<Operator*, double>>& getOperatorTimes() const {
+        return operatorTimes;
+    }
 
    protected:
+    /**
+     * Tiles all the operators and fuses them where possible, then ends the
+     * fast-forwarding of the simulation.
+     */
+    void prepareNetwork();
+
+    /**
+     * Pairs up back-to-back operators that can hand their data over through
+     * the scratchpads. A producer is fused with its consumer if the consumer
+     * is its only one and becomes ready as soon as the producer finishes, and
+     * both tilings allow it.
+     */
+    void fuseOperators();
+
+    /**
+     * Sorts the ready operators from the given position on by their place in
+     * the schedule order, if one was set.
+     */
+    void sortReadyQueue(std::list<Operator*>::iterator from);
+
     /**
      * Runs the operators in the ready queue. This may add new operators to
      * the ready queue by calling updateChildren().
      */
     Tensor* scheduleReady();
 
+    /**
+     * If the parameters are loaded on demand, pins those of the Operator at
+     * the given position of the ready queue while it runs, and starts
+     * prefetching those of the next Operator that will run: the next one in
+     * the ready queue, or else the first child of this one.
+     */
+    void prepareParams(std::list<Operator*>::iterator it);
+
     /**
      * If none of the inputs to the current Operator are dead, then this will
      * run the Operator; otherwise, otherwise, all of the Operator's outputs
@@ -35,6 +134,13 @@ class Scheduler {
      */
     void maybeRunOperator(Operator* op);
 
+    /**
+     * Frees the dense copies of the compressed inputs of the Operator and of
+     * their tiles, so that only the compressed data stays in memory between
+     * the runs of the Operator.
+     */
+    void releaseDecompressedInputs(Operator* op);
+
     /**
      * After an Operator is run, this updates the number of pending inputs on
      * all its children. Any child Operator with no more pending inputs is then
@@ -42,11 +148,48 @@ class Scheduler {
      */
     void updateChildren(Operator* op);
 
+    /**
+     * Returns the outputs of the operators before the given position of the
+     * ready queue that are still needed: those read by an operator at or
+     * after it, and the outputs of the network.
+     */
+    std::vector<Tensor*> getLiveTensors(std::list<Operator*>::iterator next);
+
+    /** Writes a checkpoint at the boundary before the given position. */
+    void writeCheckpoint(int boundary, std::list<Operator*>::iterator next);
+
+    /**
+     * Prints the estimated cycles of every operator that ran, in the order
+     * they ran, and their sum for the whole network. Operators whose backend
+     * has no cycle model are left out.
+     */
+    void printEstimatedCycles(const std::list<Operator*>& ops) const;
+
     Network* network;
     Workspace* workspace;
 
     /** The queue of all Operators ready to be executed. */
     std::list<Operator*> readyQueue;
+
+    /** The position of each Operator in the schedule order, if one is set. */
+    std::map<Operator*, int> schedulePriority;
+
+    OutputWriter* outputWriter;
+
+    /** The range of operator positions to run, see setOperatorRange(). */
+    int rangeBegin;
+    int rangeEnd;
+    /** The expected names of the operators before rangeBegin, if known. */
+    std::vector<std::string> skippedOps;
+
+    std::set<int> checkpointBoundaries;
+    std::string checkpointPrefix;
+
+    /** True once the operators have been tiled. */
+    bool networkPrepared;
+
+    double tilingTime;
+    std::vector<std::pair<Operator*, double>> operatorTimes;
 };
 
 }  // namespace smaug
@@ -52,6 +52,11 @@ class SmaugTest {
         runningInSimulation = false;
         useSystolicArrayWhenAvailable = false;
         numAcceleratorsAvailable = 1;
+        fuseOperatorsWhenPossible = false;
+        doubleBufferSpadsWhenPossible = false;
+        paramMemoryBudget = 0;
+        reportEstimatedCycles = false;
+        accelDispatchPolicy = RoundRobinDispatch;
     }
 
     ~SmaugTest() {
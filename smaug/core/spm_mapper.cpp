@@ -128,7 +128,8 @@ std::vector<std::vector<int>> find_optimal_mapping(
     initialize_mapping(input_spm_mapping, output_spm_mapping, input_sizes);
 
     int max_pinned_outputs = 0;
-    int max_spm_id = 2;
+    // the last spm holds the outputs.
+    int max_spm_id = SmvBackend::NumSpads() - 1;
     int max_pinned = 0;
     int scratchpad_size = SmvBackend::SpadSize();
     std::vector<std::vector<int>> optimal_mapping;
@@ -1,6 +1,11 @@
 #include <google/protobuf/stubs/hash.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <iostream>
 #include <fstream>
+#include <set>
+#include <sstream>
 
 #include "backend.h"
 #include "smaug/core/static_graph_analyzer.h"
@@ -8,6 +13,10 @@
 
 namespace smaug {
 
+// the smv kernels read their first input from spm0 and any other input from
+// spm1, and write their outputs to spm2.
+const int kernel_output_spm = 2;
+
 auto print_pin = [](auto &node, auto& livenessMap) {
     std::cout << "OPERATOR: [" << node.first->getName() << "] = " << std::endl;
     std::vector<TensorBase*> pin_vec = node.second;
@@ -175,7 +184,6 @@ std::map<TensorBase*, double> GraphAnalyzer::sort(std::vector<TensorBase*> tenso
 
 void GraphAnalyzer::validate_pin_v2()
 {
-    int spad_count = SMV_SPAD_COUNT;
     // The backend here is hardcoded. This not ideal and should
     // be changed to be passed in as a param.
     int spad_size = SmvBackend::SpadSize();
@@ -505,56 +513,403 @@ void GraphAnalyzer::create_pin_map()
     }
 }
 
-void GraphAnalyzer::create_ilp_map(std::string map_path)
+std::string TileRegion::getName() const
+{
+    return tensor->getName() + "@[" + std::to_string(begin) + "," +
+           std::to_string(end) + ")";
+}
+
+// the region that a whole tensor covers when an op doesn't tile it.
+static TileRegion get_whole_tensor_region(TensorBase* tensor)
+{
+    int storageSize = tensor->getShape().storageSize();
+    return TileRegion(tensor, 0, storageSize, true,
+                      storageSize * tensor->getDataTypeSize());
+}
+
+// the region of the original tensor a tile was copied from.
+static TileRegion get_tile_region(TiledTensor* tiledTensor, int tileIdx)
+{
+    Tensor* origTensor = tiledTensor->getOrigTensor();
+    Tensor* tile = (*tiledTensor)[tileIdx];
+    const TensorShape& tileShape = tile->getShape();
+    uint32_t size = tileShape.storageSize() * origTensor->getDataTypeSize();
+    std::vector<int> origin = tiledTensor->getTileOrigin(tileIdx);
+
+    // raw tiles are flat copies starting at the offset in their origin.
+    if(tiledTensor->usesRawTensor()) {
+        return TileRegion(origTensor, origin[0], origin[0] + tileShape.size(),
+                          true, size);
+    }
+
+    // the region spans from the tile's first to its last element. It only
+    // covers that whole range if the tile is a run of full inner dimensions.
+    const TensorShape& origShape = origTensor->getShape();
+    int ndims = origShape.ndims();
+    if(origin.size() != ndims || tileShape.ndims() != ndims)
+        return get_whole_tensor_region(origTensor);
+    int begin = 0, last = 0, stride = 1;
+    for(int i = ndims - 1; i >= 0; i--) {
+        begin += origin[i] * stride;
+        last += (origin[i] + tileShape[i] - 1) * stride;
+        stride *= origShape.getStorageDim(i);
+    }
+    bool contiguous = true;
+    bool partial = false;
+    for(int i = ndims - 1; i >= 0; i--) {
+        if(partial && tileShape[i] != 1)
+            contiguous = false;
+        if(tileShape[i] != origShape[i])
+            partial = true;
+    }
+    // tiles of padded convolutions may start before or end after the tensor.
+    begin = std::max(begin, 0);
+    last = std::min(last, origShape.storageSize() - 1);
+    return TileRegion(origTensor, begin, last + 1, contiguous, size);
+}
+
+std::vector<TileRegion> GraphAnalyzer::get_read_regions(const TileRegion& tile)
+{
+    auto& known = knownRegions[tile.tensor];
+    auto exact = std::find(known.begin(), known.end(), tile);
+    if(exact != known.end())
+        return { *exact };
+
+    // a contiguous tile can be served by the tiles the tensor was produced
+    // (or first read) as, if they cover its whole range, e.g. a row tile of a
+    // convolution input with its halo reading back a producer's output tiles.
+    if(tile.contiguous) {
+        std::vector<TileRegion> overlapping;
+        for(const auto& region : known) {
+            if(region.contiguous && region.overlaps(tile))
+                overlapping.push_back(region);
+        }
+        std::sort(overlapping.begin(), overlapping.end());
+        int covered = tile.begin;
+        for(const auto& region : overlapping) {
+            if(region.begin > covered)
+                break;
+            covered = std::max(covered, region.end);
+        }
+        if(!overlapping.empty() && covered >= tile.end)
+            return overlapping;
+    }
+
+    known.push_back(tile);
+    return { tile };
+}
+
+void GraphAnalyzer::get_tile_schedule()
+{
+    tileSchedule.clear();
+    knownRegions.clear();
+    // the regions are numbered again for the new schedule.
+    uniqueTileNumberMap.clear();
+    for(auto op : readyQueue) {
+        std::vector<TiledTensor*> tiledTensors = op->getTiledTensors();
+        const std::vector<TensorBase*>& outputs = op->getOutputs();
+        auto is_output = [&outputs](TensorBase* tensor) {
+            return std::find(outputs.begin(), outputs.end(), tensor) !=
+                   outputs.end();
+        };
+        auto add_output = [this](std::vector<TileAccess>& accesses,
+                                 Tensor* tile, const TileRegion& region) {
+            // an op (re)writes its outputs, so the output tiles replace
+            // whatever was known about the tensor.
+            auto& known = knownRegions[region.tensor];
+            known.erase(std::remove_if(known.begin(), known.end(),
+                                [&region](const TileRegion& other) {
+                                    return other.overlaps(region);
+                                }),
+                        known.end());
+            known.push_back(region);
+            accesses.push_back({ tile, { region } });
+        };
+
+        if(tiledTensors.empty()) {
+            // host side ops (data, reorder, reshape...) don't stream tiles,
+            // so they touch their whole tensors in one step.
+            TileStep step{op};
+            for(auto input : op->getInputs()) {
+                step.inputs.push_back(
+                        { dynamic_cast<Tensor*>(input),
+                          get_read_regions(get_whole_tensor_region(input)) });
+            }
+            for(auto output : outputs) {
+                add_output(step.outputs, dynamic_cast<Tensor*>(output),
+                           get_whole_tensor_region(output));
+            }
+            tileSchedule.push_back(step);
+            continue;
+        }
+
+        // Every kernel invocation of the op is one step, using the tiles its
+        // dispatcher picks from the op's loop nest.
+        std::vector<std::vector<int>> invocations = op->getTileInvocations();
+        if(invocations.empty()) {
+            // the tiled tensors step together, so the kernel is invoked once
+            // per tile of the most finely tiled tensor and a tile of a
+            // coarser tensor is reused across the consecutive invocations
+            // that need it.
+            int numSteps = 0;
+            for(auto tiledTensor : tiledTensors)
+                numSteps = std::max(numSteps, tiledTensor->size());
+            for(int i = 0; i < numSteps; i++) {
+                std::vector<int> tileIdxs;
+                for(auto tiledTensor : tiledTensors) {
+                    tileIdxs.push_back(tiledTensor->size() == 0
+                            ? 0 : (long)i * tiledTensor->size() / numSteps);
+                }
+                invocations.push_back(tileIdxs);
+            }
+        }
+
+        for(const auto& tileIdxs : invocations) {
+            assert(tileIdxs.size() == tiledTensors.size());
+            TileStep step{op};
+            for(int t = 0; t < tiledTensors.size(); t++) {
+                TiledTensor* tiledTensor = tiledTensors[t];
+                Tensor* origTensor = tiledTensor->getOrigTensor();
+                if(origTensor == nullptr || tiledTensor->size() == 0)
+                    continue;
+                int tileIdx = tileIdxs[t];
+                Tensor* tile = (*tiledTensor)[tileIdx];
+                TileRegion region = get_tile_region(tiledTensor, tileIdx);
+                if(is_output(origTensor))
+                    add_output(step.outputs, tile, region);
+                else
+                    step.inputs.push_back({ tile, get_read_regions(region) });
+            }
+            tileSchedule.push_back(step);
+        }
+    }
+}
+
+void GraphAnalyzer::get_tile_liveness_data()
+{
+    for(auto &node : tileLivenessMap)
+        delete node.second;
+    tileLivenessMap.clear();
+
+    auto update_tile_liveness = [this](const TileRegion& region,
+                                       uint32_t step_cycle) {
+        auto it = tileLivenessMap.find(region);
+        if(it == tileLivenessMap.end()) {
+            it = tileLivenessMap.emplace(region,
+                    new LivenessData(region.getName())).first;
+        }
+        it->second->update_liveness(step_cycle);
+    };
+
+    uint32_t step_cycle{};
+    for(const auto& step : tileSchedule) {
+        for(const auto& access : step.inputs) {
+            for(const auto& region : access.regions)
+                update_tile_liveness(region, step_cycle);
+        }
+        for(const auto& access : step.outputs) {
+            for(const auto& region : access.regions)
+                update_tile_liveness(region, step_cycle);
+        }
+        step_cycle++;
+    }
+
+    for(auto &node : tileLivenessMap)
+        node.second->remove_duplicate_cycles();
+}
+
+uint32_t GraphAnalyzer::get_region_spm_size(const TileRegion& region) const
+{
+    uint32_t spad_size = SmvBackend::SpadSize();
+    return std::min(region.size, spad_size);
+}
+
+void GraphAnalyzer::create_tile_pin_map()
 {
+    tilePinMap.clear();
+    tileSPMap.clear();
+    tilePins.clear();
+    int num_steps = tileSchedule.size();
+    uint32_t spad_size = SmvBackend::SpadSize();
+
+    // the working set of every step: input tiles go on the input spms and
+    // output tiles go on the output spm, same as the kernels do. Any other
+    // spm is free for pins.
+    std::vector<std::vector<uint32_t>> spm_usage(
+            spad_count, std::vector<uint32_t>(num_steps, 0));
+    for(int i = 0; i < num_steps; i++) {
+        const TileStep& step = tileSchedule[i];
+        for(int j = 0; j < step.inputs.size(); j++) {
+            int spm = std::min(j, kernel_output_spm - 1);
+            for(const auto& region : step.inputs[j].regions)
+                spm_usage[spm][i] += get_region_spm_size(region);
+        }
+        for(const auto& access : step.outputs) {
+            for(const auto& region : access.regions)
+                spm_usage[kernel_output_spm][i] += get_region_spm_size(region);
+        }
+    }
+
+    // every pair of consecutive uses of a region is a pin candidate: keeping
+    // the tile resident in between saves reloading it at the later use.
+    struct PinCandidate {
+        TileRegion region;
+        uint32_t begin;
+        uint32_t end;
+    };
+    std::vector<PinCandidate> candidates;
+    for(const auto& [region, liveness] : tileLivenessMap) {
+        // regions larger than a spm are never resident as a whole.
+        if(region.size > spad_size)
+            continue;
+        std::vector<uint32_t> accesses = liveness->get_access_times();
+        for(int i = 1; i < accesses.size(); i++)
+            candidates.push_back({region, accesses[i - 1], accesses[i]});
+    }
+
+    // short reuse distances first, so that the last output tiles of a layer
+    // are kept for the first tiles of the next layer before anything that
+    // has to survive across many steps. Larger tiles save more DMA traffic.
+    std::stable_sort(candidates.begin(), candidates.end(),
+            [](const PinCandidate& a, const PinCandidate& b) {
+                uint32_t distA = a.end - a.begin;
+                uint32_t distB = b.end - b.begin;
+                if(distA != distB)
+                    return distA < distB;
+                return a.region.size > b.region.size;
+            });
+
+    for(const auto& candidate : candidates) {
+        uint32_t size = candidate.region.size;
+        for(int spm = 0; spm < spad_count; spm++) {
+            bool fits = true;
+            for(uint32_t i = candidate.begin + 1; i < candidate.end; i++) {
+                if(spm_usage[spm][i] + size > spad_size) {
+                    fits = false;
+                    break;
+                }
+            }
+            if(!fits)
+                continue;
+            for(uint32_t i = candidate.begin + 1; i < candidate.end; i++)
+                spm_usage[spm][i] += size;
+
+            // the tile the consumer reads at the end of the interval is
+            // already on the spm, and so is the one it was produced or last
+            // read as.
+            const TileStep& begin_step = tileSchedule[candidate.begin];
+            const TileStep& end_step = tileSchedule[candidate.end];
+            auto mark_tiles = [&](const TileStep& step, bool mark_op) {
+                auto add_tile = [&](const std::vector<TileAccess>& accesses) {
+                    for(const auto& access : accesses) {
+                        if(std::find(access.regions.begin(),
+                                     access.regions.end(),
+                                     candidate.region) == access.regions.end())
+                            continue;
+                        tileSPMap[access.tile] = spm;
+                        if(mark_op)
+                            tilePinMap[step.op].push_back(access.tile);
+                    }
+                };
+                add_tile(step.inputs);
+                add_tile(step.outputs);
+            };
+            mark_tiles(begin_step, false);
+            mark_tiles(end_step, true);
+            tilePins.push_back(
+                    {candidate.region, spm, candidate.begin, candidate.end});
+            if(verbose) {
+                std::cout << "pinning tile: " << candidate.region.getName()
+                          << " on spm " << spm << " from step "
+                          << candidate.begin << " to step " << candidate.end
+                          << std::endl;
+            }
+            break;
+        }
+    }
+
+    // the same tile may be pinned from several intervals.
+    for(auto &node : tilePinMap) {
+        auto& pin_vec = node.second;
+        std::sort(pin_vec.begin(), pin_vec.end());
+        pin_vec.erase(std::unique(pin_vec.begin(), pin_vec.end()),
+                      pin_vec.end());
+    }
+}
+
+void GraphAnalyzer::populate_tile_pin_map()
+{
+    std::cout << "======================================================\n";
+    std::cout << "      Getting Tile Schedule...\n";
+    std::cout << "======================================================\n";
+    this->get_tile_schedule();
+    std::cout << "======================================================\n";
+    std::cout << "      Getting Tile Liveness Data...\n";
+    std::cout << "======================================================\n";
+    this->get_tile_liveness_data();
+    std::cout << "======================================================\n";
+    std::cout << "      Creating Tile Pin Map ...\n";
+    std::cout << "======================================================\n";
+    this->create_tile_pin_map();
+
+    for(auto op : readyQueue) {
+        auto& pin_vec = tilePinMap[op];
+        if(pin_vec.empty())
+            continue;
+        std::cout << "OPERATOR NAME: " << op->getName() << std::endl;
+        std::cout << "PINNED TILES" << std::endl;
+        for(auto tile : pin_vec) {
+            std::cout << tile->getName() << " on spm "
+                      << (int)tileSPMap[tile] << std::endl;
+        }
+    }
+}
+
+void GraphAnalyzer::build_ilp_matrices()
+{
+    if(tileSchedule.empty())
+        get_tile_schedule();
+    uniqueTileNumberMap.clear();
+    tensorSizeMap.clear();
+
     uint32_t op_cycle{};
     uint32_t tensorNum{};
-    // create a dict of all the inputs and outputs per op for a schedule dict
-    // will have the op_cycle_idx as key and value of input0, input1, output0
-    // there is no op_name mapping for the idx. we just assume that the
-    // schedule is determinisitic and static so we can retreive it in another
-    // function if we want. also create mapping of tensor # to tensor. so like
-    // some unique tensor name should be mapped to a unique tensor #.
-    for(auto op : readyQueue) {
-        std::vector<TensorBase*> inputs = op->getInputs();
-        std::vector<TensorBase*> outputs = op->getOutputs();
-        // create a temp vector for the inputs and outputs
-        std::vector<TensorBase*> inputs_and_output{};
-        // concat the inputs and outputs into the temp vec
-        inputs_and_output.insert(inputs_and_output.end(),
-                inputs.begin(), inputs.end());
-        inputs_and_output.insert(inputs_and_output.end(),
-                outputs.begin(), outputs.end());
-
-        // add the concatted inputs and outputs vec to the map
-        op_cycle_to_input_output_mapping.insert_or_assign(
-                op_cycle, inputs_and_output);
-
-        std::cout << "      operator: " << op->getName() << "...\n";
-        for(auto tensor : inputs_and_output) {
-            if(!uniqueTensorNumberMap.count(tensor)) {
+    for(const auto& step : tileSchedule) {
+        if(verbose) {
+            std::cout << "      step " << op_cycle << ": operator: "
+                      << step.op->getName() << "...\n";
+        }
+        std::vector<const TileRegion*> inputs_and_output{};
+        for(const auto& access : step.inputs) {
+            for(const auto& region : access.regions)
+                inputs_and_output.push_back(&region);
+        }
+        for(const auto& access : step.outputs) {
+            for(const auto& region : access.regions)
+                inputs_and_output.push_back(&region);
+        }
+        for(auto region : inputs_and_output) {
+            if(!uniqueTileNumberMap.count(*region)) {
                 tensorSizeMap.insert_or_assign(tensorNum,
-                        tensor->getShape().storageSize());
-                uniqueTensorNumberMap.insert_or_assign(tensor, tensorNum);
-                std::cout << "      tensor: " << tensor->getName() 
-                    << " tensorNumber = " << tensorNum << "\n";
+                        get_region_spm_size(*region));
+                uniqueTileNumberMap.insert_or_assign(*region, tensorNum);
+                if(verbose) {
+                    std::cout << "      tile: " << region->getName()
+                        << " tensorNumber = " << tensorNum << "\n";
+                }
                 tensorNum++;
             }
         }
         op_cycle++;
     }
 
-    // now that we have a dict of intputs and outputs to a cycle map, we create
-    // our spm tensor mappings
-    
-    // get # of tensors that exist to create tensor mapping matrix
-    int num_tensors = uniqueTensorNumberMap.size();
+    int num_tensors = uniqueTileNumberMap.size();
 
-    // op_cycle - 1 since the last time we incremet op_cycle at end of loop
-    // when creating the op to tensor mapping
-    std::cout << "======================================================\n";
-    std::cout << "      Starting SPM mapping...\n";
-    std::cout << "======================================================\n";
+    if(verbose) {
+        std::cout << "======================================================\n";
+        std::cout << "      Starting SPM mapping...\n";
+        std::cout << "======================================================\n";
+    }
     // initialize spm_n_map to a vector of op_size so we don't segfault
     std::vector<int> tempTensors(num_tensors, 0);
     std::vector<std::vector<int>> tempSpm(op_cycle, tempTensors);
@@ -562,40 +917,37 @@ void GraphAnalyzer::create_ilp_map(std::string map_path)
     spm1Map = tempSpm;
     spm2Map = tempSpm;
     for(int i = 0; i < op_cycle; i++) {
-        std::vector<int> allTensors0(num_tensors, 0); // input0 spm
-        std::vector<int> allTensors1(num_tensors, 0); // input0 spm
-        std::vector<int> allTensors2(num_tensors, 0); //output spm
-        if(op_cycle_to_input_output_mapping[i].size() < 3) {
-            // reorder op or something where we don't populate all 3 spms
-            // There might be a problem with the ILP solver where an input is
-            // also the output and so theres some kind of interference thing 
-            // there where it thinks it goes back to main mem and back to spm
-            std::vector<std::vector<int>> temp_spm_map{allTensors0, allTensors2};
-            for(int j = 0; j < 2; j++) {
-                TensorBase* tensor = op_cycle_to_input_output_mapping[i][j];
-                int tensorIdx = uniqueTensorNumberMap[tensor];
-                temp_spm_map[j][tensorIdx] = 1;
+        const TileStep& step = tileSchedule[i];
+        // the first input goes on spm0, any other input on spm1 and the
+        // output on spm2, which is how the smv kernels use their spms.
+        for(int j = 0; j < step.inputs.size(); j++) {
+            for(const auto& region : step.inputs[j].regions) {
+                int tensorIdx = uniqueTileNumberMap[region];
+                if(j == 0)
+                    spm0Map[i][tensorIdx] = 1;
+                else
+                    spm1Map[i][tensorIdx] = 1;
             }
-            spm0Map[i] = temp_spm_map[0];
-            spm1Map[i] = allTensors1;
-            spm2Map[i] = temp_spm_map[1];
-        } else { // there are the proper amount of inputs and outputs
-            std::vector<std::vector<int>> temp_spm_map{allTensors0, 
-                                                       allTensors1,
-                                                       allTensors2};
-            for(int j = 0; j < 3; j++) {
-                TensorBase* tensor = op_cycle_to_input_output_mapping[i][j];
-                int tensorIdx = uniqueTensorNumberMap[tensor];
-                temp_spm_map[j][tensorIdx] = 1;
-            }
-            spm0Map[i] = temp_spm_map[0];
-            spm1Map[i] = temp_spm_map[1];
-            spm2Map[i] = temp_spm_map[2];
+        }
+        for(const auto& access : step.outputs) {
+            for(const auto& region : access.regions)
+                spm2Map[i][uniqueTileNumberMap[region]] = 1;
         }
     }
+}
+
+void GraphAnalyzer::create_ilp_map(std::string map_path)
+{
+    // The ILP works on tiles: every row of the matrices is one tile step
+    // (kernel invocation) and every column is a unique tile region. Tiles
+    // already fit on a spm, so their real sizes can be used, which lets the
+    // solver keep the last tiles of a layer's output resident for the first
+    // tiles of the next layer even if the whole activation doesn't fit.
+    build_ilp_matrices();
+    int num_tensors = uniqueTileNumberMap.size();
+
     auto print_array = [](auto &array0, auto &array1, auto &array2) {
         for(int k = 0; k < array0.size(); k++) {
-            //std::cout << "array[" << k << "] = " << array[k] << " ";
             std::cout << array0[k] << " ";
         }
 
@@ -615,25 +967,23 @@ void GraphAnalyzer::create_ilp_map(std::string map_path)
         print_array(spm0Map[i], spm1Map[i], spm2Map[i]);
     }
 
-
-    // TODO: create file of all tensor sizes
-    // TODO: make sure if the tensor size is greater than the spm size then we make it the size of the spm
-    // TODO: create file of spm sizes
-    
+    // tile sizes are in bytes, same as the spm sizes.
     std::ofstream tensorSizeFile;
     std::string fileName = map_path + "sizeFile.txt";
     tensorSizeFile.open(fileName);
     for(int i = 0; i < num_tensors; i++) {
-        uint32_t size = tensorSizeMap[i];
-        if(size > smv::kSpadSize) {
-            size = smv::kSpadSize;
-        }
-        tensorSizeFile << size << " ";
+        tensorSizeFile << tensorSizeMap[i] << " ";
     }
     tensorSizeFile.close();
 
-    std::vector<std::vector<std::vector<int>>> spmMaps{spm0Map, spm1Map, spm2Map};
-    for(int i = 0; i < 3; i++) {
+    // one size per spm, so the solver knows the spm geometry.
+    std::ofstream spmSizeFile(map_path + "spmSizeFile.txt");
+    for(int i = 0; i < spad_count; i++)
+        spmSizeFile << SmvBackend::SpadSize() << " ";
+    spmSizeFile.close();
+
+    SpmMapping spmMaps = get_baseline_spm_mapping();
+    for(int i = 0; i < spad_count; i++) {
         std::ofstream matrixFile;
         std::string fileName = map_path + "matrixFile" + std::to_string(i) + ".txt";
         matrixFile.open(fileName);
@@ -698,7 +1048,7 @@ void GraphAnalyzer::populate_pin_map()
     }
 }
 
-void GraphAnalyzer::dry_run_network()
+void GraphAnalyzer::tile_operators()
 {
     std::cout << "======================================================\n";
     std::cout << "      Tiling operators of the network...\n";
@@ -709,12 +1059,19 @@ void GraphAnalyzer::dry_run_network()
                 << OpType_Name(op->getOpType()) << ").\n";
         op->tile();
     }
+}
+
+void GraphAnalyzer::dry_run_network()
+{
+    tile_operators();
 
     std::cout << "======================================================\n";
     std::cout << "      Scheduling operators of the network...\n";
     std::cout << "======================================================\n";
     // Initialize number of pending inputs for every operator and put Data
-    // operators into the ready queue.
+    // operators into the ready queue. The queue is cleared first so the
+    // network can be dry run again with a different schedule order.
+    readyQueue.clear();
     for (auto nameOp : network->getOperators()) {
         Operator* op = nameOp.second;
         Vertex vertex = op->getVertex();
@@ -727,6 +1084,177 @@ void GraphAnalyzer::dry_run_network()
     scheduleReady();
 }
 
+ScheduleState GraphAnalyzer::init_schedule_state()
+{
+    ScheduleState state;
+    const Graph& graph = network->getGraph();
+    for (auto nameOp : network->getOperators()) {
+        Operator* op = nameOp.second;
+        int numPendingInputs = boost::in_degree(op->getVertex(), graph);
+        state.pending_inputs[op] = numPendingInputs;
+        if (numPendingInputs == 0)
+            state.ready.push_back(op);
+    }
+    return state;
+}
+
+void GraphAnalyzer::schedule_op(ScheduleState& state, Operator* op)
+{
+    state.order.push_back(op);
+    state.ready.erase(std::find(state.ready.begin(), state.ready.end(), op));
+    const Graph& graph = network->getGraph();
+    out_edge_iter outEdgeIt, outEdgeEnd;
+    for (boost::tie(outEdgeIt, outEdgeEnd) = out_edges(op->getVertex(), graph);
+         outEdgeIt != outEdgeEnd;
+         ++outEdgeIt) {
+        Operator* child =
+                get(boost::vertex_op, graph, target(*outEdgeIt, graph));
+        if (--state.pending_inputs[child] == 0)
+            state.ready.push_back(child);
+    }
+}
+
+std::vector<Operator*> GraphAnalyzer::get_default_schedule()
+{
+    ScheduleState state = init_schedule_state();
+    while (!state.ready.empty())
+        schedule_op(state, state.ready.front());
+    return state.order;
+}
+
+DmaTraffic GraphAnalyzer::get_schedule_traffic(
+        const std::vector<Operator*>& order)
+{
+    // the tile model works on the ready queue of a dry run.
+    readyQueue.assign(order.begin(), order.end());
+    bool was_verbose = verbose;
+    verbose = false;
+    get_tile_schedule();
+    get_tile_liveness_data();
+    create_tile_pin_map();
+    DmaTraffic traffic =
+            estimate_dma_traffic(get_tile_pin_spm_mapping(), "schedule").total;
+    verbose = was_verbose;
+    return traffic;
+}
+
+void GraphAnalyzer::restore_tile_schedule(const std::list<Operator*>& queue,
+                                          bool had_tile_schedule)
+{
+    readyQueue = queue;
+    if (!had_tile_schedule) {
+        tileSchedule.clear();
+        knownRegions.clear();
+        uniqueTileNumberMap.clear();
+        tilePinMap.clear();
+        tileSPMap.clear();
+        tilePins.clear();
+        return;
+    }
+    bool was_verbose = verbose;
+    verbose = false;
+    get_tile_schedule();
+    get_tile_liveness_data();
+    create_tile_pin_map();
+    verbose = was_verbose;
+}
+
+DmaTraffic GraphAnalyzer::estimate_schedule_traffic(
+        const std::vector<Operator*>& order)
+{
+    ScheduleState state = init_schedule_state();
+    for (Operator* op : order) {
+        assert(std::find(state.ready.begin(), state.ready.end(), op) !=
+                       state.ready.end() &&
+               "The schedule order is not a topological order!");
+        schedule_op(state, op);
+    }
+    std::list<Operator*> queue = readyQueue;
+    bool had_tile_schedule = !tileSchedule.empty();
+    DmaTraffic traffic = get_schedule_traffic(order);
+    restore_tile_schedule(queue, had_tile_schedule);
+    return traffic;
+}
+
+std::vector<Operator*> GraphAnalyzer::optimize_schedule(int beam_width)
+{
+    assert(beam_width > 0);
+    tile_operators();
+    std::list<Operator*> queue = readyQueue;
+    bool had_tile_schedule = !tileSchedule.empty();
+    auto score = [this](ScheduleState& state) {
+        DmaTraffic traffic = get_schedule_traffic(state.order);
+        state.traffic_bytes = traffic.load_bytes + traffic.store_bytes;
+    };
+
+    ScheduleState init = init_schedule_state();
+    // run all the Data operators first, they don't cost anything and make
+    // the weights available to every operator.
+    bool scheduled_data = true;
+    while (scheduled_data) {
+        scheduled_data = false;
+        for (Operator* op : init.ready) {
+            if (op->getOpType() == OpType::Data) {
+                schedule_op(init, op);
+                scheduled_data = true;
+                break;
+            }
+        }
+    }
+
+    // Every candidate is scored on its own tile schedule and pins, so tiles
+    // of activations that don't fit in a spm are still reused between a
+    // producer and a consumer that run close together.
+    std::vector<ScheduleState> beam = { init };
+    while (!beam.front().ready.empty()) {
+        std::vector<ScheduleState> candidates;
+        for (const auto& state : beam) {
+            for (Operator* op : state.ready) {
+                candidates.push_back(state);
+                schedule_op(candidates.back(), op);
+                score(candidates.back());
+            }
+        }
+        // Ties keep the expansion order, which prefers the FIFO order.
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const ScheduleState& a, const ScheduleState& b) {
+                             return a.traffic_bytes < b.traffic_bytes;
+                         });
+        // Partial schedules that ran the same set of operators only differ in
+        // what is left on the spms, so keep the cheapest one of them.
+        beam.clear();
+        std::set<std::set<Operator*>> seen;
+        for (auto& state : candidates) {
+            std::set<Operator*> scheduled(
+                    state.order.begin(), state.order.end());
+            if (!seen.insert(scheduled).second)
+                continue;
+            beam.push_back(std::move(state));
+            if (beam.size() == beam_width)
+                break;
+        }
+    }
+
+    std::vector<Operator*> order = beam.front().order;
+    DmaTraffic fifo_traffic = get_schedule_traffic(get_default_schedule());
+    uint64_t fifo_bytes = fifo_traffic.load_bytes + fifo_traffic.store_bytes;
+    restore_tile_schedule(queue, had_tile_schedule);
+    std::cout << "Schedule DMA traffic: FIFO " << fifo_bytes
+              << " bytes, optimized " << beam.front().traffic_bytes
+              << " bytes (beam width " << beam_width << ")." << std::endl;
+    if (fifo_bytes <= beam.front().traffic_bytes)
+        return get_default_schedule();
+    return order;
+}
+
+void GraphAnalyzer::write_schedule_order(const std::vector<Operator*>& order,
+                                         std::string file_name)
+{
+    std::ofstream orderFile(file_name);
+    for (Operator* op : order)
+        orderFile << op->getName() << "\n";
+}
+
 void GraphAnalyzer::remove_duplicate_cycles()
 {
     for(auto &node : livenessMap)
@@ -735,4 +1263,281 @@ void GraphAnalyzer::remove_duplicate_cycles()
     }
 }
 
+uint64_t DmaTraffic::get_cycles(const DmaModel& model) const
+{
+    uint64_t bytes = load_bytes + store_bytes;
+    return (uint64_t)(loads + stores) * model.latency_cycles +
+           (uint64_t)std::ceil(bytes / model.bytes_per_cycle);
+}
+
+uint64_t GraphAnalyzer::get_parallel_dma_cycles(const DmaReport& report,
+                                                int num_accels)
+{
+    assert(report.per_step.size() == tileSchedule.size() &&
+           "The report must be of the current tile schedule!");
+    uint64_t cycles = 0;
+    std::vector<uint64_t> accel_cycles(num_accels, 0);
+    int accel = 0;
+    for(int i = 0; i < tileSchedule.size(); i++) {
+        accel_cycles[accel] += report.per_step[i].get_cycles(dma_model);
+        accel = (accel + 1) % num_accels;
+        // the next operator starts when the slowest accelerator is done.
+        if(i + 1 == tileSchedule.size() ||
+           tileSchedule[i + 1].op != tileSchedule[i].op) {
+            cycles += *std::max_element(accel_cycles.begin(),
+                                        accel_cycles.end());
+            std::fill(accel_cycles.begin(), accel_cycles.end(), 0);
+            accel = 0;
+        }
+    }
+    return cycles;
+}
+
+SpmMapping GraphAnalyzer::get_baseline_spm_mapping()
+{
+    build_ilp_matrices();
+    SpmMapping mapping(spad_count, std::vector<std::vector<int>>(
+            spm0Map.size(), std::vector<int>(uniqueTileNumberMap.size(), 0)));
+    mapping[0] = spm0Map;
+    mapping[1] = spm1Map;
+    mapping[kernel_output_spm] = spm2Map;
+    return mapping;
+}
+
+SpmMapping GraphAnalyzer::get_tile_pin_spm_mapping()
+{
+    SpmMapping mapping = get_baseline_spm_mapping();
+    // a pinned region stays on its spm for every step between the two uses.
+    for(const auto& pin : tilePins) {
+        int tensorIdx = uniqueTileNumberMap.at(pin.region);
+        for(uint32_t i = pin.begin; i <= pin.end; i++)
+            mapping[pin.spm][i][tensorIdx] = 1;
+    }
+    return mapping;
+}
+
+SpmMapping GraphAnalyzer::load_spm_mapping(std::string path, std::string prefix)
+{
+    SpmMapping mapping;
+    for(int i = 0; i < spad_count; i++) {
+        std::string fileName = path + prefix + std::to_string(i) + ".txt";
+        std::ifstream matrixFile(fileName);
+        if(!matrixFile.is_open()) {
+            std::cerr << "Failed to open the spm mapping file " << fileName
+                      << "!\n";
+            exit(1);
+        }
+        std::vector<std::vector<int>> spmMap;
+        std::string line;
+        while(std::getline(matrixFile, line)) {
+            std::istringstream lineStream(line);
+            std::vector<int> row;
+            int value;
+            while(lineStream >> value)
+                row.push_back(value);
+            if(!row.empty())
+                spmMap.push_back(row);
+        }
+        mapping.push_back(spmMap);
+    }
+    return mapping;
+}
+
+DmaReport GraphAnalyzer::estimate_dma_traffic(const SpmMapping& mapping,
+                                              std::string mapping_name)
+{
+    // the regions have to be numbered the same way as the mapping.
+    if(uniqueTileNumberMap.empty())
+        build_ilp_matrices();
+    int num_steps = tileSchedule.size();
+    int num_tensors = uniqueTileNumberMap.size();
+    assert(mapping.size() == spad_count &&
+           "The mapping must have a matrix for every spm!");
+    for(const auto& spmMap : mapping) {
+        assert(spmMap.size() == num_steps &&
+               "The mapping must have a row for every tile step!");
+        for(const auto& row : spmMap)
+            assert(row.size() == num_tensors &&
+                   "The mapping must have a column for every tile region!");
+    }
+
+    std::vector<const TileRegion*> regions(num_tensors);
+    for(const auto& [region, tensorIdx] : uniqueTileNumberMap)
+        regions[tensorIdx] = &region;
+    // which regions every step reads and writes.
+    std::vector<std::vector<bool>> reads(
+            num_steps, std::vector<bool>(num_tensors, false));
+    std::vector<std::vector<bool>> writes(
+            num_steps, std::vector<bool>(num_tensors, false));
+    for(int i = 0; i < num_steps; i++) {
+        for(const auto& access : tileSchedule[i].inputs) {
+            for(const auto& region : access.regions)
+                reads[i][uniqueTileNumberMap[region]] = true;
+        }
+        for(const auto& access : tileSchedule[i].outputs) {
+            for(const auto& region : access.regions)
+                writes[i][uniqueTileNumberMap[region]] = true;
+        }
+    }
+
+    DmaReport report;
+    report.mapping = mapping_name;
+    report.per_spm.resize(spad_count);
+    report.per_step.resize(num_steps);
+    std::map<Operator*, int> opIndex;
+    for(const auto& step : tileSchedule) {
+        if(opIndex.count(step.op))
+            continue;
+        opIndex[step.op] = report.per_op.size();
+        report.per_op.push_back({ step.op->getName(), DmaTraffic() });
+    }
+    auto add_transfer = [&](int step, int tensorIdx, int spm, bool load) {
+        // whole untiled tensors are moved in full even if they are bigger
+        // than a spm.
+        uint64_t bytes = regions[tensorIdx]->size;
+        std::vector<DmaTraffic*> traffic = {
+            &report.total,
+            &report.per_op[opIndex[tileSchedule[step].op]].second,
+            &report.per_step[step],
+            &report.per_tensor[regions[tensorIdx]->tensor->getName()],
+            &report.per_spm[spm]
+        };
+        for(auto t : traffic) {
+            if(load)
+                t->add_load(bytes);
+            else
+                t->add_store(bytes);
+        }
+    };
+
+    // A region is loaded when it's read while not on a spm yet, and stored
+    // when it leaves the spms after having been written there. It only stays
+    // resident from one step to the next if it's kept on the same spm, e.g.
+    // an output tile on spm2 that the next step reads from spm0 is stored and
+    // loaded again. Regions that are produced on a spm are never loaded.
+    for(int n = 0; n < num_tensors; n++) {
+        unsigned prevSpms = 0;
+        bool loaded = false;
+        bool dirty = false;
+        int residentSpm = -1;
+        int residentStep = -1;
+        for(int m = 0; m < num_steps; m++) {
+            unsigned spms = 0;
+            for(int k = 0; k < spad_count; k++) {
+                if(mapping[k][m][n])
+                    spms |= 1u << k;
+            }
+            if(prevSpms && !(prevSpms & spms)) {
+                if(dirty)
+                    add_transfer(m - 1, n, residentSpm, false);
+            }
+            if(!spms) {
+                // the mapping doesn't put an accessed region on any spm, so
+                // it's streamed in and out through the default spms.
+                if(reads[m][n])
+                    add_transfer(m, n, 0, true);
+                if(writes[m][n])
+                    add_transfer(m, n, kernel_output_spm, false);
+                prevSpms = 0;
+                continue;
+            }
+            if(!(prevSpms & spms)) {
+                loaded = false;
+                dirty = false;
+                residentSpm = __builtin_ctz(spms);
+                residentStep = m;
+            }
+            if(reads[m][n] && !loaded && !dirty) {
+                // the load happens when the region is put on the spm.
+                add_transfer(residentStep, n, residentSpm, true);
+                loaded = true;
+            }
+            if(writes[m][n])
+                dirty = true;
+            prevSpms = spms;
+        }
+        if(prevSpms && dirty)
+            add_transfer(num_steps - 1, n, residentSpm, false);
+    }
+
+    if(verbose) {
+        std::cout << "DMA traffic of the " << mapping_name << " mapping: "
+                  << report.total.load_bytes << " bytes loaded, "
+                  << report.total.store_bytes << " bytes stored, "
+                  << report.total.get_cycles(dma_model) << " cycles\n";
+    }
+    return report;
+}
+
+void GraphAnalyzer::write_dma_report_json(const std::vector<DmaReport>& reports,
+                                          std::string file_name)
+{
+    std::ofstream jsonFile(file_name);
+    auto write_traffic = [this, &jsonFile](const DmaTraffic& traffic) {
+        jsonFile << "{\"load_bytes\": " << traffic.load_bytes
+                 << ", \"store_bytes\": " << traffic.store_bytes
+                 << ", \"loads\": " << traffic.loads
+                 << ", \"stores\": " << traffic.stores
+                 << ", \"cycles\": " << traffic.get_cycles(dma_model) << "}";
+    };
+    jsonFile << "{\n  \"dma_model\": {\"bytes_per_cycle\": "
+             << dma_model.bytes_per_cycle
+             << ", \"latency_cycles\": " << dma_model.latency_cycles
+             << "},\n  \"mappings\": [";
+    for(int i = 0; i < reports.size(); i++) {
+        const DmaReport& report = reports[i];
+        jsonFile << (i == 0 ? "\n" : ",\n") << "    {\n      \"name\": \""
+                 << report.mapping << "\",\n      \"total\": ";
+        write_traffic(report.total);
+        jsonFile << ",\n      \"operators\": {";
+        for(int j = 0; j < report.per_op.size(); j++) {
+            jsonFile << (j == 0 ? "\n" : ",\n") << "        \""
+                     << report.per_op[j].first << "\": ";
+            write_traffic(report.per_op[j].second);
+        }
+        jsonFile << "\n      },\n      \"tensors\": {";
+        bool first = true;
+        for(const auto& [name, traffic] : report.per_tensor) {
+            jsonFile << (first ? "\n" : ",\n") << "        \"" << name
+                     << "\": ";
+            write_traffic(traffic);
+            first = false;
+        }
+        jsonFile << "\n      },\n      \"spms\": [";
+        for(int j = 0; j < report.per_spm.size(); j++) {
+            jsonFile << (j == 0 ? "\n" : ",\n") << "        ";
+            write_traffic(report.per_spm[j]);
+        }
+        jsonFile << "\n      ]\n    }";
+    }
+    jsonFile << "\n  ]\n}\n";
+}
+
+void GraphAnalyzer::write_dma_report_csv(const std::vector<DmaReport>& reports,
+                                         std::string file_name)
+{
+    std::ofstream csvFile(file_name);
+    csvFile << "mapping,scope,name,load_bytes,store_bytes,loads,stores,cycles\n";
+    auto write_row = [this, &csvFile](const std::string& mapping,
+                                      const std::string& scope,
+                                      const std::string& name,
+                                      const DmaTraffic& traffic) {
+        csvFile << mapping << "," << scope << "," << name << ","
+                << traffic.load_bytes << "," << traffic.store_bytes << ","
+                << traffic.loads << "," << traffic.stores << ","
+                << traffic.get_cycles(dma_model) << "\n";
+    };
+    for(const auto& report : reports) {
+        write_row(report.mapping, "total", "", report.total);
+        for(const auto& [name, traffic] : report.per_op)
+            write_row(report.mapping, "operator", name, traffic);
+        for(const auto& [name, traffic] : report.per_tensor)
+            write_row(report.mapping, "tensor", name, traffic);
+        for(int i = 0; i < report.per_spm.size(); i++) {
+            write_row(report.mapping, "spm", "spm" + std::to_string(i),
+                      report.per_spm[i]);
+        }
+    }
+}
+
 } //smaug
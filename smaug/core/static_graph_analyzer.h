@@ -1,8 +1,12 @@
 #ifndef _CORE_ANALYSIS_H_
 #define _CORE_ANALYSIS_H_
-#define SMV_SPAD_COUNT 3
 
+#include <list>
+#include <cassert>
 #include <map>
+#include <string>
+#include <tuple>
+#include <vector>
 #include <cstdint>
 
 #include "smaug/core/scheduler.h"
@@ -14,6 +18,134 @@
 
 namespace smaug {
 
+/**
+ * A region of a tensor that is streamed through a scratchpad as one tile.
+ *
+ * Operators tile the same tensor differently (row tiles with halos for
+ * convolutions, flat chunks for unary ops, ...), so regions are identified by
+ * the range of linear storage indices they span in the original tensor. A
+ * tile that a consumer reads is served by the producer's tiles whose ranges
+ * cover it, which is what lets a producer's output tile stay resident on the
+ * scratchpad for the consumer.
+ */
+struct TileRegion {
+    TileRegion() : tensor(nullptr), begin(0), end(0), contiguous(true), size(0) {}
+    TileRegion(TensorBase* _tensor,
+               int _begin,
+               int _end,
+               bool _contiguous,
+               uint32_t _size)
+            : tensor(_tensor), begin(_begin), end(_end),
+              contiguous(_contiguous), size(_size) {}
+
+    bool operator<(const TileRegion& other) const {
+        return std::tie(tensor, begin, end) <
+               std::tie(other.tensor, other.begin, other.end);
+    }
+    bool operator==(const TileRegion& other) const {
+        return std::tie(tensor, begin, end) ==
+               std::tie(other.tensor, other.begin, other.end);
+    }
+    bool overlaps(const TileRegion& other) const {
+        return tensor == other.tensor && begin < other.end &&
+               other.begin < end;
+    }
+
+    std::string getName() const;
+
+    /** The original (untiled) tensor this region belongs to. */
+    TensorBase* tensor;
+    /** The first linear storage index of the region in the tensor. */
+    int begin;
+    /** One past the last linear storage index of the region. */
+    int end;
+    /**
+     * True if the region occupies every element in [begin, end). Regions that
+     * are tiled in an inner dimension (e.g. channelwise) are not, and can only
+     * be matched exactly.
+     */
+    bool contiguous;
+    /** Storage size of the region in bytes, including alignment padding. */
+    uint32_t size;
+};
+
+/** A tile that an operator reads or writes, and the regions backing it. */
+struct TileAccess {
+    Tensor* tile;
+    std::vector<TileRegion> regions;
+};
+
+/**
+ * The tiles read and written by one kernel invocation of an operator. The
+ * tile Tensors are kept alongside their regions so that pin decisions can be
+ * mapped back to the tiles the operator actually dispatches.
+ */
+struct TileStep {
+    Operator* op;
+    std::vector<TileAccess> inputs;
+    std::vector<TileAccess> outputs;
+};
+
+/** A tile region kept on a spm between two of its uses. */
+struct TilePin {
+    TileRegion region;
+    int spm;
+    uint32_t begin;
+    uint32_t end;
+};
+
+/**
+ * A simple DMA cost model: every transfer pays a fixed setup latency and then
+ * moves data at a fixed bandwidth.
+ */
+struct DmaModel {
+    double bytes_per_cycle = 16;
+    uint32_t latency_cycles = 100;
+};
+
+/** DMA traffic of some part of the network under an SPM mapping. */
+struct DmaTraffic {
+    uint64_t load_bytes = 0;
+    uint64_t store_bytes = 0;
+    uint32_t loads = 0;
+    uint32_t stores = 0;
+
+    void add_load(uint64_t bytes) { load_bytes += bytes; loads++; }
+    void add_store(uint64_t bytes) { store_bytes += bytes; stores++; }
+    uint64_t get_cycles(const DmaModel& model) const;
+};
+
+/**
+ * The DMA traffic of one SPM mapping, broken down per operator (in schedule
+ * order), per tile step, per tensor and per scratchpad.
+ */
+struct DmaReport {
+    std::string mapping;
+    DmaTraffic total;
+    std::vector<std::pair<std::string, DmaTraffic>> per_op;
+    std::vector<DmaTraffic> per_step;
+    std::map<std::string, DmaTraffic> per_tensor;
+    std::vector<DmaTraffic> per_spm;
+};
+
+/**
+ * An SPM mapping in the same form as the ILP matrices: for every spm, every
+ * tile step and every tile region, 1 if the region is on that spm.
+ */
+using SpmMapping = std::vector<std::vector<std::vector<int>>>;
+
+/**
+ * A partial schedule explored by GraphAnalyzer::optimize_schedule. The cost
+ * is the DMA traffic, loads and stores, of the tile schedule of the operators
+ * run so far, pinned for that order.
+ */
+struct ScheduleState {
+    std::vector<Operator*> order;
+    std::map<Operator*, int> pending_inputs;
+    std::vector<Operator*> ready;
+    uint64_t traffic_bytes = 0;
+};
+
 /**
  * The graph analyzer will analyze the network graph to calculate the tensor
  * usage counts and time to live and label their FOMDs.
@@ -22,12 +154,20 @@ namespace smaug {
 class GraphAnalyzer : public Scheduler {
     public:
         std::map<Tensor, bool> findTensorsToPin();
-        GraphAnalyzer(Network* _network, Workspace* _workspace) : Scheduler(_network, _workspace) { spad_count = SMV_SPAD_COUNT;}
-        GraphAnalyzer(Network* _network, Workspace* _workspace, int _spad_count) : Scheduler(_network, _workspace), spad_count{_spad_count} {}
+        GraphAnalyzer(Network* _network, Workspace* _workspace) : Scheduler(_network, _workspace) { spad_count = SmvBackend::NumSpads();}
+        // the kernels stream their tiles through the first three spms, any
+        // spm after those only holds pinned tiles.
+        GraphAnalyzer(Network* _network, Workspace* _workspace, int _spad_count) : Scheduler(_network, _workspace), spad_count{_spad_count} {
+            assert(spad_count >= 3 && "The SMV kernels need three spms!");
+        }
 
         void compare_schedule_list();
         void create_ilp_map(std::string map_path);
         void populate_pin_map();
+        // same as populate_pin_map, but the liveness and pinning analysis is
+        // done on the individual tiles that the operators stream through the
+        // scratchpads instead of on whole tensors.
+        void populate_tile_pin_map();
         // creates a schedule of all the ops in the network wihtout executing
         // any of them so that we have a reference to the execution schedule
         // independant of the one that will actually run. (we don't change the
@@ -35,6 +175,63 @@ class GraphAnalyzer : public Scheduler {
         void dry_run_network();
         std::map<Operator*, std::vector<TensorBase*>>* get_pin_map();
 
+        // search for an operator order that keeps tensors on the spms
+        // between their producer and consumers. A beam search keeps the
+        // beam_width cheapest partial schedules at every step, so a width of
+        // 1 is a greedy list scheduler. The order of the default FIFO
+        // scheduler is returned instead if it is cheaper. Pass the result to
+        // setScheduleOrder before dry_run_network or runNetwork to use it.
+        std::vector<Operator*> optimize_schedule(int beam_width);
+        // the order the operators ran in during the last dry run.
+        std::vector<Operator*> get_schedule() const {
+            return std::vector<Operator*>(readyQueue.begin(), readyQueue.end());
+        }
+        // the kernel invocations of the operators of the last dry run, as
+        // found by populate_tile_pin_map.
+        const std::vector<TileStep>& get_tile_steps() const {
+            return tileSchedule;
+        }
+        // the order the default FIFO scheduler runs the operators in.
+        std::vector<Operator*> get_default_schedule();
+        // the DMA traffic of running the operators in the given order: the
+        // tile schedule of that order is pinned the same way as by
+        // populate_tile_pin_map, and its loads and stores are counted by
+        // estimate_dma_traffic. This is the cost optimize_schedule minimizes.
+        // The operators must have been tiled already.
+        DmaTraffic estimate_schedule_traffic(
+                const std::vector<Operator*>& order);
+        // write the operator names one per line, the format read by
+        // smaug's --schedule-order option.
+        void write_schedule_order(const std::vector<Operator*>& order,
+                                  std::string file_name);
+
+        // SPM mappings that can be fed to estimate_dma_traffic. The baseline
+        // loads every tile when it's used and keeps nothing around, the tile
+        // pin mapping adds the pins from populate_tile_pin_map, and a solver
+        // mapping is read back from <path><prefix>{0,1,2}.txt, e.g. the
+        // optimal*.txt files written by gurobi/prayers.py.
+        SpmMapping get_baseline_spm_mapping();
+        SpmMapping get_tile_pin_spm_mapping();
+        SpmMapping load_spm_mapping(std::string path, std::string prefix);
+
+        // estimate the bytes loaded to and stored from the spms, and the DMA
+        // cycles that takes, for the given mapping of the tile schedule.
+        DmaReport estimate_dma_traffic(const SpmMapping& mapping,
+                                       std::string mapping_name);
+        // the DMA cycles of a report when the tile steps of every operator
+        // are spread round robin over num_accels accelerators, each with its
+        // own spms and DMA engine. Operators still run one after another.
+        uint64_t get_parallel_dma_cycles(const DmaReport& report,
+                                         int num_accels);
+        void set_dma_model(const DmaModel& model) { dma_model = model; }
+        const DmaModel& get_dma_model() const { return dma_model; }
+
+        // write the reports of one or more mappings for comparison.
+        void write_dma_report_json(const std::vector<DmaReport>& reports,
+                                   std::string file_name);
+        void write_dma_report_csv(const std::vector<DmaReport>& reports,
+                                  std::string file_name);
+
     protected:
         // override from Scheduler class to not actually run any kernels so we
         // can dry run the network.
@@ -49,6 +246,50 @@ class GraphAnalyzer : public Scheduler {
         // update the livenessmap with a new entry or cycle count
         void update_liveness_map(TensorBase* tensor, uint32_t op_cycle);
 
+        // break every operator in the schedule down into its kernel
+        // invocations (tile steps). Operators that are not tiled become one
+        // step over their whole input and output tensors.
+        void get_tile_schedule();
+
+        // find the regions backing a tile an operator reads. If the tiles
+        // already seen for the tensor cover it, those are used, otherwise the
+        // tile becomes a new region.
+        std::vector<TileRegion> get_read_regions(const TileRegion& tile);
+
+        // get liveness data for each tile region. The cycle is the index of
+        // the tile step rather than the index of the operator.
+        void get_tile_liveness_data();
+
+        // greedily pin tile regions between consecutive uses as long as they
+        // fit on a scratchpad for every tile step in between.
+        void create_tile_pin_map();
+
+        // number the tile regions and fill the spm matrices of the baseline
+        // mapping (spm0Map, spm1Map and spm2Map) from the tile schedule.
+        void build_ilp_matrices();
+
+        // the storage size of a region, capped to the scratchpad size for
+        // whole tensors that are never tiled (e.g. host-side ops).
+        uint32_t get_region_spm_size(const TileRegion& region) const;
+
+        // tile every operator of the network.
+        void tile_operators();
+
+        // start a schedule with no operators run.
+        ScheduleState init_schedule_state();
+
+        // append op to the schedule and update the operators that are ready.
+        void schedule_op(ScheduleState& state, Operator* op);
+
+        // build the tile schedule and tile pins of the given order in place
+        // of the ones of the last dry run, and return their DMA traffic.
+        DmaTraffic get_schedule_traffic(const std::vector<Operator*>& order);
+
+        // rebuild the tile schedule and tile pins of the last dry run after
+        // they were replaced by get_schedule_traffic.
+        void restore_tile_schedule(const std::list<Operator*>& queue,
+                                   bool had_tile_schedule);
+
         // remove duplicate cycles in the liveness map this is an artifact of
         // how we update the use_counts in LivenessData
         void remove_duplicate_cycles();
@@ -91,6 +332,16 @@ class GraphAnalyzer : public Scheduler {
         std::map<uint32_t, std::vector<TensorBase*>> op_cycle_to_input_output_mapping;
         std::map<TensorBase*, uint32_t> uniqueTensorNumberMap;
         std::map<uint32_t, uint32_t> tensorSizeMap;
+
+        std::vector<TileStep> tileSchedule;
+        std::map<TileRegion, LivenessData*> tileLivenessMap;
+        std::map<TileRegion, uint32_t> uniqueTileNumberMap;
+        std::map<TensorBase*, std::vector<TileRegion>> knownRegions;
+        std::vector<TilePin> tilePins;
+        DmaModel dma_model;
+        // print the details of every pass. Off while scoring the candidate
+        // orders of optimize_schedule.
+        bool verbose = true;
 };
 } //smaug
 #endif
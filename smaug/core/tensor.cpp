@@ -1,6 +1,8 @@
 #include "smaug/core/tensor.h"
+#include "smaug/core/csr_data.h"
 #include "smaug/core/tensor_utils.h"
 #include "smaug/core/globals.h"
+#include "smaug/core/param_store.h"
 #include "smaug/utility/thread_pool.h"
 
 namespace smaug {
@@ -21,6 +23,13 @@ TensorProto* Tensor::asTensorProto() {
     tensorProto->set_data_format(dataFormat);
     // Copy the tensor data into the proto.
     TensorData* protoData = new TensorData();
+    if (csrData) {
+        csrData->toTensorData(protoData);
+        tensorProto->set_allocated_data(protoData);
+        return tensorProto;
+    }
+    if (paramStore)
+        loadParams();
     void* rawPtr = tensorData.get();
     switch (dataType) {
         case Float16:
@@ -62,6 +71,25 @@ TensorProto* Tensor::asTensorProto() {
     return tensorProto;
 }
 
+void Tensor::loadParams() const {
+    // Loading the data doesn't change the contents of the Tensor.
+    paramStore->load(const_cast<Tensor*>(this));
+}
+
+void Tensor::fillCompressedData(DataType _dataType,
+                                const TensorData& tensorData) {
+    assert(dataFormat == CSR && "Only the CSR data format is supported!");
+    dataType = _dataType;
+    csrData = std::make_shared<CsrData>(shape, _dataType, tensorData);
+}
+
+void Tensor::decompressData() const {
+    // Like loading the parameters, this doesn't change the contents.
+    Tensor* tensor = const_cast<Tensor*>(this);
+    tensor->allocateStorage(dataType);
+    csrData->decompressRange(tensor, 0, shape.storageSize());
+}
+
 Tensor* TiledTensor::getTileWithData(int index) {
     Tile* tile = &tiles[index];
     copyDataToTile(tile);
@@ -114,12 +142,15 @@ void TiledTensor::parallelCopyTileData(TileDataOperation op) {
 }
 
 void TiledTensor::copyDataToAllTiles() {
-    // Don't copy if all the tiles have data filled.
-    if (dataFilled)
-        return;
-
     assert(origTensor != nullptr &&
            "TiledTensor must have the original tensor to copy data from!");
+    // Don't copy if all the tiles have the current data filled. The tiles of
+    // a deferred tensor may have been freed since, so they are checked one
+    // by one.
+    if (dataFilled && filledVersion == origTensor->getDataVersion() &&
+        !origTensor->isDataDeferred())
+        return;
+
     if (fastForwardMode || !threadPool || tiles.size() == 1) {
         for (auto index = startIndex(); !index.end(); ++index)
             copyDataToTile(&tiles[index]);
@@ -127,18 +158,39 @@ void TiledTensor::copyDataToAllTiles() {
         parallelCopyTileData(Scatter);
     }
     dataFilled = true;
+    filledVersion = origTensor->getDataVersion();
 }
 
 void TiledTensor::copyDataToTile(Tile* tile) {
-    // Don't copy if the tile already has data,  or if the tile is the original
-    // tensor (we have only one tile).
-    if (tile->hasData || tile->tensor == origTensor)
+    // Don't copy if the tile is the original tensor (we have only one tile),
+    // or if the tile already has the current data.
+    if (tile->tensor == origTensor)
+        return;
+    if (tile->hasData && tile->tensor->containsData() &&
+        (!origTensor || tile->dataVersion == origTensor->getDataVersion()))
         return;
 
     // Perform the data copy.
     assert(tile->hasOrigin &&
            "Must set the tile's origin in the original tensor!");
-    if (useRawTensor) {
+    // The tiles of a deferred tensor only get storage when they are filled,
+    // and the ParamStore frees them again with the tensor.
+    if (!tile->tensor->containsData()) {
+        tile->tensor->allocateStorage(origTensor->getDataType());
+        if (ParamStore* paramStore = origTensor->getParamStore())
+            paramStore->addTile(origTensor, tile->tensor);
+    }
+    if (const CsrData* csrData = origTensor->getCsrData()) {
+        // Decompress the tile without decompressing the whole tensor.
+        Tensor* tensor = tile->tensor;
+        if (useRawTensor) {
+            csrData->decompressRange(tensor, tile->origin[0],
+                                     tensor->getShape().storageSize());
+        } else {
+            csrData->decompressRegion(
+                    tensor, tile->origin, tensor->getShape().dims());
+        }
+    } else if (useRawTensor) {
         // Use the raw tensor copy function for the unary tile.
         copyRawTensorData(tile->tensor, origTensor, 0, tile->origin[0],
                           tile->tensor->getShape().storageSize());
@@ -148,6 +200,16 @@ void TiledTensor::copyDataToTile(Tile* tile) {
                          tile->tensor->getShape().dims());
     }
     tile->hasData = true;
+    tile->dataVersion = origTensor->getDataVersion();
+}
+
+void TiledTensor::releaseDecompressedTiles() {
+    if (!origTensor || !origTensor->getCsrData())
+        return;
+    for (Tile& tile : tiles) {
+        if (tile.tensor != origTensor)
+            tile.tensor->tensorData.reset();
+    }
 }
 
 void TiledTensor::untile() {
@@ -17,6 +17,9 @@
 
 namespace smaug {
 
+class CsrData;
+class ParamStore;
+
 /**
  * TensorShape describes the shape of a Tensor.
  *
@@ -318,8 +321,8 @@ class TensorBase {
     /** Shape of the Tensor. */
     TensorShape shape;
     /**
-     * Indicates the compression format of the data.
-     * NOTE: Compressed data formats are not currently supported in SMAUG.
+     * Indicates the compression format of the data. Only the CSR format is
+     * supported, for tensors filled from serialized data.
      */
     DataStorageFormat dataFormat;
     DataType dataType;
@@ -340,14 +343,25 @@ class TensorBase {
  * incoming data. Afterwards, the underlying data array can be accessed with
  * Tensor::data<T> (which will check that T matches the expected data type and
  * assert-fail if not) and indexed using TensorIndexIterator.
+ *
+ * The data of a network parameter may instead be loaded from a ParamStore on
+ * the first call to Tensor::data<T>, and be evicted again when it is not used.
+ * A Tensor with the CSR data format keeps its data compressed, and its tiles
+ * are decompressed from it. Tensor::data<T> decompresses the whole Tensor.
+ *
+ * Tiles copied from a Tensor are only copied again once its data version is
+ * bumped, which the Scheduler does for the outputs of every Operator it runs.
  */
 class Tensor : public TensorBase {
    public:
-    Tensor() : TensorBase(), tensorData(NULL) {}
+    Tensor()
+            : TensorBase(), tensorData(NULL), csrData(nullptr),
+              paramStore(nullptr), dataVersion(0) {}
 
     /** Construct a Tensor with the given name and shape. */
     Tensor(const std::string& _name, const TensorShape& _shape)
-            : TensorBase(_name, _shape), tensorData(NULL) {}
+            : TensorBase(_name, _shape), tensorData(NULL), csrData(nullptr),
+              paramStore(nullptr), dataVersion(0) {}
     virtual ~Tensor() {}
 
     /**
@@ -357,9 +371,80 @@ class Tensor : public TensorBase {
      * @param tensorData The data contents of the Tensor.
      */
     Tensor(const TensorProto& tensorProto, const TensorData& tensorData)
-            : TensorBase(tensorProto), tensorData(NULL) {
-        DataType dataType = tensorProto.data_type();
-        switch (dataType) {
+            : TensorBase(tensorProto), tensorData(NULL), csrData(nullptr),
+              paramStore(nullptr), dataVersion(0) {
+        fillData(tensorProto.data_type(), tensorData);
+    }
+
+    /**
+     * Constructs a Tensor from serialized protobufs, without its data (e.g.
+     * for it to be added to a ParamStore).
+     */
+    explicit Tensor(const TensorProto& tensorProto)
+            : TensorBase(tensorProto), tensorData(NULL), csrData(nullptr),
+              paramStore(nullptr), dataVersion(0) {}
+
+    /** Returns an iterator starting at the beginning of the Tensor. */
+    TensorIndexIterator startIndex() const {
+        return TensorIndexIterator(shape);
+    }
+
+    virtual bool containsData() const {
+        return tensorData != nullptr || csrData != nullptr ||
+               paramStore != nullptr;
+    }
+
+    /**
+     * Returns true if the data of this Tensor is not kept dense in memory,
+     * in which case its tiles are only filled when they are used.
+     */
+    bool isDataDeferred() const {
+        return csrData != nullptr || paramStore != nullptr;
+    }
+
+    /**
+     * Returns the current storage of the Tensor, or null if it has none. The
+     * storage is kept alive by the returned pointer even if the Tensor frees
+     * it, e.g. when a ParamStore evicts the Tensor.
+     */
+    std::shared_ptr<const void> getSharedStorage() const { return tensorData; }
+
+    /** Returns the compressed data of a CSR Tensor, or null. */
+    const CsrData* getCsrData() const { return csrData.get(); }
+
+    /**
+     * Returns true if a CSR Tensor currently holds a dense copy of its data,
+     * which it gets when the whole Tensor is accessed.
+     */
+    bool isDecompressed() const { return csrData && tensorData; }
+
+    /**
+     * Frees the dense copy of the data of a CSR Tensor. The data is
+     * decompressed again when it is next accessed.
+     */
+    void releaseDecompressedData() {
+        if (csrData)
+            tensorData.reset();
+    }
+
+    /**
+     * Returns the ParamStore this Tensor loads its data from, or null if the
+     * data is always in memory.
+     */
+    ParamStore* getParamStore() const { return paramStore; }
+
+    /**
+     * Fills the Tensor with serialized data of the given type. The data of a
+     * CSR Tensor stays compressed. The PackedCSR format is not supported.
+     */
+    void fillData(DataType _dataType, const TensorData& tensorData) {
+        assert(dataFormat != PackedCSR &&
+               "The PackedCSR data format is not supported!");
+        if (dataFormat == CSR) {
+            fillCompressedData(_dataType, tensorData);
+            return;
+        }
+        switch (_dataType) {
             case Float16:
                 fillHalfData(tensorData.half_data());
                 break;
@@ -383,13 +468,6 @@ class Tensor : public TensorBase {
         }
     }
 
-    /** Returns an iterator starting at the beginning of the Tensor. */
-    TensorIndexIterator startIndex() const {
-        return TensorIndexIterator(shape);
-    }
-
-    virtual bool containsData() const { return tensorData != nullptr; }
-
     /**
      * Fills the Tensor with externalData.
      *
@@ -511,6 +589,33 @@ class Tensor : public TensorBase {
         }
     }
 
+    /**
+     * Sets the data type without allocating storage, for a Tensor whose
+     * storage is only allocated when it is first filled (e.g. a tile of a
+     * Tensor whose data is deferred).
+     */
+    void setDataType(DataType _dataType) { dataType = _dataType; }
+
+    /**
+     * Makes the Tensor use externally owned storage of the given type instead
+     * of its own, without copying. The storage must cover the whole Tensor,
+     * including the alignment padding, and outlive its use by the Tensor.
+     */
+    void setExternalData(void* externalData, DataType _dataType) {
+        dataType = _dataType;
+        tensorData = std::shared_ptr<void>(externalData, [](void*) {});
+        bumpDataVersion();
+    }
+
+    /**
+     * Returns the version of the data, which changes whenever the data is
+     * rewritten by an Operator or replaced.
+     */
+    uint64_t getDataVersion() const { return dataVersion; }
+
+    /** Marks the data as changed, so that its tiles are copied again. */
+    void bumpDataVersion() { dataVersion++; }
+
     /** Serializes this Tensor to a TensorProto. */
     TensorProto* asTensorProto();
 
@@ -520,6 +625,10 @@ class Tensor : public TensorBase {
     template <typename T>
     const T* data() const {
         assert(ToDataType<T>::dataType == dataType);
+        if (paramStore)
+            loadParams();
+        else if (csrData && !tensorData)
+            decompressData();
         return reinterpret_cast<T*>(tensorData.get());
     }
 
@@ -529,6 +638,10 @@ class Tensor : public TensorBase {
     template <typename T>
     T* data() {
         assert(ToDataType<T>::dataType == dataType);
+        if (paramStore)
+            loadParams();
+        else if (csrData && !tensorData)
+            decompressData();
         return reinterpret_cast<T*>(tensorData.get());
     }
 
@@ -538,7 +651,27 @@ class Tensor : public TensorBase {
     friend std::ostream& operator<<(std::ostream& os, const Tensor& tensor);
 
    protected:
+    friend class ParamStore;
+    friend class TiledTensor;
+
+    /** Loads the data of this Tensor from its ParamStore if needed. */
+    void loadParams() const;
+
+    /** Fills the compressed data of a CSR Tensor. */
+    void fillCompressedData(DataType _dataType, const TensorData& tensorData);
+
+    /** Decompresses the whole CSR Tensor into dense storage. */
+    void decompressData() const;
+
     std::shared_ptr<void> tensorData;
+
+    /** The compressed data of a CSR Tensor. */
+    std::shared_ptr<CsrData> csrData;
+
+    /** The ParamStore the data is loaded from, if any. */
+    ParamStore* paramStore;
+
+    uint64_t dataVersion;
 };
 
 /**
@@ -553,7 +686,7 @@ class TiledTensor : public TensorBase {
   public:
    TiledTensor(Tensor* _origTensor = nullptr, bool _useRawTensor = false)
            : TensorBase(), origTensor(_origTensor), useRawTensor(_useRawTensor),
-             dataFilled(false) {}
+             dataFilled(false), filledVersion(0) {}
    /**
     * Construct a TiledTensor.
     *
@@ -568,7 +701,7 @@ class TiledTensor : public TensorBase {
                Tensor* _origTensor = nullptr,
                bool _useRawTensor = false)
            : TensorBase("", shape), origTensor(_origTensor),
-             useRawTensor(_useRawTensor), dataFilled(false) {
+             useRawTensor(_useRawTensor), dataFilled(false), filledVersion(0) {
        tiles.resize(shape.size());
    }
 
@@ -582,6 +715,27 @@ class TiledTensor : public TensorBase {
    Tensor*& operator[](int index) { return tiles[index].tensor; }
    int size() const { return shape.size(); }
 
+   /** Returns the original Tensor that was tiled into this TiledTensor. */
+   Tensor* getOrigTensor() const { return origTensor; }
+
+   /**
+    * Returns the coordinate origin of the tile at the given linear index in
+    * the original tensor. A tile without an origin (e.g. when the original
+    * tensor was used directly as the only tile) starts at zero.
+    */
+   std::vector<int> getTileOrigin(int index) const {
+       const Tile& tile = tiles.at(index);
+       if (tile.hasOrigin)
+           return tile.origin;
+       return std::vector<int>(tile.tensor ? tile.tensor->ndims() : 0, 0);
+   }
+
+   /**
+    * Returns true if the tiles are raw (flattened) copies of contiguous
+    * ranges of the original Tensor's storage.
+    */
+   bool usesRawTensor() const { return useRawTensor; }
+
    /**
     * Returns true if this TiledTensor is tiled along the N and H logical
     * dimensions.
@@ -621,6 +775,12 @@ class TiledTensor : public TensorBase {
     */
    void untile();
 
+   /**
+    * Frees the tiles of a CSR Tensor, which hold dense copies of its data.
+    * They are decompressed again when they are next used.
+    */
+   void releaseDecompressedTiles();
+
    static void* tileCopyWorker(void* _args);
 
   protected:
@@ -636,13 +796,17 @@ class TiledTensor : public TensorBase {
        bool hasOrigin;
        /** True if we have copied data to this tile. */
        bool hasData;
+       /** The data version of the original Tensor that was copied. */
+       uint64_t dataVersion;
 
        /**
         * Construct a new blank Tile.
         *
         * Set the properties of this Tile using TiledTensor::setTile
         */
-       Tile() : tensor(nullptr), origin(), hasOrigin(false), hasData(false) {}
+       Tile()
+               : tensor(nullptr), origin(), hasOrigin(false), hasData(false),
+                 dataVersion(0) {}
    };
 
    /**
@@ -689,6 +853,9 @@ class TiledTensor : public TensorBase {
    /** True if all the tiles have data filled. */
    bool dataFilled;
 
+   /** The data version of the original Tensor when all tiles were filled. */
+   uint64_t filledVersion;
+
    /** The list of Tiles, indexed using a TensorIndexIterator. */
    std::vector<Tile> tiles;
 };
@@ -194,6 +194,16 @@ int computePaddedTileDim(int maxTileDim,
     int tileDim = weightDim + stride * numStrides;
     return tileDim - padding;
 }
+
+// Allocates the storage of a new tile of the tensor. The tiles of a deferred
+// tensor only get their storage when they are filled, so that they don't hold
+// a dense copy of data that is not in memory.
+void allocateTileStorage(Tensor* tile, Tensor* tensor) {
+    if (tensor->isDataDeferred())
+        tile->setDataType(tensor->getDataType());
+    else
+        tile->allocateStorage(tensor->getDataType());
+}
 }  // namespace internal
 
 TiledTensor generateTiledTensorPerBatchNC(Tensor* tensor,
@@ -217,8 +227,9 @@ TiledTensor generateTiledTensorPerBatchNC(Tensor* tensor,
         std::string tileName = op->getName() + ":" + tensor->getName() +
                                "/tile:" + std::to_string((int)tileIndex);
         Tensor* tile = new Tensor(tileName, currentShape);
-        tile->allocateStorage(tensor->getDataType());
-        tiledTensor.setTile(tileIndex, { srcOffset }, tile, copyData);
+        internal::allocateTileStorage(tile, tensor);
+        tiledTensor.setTile(tileIndex, { srcOffset }, tile,
+                            copyData && !tensor->isDataDeferred());
         srcOffset += currentTileSize;
         remainingSize -= currentTileSize;
     }
@@ -308,7 +319,7 @@ TiledTensor generateTiledTensorWithStrideAndPadding(
             std::string tileName = op->getName() + ":" + tensor->getName() +
                                    "/tile:" + std::to_string((int)tileIndex);
             Tensor* tile = new Tensor(tileName, currentShape);
-            tile->allocateStorage(tensor->getDataType());
+            internal::allocateTileStorage(tile, tensor);
             tiledTensor.setTile(tileIndex, currentOrigin, tile, false);
             for (int i = ndims - 1; i >= 0; i--) {
                 currentOrigin[i] += currentShape[i];
@@ -321,7 +332,7 @@ TiledTensor generateTiledTensorWithStrideAndPadding(
             }
         }
     }
-    if (copyData) {
+    if (copyData && !tensor->isDataDeferred()) {
         tiledTensor.copyDataToAllTiles();
     }
     op->getWorkspace()->addTiledTensor(tiledTensor);
@@ -207,6 +207,8 @@ void copyRawTensorData(
  * @param tileShape The maximum size of each tile.
  * @param op The Operator that will be consuming this TiledTensor.
  * @param copyData Whether to copy data from the source tensor into the tiles.
+ * The data of a tensor in a ParamStore or in the CSR format is only copied when
+ * the tiles are used.
  */
 TiledTensor generateTiledTensorPerBatchNC(Tensor* tensor,
                                           const TensorShape& tileShape,
@@ -229,6 +231,8 @@ TiledTensor generateTiledTensorPerBatchNC(Tensor* tensor,
  * @param paddingType The type of additional zero-padding applied on the Tensor
  * by the Operator, if any.
  * @param copyData Whether to copy data from the source tensor into the tiles.
+ * The data of a tensor in a ParamStore or in the CSR format is only copied when
+ * the tiles are used.
  */
 TiledTensor generateTiledTensorWithStrideAndPadding(
         Tensor* tensor,
@@ -251,6 +255,8 @@ TiledTensor generateTiledTensorWithStrideAndPadding(
  * @param tileShape The maximum size of each tile.
  * @param op The Operator that will be consuming this TiledTensor.
  * @param copyData Whether to copy data from the source tensor into the tiles.
+ * The data of a tensor in a ParamStore or in the CSR format is only copied when
+ * the tiles are used.
  */
 TiledTensor generateTiledTensor(Tensor* tensor,
                                 const TensorShape& tileShape,
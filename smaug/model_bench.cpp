@@ -0,0 +1,452 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+#include "core/backend.h"
+#include "core/globals.h"
+#include "core/network_builder.h"
+#include "core/scheduler.h"
+#include "core/static_graph_analyzer.h"
+
+namespace po = boost::program_options;
+
+using namespace smaug;
+
+// Every heap allocation made through operator new is counted. Tensor storage
+// comes from malloc_aligned() and is not, so this is a measure of the
+// bookkeeping overhead rather than of the memory footprint, which the peak
+// RSS gives.
+std::atomic<uint64_t> numAllocations(0);
+std::atomic<uint64_t> allocatedBytes(0);
+
+void* operator new(std::size_t size) {
+    numAllocations++;
+    allocatedBytes += size;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+/**
+ * The models of the model zoo, by name, with the directory they are in. A
+ * model that isn't listed here is looked for in a directory of its own name.
+ */
+const std::map<std::string, std::string> kModelZoo = {
+    { "lstm", "lstm" },
+    { "minerva", "minerva" },
+    { "lenet5", "lenet5" },
+    { "cnn", "cnn" },
+    { "elu", "cifar100-elu" },
+    { "large_elu", "cifar100-large-elu" },
+    { "vgg", "cifar10-vgg" },
+    { "resnet", "imagenet-resnet" },
+};
+
+/**
+ * The metrics of one model on one backend, in the order they were measured.
+ */
+struct BenchResult {
+    std::string model;
+    std::string backend;
+    bool valid = false;
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * Builds the model and runs it the given number of times, writing the
+ * metrics one "name value" line at a time to the given file. This runs in its
+ * own process, so that the peak RSS and the global state are its own.
+ */
+void benchmarkModel(const std::string& modelTopo,
+                    const std::string& modelParams,
+                    const std::string& backend,
+                    int iterations,
+                    bool estimateDma,
+                    FILE* results) {
+    runningInSimulation = false;
+    numAcceleratorsAvailable = 1;
+    ReferenceBackend::initGlobals();
+    SmvBackend::initGlobals();
+    numAllocations = 0;
+    allocatedBytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    SamplingInfo sampling;
+    sampling.level = NoSampling;
+    sampling.num_sample_iterations = 1;
+    Workspace* workspace = new Workspace();
+    Network* network =
+            buildNetwork(modelTopo, modelParams, sampling, workspace);
+    double startupTime = elapsedSeconds(start);
+
+    Scheduler scheduler(network, workspace);
+    std::vector<std::string> opNames;
+    std::map<std::string, double> opTimes;
+    std::vector<double> runTimes;
+    for (int i = 0; i < iterations; i++) {
+        start = std::chrono::steady_clock::now();
+        scheduler.runNetwork();
+        double runTime = elapsedSeconds(start);
+        // The first run also tiles the network.
+        if (i == 0)
+            runTime -= scheduler.getTilingTime();
+        runTimes.push_back(runTime);
+        for (const auto& opTime : scheduler.getOperatorTimes()) {
+            const std::string& name = opTime.first->getName();
+            if (!opTimes.count(name))
+                opNames.push_back(name);
+            opTimes[name] += opTime.second;
+        }
+    }
+    double runTime = 0;
+    for (double time : runTimes)
+        runTime += time;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(results, "startup_s %.9g\n", startupTime);
+    fprintf(results, "tiling_s %.9g\n", scheduler.getTilingTime());
+    fprintf(results, "first_run_s %.9g\n", runTimes[0]);
+    fprintf(results, "run_s %.9g\n", runTime / iterations);
+    fprintf(results, "total_s %.9g\n",
+            startupTime + scheduler.getTilingTime() + runTime);
+    fprintf(results, "peak_rss_kb %ld\n", usage.ru_maxrss);
+    fprintf(results, "allocations %lu\n", (unsigned long)numAllocations);
+    fprintf(results, "allocated_bytes %lu\n", (unsigned long)allocatedBytes);
+    for (const auto& name : opNames) {
+        fprintf(results, "op:%s_s %.9g\n", name.c_str(),
+                opTimes[name] / iterations);
+    }
+    // The DMA traffic is that of the SMV scratchpads, which the reference
+    // operators don't tile for.
+    if (estimateDma && backend == "smv") {
+        GraphAnalyzer analyzer(network, workspace);
+        analyzer.dry_run_network();
+        DmaReport report = analyzer.estimate_dma_traffic(
+                analyzer.get_baseline_spm_mapping(), "baseline");
+        fprintf(results, "dma_load_bytes %lu\n",
+                (unsigned long)report.total.load_bytes);
+        fprintf(results, "dma_store_bytes %lu\n",
+                (unsigned long)report.total.store_bytes);
+    }
+}
+
+/**
+ * Runs benchmarkModel() in a child process and collects its metrics. The
+ * result is invalid if the model fails to build or run.
+ */
+BenchResult runBenchmark(const std::string& model,
+                         const std::string& modelDir,
+                         const std::string& backend,
+                         int iterations,
+                         bool estimateDma) {
+    BenchResult result;
+    result.model = model;
+    result.backend = backend;
+    auto it = kModelZoo.find(model);
+    std::string prefix = modelDir + "/" +
+                         (it == kModelZoo.end() ? model : it->second) + "/" +
+                         model + "_" + backend;
+    std::string modelTopo = prefix + "_topo.pbtxt";
+    std::string modelParams = prefix + "_params.pb";
+    if (!std::ifstream(modelTopo) || !std::ifstream(modelParams)) {
+        std::cout << "Skipping " << model << " on " << backend << ", "
+                  << modelTopo << " or its parameters are missing.\n";
+        return result;
+    }
+    std::cout << "Benchmarking " << model << " on " << backend << ".\n";
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        std::cerr << "Failed to create a pipe!\n";
+        exit(1);
+    }
+    // Don't let the child inherit buffered output.
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Failed to fork!\n";
+        exit(1);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        // The network is chatty, only keep the errors.
+        if (!freopen("/dev/null", "w", stdout))
+            _exit(1);
+        FILE* results = fdopen(fds[1], "w");
+        benchmarkModel(modelTopo, modelParams, backend, iterations,
+                       estimateDma, results);
+        _exit(fclose(results) == 0 ? 0 : 1);
+    }
+    close(fds[1]);
+    std::string output;
+    char buffer[4096];
+    ssize_t bytes;
+    while ((bytes = read(fds[0], buffer, sizeof(buffer))) > 0)
+        output.append(buffer, bytes);
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "Benchmarking " << model << " on " << backend
+                  << " failed.\n";
+        return result;
+    }
+    std::istringstream lines(output);
+    std::string name;
+    double value;
+    while (lines >> name >> value)
+        result.metrics.emplace_back(name, value);
+    result.valid = true;
+    return result;
+}
+
+void writeResults(const std::vector<BenchResult>& results,
+                  const std::string& fileName) {
+    std::ofstream csvFile(fileName);
+    csvFile << "model,backend,metric,value\n";
+    csvFile << std::setprecision(9);
+    for (const auto& result : results) {
+        for (const auto& metric : result.metrics) {
+            csvFile << result.model << "," << result.backend << ","
+                    << metric.first << "," << metric.second << "\n";
+        }
+    }
+}
+
+/** The metrics of a results file, keyed by model, backend and metric. */
+using Baseline = std::map<std::tuple<std::string, std::string, std::string>,
+                          double>;
+
+bool readBaseline(const std::string& fileName, Baseline& baseline) {
+    std::ifstream csvFile(fileName);
+    if (!csvFile)
+        return false;
+    std::string line;
+    // Skip the header.
+    std::getline(csvFile, line);
+    while (std::getline(csvFile, line)) {
+        std::istringstream fields(line);
+        std::string model, backend, metric, value;
+        if (!std::getline(fields, model, ',') ||
+            !std::getline(fields, backend, ',') ||
+            !std::getline(fields, metric, ',') ||
+            !std::getline(fields, value))
+            continue;
+        baseline[std::make_tuple(model, backend, metric)] = std::stod(value);
+    }
+    return true;
+}
+
+/**
+ * Compares the results against the baseline and prints every metric that got
+ * worse by more than its threshold in percent. Per-operator metrics use the
+ * threshold of "op", and metrics without a threshold of their own the default
+ * one. Times that stay below minSeconds are too noisy to compare. Returns the
+ * number of regressions.
+ */
+int compareToBaseline(const std::vector<BenchResult>& results,
+                      const Baseline& baseline,
+                      const std::map<std::string, double>& thresholds,
+                      double defaultThreshold,
+                      double minSeconds) {
+    int numCompared = 0;
+    int numRegressions = 0;
+    for (const auto& result : results) {
+        for (const auto& metric : result.metrics) {
+            const std::string& name = metric.first;
+            auto it = baseline.find(
+                    std::make_tuple(result.model, result.backend, name));
+            if (it == baseline.end())
+                continue;
+            double base = it->second;
+            double value = metric.second;
+            bool isTime = name.size() > 2 &&
+                          name.compare(name.size() - 2, 2, "_s") == 0;
+            if (isTime && base < minSeconds && value < minSeconds)
+                continue;
+            numCompared++;
+            std::string key = name.compare(0, 3, "op:") == 0 ? "op" : name;
+            auto thresholdIt = thresholds.find(key);
+            double threshold = thresholdIt == thresholds.end()
+                                       ? defaultThreshold
+                                       : thresholdIt->second;
+            if (value <= base * (1 + threshold / 100))
+                continue;
+            numRegressions++;
+            std::cout << "  REGRESSION " << result.model << "/"
+                      << result.backend << " " << name << ": " << base
+                      << " -> " << value;
+            if (base > 0) {
+                std::cout << " (+" << std::setprecision(3)
+                          << 100 * (value - base) / base << "%, threshold "
+                          << threshold << "%)" << std::setprecision(6);
+            }
+            std::cout << "\n";
+        }
+    }
+    std::cout << numRegressions << " regression(s) in " << numCompared
+              << " compared metrics.\n";
+    return numRegressions;
+}
+
+void printSummary(const std::vector<BenchResult>& results) {
+    std::cout << "Results (startup, tiling, run, peak RSS, allocations):\n";
+    for (const auto& result : results) {
+        if (!result.valid)
+            continue;
+        std::map<std::string, double> metrics(result.metrics.begin(),
+                                              result.metrics.end());
+        std::cout << "  " << result.model << " on " << result.backend << ": "
+                  << std::fixed << std::setprecision(3)
+                  << metrics["startup_s"] * 1e3 << " ms, "
+                  << metrics["tiling_s"] * 1e3 << " ms, "
+                  << metrics["run_s"] * 1e3 << " ms, ";
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6) << (long)metrics["peak_rss_kb"]
+                  << " KB, " << (long)metrics["allocations"] << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> models;
+    for (const auto& model : kModelZoo)
+        models.push_back(model.first);
+    std::vector<std::string> backends = { "smv", "ref" };
+    const char* smaugHome = std::getenv("SMAUG_HOME");
+    std::string modelDir = std::string(smaugHome ? smaugHome : ".") +
+                           "/experiments/models";
+    int iterations = 3;
+    bool skipDma = false;
+    std::string outputFile = "model_bench.csv";
+    std::string baselineFile;
+    double defaultThreshold = 10;
+    std::vector<std::string> thresholdArgs;
+    double minSeconds = 0.001;
+    po::options_description options(
+            "Model benchmark Usage:  ./smaug-model-bench [options]");
+    // clang-format off
+    options.add_options()
+        ("help", "Display this help message")
+        ("models",
+         po::value(&models)->multitoken(),
+         "The models to run. Defaults to the whole model zoo.")
+        ("backends",
+         po::value(&backends)->multitoken(),
+         "The backends to run each model on: smv and/or ref.")
+        ("model-dir",
+         po::value(&modelDir),
+         "The model zoo directory, with a directory per model holding "
+         "<model>_<backend>_topo.pbtxt and <model>_<backend>_params.pb. "
+         "Defaults to $SMAUG_HOME/experiments/models.")
+        ("iterations",
+         po::value(&iterations),
+         "The number of times each model is run.")
+        ("skip-dma-estimate",
+         po::bool_switch(&skipDma),
+         "Don't estimate the DMA traffic of the SMV scratchpads, which takes "
+         "another run of the network.")
+        ("output",
+         po::value(&outputFile),
+         "The CSV file to write the results to.")
+        ("baseline",
+         po::value(&baselineFile),
+         "A results file of an earlier run to compare against. The program "
+         "exits with status 2 if any metric regressed.")
+        ("max-regression",
+         po::value(&defaultThreshold),
+         "The percentage by which a metric may get worse than the baseline.")
+        ("threshold",
+         po::value(&thresholdArgs)->multitoken(),
+         "Thresholds of single metrics as metric=percent, e.g. "
+         "peak_rss_kb=5. The metric op stands for all the per-operator "
+         "times.")
+        ("min-seconds",
+         po::value(&minSeconds),
+         "Times below this in both runs are not compared.");
+    // clang-format on
+
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+        po::notify(vm);
+    } catch (po::error& e) {
+        std::cout << "ERROR: " << e.what() << "\n";
+        exit(1);
+    }
+
+    if (vm.count("help")) {
+        std::cout << options << "\n";
+        return 1;
+    }
+    if (iterations < 1) {
+        std::cout << "At least one iteration must run!\n";
+        exit(1);
+    }
+    for (const auto& backend : backends) {
+        if (backend != "smv" && backend != "ref") {
+            std::cout << "Unknown backend: " << backend << "\n";
+            exit(1);
+        }
+    }
+    std::map<std::string, double> thresholds;
+    for (const auto& arg : thresholdArgs) {
+        size_t pos = arg.find('=');
+        if (pos == std::string::npos) {
+            std::cout << "Thresholds are given as metric=percent: " << arg
+                      << "\n";
+            exit(1);
+        }
+        thresholds[arg.substr(0, pos)] = std::stod(arg.substr(pos + 1));
+    }
+    Baseline baseline;
+    if (!baselineFile.empty() && !readBaseline(baselineFile, baseline)) {
+        std::cout << "Cannot read the baseline: " << baselineFile << "\n";
+        exit(1);
+    }
+
+    std::vector<BenchResult> results;
+    for (const auto& model : models) {
+        for (const auto& backend : backends) {
+            results.push_back(runBenchmark(
+                    model, modelDir, backend, iterations, !skipDma));
+        }
+    }
+    writeResults(results, outputFile);
+    printSummary(results);
+    std::cout << "Results written to " << outputFile << ".\n";
+
+    if (baselineFile.empty())
+        return 0;
+    std::cout << "Comparing against " << baselineFile << ":\n";
+    int numRegressions = compareToBaseline(
+            results, baseline, thresholds, defaultThreshold, minSeconds);
+    return numRegressions > 0 ? 2 : 0;
+}
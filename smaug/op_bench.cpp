@@ -0,0 +1,483 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "fp16.h"
+#include "core/backend.h"
+#include "core/globals.h"
+#include "core/tensor.h"
+#include "core/workspace.h"
+#include "operators/batch_norm_op.h"
+#include "operators/convolution_op.h"
+#include "operators/depthwise_convolution_op.h"
+#include "operators/eltwise_add_op.h"
+#include "operators/eltwise_mul_op.h"
+#include "operators/elu_op.h"
+#include "operators/inner_product_op.h"
+#include "operators/pooling_op.h"
+#include "operators/relu_op.h"
+#include "operators/sigmoid_op.h"
+#include "operators/softmax_op.h"
+#include "operators/tanh_op.h"
+#include "operators/smv/smv_batch_norm_op.h"
+#include "operators/smv/smv_convolution_op.h"
+#include "operators/smv/smv_depthwise_convolution_op.h"
+#include "operators/smv/smv_eltwise_add_op.h"
+#include "operators/smv/smv_eltwise_mul_op.h"
+#include "operators/smv/smv_elu_op.h"
+#include "operators/smv/smv_inner_product_op.h"
+#include "operators/smv/smv_pooling_op.h"
+#include "operators/smv/smv_relu_op.h"
+#include "operators/smv/smv_sigmoid_op.h"
+#include "operators/smv/smv_softmax_op.h"
+#include "operators/smv/smv_tanh_op.h"
+#include "utility/utils.h"
+
+namespace po = boost::program_options;
+
+using namespace smaug;
+
+/** The operator to benchmark, as given on the command line. */
+struct BenchConfig {
+    std::string op = "conv";
+    std::string backend = "smv";
+    std::string dataType;
+    std::string layout;
+    std::vector<int> inputDims = { 1, 32, 32, 32 };
+    std::vector<int> kernelSize = { 3, 3 };
+    std::vector<int> stride = { 1, 1 };
+    std::string padding = "same";
+    int numOutputs = 32;
+    int iterations = 10;
+    int seed = 1;
+};
+
+/** The times of one phase over all the iterations. */
+struct PhaseTimes {
+    std::string name;
+    std::vector<double> seconds;
+
+    double mean() const {
+        double sum = 0;
+        for (double s : seconds)
+            sum += s;
+        return seconds.empty() ? 0 : sum / seconds.size();
+    }
+    double min() const {
+        return seconds.empty() ? 0
+                               : *std::min_element(seconds.begin(),
+                                                   seconds.end());
+    }
+};
+
+std::string dimsToStr(const TensorShape& shape) {
+    std::string str = "[";
+    for (int i = 0; i < shape.ndims(); i++)
+        str += (i ? ", " : "") + std::to_string(shape[i]);
+    return str + "]";
+}
+
+double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void fillWithRandomData(Tensor* tensor, std::default_random_engine& engine) {
+    std::uniform_real_distribution<float> dist(-1, 1);
+    int size = tensor->getShape().storageSize();
+    if (tensor->getDataType() == Float16) {
+        float16* data = tensor->data<float16>();
+        for (int i = 0; i < size; i++)
+            data[i] = fp16_ieee_from_fp32_value(dist(engine));
+    } else {
+        float* data = tensor->data<float>();
+        for (int i = 0; i < size; i++)
+            data[i] = dist(engine);
+    }
+}
+
+/**
+ * Creates the operator of the config through the operator factories of the
+ * backend and connects it to the given inputs. Returns nullptr for an unknown
+ * operator type.
+ */
+template <typename Backend>
+Operator* createOperator(const BenchConfig& config,
+                         const std::vector<Tensor*>& inputs,
+                         Workspace* workspace) {
+    const std::string name = "bench";
+    PaddingType padding =
+            config.padding == "valid" ? ValidPadding : SamePadding;
+    Operator* op = nullptr;
+    if (config.op == "conv") {
+        auto convOp = Backend::createConvolutionOp(name, workspace);
+        convOp->setWeightDims(
+                config.kernelSize[0], config.kernelSize[1], config.numOutputs);
+        convOp->setStride(config.stride[0], config.stride[1]);
+        convOp->setPadding(padding);
+        op = convOp;
+    } else if (config.op == "depthwise-conv") {
+        auto convOp = Backend::createDepthwiseConvolutionOp(name, workspace);
+        const TensorShape& shape = inputs[0]->getShape();
+        int channels =
+                shape[shape.getLayout() == DataLayout::NCHW ? 1 : 3];
+        convOp->setWeightDims(
+                config.kernelSize[0], config.kernelSize[1], channels);
+        convOp->setStride(config.stride[0], config.stride[1]);
+        convOp->setPadding(padding);
+        op = convOp;
+    } else if (config.op == "fc") {
+        auto fcOp = Backend::createInnerProductOp(name, workspace);
+        fcOp->setNumOutputs(config.numOutputs);
+        op = fcOp;
+    } else if (config.op == "max-pool" || config.op == "avg-pool") {
+        auto setPooling = [&](auto poolOp) {
+            poolOp->setPoolingSize(config.kernelSize[0], config.kernelSize[1]);
+            poolOp->setPoolingStride(config.stride[0], config.stride[1]);
+            return poolOp;
+        };
+        if (config.op == "max-pool")
+            op = setPooling(Backend::createMaxPoolingOp(name, workspace));
+        else
+            op = setPooling(Backend::createAvgPoolingOp(name, workspace));
+    } else if (config.op == "batch-norm") {
+        op = Backend::createBatchNormOp(name, workspace);
+    } else if (config.op == "eltwise-add") {
+        op = Backend::createEltwiseAddOp(name, workspace);
+    } else if (config.op == "eltwise-mul") {
+        op = Backend::createEltwiseMulOp(name, workspace);
+    } else if (config.op == "relu") {
+        op = Backend::createReluOp(name, workspace);
+    } else if (config.op == "elu") {
+        op = Backend::createEluOp(name, workspace);
+    } else if (config.op == "sigmoid") {
+        op = Backend::createSigmoidOp(name, workspace);
+    } else if (config.op == "tanh") {
+        op = Backend::createTanhOp(name, workspace);
+    } else if (config.op == "softmax") {
+        op = Backend::createSoftmaxOp(name, workspace);
+    } else {
+        return nullptr;
+    }
+    for (int i = 0; i < inputs.size(); i++)
+        op->setInput(inputs[i], i);
+    return op;
+}
+
+void printTileStats(Operator* op, int spadSize) {
+    std::vector<TiledTensor*> tiledTensors = op->getTiledTensors();
+    if (tiledTensors.empty()) {
+        std::cout << "The operator doesn't tile its tensors.\n";
+        return;
+    }
+    std::cout << "Tiles:\n";
+    for (TiledTensor* tiledTensor : tiledTensors) {
+        Tensor* origTensor = tiledTensor->getOrigTensor();
+        const TensorShape& grid = tiledTensor->getShape();
+        uint64_t totalBytes = 0;
+        uint64_t maxTileBytes = 0;
+        for (int i = 0; i < tiledTensor->size(); i++) {
+            const Tensor* tile = (*tiledTensor)[i];
+            uint64_t bytes = (uint64_t)tile->getShape().storageSize() *
+                             tile->getDataTypeSize();
+            totalBytes += bytes;
+            maxTileBytes = std::max(maxTileBytes, bytes);
+        }
+        uint64_t origBytes = (uint64_t)origTensor->getShape().storageSize() *
+                             origTensor->getDataTypeSize();
+        std::cout << "  " << origTensor->getName() << ": " << grid.size()
+                  << " tile(s), grid " << dimsToStr(grid) << ", largest "
+                  << maxTileBytes << " bytes ("
+                  << std::setprecision(3) << 100.0 * maxTileBytes / spadSize
+                  << "% of a spad), " << totalBytes << " bytes for "
+                  << origBytes << " bytes of data\n";
+    }
+}
+
+/**
+ * Runs the benchmark on the given backend. Returns the exit code of the
+ * program.
+ */
+template <typename Backend>
+int runBenchmark(const BenchConfig& config,
+                 DataType dataType,
+                 DataLayout layout,
+                 const std::string& outputFile) {
+    std::default_random_engine engine(config.seed);
+    Workspace* workspace = new Workspace();
+    int numInputs = config.op.compare(0, 7, "eltwise") == 0 ? 2 : 1;
+    std::vector<Tensor*> inputs;
+    for (int i = 0; i < numInputs; i++) {
+        TensorShape shape(config.inputDims, layout, Backend::Alignment);
+        Tensor* input = new Tensor("input" + std::to_string(i), shape);
+        input->allocateStorage(dataType);
+        fillWithRandomData(input, engine);
+        workspace->addTensor(input);
+        inputs.push_back(input);
+    }
+    Operator* op = createOperator<Backend>(config, inputs, workspace);
+    if (!op) {
+        std::cout << "Unknown operator type: " << config.op << "\n";
+        delete workspace;
+        return 1;
+    }
+    op->createAllTensors();
+    if (!op->validate()) {
+        std::cout << "Invalid parameters for the operator!\n";
+        delete op;
+        delete workspace;
+        return 1;
+    }
+    // Fill the parameters, and allocate the outputs.
+    for (auto input : op->getInputs()) {
+        Tensor* tensor = static_cast<Tensor*>(input);
+        if (!tensor->containsData()) {
+            tensor->allocateStorage(dataType);
+            fillWithRandomData(tensor, engine);
+        }
+    }
+    for (auto output : op->getOutputs())
+        static_cast<Tensor*>(output)->allocateStorage(dataType);
+
+    std::cout << "Benchmarking " << config.op << " on " << Backend::Name
+              << ", input " << dimsToStr(inputs[0]->getShape())
+              << " " << dataLayoutToStr(inputs[0]->getShape().getLayout())
+              << ", output " << dimsToStr(op->getOutput(0)->getShape())
+              << ".\n";
+
+    auto start = std::chrono::steady_clock::now();
+    op->tile();
+    double tilingTime = elapsedSeconds(start);
+
+    // The ScopedStats sections of the operators give the time to copy the
+    // data into the tiles and out of them.
+    PhaseTimes total{ "total" }, tileCopy{ "tile copy" }, kernel{ "kernel" },
+            untile{ "untile" };
+    gem5::setSectionTimingEnabled(true);
+    gem5::takeSectionTimes();
+    for (int i = 0; i < config.iterations; i++) {
+        // Every iteration gets new inputs, so that their tiles are copied
+        // again. The parameters stay in their tiles, as in a real network.
+        for (Tensor* input : inputs)
+            input->bumpDataVersion();
+        start = std::chrono::steady_clock::now();
+        op->run();
+        double runTime = elapsedSeconds(start);
+        auto sections = gem5::takeSectionTimes();
+        double copyTime = sections[stats::kTensorPrepStart];
+        double untileTime = sections[stats::kTensorFinalStart];
+        total.seconds.push_back(runTime);
+        tileCopy.seconds.push_back(copyTime);
+        untile.seconds.push_back(untileTime);
+        kernel.seconds.push_back(
+                std::max(0.0, runTime - copyTime - untileTime));
+    }
+    gem5::setSectionTimingEnabled(false);
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "Tiling: " << tilingTime * 1e3 << " ms\n"
+              << "Per iteration over " << config.iterations
+              << " iteration(s) (mean / min):\n";
+    for (const PhaseTimes* phase : { &tileCopy, &kernel, &untile, &total }) {
+        std::cout << "  " << std::left << std::setw(10) << phase->name
+                  << std::right << phase->mean() * 1e3 << " / "
+                  << phase->min() * 1e3 << " ms\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+    if (op->getEstimatedCycles() > 0) {
+        std::cout << "Estimated accelerator cycles: "
+                  << op->getEstimatedCycles() << "\n";
+    }
+    printTileStats(op, Backend::SpadSize());
+
+    if (!outputFile.empty()) {
+        std::ofstream csvFile(outputFile);
+        csvFile << "op,backend,tiling_s,tile_copy_s,kernel_s,untile_s,"
+                   "total_s,num_tiles\n";
+        int numTiles = 0;
+        for (TiledTensor* tiledTensor : op->getTiledTensors())
+            numTiles += tiledTensor->size();
+        csvFile << config.op << "," << Backend::Name << "," << tilingTime
+                << "," << tileCopy.mean() << "," << kernel.mean() << ","
+                << untile.mean() << "," << total.mean() << "," << numTiles
+                << "\n";
+        std::cout << "Results written to " << outputFile << ".\n";
+    }
+
+    delete op;
+    delete workspace;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+    std::string configFile;
+    std::string outputFile;
+    int spadSize = smv::kDefaultSpadSize;
+    int numSpads = smv::kDefaultNumSpads;
+    po::options_description options(
+            "Operator benchmark Usage:  ./smaug-op-bench [options]");
+    // clang-format off
+    options.add_options()
+        ("help", "Display this help message")
+        ("config",
+         po::value(&configFile),
+         "A file of key=value lines with any of the options below. Options "
+         "on the command line take precedence.")
+        ("op",
+         po::value(&config.op),
+         "The operator: conv, depthwise-conv, fc, max-pool, avg-pool, "
+         "batch-norm, eltwise-add, eltwise-mul, relu, elu, sigmoid, tanh or "
+         "softmax.")
+        ("backend",
+         po::value(&config.backend),
+         "The backend: smv or ref.")
+        ("data-type",
+         po::value(&config.dataType),
+         "The data type: float16 or float32. Defaults to the one the backend "
+         "supports.")
+        ("input-dims",
+         po::value(&config.inputDims)->multitoken(),
+         "The input dimensions in the order of the layout, e.g. 1 32 32 8 for "
+         "NHWC or 1 256 for NC.")
+        ("layout",
+         po::value(&config.layout),
+         "The input layout: NCHW, NHWC or NC. Defaults to the default layout "
+         "of the backend for 4D inputs and NC for 2D inputs.")
+        ("kernel-size",
+         po::value(&config.kernelSize)->multitoken(),
+         "The rows and columns of the conv kernels or pooling window.")
+        ("stride",
+         po::value(&config.stride)->multitoken(),
+         "The row and column strides of a conv or pooling.")
+        ("padding",
+         po::value(&config.padding),
+         "The conv padding: same or valid.")
+        ("num-outputs",
+         po::value(&config.numOutputs),
+         "The output channels of a conv or outputs of an FC.")
+        ("iterations",
+         po::value(&config.iterations),
+         "The number of times the operator is run.")
+        ("seed",
+         po::value(&config.seed),
+         "The seed of the random data.")
+        ("spad-size",
+         po::value(&spadSize),
+         "The size of each SMV scratchpad in bytes.")
+        ("num-spads",
+         po::value(&numSpads),
+         "The number of SMV scratchpads, at least 3.")
+        ("num-accels",
+         po::value(&numAcceleratorsAvailable)->default_value(1),
+         "The number of accelerators the operator runs on.")
+        ("output",
+         po::value(&outputFile),
+         "A CSV file to write the mean times to.");
+    // clang-format on
+
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+        if (vm.count("config")) {
+            std::ifstream file(vm["config"].as<std::string>());
+            if (!file) {
+                std::cout << "Cannot open the config file: "
+                          << vm["config"].as<std::string>() << "\n";
+                exit(1);
+            }
+            po::store(po::parse_config_file(file, options), vm);
+        }
+        po::notify(vm);
+    } catch (po::error& e) {
+        std::cout << "ERROR: " << e.what() << "\n";
+        exit(1);
+    }
+
+    if (vm.count("help")) {
+        std::cout << options << "\n";
+        return 1;
+    }
+    if (config.iterations < 1) {
+        std::cout << "At least one iteration must run!\n";
+        exit(1);
+    }
+    if (config.kernelSize.size() != 2 || config.stride.size() != 2) {
+        std::cout << "The kernel size and stride take two values each!\n";
+        exit(1);
+    }
+    if (config.padding != "same" && config.padding != "valid") {
+        std::cout << "Unknown padding: " << config.padding << "\n";
+        exit(1);
+    }
+    if (config.backend != "smv" && config.backend != "ref") {
+        std::cout << "Unknown backend: " << config.backend << "\n";
+        exit(1);
+    }
+    bool isSmv = config.backend == "smv";
+    // All the SMV operators work on float16, and the reference ones on
+    // float32.
+    DataType dataType = isSmv ? Float16 : Float32;
+    if (!config.dataType.empty()) {
+        DataType requested = config.dataType == "float16"
+                                     ? Float16
+                                     : config.dataType == "float32"
+                                               ? Float32
+                                               : UnknownDataType;
+        if (requested != dataType) {
+            std::cout << "The " << config.backend
+                      << " backend doesn't support data type "
+                      << config.dataType << "!\n";
+            exit(1);
+        }
+    }
+    DataLayout layout = UnknownLayout;
+    if (config.layout.empty()) {
+        if (config.inputDims.size() == 4) {
+            layout = isSmv ? SmvBackend::DefaultInputDataLayout
+                           : ReferenceBackend::DefaultInputDataLayout;
+        } else if (config.inputDims.size() == 2) {
+            layout = DataLayout::NC;
+        }
+    } else if (config.layout == "NCHW") {
+        layout = DataLayout::NCHW;
+    } else if (config.layout == "NHWC") {
+        layout = DataLayout::NHWC;
+    } else if (config.layout == "NC") {
+        layout = DataLayout::NC;
+    }
+    int expectedDims = layout == DataLayout::NC ? 2 : 4;
+    if (layout == UnknownLayout || config.inputDims.size() != expectedDims) {
+        std::cout << "The input dimensions don't match the layout!\n";
+        exit(1);
+    }
+
+    runningInSimulation = false;
+    if (numAcceleratorsAvailable < 1 ||
+        numAcceleratorsAvailable > maxNumAccelerators) {
+        std::cout << "The number of accelerators must be between 1 and "
+                  << maxNumAccelerators << "!\n";
+        exit(1);
+    }
+    if (spadSize <= 0 || numSpads < 3) {
+        std::cout << "Invalid scratchpad geometry!\n";
+        exit(1);
+    }
+    ReferenceBackend::initGlobals();
+    SmvBackend::initGlobals(spadSize, numSpads);
+    int ret = isSmv ? runBenchmark<SmvBackend>(
+                              config, dataType, layout, outputFile)
+                    : runBenchmark<ReferenceBackend>(
+                              config, dataType, layout, outputFile);
+    ReferenceBackend::freeGlobals();
+    SmvBackend::freeGlobals();
+    return ret;
+}
@@ -1,3 +1,5 @@
+#include <float.h>
+
 #include "smaug/operators/common.h"
 #include "smaug/operators/smv/kernels/load_store_fp16_data.h"
 #include "smaug/operators/smv/kernels/activation_functions_simd.h"
@@ -9,6 +11,9 @@ extern "C" {
 /** \ingroup AladdinKernels
  *
  * Top level function entry for all unary SMV activation functions.
+ *
+ * If read_inputs is false, the inputs are expected to be in the inputs
+ * scratchpad already, left there by the previous operator.
  */
 void smv_activation_fun_nc_vec_fxp(float16* host_inputs,
                                    float16* host_results,
@@ -16,9 +21,11 @@ void smv_activation_fun_nc_vec_fxp(float16* host_inputs,
                                    float* results,
                                    int inputs_size,
                                    activation_type function,
-                                   activation_param_t params) {
-    // Load inputs.
-    host_load_fp16(inputs, host_inputs, inputs_size, 0, 0);
+                                   activation_param_t params,
+                                   bool read_inputs) {
+    // Load inputs if needed.
+    if (read_inputs)
+        host_load_fp16(inputs, host_inputs, inputs_size, 0, 0);
     activation_fun_vec(inputs, results, inputs_size, function, params);
     // Store results to the host memory.
     host_store_fp16(results, host_results, inputs_size, 0, 0);
@@ -79,6 +86,101 @@ void smv_softmax_nc_vec_fxp(float16* host_inputs,
             results, host_results, input_num * (input_size + input_pad), 0, 0);
 }
 
+/** \ingroup AladdinKernels
+ *
+ * First pass of softmax over rows that are tiled by columns.
+ *
+ * This folds one column tile into the running max and sum of exponentials of
+ * its rows, which stay in the stats scratchpad across the column tiles of the
+ * same rows: stats[i] is the max of row i, and stats[input_num + i] is the sum
+ * of exp(x - max) over the row. The first column tile sets init_stats.
+ */
+void smv_softmax_reduce_nc_vec_fxp(float16* host_inputs,
+                                   float* inputs,
+                                   float* stats,
+                                   int input_num,
+                                   int input_size,
+                                   int input_pad,
+                                   bool init_stats) {
+    // Load inputs.
+    host_load_fp16(
+            inputs, host_inputs, input_num * (input_size + input_pad), 0, 0);
+
+    VEC_ARRAY_2D(v8fp_t, _inputs, inputs, input_size + input_pad);
+    int input_vec_size = FRAC_CEIL(input_size, VECTOR_SIZE);
+
+    softmax_stats_batch:
+    for (int i = 0; i < input_num; i++) {
+        float tile_max = -FLT_MAX;
+        softmax_stats_max:
+        for (int j = 0; j < input_vec_size; j++) {
+            softmax_stats_max_vec:
+            for (int k = 0; k < VECTOR_SIZE; k++) {
+                if (j * VECTOR_SIZE + k < input_size)
+                    tile_max = max2(tile_max, _inputs[i][j][k]);
+            }
+        }
+        float row_max = init_stats ? tile_max : max2(stats[i], tile_max);
+
+        float tile_sum = 0.0;
+        softmax_stats_sum:
+        for (int j = 0; j < input_vec_size; j++) {
+            softmax_stats_sum_vec:
+            for (int k = 0; k < VECTOR_SIZE; k++) {
+                if (j * VECTOR_SIZE + k < input_size)
+                    tile_sum += exp(_inputs[i][j][k] - row_max);
+            }
+        }
+        // The sum of the previous tiles was taken relative to the old max.
+        float row_sum =
+                init_stats ? 0.0
+                           : stats[input_num + i] * exp(stats[i] - row_max);
+        stats[i] = row_max;
+        stats[input_num + i] = row_sum + tile_sum;
+    }
+}
+
+/** \ingroup AladdinKernels
+ *
+ * Second pass of softmax over rows that are tiled by columns, which
+ * normalizes one column tile with the stats of its rows from
+ * smv_softmax_reduce_nc_vec_fxp().
+ */
+void smv_softmax_normalize_nc_vec_fxp(float16* host_inputs,
+                                      float16* host_results,
+                                      float* inputs,
+                                      float* results,
+                                      float* stats,
+                                      int input_num,
+                                      int input_size,
+                                      int input_pad) {
+    // Load inputs.
+    host_load_fp16(
+            inputs, host_inputs, input_num * (input_size + input_pad), 0, 0);
+
+    VEC_ARRAY_2D(v8fp_t, _inputs, inputs, input_size + input_pad);
+    VEC_ARRAY_2D(v8fp_t, _results, results, input_size + input_pad);
+    int input_vec_size = FRAC_CEIL(input_size, VECTOR_SIZE);
+
+    softmax_norm_batch:
+    for (int i = 0; i < input_num; i++) {
+        float row_max = stats[i];
+        // Precompute the division so that later we can just do a
+        // multiplication.
+        float normaliz = 1.0 / (stats[input_num + i] + 1e-6);
+        softmax_norm_mul:
+        for (int j = 0; j < input_vec_size; j++) {
+            softmax_norm_mul_vec:
+            for (int k = 0; k < VECTOR_SIZE; k++)
+                _results[i][j][k] = exp(_inputs[i][j][k] - row_max) * normaliz;
+        }
+    }
+
+    // Store results to the host memory.
+    host_store_fp16(
+            results, host_results, input_num * (input_size + input_pad), 0, 0);
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -2,6 +2,7 @@
 #define _OPERATORS_SMV_KERNELS_ACTIVATION_FUNCTIONS_SIMD_H_
 
 #include "assert.h"
+#include "math.h"
 #include "stdio.h"
 
 #include "smaug/operators/common.h"
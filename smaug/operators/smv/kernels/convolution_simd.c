@@ -45,9 +45,21 @@ extern "C" {
  *        activations can be reused from the last invocation.
  * @param read_weights Load weights from the host. Set to false if the weights
  *        can be reused from the last invocation.
+ * @param finish_results The results are complete after this invocation, so
+ *        the activation function is applied to them.
  * @param send_results Send the results to the host memory if this is true.
+ *        This can be false for finished results that the next operator reads
+ *        directly from the results scratchpad.
  * @param act_function Activation function the operator runs.
  * @param act_params Parameters for the activation function.
+ * @param host_next_inputs Host buffer of the inputs of the next invocation.
+ * @param host_next_weights Host buffer of the weights of the next invocation.
+ * @param host_last_results Host buffer of the results of the last invocation.
+ * @param next_inputs Local buffer to prefetch the next inputs to.
+ * @param next_weights Local buffer to prefetch the next weights to.
+ * @param last_results Local buffer to drain the last results from.
+ * @param transfer_sizes Sizes of the double-buffered transfers, which overlap
+ *        with this invocation. See host_double_buffer_fp16().
  * @param sampling Simulation samplng settings.
  */
 void smv_conv3d_nhwc_vec_fxp(float16* host_inputs,
@@ -70,9 +82,17 @@ void smv_conv3d_nhwc_vec_fxp(float16* host_inputs,
                              bool accumulate,
                              bool read_inputs,
                              bool read_weights,
+                             bool finish_results,
                              bool send_results,
                              activation_type act_function,
                              activation_param_t act_params,
+                             float16* host_next_inputs,
+                             float16* host_next_weights,
+                             float16* host_last_results,
+                             float* next_inputs,
+                             float* next_weights,
+                             float* last_results,
+                             int transfer_sizes[3],
                              SamplingInfo* sampling) {
     int result_rows = results_dims[1];
     int result_cols = results_dims[2];
@@ -126,6 +146,9 @@ void smv_conv3d_nhwc_vec_fxp(float16* host_inputs,
         host_load_fp16(inputs, host_inputs, inputs_size, 0, 0);
     if (read_weights)
         host_load_fp16(weights, host_weights, weights_size, 0, 0);
+    host_double_buffer_fp16(host_next_inputs, host_next_weights,
+                            host_last_results, next_inputs, next_weights,
+                            last_results, transfer_sizes);
 
     // Set up the sample sizes and factors.
     int pe_block_sample = num_kernel_blocks + 1;
@@ -311,7 +334,7 @@ void smv_conv3d_nhwc_vec_fxp(float16* host_inputs,
         }
     }
     // Only run activation functions when the results are finished.
-    if (act_function != NO_ACTIVATION && send_results) {
+    if (act_function != NO_ACTIVATION && finish_results) {
         activation_fun_vec(
                 results, results, results_size, act_function, act_params);
     }
@@ -320,6 +343,135 @@ void smv_conv3d_nhwc_vec_fxp(float16* host_inputs,
         host_store_fp16(results, host_results, results_size, 0, 0);
 }
 
+/** \ingroup AladdinKernels
+ *
+ * Perform a depthwise 2D convolution on an image in NHWC format, where every
+ * channel of the inputs is convolved with its own 2D filter. There is no
+ * reduction across channels, so VECTOR_SIZE channels are computed at a time.
+ *
+ * @param host_inputs Host inputs buffer in NHWC.
+ * @param host_weights Host weights buffer in NHWC, with one filter per
+ *        channel.
+ * @param host_results Host results buffer in NHWC.
+ * @param inputs Local inputs buffer in NHWC.
+ * @param weights Local weights buffer in NHWC.
+ * @param results Local results buffer in NHWC.
+ * @param inputs_dims Dimensions of the inputs.
+ * @param weights_dims Dimensions of the weights.
+ * @param results_dims Dimensions of the results.
+ * @param inputs_align_pad Alignment padding size on the channel dimension of
+ *        the inputs.
+ * @param weights_pad Alignment padding size on the channel dimension of the
+ *        weights.
+ * @param results_pad Alignment padding size on the channel dimension of the
+ *        results.
+ * @param inputs_halo_pad Padding sizes on top, bottom, left and right of the
+ * input 2D feature maps.
+ * @param row_stride Stride size on the row dimension.
+ * @param col_stride Stride size on the col dimension.
+ * @param read_weights Load weights from the host. Set to false if the weights
+ *        can be reused from the last invocation.
+ * @param act_function Activation function the operator runs.
+ * @param act_params Parameters for the activation function.
+ */
+void smv_depthwise_conv2d_nhwc_vec_fxp(float16* host_inputs,
+                                       float16* host_weights,
+                                       float16* host_results,
+                                       float* inputs,
+                                       float* weights,
+                                       float* results,
+                                       int inputs_dims[4],
+                                       int weights_dims[4],
+                                       int results_dims[4],
+                                       int inputs_align_pad,
+                                       int weights_pad,
+                                       int results_pad,
+                                       int inputs_halo_pad[4],
+                                       int row_stride,
+                                       int col_stride,
+                                       bool read_weights,
+                                       activation_type act_function,
+                                       activation_param_t act_params) {
+    int result_rows = results_dims[1];
+    int result_cols = results_dims[2];
+    int result_height = results_dims[3];
+    int results_size = results_dims[0] * result_rows * result_cols *
+                       (result_height + results_pad);
+
+    int k_rows = weights_dims[1];
+    int k_cols = weights_dims[2];
+    int k_height = weights_dims[3];
+    int weights_size = weights_dims[0] * k_rows * k_cols *
+                       (k_height + weights_pad);
+
+    int a_rows = inputs_dims[1];
+    int a_cols = inputs_dims[2];
+    int a_height = inputs_dims[3];
+    int a_pad = inputs_align_pad;
+    int inputs_size = inputs_dims[0] * a_rows * a_cols * (a_height + a_pad);
+
+    int top_pad = inputs_halo_pad[0];
+    int left_pad = inputs_halo_pad[2];
+    const v8fp_t zero = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    // Load inputs and weights if needed.
+    host_load_fp16(inputs, host_inputs, inputs_size, 0, 0);
+    if (read_weights)
+        host_load_fp16(weights, host_weights, weights_size, 0, 0);
+
+    // Kernels, inputs and results are in NHWC. The weights have a single
+    // kernel, which is applied to every input batch.
+    VEC_ARRAY_3D(v8fp_t, _kernels, weights, k_cols, k_height + weights_pad);
+    VEC_ARRAY_4D(v8fp_t, _a, inputs, a_rows, a_cols, a_height + a_pad);
+    VEC_ARRAY_4D(v8fp_t,
+                 _result,
+                 results,
+                 result_rows,
+                 result_cols,
+                 result_height + results_pad);
+    int num_chan_vecs = FRAC_CEIL(result_height, VECTOR_SIZE);
+
+    dwconv_batch:
+    for (int n = 0; n < results_dims[0]; n++) {
+        dwconv_row:
+        for (int out_i = 0; out_i < result_rows; out_i++) {
+            dwconv_col:
+            for (int out_j = 0; out_j < result_cols; out_j++) {
+                dwconv_chan:
+                for (int chan_vec = 0; chan_vec < num_chan_vecs; chan_vec++) {
+                    v8fp_t results_buffer = zero;
+                    dwconv_k_row:
+                    for (int kern_row = 0; kern_row < k_rows; kern_row++) {
+                        dwconv_k_col:
+                        for (int kern_col = 0; kern_col < k_cols; kern_col++) {
+                            int in_row =
+                                    out_i * row_stride - top_pad + kern_row;
+                            int in_col =
+                                    out_j * col_stride - left_pad + kern_col;
+                            bool is_padding = in_row < 0 || in_row >= a_rows ||
+                                              in_col < 0 || in_col >= a_cols;
+                            v8fp_t act_reg =
+                                    is_padding
+                                            ? zero
+                                            : _a[n][in_row][in_col][chan_vec];
+                            v8fp_t kernel_reg =
+                                    _kernels[kern_row][kern_col][chan_vec];
+                            results_buffer += act_reg * kernel_reg;
+                        }
+                    }
+                    _result[n][out_i][out_j][chan_vec] = results_buffer;
+                }
+            }
+        }
+    }
+    if (act_function != NO_ACTIVATION) {
+        activation_fun_vec(
+                results, results, results_size, act_function, act_params);
+    }
+    // Store results to the host memory.
+    host_store_fp16(results, host_results, results_size, 0, 0);
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
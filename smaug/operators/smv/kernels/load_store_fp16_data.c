@@ -80,6 +80,25 @@ void host_store_fp16(float* local_data,
     }
 }
 
+void host_double_buffer_fp16(float16* host_next_inputs,
+                             float16* host_next_weights,
+                             float16* host_last_results,
+                             float* next_inputs,
+                             float* next_weights,
+                             float* last_results,
+                             int transfer_sizes[3]) {
+    if (transfer_sizes[0] > 0)
+        host_load_fp16(next_inputs, host_next_inputs, transfer_sizes[0], 0, 0);
+    if (transfer_sizes[1] > 0) {
+        host_load_fp16(
+                next_weights, host_next_weights, transfer_sizes[1], 0, 0);
+    }
+    if (transfer_sizes[2] > 0) {
+        host_store_fp16(
+                last_results, host_last_results, transfer_sizes[2], 0, 0);
+    }
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -61,6 +61,32 @@ void host_store_fp16(float* local_data,
                      int local_offset,
                      int remote_offset);
 
+/** \ingroup AladdinKernels
+ *
+ * Does the transfers that a double-buffered kernel overlaps with its
+ * computation: prefetches the inputs and weights of the next invocation into
+ * the other halves of their scratchpads, and drains the results of the last
+ * invocation from the other half of the results scratchpad. None of these
+ * depend on the computation of the current invocation, so the datapath doesn't
+ * have to wait for them.
+ *
+ * @param host_next_inputs Host buffer of the next inputs.
+ * @param host_next_weights Host buffer of the next weights.
+ * @param host_last_results Host buffer of the last results.
+ * @param next_inputs Local buffer to prefetch the next inputs to.
+ * @param next_weights Local buffer to prefetch the next weights to.
+ * @param last_results Local buffer to drain the last results from.
+ * @param transfer_sizes Number of elements of the next inputs, the next
+ *        weights and the last results. A transfer of zero elements is skipped.
+ */
+void host_double_buffer_fp16(float16* host_next_inputs,
+                             float16* host_next_weights,
+                             float16* host_last_results,
+                             float* next_inputs,
+                             float* next_weights,
+                             float* last_results,
+                             int transfer_sizes[3]);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -51,9 +51,23 @@ extern "C" {
  *        for knon-first b tiles.
  * @param read_inputs Load inputs from the host. Set to false if the input
  *        activations can be reused from the last invocation.
+ * @param read_weights Load b from the host. Set to false if it has been
+ *        prefetched by the last invocation.
+ * @param finish_results The results are complete after this invocation, so
+ *        the activation function is applied to them.
  * @param send_results Send the results to the host memory if this is true.
+ *        This can be false for finished results that the next operator reads
+ *        directly from the results scratchpad.
  * @param act_function Activation function the operator runs.
  * @param act_params Parameters for the activation function.
+ * @param host_next_a Host buffer of a of the next invocation.
+ * @param host_next_b Host buffer of b of the next invocation.
+ * @param host_last_results Host buffer of the results of the last invocation.
+ * @param next_a Local buffer to prefetch the next a to.
+ * @param next_b Local buffer to prefetch the next b to.
+ * @param last_results Local buffer to drain the last results from.
+ * @param transfer_sizes Sizes of the double-buffered transfers, which overlap
+ *        with this invocation. See host_double_buffer_fp16().
  * @param sampling Simulation samplng settings.
  */
 void smv_matrix_multiply_transpose_nc_vec_fxp(float16* host_a,
@@ -72,9 +86,18 @@ void smv_matrix_multiply_transpose_nc_vec_fxp(float16* host_a,
                                               int result_start,
                                               bool accumulate,
                                               bool read_inputs,
+                                              bool read_weights,
+                                              bool finish_results,
                                               bool send_results,
                                               activation_type act_function,
                                               activation_param_t act_params,
+                                              float16* host_next_a,
+                                              float16* host_next_b,
+                                              float16* host_last_results,
+                                              float* next_a,
+                                              float* next_b,
+                                              float* last_results,
+                                              int transfer_sizes[3],
                                               SamplingInfo* sampling) {
     int a_width = a_dims[1];
     int a_height = a_dims[0];
@@ -99,7 +122,10 @@ void smv_matrix_multiply_transpose_nc_vec_fxp(float16* host_a,
     // Load a and b if needed.
     if (read_inputs)
         host_load_fp16(a, host_a, a_size, 0, 0);
-    host_load_fp16(b, host_b, b_size, 0, 0);
+    if (read_weights)
+        host_load_fp16(b, host_b, b_size, 0, 0);
+    host_double_buffer_fp16(host_next_a, host_next_b, host_last_results,
+                            next_a, next_b, last_results, transfer_sizes);
 
     // We sample on the FC kernel only if the highest sampling level is used.
     int b_col_sample = b_width_vec;
@@ -197,7 +223,7 @@ void smv_matrix_multiply_transpose_nc_vec_fxp(float16* host_a,
         }
     }
     // Only run activation functions when the results are finished.
-    if (act_function != NO_ACTIVATION && send_results) {
+    if (act_function != NO_ACTIVATION && finish_results) {
         activation_fun_vec(
                 results, results, results_size, act_function, act_params);
     }
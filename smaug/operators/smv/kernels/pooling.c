@@ -31,6 +31,8 @@ extern "C" {
  * @param col_stride Stride size on the col dimension.
  * @param ofmap_start If the results contains more channels than the inputs,
  *        start from this one. Otherwise this should always be zero.
+ * @param read_inputs Load inputs from the host. Set to false if the inputs
+ *        were left in the inputs scratchpad by the previous operator.
  * @param sampling Simulation samplng settings.
  */
 void smv_maxpooling_nhwc_vec_fxp(float16* host_inputs,
@@ -46,6 +48,7 @@ void smv_maxpooling_nhwc_vec_fxp(float16* host_inputs,
                                  int row_stride,
                                  int col_stride,
                                  int ofmap_start,
+                                 bool read_inputs,
                                  SamplingInfo* sampling) {
     int a_rows = inputs_dims[1];
     int a_cols = inputs_dims[2];
@@ -72,8 +75,9 @@ void smv_maxpooling_nhwc_vec_fxp(float16* host_inputs,
                  results_cols,
                  results_height + results_pad);
 
-    // Load inputs.
-    host_load_fp16(inputs, host_inputs, inputs_size, 0, 0);
+    // Load inputs if needed.
+    if (read_inputs)
+        host_load_fp16(inputs, host_inputs, inputs_size, 0, 0);
 
     // We sample on the pooling kernel only if the highest sampling level is
     // used.
@@ -161,6 +165,8 @@ void smv_maxpooling_nhwc_vec_fxp(float16* host_inputs,
  * @param col_stride Stride size on the col dimension.
  * @param ofmap_start If the results contains more channels than the inputs,
  *        start from this one. Otherwise this should always be zero.
+ * @param read_inputs Load inputs from the host. Set to false if the inputs
+ *        were left in the inputs scratchpad by the previous operator.
  * @param sampling Simulation samplng settings.
  */
 void smv_avgpooling_nhwc_vec_fxp(float16* host_inputs,
@@ -176,6 +182,7 @@ void smv_avgpooling_nhwc_vec_fxp(float16* host_inputs,
                                  int row_stride,
                                  int col_stride,
                                  int ofmap_start,
+                                 bool read_inputs,
                                  SamplingInfo* sampling) {
     int a_rows = inputs_dims[1];
     int a_cols = inputs_dims[2];
@@ -207,8 +214,9 @@ void smv_avgpooling_nhwc_vec_fxp(float16* host_inputs,
                  results_cols,
                  results_height + results_pad);
 
-    // Load inputs.
-    host_load_fp16(inputs, host_inputs, inputs_size, 0, 0);
+    // Load inputs if needed.
+    if (read_inputs)
+        host_load_fp16(inputs, host_inputs, inputs_size, 0, 0);
 
     // We sample on the pooling kernel only if the highest sampling level is
     // used.
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <string>
 
 #include "smaug/operators/common.h"
@@ -6,8 +7,10 @@
 
 namespace smaug {
 
-SmvAcceleratorPool::SmvAcceleratorPool(int _size)
-        : size(_size), finishFlags(_size) {}
+SmvAcceleratorPool::SmvAcceleratorPool(int _size, AccelDispatchPolicy _policy)
+        : size(_size), policy(_policy), lastAccelIdx(-1),
+          finishTime(_size, 0), currTime(0), lastReadWeightTiles(nullptr),
+          estimatedCycles(_size, 0), finishFlags(_size) {}
 
 void SmvAcceleratorPool::addFinishFlag(
         int accelIdx, std::unique_ptr<volatile int> finishFlag) {
@@ -29,6 +32,13 @@ void SmvAcceleratorPool::join(int accelIdx) {
     dout(1) << "Accelerator " << accelIdx << " finished.\n";
 }
 
+bool SmvAcceleratorPool::isIdle(int accelIdx) {
+    auto& flags = finishFlags[accelIdx];
+    while (!flags.empty() && *flags.front() != NOT_COMPLETED)
+        flags.pop_front();
+    return flags.empty();
+}
+
 void SmvAcceleratorPool::joinAll() {
     dout(1) << "Waiting for all accelerators to finish.\n";
     for (int i = 0; i < size; i++)
@@ -36,15 +46,71 @@ void SmvAcceleratorPool::joinAll() {
     dout(1) << "All accelerators finished.\n";
 }
 
-int SmvAcceleratorPool::getNextAvailableAccelerator(int currAccelIdx) {
-    // Round-robin policy.
-    int pickedAccel = currAccelIdx + 1;
-    if (pickedAccel == size)
-        pickedAccel = 0;
+uint64_t SmvAcceleratorPool::getEstimatedCycles() const {
+    return *std::max_element(estimatedCycles.begin(), estimatedCycles.end());
+}
+
+int SmvAcceleratorPool::pickRoundRobin() {
+    return (lastAccelIdx + 1) % size;
+}
+
+int SmvAcceleratorPool::pickPolling() {
+    // Start looking after the last picked accelerator, so the work is spread
+    // evenly when several are idle (always the case when not simulating).
+    while (true) {
+        for (int i = 1; i <= size; i++) {
+            int accelIdx = (lastAccelIdx + i) % size;
+            if (isIdle(accelIdx))
+                return accelIdx;
+        }
+    }
+}
+
+int SmvAcceleratorPool::pickLeastWork() {
+    return std::min_element(finishTime.begin(), finishTime.end()) -
+           finishTime.begin();
+}
+
+int SmvAcceleratorPool::pickWeightAffinity(const AcceleratorWork& work) {
+    if (lastReadWeightTiles && work.weightTileIdx >= 0) {
+        // Among the accelerators that hold the weight tile, take the one that
+        // is done first.
+        int pickedAccel = -1;
+        for (int i = 0; i < size; i++) {
+            if (lastReadWeightTiles->at(i) == work.weightTileIdx &&
+                (pickedAccel == -1 ||
+                 finishTime[i] < finishTime[pickedAccel]))
+                pickedAccel = i;
+        }
+        if (pickedAccel != -1)
+            return pickedAccel;
+    }
+    return pickLeastWork();
+}
+
+int SmvAcceleratorPool::getNextAvailableAccelerator(
+        const AcceleratorWork& work) {
+    int pickedAccel;
+    switch (policy) {
+        case PollingDispatch:
+            pickedAccel = pickPolling();
+            break;
+        case LeastWorkDispatch:
+            pickedAccel = pickLeastWork();
+            break;
+        case WeightAffinityDispatch:
+            pickedAccel = pickWeightAffinity(work);
+            break;
+        default:
+            pickedAccel = pickRoundRobin();
+    }
     // If the picked accelerator has not finished, wait until it returns.
     join(pickedAccel);
-    if (size > 1)
+    currTime = std::max(currTime, finishTime[pickedAccel]);
+    finishTime[pickedAccel] = currTime + work.cost;
+    if (size > 1 && pickedAccel != lastAccelIdx)
         dout(1) << "Switched to accelerator " << pickedAccel << ".\n";
+    lastAccelIdx = pickedAccel;
     return pickedAccel;
 }
 
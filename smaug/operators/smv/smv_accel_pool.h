@@ -1,37 +1,56 @@
 #ifndef _OPERATORS_SMV_SMV_ACCELERATOR_POOL_H_
 #define _OPERATORS_SMV_SMV_ACCELERATOR_POOL_H_
 
+#include <cstdint>
 #include <vector>
 #include <deque>
 #include <memory>
 
+#include "smaug/core/globals.h"
+
 namespace smaug {
 
+/**
+ * Describes a unit of work to be dispatched to an accelerator, so that the
+ * dispatch policies can pick a suitable one.
+ */
+struct AcceleratorWork {
+    /**
+     * The estimated cost of the work, e.g. the number of MACs. Only the
+     * relative costs of the work units of an operator matter.
+     */
+    double cost = 1;
+    /** The first weight tile the work reads, or -1 if it reads none. */
+    int weightTileIdx = -1;
+};
+
 /**
  * Implements a pool of worker accelerators.
  *
  * For operators that require work tiling, tiles can be distributed across
- * multiple accelerators to exploit parallelism. This class implements a
- * deterministic round-robin worker pool. Determinism is required because when
- * generating multiple dynamic traces, worker accelerator assignments must
- * match with simulation of the binary in gem5.
+ * multiple accelerators to exploit parallelism. Which accelerator gets the next
+ * unit of work is decided by an AccelDispatchPolicy. The default round-robin
+ * policy is deterministic, which is required when generating multiple dynamic
+ * traces, because worker accelerator assignments must match with simulation of
+ * the binary in gem5. The other policies balance uneven work (e.g. the last
+ * partial tiles) better.
  *
  * To use:
  *
  * ```c
  * SmvAcceleratorPool pool(size);
- * int currAccel = 0;
  * for (int i = 0; i < tiles; i++) {
+ *    int currAccel = pool.getNextAvailableAccelerator(work[i]);
  *    volatile int* finishFlag = invokeKernelNoBlock(currAccel, redCode, kernel, args...);
  *    pool.addFinishFlag(currAccel, std::make_unique(finishFlag));
- *    currAccel = pool.getNextAvailableAccelerator(currAccel);
  * }
  * pool.joinAll();
  * ```
  */
 class SmvAcceleratorPool {
    public:
-    SmvAcceleratorPool(int _size);
+    SmvAcceleratorPool(int _size,
+                       AccelDispatchPolicy _policy = accelDispatchPolicy);
 
     /** Add a finish flag for the specified accelerator. */
     void addFinishFlag(int accelIdx, std::unique_ptr<volatile int> finishFlag);
@@ -40,25 +59,74 @@ class SmvAcceleratorPool {
     void joinAll();
 
     /**
-     * Get the next accelerator and wait if it's still busy. A round-robin
-     * scheduling policy is used for picking the accelerator. The simple static
-     * policy is used because the scheduling decisions need to be the same as
-     * when we generate the traces, whereas dynamic decisions that depend on
-     * runtime information may lead to mismatch between the traces and the
-     * simulation.
-     *
-     * TODO(xyzsam): the pool should be able to keep track of the current
-     * accelerator index on its own.
+     * Sets the weight tile that each accelerator last read, for the
+     * weight-affinity policy. The vector is owned by the operator, which keeps
+     * it up to date as it dispatches work.
+     */
+    void setLastReadWeightTiles(const std::vector<int>* lastReadWeightTileIdx) {
+        lastReadWeightTiles = lastReadWeightTileIdx;
+    }
+
+    /**
+     * Picks the accelerator to run the given work on, according to the
+     * dispatch policy, and waits until it's done with its previous work.
+     */
+    int getNextAvailableAccelerator(
+            const AcceleratorWork& work = AcceleratorWork());
+
+    /**
+     * Adds the estimated cycles of a kernel invocation on this accelerator
+     * (see InvocationCost).
+     */
+    void addEstimatedCycles(int accelIdx, uint64_t cycles) {
+        estimatedCycles[accelIdx] += cycles;
+    }
+
+    /**
+     * Returns the estimated cycles until all the accelerators are done with
+     * their invocations. The accelerators run in parallel, so this is the
+     * most any of them has.
      */
-    int getNextAvailableAccelerator(int currAccelIdx);
+    uint64_t getEstimatedCycles() const;
 
    protected:
     /** Wait until this accelerator's finish flags turn complete. */
     void join(int accelIdx);
 
+    /**
+     * Returns true if this accelerator has finished all its work, without
+     * blocking.
+     */
+    bool isIdle(int accelIdx);
+
+    int pickRoundRobin();
+    int pickPolling();
+    int pickLeastWork();
+    int pickWeightAffinity(const AcceleratorWork& work);
+
     /** Number of accelerators in the pool. */
     int size;
 
+    AccelDispatchPolicy policy;
+
+    /** The accelerator that got the last unit of work. */
+    int lastAccelIdx;
+
+    /**
+     * The estimated time at which each accelerator finishes its outstanding
+     * work, in units of work cost. This is only a model and never depends on
+     * the real accelerators, so the least-work policy is deterministic too.
+     */
+    std::vector<double> finishTime;
+
+    /** The estimated current time, in units of work cost. */
+    double currTime;
+
+    const std::vector<int>* lastReadWeightTiles;
+
+    /** The estimated cycles of the invocations on each accelerator. */
+    std::vector<uint64_t> estimatedCycles;
+
     /** Active finish flags for all the accelerators in the pool. */
     std::vector<std::deque<std::unique_ptr<volatile int>>> finishFlags;
 };
@@ -0,0 +1,74 @@
+#include "catch.hpp"
+#include "smaug/core/globals.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/operators/common.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
+
+using namespace smaug;
+
+namespace {
+
+std::unique_ptr<volatile int> makeFinishFlag(int value) {
+    std::unique_ptr<volatile int> flag(new int);
+    *flag = value;
+    return flag;
+}
+
+AcceleratorWork makeWork(double cost, int weightTileIdx = -1) {
+    AcceleratorWork work;
+    work.cost = cost;
+    work.weightTileIdx = weightTileIdx;
+    return work;
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SmaugTest, "SMV accelerator dispatch policies", "[smvpool]") {
+    SECTION("Round robin") {
+        SmvAcceleratorPool pool(2, RoundRobinDispatch);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(10)) == 0);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1)) == 1);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1)) == 0);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1)) == 1);
+    }
+
+    SECTION("Least work") {
+        // Accelerator 0 is busy with the big work unit while accelerator 1
+        // gets through the small ones.
+        SmvAcceleratorPool pool(2, LeastWorkDispatch);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(10)) == 0);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1)) == 1);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1)) == 1);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1)) == 1);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(10)) == 1);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1)) == 0);
+    }
+
+    SECTION("Weight affinity") {
+        SmvAcceleratorPool pool(2, WeightAffinityDispatch);
+        std::vector<int> lastReadWeightTiles = { 5, 7 };
+        pool.setLastReadWeightTiles(&lastReadWeightTiles);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1, 7)) == 1);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1, 7)) == 1);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1, 5)) == 0);
+        // Nobody holds this tile, so it goes to the least busy accelerator.
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1, 3)) == 0);
+        REQUIRE(pool.getNextAvailableAccelerator(makeWork(1)) == 1);
+    }
+
+    SECTION("Polling") {
+        runningInSimulation = true;
+        SmvAcceleratorPool pool(2, PollingDispatch);
+        REQUIRE(pool.getNextAvailableAccelerator() == 0);
+        auto busyFlag = makeFinishFlag(NOT_COMPLETED);
+        volatile int* busy = busyFlag.get();
+        pool.addFinishFlag(0, std::move(busyFlag));
+        REQUIRE(pool.getNextAvailableAccelerator() == 1);
+        pool.addFinishFlag(1, makeFinishFlag(IS_COMPLETED));
+        // Accelerator 1 has finished and 0 hasn't.
+        REQUIRE(pool.getNextAvailableAccelerator() == 1);
+        *busy = IS_COMPLETED;
+        REQUIRE(pool.getNextAvailableAccelerator() == 0);
+        pool.joinAll();
+    }
+}
@@ -28,20 +28,37 @@ void SmvBatchNormOp::runNA(TiledTensor& inputs,
     auto inputIdx = inputs.startIndex();
     auto weightIdx = weights.startIndex();
     auto outputIdx = outputs.startIndex();
-    setArrayMemTypeIfSimulating(
-            smv::kBatchNormHw, "host_inputs", getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kBatchNormHw, "host_weights", getWeightsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kBatchNormHw, "host_results", getOutputsMemType());
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = smv::kBatchNormHw + firstAccelIdx;
+    for (int i = 0; i < numAccels; i++) {
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_weights", getWeightsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_results", getOutputsMemType());
+    }
+    SmvAcceleratorPool accelPool(numAccels);
     for (int N = 0; N < inputNumTiles; N++) {
         int iC = 0, wC = 0;
         // This keeps track of the activation offset of the inputs.
         int actOffset = 0;
+        int currAccelIdx = 0;
         while (iC < inputActTiles && wC < weightActTiles) {
             int inputTileIdx =  inputIdx(N, iC);
             int weightTileIdx = weightIdx(0, wC);
             int outputTileIdx = outputIdx(N, iC);
+            // Every output tile can be computed on a different accelerator.
+            // If the inputs are not tiled activation-wise, all the weight
+            // tiles contribute to the same output tile, which stays in the
+            // results spad until the last one, so they must run on the same
+            // accelerator.
+            if (wC == 0 || inputActTiles == weightActTiles) {
+                AcceleratorWork work;
+                work.cost = outputs[outputTileIdx]->getShape().size();
+                currAccelIdx = accelPool.getNextAvailableAccelerator(work);
+            }
             dout(1) << "Input: " << inputIdx(N, iC)
                     << ", weight: " << weightIdx(0, wC)
                     << ", output: " << outputIdx(N, iC) << "\n";
@@ -51,13 +68,13 @@ void SmvBatchNormOp::runNA(TiledTensor& inputs,
             const TensorShape& inputShape = inputTile->getShape();
             const TensorShape& weightsShape = weightsTile->getShape();
             const TensorShape& outputShape = outputTile->getShape();
-            mapArrayToAccel(smv::kBatchNormHw, "host_inputs",
+            mapArrayToAccel(accelId + currAccelIdx, "host_inputs",
                             inputTile->data<float16>(),
                             inputShape.storageSize() * sizeof(float16));
-            mapArrayToAccel(smv::kBatchNormHw, "host_weights",
+            mapArrayToAccel(accelId + currAccelIdx, "host_weights",
                             weightsTile->data<float16>(),
                             weightsShape.storageSize() * sizeof(float16));
-            mapArrayToAccel(smv::kBatchNormHw, "host_results",
+            mapArrayToAccel(accelId + currAccelIdx, "host_results",
                             outputTile->data<float16>(),
                             outputShape.storageSize() * sizeof(float16));
             int inputDims[2] = { inputShape[0], inputShape[1] };
@@ -69,13 +86,15 @@ void SmvBatchNormOp::runNA(TiledTensor& inputs,
             // Send the results back to host memory when we finish the weights.
             bool sendOutputs = iC == wC || wC == weightActTiles - 1;
 
-            invokeKernel(smv::kBatchNormHw, smv_batch_norm_post_fc_nc_vec_fxp,
-                         inputTile->data<float16>(),
-                         weightsTile->data<float16>(),
-                         outputTile->data<float16>(), smv::spad0, smv::spad1,
-                         smv::spad2, inputDims, weightsShape[1],
-                         inputShape.getPadding(1), actStart, sendOutputs,
-                         actInfo.function, actInfo.params);
+            std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
+                    firstAccelIdx + currAccelIdx, accelId + currAccelIdx,
+                    smv_batch_norm_post_fc_nc_vec_fxp,
+                    inputTile->data<float16>(), weightsTile->data<float16>(),
+                    outputTile->data<float16>(), smv::spad0, smv::spad1,
+                    smv::spad2, inputDims, weightsShape[1],
+                    inputShape.getPadding(1), actStart, sendOutputs,
+                    actInfo.function, actInfo.params);
+            accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
 
             actOffset += weightsTile->getShape()[1];
             if (inputActTiles == weightActTiles) {
@@ -90,6 +109,7 @@ void SmvBatchNormOp::runNA(TiledTensor& inputs,
             }
         }
     }
+    accelPool.joinAll();
 }
 
 // The tile dispatcher for post-convolution batch norms. The tile iteration is
@@ -111,19 +131,21 @@ void SmvBatchNormOp::runNHWC(TiledTensor& inputs,
     auto outputIdx = outputs.startIndex();
     Tensor* weightTile = weights.getTileWithData(0);
     const TensorShape& weightShape = weightTile->getShape();
-    for (int i = 0; i < numAcceleratorsAvailable; i++) {
-        mapArrayToAccel(smv::kBatchNormHw + i, "host_weights",
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = smv::kBatchNormHw + firstAccelIdx;
+    for (int i = 0; i < numAccels; i++) {
+        mapArrayToAccel(accelId + i, "host_weights",
                         weightTile->data<float16>(),
                         weightShape.storageSize() * sizeof(float16));
         setArrayMemTypeIfSimulating(
-                smv::kBatchNormHw + i, "host_inputs", getInputsMemType());
+                accelId + i, "host_inputs", getInputsMemType());
         setArrayMemTypeIfSimulating(
-                smv::kBatchNormHw + i, "host_weights", getWeightsMemType());
+                accelId + i, "host_weights", getWeightsMemType());
         setArrayMemTypeIfSimulating(
-                smv::kBatchNormHw + i, "host_results", getOutputsMemType());
+                accelId + i, "host_results", getOutputsMemType());
     }
-    SmvAcceleratorPool accelPool(numAcceleratorsAvailable);
-    int currAccelIdx = 0;
+    SmvAcceleratorPool accelPool(numAccels);
     for (int N = 0; N < inputNumTiles; N++) {
         for (int H = 0; H < inputRowTiles; H++) {
             for (int W = 0; W < inputColTiles; W++) {
@@ -132,17 +154,22 @@ void SmvBatchNormOp::runNHWC(TiledTensor& inputs,
                 for (int C = 0; C < inputChanTiles; C++) {
                     int inputTileIdx = inputIdx(N, H, W, C);
                     int outputTileIdx = outputIdx(N, H, W, C);
+                    // Every accelerator already has the only weight tile.
+                    AcceleratorWork work;
+                    work.cost = inputs[inputTileIdx]->getShape().size();
+                    int currAccelIdx =
+                            accelPool.getNextAvailableAccelerator(work);
                     dout(1) << "Input: " << inputTileIdx << ", Weight: 0"
                             << ", output: " << outputTileIdx << "\n";
                     Tensor* inputTile = inputs.getTileWithData(inputTileIdx);
                     Tensor* outputTile = outputs[outputTileIdx];
                     const TensorShape& inputShape = inputTile->getShape();
                     const TensorShape& outputShape = outputTile->getShape();
-                    mapArrayToAccel(smv::kBatchNormHw + currAccelIdx,
+                    mapArrayToAccel(accelId + currAccelIdx,
                                     "host_inputs", inputTile->data<float16>(),
                                     inputShape.storageSize() * sizeof(float16));
                     mapArrayToAccel(
-                            smv::kBatchNormHw + currAccelIdx, "host_results",
+                            accelId + currAccelIdx, "host_results",
                             outputTile->data<float16>(),
                             outputShape.storageSize() * sizeof(float16));
                     int inputDims[4] = { inputShape[0], inputShape[1],
@@ -150,8 +177,8 @@ void SmvBatchNormOp::runNHWC(TiledTensor& inputs,
 
                     std::unique_ptr<volatile int> finishFlag =
                             invokeKernelNoBlock(
-                                    currAccelIdx,
-                                    smv::kBatchNormHw + currAccelIdx,
+                                    firstAccelIdx + currAccelIdx,
+                                    accelId + currAccelIdx,
                                     smv_batch_norm_post_conv_nhwc_vec_fxp,
                                     inputTile->data<float16>(),
                                     weightTile->data<float16>(),
@@ -164,8 +191,6 @@ void SmvBatchNormOp::runNHWC(TiledTensor& inputs,
                     accelPool.addFinishFlag(
                             currAccelIdx, std::move(finishFlag));
                     ifmapOffset += inputShape[3];
-                    currAccelIdx =
-                            accelPool.getNextAvailableAccelerator(currAccelIdx);
                 }
             }
         }
@@ -29,6 +29,9 @@ class SmvBatchNormOp : public BatchNormOp<SmvBackend> {
     using BatchNormOp<SmvBackend>::BatchNormOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
 
   protected:
    /** Post-FC tile dispatcher. */
@@ -239,6 +239,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(Tensor* inputs,
                                 fullConfigs);
     }
 
+    tilingSearchStats.configs += fullConfigs.size();
     dout(2) << "  Number of possible tiling configs: " << fullConfigs.size()
             << "\n";
     for (auto& config : fullConfigs)
@@ -1,9 +1,13 @@
+#include <algorithm>
+
 #include "smaug/core/backend.h"
 #include "smaug/operators/common.h"
 #include "smaug/operators/smv/smv_convolution_op.h"
 #include "smaug/operators/smv/smv_convolution_tiling.h"
 #include "smaug/operators/smv/smv_kernels.h"
 #include "smaug/operators/smv/smv_accel_pool.h"
+#include "smaug/operators/smv/smv_cycle_model.h"
+#include "smaug/operators/smv/smv_double_buffer.h"
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
@@ -34,210 +38,403 @@ void SmvConvolutionOp::runNHWC(TiledTensor& inputs,
     int bottomPad = inputPadding[1];
     int leftPad = inputPadding[2];
     int rightPad = inputPadding[3];
-    unsigned accelId = useSystolicArrayWhenAvailable ? smv::kSystolicArrayHw
-                                                     : smv::kConvolutionHw;
-    SmvAcceleratorPool accelPool(numAcceleratorsAvailable);
-    std::vector<int> lastReadInputTileIdx(numAcceleratorsAvailable, -1);
-    std::vector<int> lastReadWeightTileIdx(numAcceleratorsAvailable, -1);
-    for (int i = 0; i < numAcceleratorsAvailable; i++) {
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = (useSystolicArrayWhenAvailable ? smv::kSystolicArrayHw
+                                                      : smv::kConvolutionHw) +
+                       firstAccelIdx;
+    SmvAcceleratorPool accelPool(numAccels);
+    std::vector<int> lastReadInputTileIdx(numAccels, -1);
+    std::vector<int> lastReadWeightTileIdx(numAccels, -1);
+    accelPool.setLastReadWeightTiles(&lastReadWeightTileIdx);
+    // If the inputs are forwarded from the previous operator, the only input
+    // tile is already in that operator's results spad, so we use it as our
+    // inputs spad and put our results in spad0 instead.
+    bool inputsOnChip = getFusedProducer() != nullptr;
+    bool outputsOnChip = getFusedConsumer() != nullptr;
+    float* inputsSpad = inputsOnChip ? smv::spad2 : smv::spad0;
+    float* resultsSpad = inputsOnChip ? smv::spad0 : smv::spad2;
+    if (inputsOnChip)
+        lastReadInputTileIdx[0] = 0;
+    bool doubleBuffered = isDoubleBuffered();
+    SmvDoubleBuffer doubleBuffer(
+            &accelPool, numAccels, inputsSpad, smv::spad1, resultsSpad);
+    for (int i = 0; i < numAccels; i++) {
         setArrayMemTypeIfSimulating(
                 accelId + i, "host_inputs", getInputsMemType());
         setArrayMemTypeIfSimulating(
                 accelId + i, "host_weights", getWeightsMemType());
         setArrayMemTypeIfSimulating(
                 accelId + i, "host_results", getOutputsMemType());
+        if (doubleBuffered) {
+            setArrayMemTypeIfSimulating(
+                    accelId + i, "host_next_inputs", getInputsMemType());
+            setArrayMemTypeIfSimulating(
+                    accelId + i, "host_next_weights", getWeightsMemType());
+            setArrayMemTypeIfSimulating(
+                    accelId + i, "host_last_results", getOutputsMemType());
+        }
     }
-    int currAccelIdx = 0;
-    for (int N = 0; N < inputIfmapTiles; N++) {
-        for (int H = 0; H < outputRowTiles; H++) {
-            int currentTileTopPad = topPad;
-            int currentTileBottomPad = bottomPad;
-            if (inputRowTiles > 1) {
-                if (H == 0) {
-                    currentTileBottomPad = 0;
-                } else if (H == inputRowTiles - 1) {
-                    currentTileTopPad = 0;
-                } else {
-                    currentTileTopPad = 0;
-                    currentTileBottomPad = 0;
-                }
+    // The three outer loop levels, over the input batch-wise tiles, the
+    // output rowwise tiles and the weight N-wise tiles, have no data
+    // dependency among them, so they can run in any order and in parallel.
+    // The batch-wise and rowwise tiles together make the activation side of
+    // a work unit.
+    smv::TileLoopOrder order = tileLoopOrder;
+    if (order == smv::AutoTileLoopOrder)
+        order = chooseTileLoopOrder(inputs, weights, outputs);
+    dout(1) << "Tile loop order: " << order << "\n";
+    int numActUnits = inputIfmapTiles * outputRowTiles;
+    std::vector<std::pair<int, int>> chanSteps =
+            smv::getChannelSteps(inputChanTiles, weightChanTiles);
+    // On one condition, the tiling optimizer allows the weight tile to
+    // contain more kernels than the output tile: the weights do not need
+    // N-wise tiling (weightOfmapTiles = 1), whereas the output needs
+    // channelwise tiling (weightOfmapTiles < outputChanTiles). We will then
+    // need multiple kernel invocations to finish the weight tile, where each
+    // invocation only consumes part of it. The argument 'kern_start' is used
+    // for this: it provides the starting kernel from which the weight tile
+    // will be effective.
+    bool needOutputIteration = weightOfmapTiles < outputChanTiles;
+    // This is the number of invocations we need to finish the weight tile. In
+    // common scenarios, only one invocation is needed. If we need to iterate
+    // the output channels, outputChanTiles invocatons are needed to finish
+    // the weight tile.
+    int numOutputInvocations = needOutputIteration ? outputChanTiles : 1;
+    assert(numOutputInvocations > 1 ? weightOfmapTiles == 1
+                                    : weightOfmapTiles == outputChanTiles);
+    for (const auto& unit :
+         smv::getWorkUnitOrder(order, numActUnits, weightOfmapTiles)) {
+        int N = unit.first / outputRowTiles;
+        int H = unit.first % outputRowTiles;
+        int W = unit.second;
+        int currentTileTopPad = topPad;
+        int currentTileBottomPad = bottomPad;
+        if (inputRowTiles > 1) {
+            if (H == 0) {
+                currentTileBottomPad = 0;
+            } else if (H == inputRowTiles - 1) {
+                currentTileTopPad = 0;
+            } else {
+                currentTileTopPad = 0;
+                currentTileBottomPad = 0;
+            }
+        }
+        // This is used to specify the padding sizes on the boundaries of the
+        // 2D feature maps in an input tile.
+        int inputHaloPad[4] = { currentTileTopPad, currentTileBottomPad,
+                                leftPad, rightPad };
+        int kernStart = 0;
+        // We have another two loop level beyond this point, one for output
+        // channelwise tiles iteration and the other for weight channelwise
+        // tiles iteration. We run these loop nests in serial (i.e., on one
+        // single accelerator). The ones in the latter loop accumulate results
+        // to the same output tile and thus exhibiting data dependency,
+        // whereas the former could run in parallel technically, but we will
+        // need to reload too much weights for that and therefore I choose not
+        // to.
+        int currAccelIdx = accelPool.getNextAvailableAccelerator(
+                getAcceleratorWork(weights, outputs, N, H, W));
+        // A tile is only still in the scratchpads if the last kernel that
+        // ran on them read it, which may have been another accelerator's.
+        int spadOwner = getSpadOwner(currAccelIdx);
+        for (int oC = 0; oC < numOutputInvocations; oC++) {
+            // This keeps track of the channel offset of the input.
+            int ifmapOffset = 0;
+            int outputTileIdx = outputIdx(N, H, 0, W + oC);
+            Tensor* outputTile = outputs[outputTileIdx];
+            const TensorShape& outputShape = outputTile->getShape();
+
+            // The tiling optimizer will make sure that the weight tiles have
+            // the same channel dimension as the input tiles (so that
+            // inputChanTiles = weightChanTiles), except one case where the
+            // input is not tiled channelwise (inputChanTiles = 1) and the
+            // weights are independently tiled channelwise. In that case, we
+            // will need multiple kernel invocations to finish the weight
+            // channelwise tiles, with the same input channel tile, producing
+            // results for the same output channels.
+            //
+            // In the former case, the steps can go in either order, and we go
+            // backwards if this accelerator still holds the tiles of the last
+            // step from its previous work unit.
+            std::vector<std::pair<int, int>> steps = chanSteps;
+            if (inputChanTiles == weightChanTiles &&
+                smv::reverseChannelSteps(
+                        { inputIdx(N, H, 0, steps.front().first),
+                          weightIdx(W, 0, 0, steps.front().second) },
+                        { inputIdx(N, H, 0, steps.back().first),
+                          weightIdx(W, 0, 0, steps.back().second) },
+                        { lastReadInputTileIdx[spadOwner],
+                          lastReadWeightTileIdx[spadOwner] })) {
+                std::reverse(steps.begin(), steps.end());
             }
-            // This is used to specify the padding sizes on the boundaries of
-            // the 2D feature maps in an input tile.
-            int inputHaloPad[4] = { currentTileTopPad, currentTileBottomPad,
-                                    leftPad, rightPad };
-            // On one condition, the tiling optimizer allows the weight tile to
-            // contain more kernels than the output tile: the weights do not
-            // need N-wise tiling (weightOfmapTiles = 1), whereas the output
-            // needs channelwise tiling (weightOfmapTiles < outputChanTiles).
-            // We will then need multiple kernel invocations to finish the
-            // weight tile, where each invocation only consumes part of it. The
-            // argument 'kern_start' is used for this: it provides the starting
-            // kernel from which the weight tile will be effective.
-            bool needOutputIteration = weightOfmapTiles < outputChanTiles;
-            int kernStart = 0;
-            // This is the number of invocations we need to finish the weight
-            // tile. In common scenarios, only one invocation is needed. If we
-            // need to iterate the output channels, outputChanTiles invocatons
-            // are needed to finish the weight tile.
-            int numOutputInvocations =
-                    needOutputIteration ? outputChanTiles : 1;
-            assert(numOutputInvocations > 1
-                           ? weightOfmapTiles == 1
-                           : weightOfmapTiles == outputChanTiles);
-            for (int W = 0; W < weightOfmapTiles; W++) {
-                // We have three loop levels up to this point, the first for
-                // input batch-wise tiles iteration, the second for input
-                // rowwise tiles iteration, the third for weight N-wise tiles
-                // iteration. There is no data dependency among the loop nests
-                // involve in these levels, and therefore we can run them
-                // in parallel.
-                //
-                // We have another two loop level beyond this point, one for
-                // output channelwise tiles iteration and the other for weight
-                // channelwise tiles iteration. We run these loop nests in
-                // serial (i.e., on one single accelerator). The ones in the
-                // latter loop accumulate results to the same output tile and
-                // thus exhibiting data dependency, whereas the former could run
-                // in parallel technically, but we will need to reload too much
-                // weights for that and therefore I choose not to.
-                for (int oC = 0; oC < numOutputInvocations; oC++) {
-                    int iC = 0, wC = 0;
-                    // This keeps track of the channel offset of the input.
-                    int ifmapOffset = 0;
-                    int outputTileIdx = outputIdx(N, H, 0, W + oC);
-                    Tensor* outputTile = outputs[outputTileIdx];
-                    const TensorShape& outputShape = outputTile->getShape();
+            for (int step = 0; step < steps.size(); step++) {
+                int iC = steps[step].first;
+                int wC = steps[step].second;
+                int inputTileIdx = inputIdx(N, H, 0, iC);
+                int weightTileIdx = weightIdx(W, 0, 0, wC);
+                dout(1) << "Input: " << inputTileIdx
+                        << ", weights: " << weightTileIdx
+                        << ", output: " << outputTileIdx << "\n";
+                Tensor* inputTile = inputs.getTileWithData(inputTileIdx);
+                Tensor* weightsTile = weights.getTileWithData(weightTileIdx);
+                const TensorShape& inputShape = inputTile->getShape();
+                const TensorShape& weightsShape = weightsTile->getShape();
+                int inputDims[4] = { inputShape[0], inputShape[1],
+                                     inputShape[2], inputShape[3] };
+                int weightsDims[4] = { weightsShape[0], weightsShape[1],
+                                       weightsShape[2], weightsShape[3] };
+                int outputDims[4] = { outputShape[0], outputShape[1],
+                                      outputShape[2], outputShape[3] };
+                // The 'ifmap_start' argument of the kernel is for handling
+                // when inputChanTiles < weightChanTiles. It provides the
+                // starting channel of the input tile that will be effective
+                // for computation in the invocation.
+                int ifmapStart = (iC == wC) ? 0 : ifmapOffset;
+                // Since multiple weight channelwise tiles produce the same
+                // output channels, 'accumulate' is set to true to avoid
+                // resetting the result for non-first steps.
+                bool accumulate = step > 0;
+                // If this is a new input/weight tile, then we need to read it.
+                bool readInputs = false;
+                if (inputTileIdx != lastReadInputTileIdx[spadOwner]) {
+                    readInputs = true;
+                    lastReadInputTileIdx[spadOwner] = inputTileIdx;
+                }
+                bool readWeights = false;
+                if (weightTileIdx != lastReadWeightTileIdx[spadOwner]) {
+                    readWeights = true;
+                    lastReadWeightTileIdx[spadOwner] = weightTileIdx;
+                }
+                // If we reach the last step, the results are finished and
+                // need to be sent back to the host, unless the next operator
+                // reads them from the results spad.
+                bool finishResults = step == steps.size() - 1;
+                bool sendResults = finishResults && !outputsOnChip;
+
+                // This maps the tiles to the accelerator and invokes the
+                // kernel. With double buffering, it only runs once the next
+                // invocation on this accelerator is known.
+                auto launch = [=, &accelPool](SpadAssignment& spads) mutable {
+                    unsigned reqCode = accelId + currAccelIdx;
+                    mapArrayToAccel(reqCode, "host_inputs",
+                                    inputTile->data<float16>(),
+                                    inputShape.storageSize() * sizeof(float16));
+                    mapArrayToAccel(
+                            reqCode, "host_weights",
+                            weightsTile->data<float16>(),
+                            weightsShape.storageSize() * sizeof(float16));
                     mapArrayToAccel(
-                            accelId + currAccelIdx, "host_results",
+                            reqCode, "host_results",
                             outputTile->data<float16>(),
                             outputShape.storageSize() * sizeof(float16));
-
-                    // The tiling optimizer will make sure that the weight tiles
-                    // have the same channel dimension as the input tiles (so
-                    // that inputChanTiles = weightChanTiles), except one case
-                    // where the input is not tiled channelwise (inputChanTiles
-                    // = 1) and the weights are independently tiled channelwise.
-                    // In that case, we will need multiple kernel invocations to
-                    // finish the weight channelwise tiles, with the same input
-                    // channel tile, producing results for the same output
-                    // channels.
-                    while (iC < inputChanTiles && wC < weightChanTiles) {
-                        int inputTileIdx = inputIdx(N, H, 0, iC);
-                        int weightTileIdx = weightIdx(W, 0, 0, wC);
-                        dout(1) << "Input: " << inputTileIdx
-                                << ", weights: " << weightTileIdx
-                                << ", output: " << outputTileIdx << "\n";
-                        Tensor* inputTile =
-                                inputs.getTileWithData(inputTileIdx);
-                        Tensor* weightsTile =
-                                weights.getTileWithData(weightTileIdx);
-                        const TensorShape& inputShape = inputTile->getShape();
-                        const TensorShape& weightsShape =
-                                weightsTile->getShape();
-                        mapArrayToAccel(
-                                accelId + currAccelIdx, "host_inputs",
-                                inputTile->data<float16>(),
-                                inputShape.storageSize() * sizeof(float16));
-                        mapArrayToAccel(
-                                accelId + currAccelIdx, "host_weights",
+                    if (useSystolicArrayWhenAvailable) {
+                        // Invoke the systolic array if specified.
+                        accelPool.addEstimatedCycles(
+                                currAccelIdx,
+                                smv::getInvocationCost(
+                                        spads, inputShape, weightsShape,
+                                        outputShape,
+                                        smv::systolic::getComputeCycles(
+                                                weightsShape, outputShape))
+                                        .getCycles());
+                        return invokeSystolicArrayKernel(
+                                reqCode, inputTile->data<float16>(),
                                 weightsTile->data<float16>(),
-                                weightsShape.storageSize() * sizeof(float16));
-                        int inputDims[4] = { inputShape[0], inputShape[1],
-                                             inputShape[2], inputShape[3] };
-                        int weightsDims[4] = { weightsShape[0], weightsShape[1],
-                                               weightsShape[2],
-                                               weightsShape[3] };
-                        int outputDims[4] = { outputShape[0], outputShape[1],
-                                              outputShape[2], outputShape[3] };
-                        // The 'ifmap_start' argument of the kernel is for
-                        // handling when inputChanTiles < weightChanTiles. It
-                        // provides the starting channel of the input tile that
-                        // will be effective for computation in the invocation.
-                        int ifmapStart = (iC == wC) ? 0 : ifmapOffset;
-                        // Since multiple weight channelwise tiles produce the
-                        // same output channels, 'accumulate' is set to true to
-                        // avoid resetting the result for non-first (wC > 0)
-                        // weight channelwise tiles.
-                        bool accumulate = wC > 0;
-                        // If this is a new input/weight tile, then we need to
-                        // read it.
-                        bool readInputs = false;
-                        if (inputTileIdx !=
-                            lastReadInputTileIdx[currAccelIdx]) {
-                            readInputs = true;
-                            lastReadInputTileIdx[currAccelIdx] = inputTileIdx;
-                        }
-                        bool readWeights = false;
-                        if (weightTileIdx !=
-                            lastReadWeightTileIdx[currAccelIdx]) {
-                            readWeights = true;
-                            lastReadWeightTileIdx[currAccelIdx] = weightTileIdx;
-                        }
-                        // If we reach the last invocation for the weight
-                        // channelwise tiles, the results are finished and need
-                        // to be sent back to the host.
-                        bool sendResults = wC == weightChanTiles - 1;
-
-                        std::unique_ptr<volatile int> finishFlag;
-                        if (useSystolicArrayWhenAvailable) {
-                            // Invoke the systolic array if specified.
-                            finishFlag = invokeSystolicArrayKernel(
-                                    accelId + currAccelIdx,
-                                    inputTile->data<float16>(),
-                                    weightsTile->data<float16>(),
-                                    outputTile->data<float16>(), inputDims,
-                                    weightsDims, outputDims,
-                                    inputShape.getPadding(3),
-                                    weightsShape.getPadding(3),
-                                    outputShape.getPadding(3), inputHaloPad,
-                                    getRowStride(), ifmapStart, kernStart,
-                                    accumulate, readInputs, readWeights,
-                                    sendResults, &actInfo);
-                        } else {
-                            // Otherwise invoke the DLA-like kernel.
-                            finishFlag = invokeKernelNoBlock(
-                                    currAccelIdx, accelId + currAccelIdx,
-                                    smv_conv3d_nhwc_vec_fxp,
-                                    inputTile->data<float16>(),
-                                    weightsTile->data<float16>(),
-                                    outputTile->data<float16>(), smv::spad0,
-                                    smv::spad1, smv::spad2, inputDims,
-                                    weightsDims, outputDims,
-                                    inputShape.getPadding(3),
-                                    weightsShape.getPadding(3),
-                                    outputShape.getPadding(3), inputHaloPad,
-                                    getRowStride(), getColStride(), ifmapStart,
-                                    kernStart, accumulate, readInputs,
-                                    readWeights, sendResults, actInfo.function,
-                                    actInfo.params, &sampling);
-                        }
-                        accelPool.addFinishFlag(
-                                currAccelIdx, std::move(finishFlag));
-
-                        ifmapOffset += weightsTile->getShape()[3];
-                        if (inputChanTiles == weightChanTiles) {
-                            iC++;
-                            wC++;
-                        } else if (inputChanTiles == 1) {
-                            wC++;
-                        } else {
-                            assert(false &&
-                                   "The input/weight tiles can have different "
-                                   "number of channels only when the inputs "
-                                   "don't need channelwise tiling.");
-                        }
+                                outputTile->data<float16>(), inputDims,
+                                weightsDims, outputDims,
+                                inputShape.getPadding(3),
+                                weightsShape.getPadding(3),
+                                outputShape.getPadding(3), inputHaloPad,
+                                getRowStride(), ifmapStart, kernStart,
+                                accumulate, spads.readInputs,
+                                spads.readWeights, spads.sendResults,
+                                &actInfo);
                     }
-                    if (needOutputIteration)
-                        kernStart += outputShape[3];
+                    // Otherwise invoke the DLA-like kernel.
+                    accelPool.addEstimatedCycles(
+                            currAccelIdx,
+                            smv::getInvocationCost(
+                                    spads, inputShape, weightsShape,
+                                    outputShape,
+                                    smv::conv::getComputeCycles(
+                                            weightsShape, outputShape))
+                                    .getCycles());
+                    mapDoubleBufferArrays(reqCode, spads, "host_next_inputs",
+                                          "host_next_weights");
+                    return invokeKernelNoBlock(
+                            firstAccelIdx + currAccelIdx, reqCode,
+                            smv_conv3d_nhwc_vec_fxp,
+                            inputTile->data<float16>(),
+                            weightsTile->data<float16>(),
+                            outputTile->data<float16>(), spads.inputs,
+                            spads.weights, spads.results, inputDims,
+                            weightsDims, outputDims, inputShape.getPadding(3),
+                            weightsShape.getPadding(3),
+                            outputShape.getPadding(3), inputHaloPad,
+                            getRowStride(), getColStride(), ifmapStart,
+                            kernStart, accumulate, spads.readInputs,
+                            spads.readWeights, finishResults,
+                            spads.sendResults, actInfo.function,
+                            actInfo.params, spads.hostNextInputs,
+                            spads.hostNextWeights, spads.hostLastResults,
+                            spads.nextInputs, spads.nextWeights,
+                            spads.lastResults, spads.transferSizes,
+                            &sampling);
+                };
+                if (doubleBuffered) {
+                    doubleBuffer.submit(currAccelIdx,
+                                        { inputTileIdx, inputTile },
+                                        { weightTileIdx, weightsTile },
+                                        { outputTileIdx, outputTile },
+                                        sendResults,
+                                        launch);
+                } else {
+                    SpadAssignment spads(inputsSpad, smv::spad1, resultsSpad,
+                                         readInputs, readWeights, sendResults);
+                    accelPool.addFinishFlag(currAccelIdx, launch(spads));
                 }
-                currAccelIdx =
-                        accelPool.getNextAvailableAccelerator(currAccelIdx);
+
+                ifmapOffset += weightsTile->getShape()[3];
             }
+            if (needOutputIteration)
+                kernStart += outputShape[3];
         }
     }
     // Before we leave, make sure all the accelerators have finished.
+    if (doubleBuffered)
+        doubleBuffer.flush();
     accelPool.joinAll();
+    setEstimatedCycles(accelPool.getEstimatedCycles());
+}
+
+void SmvConvolutionOp::forEachTileInvocation(
+        smv::TileLoopOrder order,
+        TiledTensor& inputs,
+        TiledTensor& weights,
+        TiledTensor& outputs,
+        const std::function<void(int, int, int, int)>& visit) {
+    // This follows runNHWC() without running the kernels.
+    int outputRowTiles = outputs.getShape()[1];
+    int inputChanTiles = inputs.getShape()[3];
+    int weightOfmapTiles = weights.getShape()[0];
+    int weightChanTiles = weights.getShape()[3];
+    int outputChanTiles = outputs.getShape()[3];
+    int numOutputInvocations =
+            weightOfmapTiles < outputChanTiles ? outputChanTiles : 1;
+    auto inputIdx = inputs.startIndex();
+    auto weightIdx = weights.startIndex();
+    auto outputIdx = outputs.startIndex();
+    int numAccels = getNumAccelerators();
+    // The work units go to the accelerators through a pool with the same
+    // dispatch policy and work costs as in runNHWC(). No accelerator is ever
+    // busy here, so the polling policy hands out the work in turn, as it
+    // does outside of simulation.
+    SmvAcceleratorPool accelPool(numAccels);
+    std::vector<int> lastReadInputTileIdx(numAccels, -1);
+    std::vector<int> lastReadWeightTileIdx(numAccels, -1);
+    accelPool.setLastReadWeightTiles(&lastReadWeightTileIdx);
+    if (getFusedProducer() != nullptr)
+        lastReadInputTileIdx[0] = 0;
+    std::vector<std::pair<int, int>> chanSteps =
+            smv::getChannelSteps(inputChanTiles, weightChanTiles);
+    for (const auto& unit : smv::getWorkUnitOrder(
+                 order, inputs.getShape()[0] * outputRowTiles,
+                 weightOfmapTiles)) {
+        int N = unit.first / outputRowTiles;
+        int H = unit.first % outputRowTiles;
+        int W = unit.second;
+        int currAccelIdx = accelPool.getNextAvailableAccelerator(
+                getAcceleratorWork(weights, outputs, N, H, W));
+        int spadOwner = getSpadOwner(currAccelIdx);
+        for (int oC = 0; oC < numOutputInvocations; oC++) {
+            std::vector<std::pair<int, int>> steps = chanSteps;
+            if (inputChanTiles == weightChanTiles &&
+                smv::reverseChannelSteps(
+                        { inputIdx(N, H, 0, steps.front().first),
+                          weightIdx(W, 0, 0, steps.front().second) },
+                        { inputIdx(N, H, 0, steps.back().first),
+                          weightIdx(W, 0, 0, steps.back().second) },
+                        { lastReadInputTileIdx[spadOwner],
+                          lastReadWeightTileIdx[spadOwner] })) {
+                std::reverse(steps.begin(), steps.end());
+            }
+            for (const auto& step : steps) {
+                int inputTileIdx = inputIdx(N, H, 0, step.first);
+                int weightTileIdx = weightIdx(W, 0, 0, step.second);
+                visit(currAccelIdx, inputTileIdx, weightTileIdx,
+                      outputIdx(N, H, 0, W + oC));
+                lastReadInputTileIdx[spadOwner] = inputTileIdx;
+                lastReadWeightTileIdx[spadOwner] = weightTileIdx;
+            }
+        }
+    }
+}
+
+AcceleratorWork SmvConvolutionOp::getAcceleratorWork(TiledTensor& weights,
+                                                     TiledTensor& outputs,
+                                                     int N,
+                                                     int H,
+                                                     int W) {
+    auto weightIdx = weights.startIndex();
+    auto outputIdx = outputs.startIndex();
+    int numOutputInvocations = weights.getShape()[0] < outputs.getShape()[3]
+                                       ? outputs.getShape()[3]
+                                       : 1;
+    // Every output element takes the same number of MACs, so the output
+    // tiles this accelerator will produce give the cost.
+    AcceleratorWork work;
+    work.cost = 0;
+    for (int oC = 0; oC < numOutputInvocations; oC++)
+        work.cost += outputs[outputIdx(N, H, 0, W + oC)]->getShape().size();
+    work.weightTileIdx = weightIdx(W, 0, 0, 0);
+    return work;
+}
+
+uint64_t SmvConvolutionOp::estimateTileLoadBytes(smv::TileLoopOrder order,
+                                                 TiledTensor& inputs,
+                                                 TiledTensor& weights,
+                                                 TiledTensor& outputs) {
+    // A tile that the accelerator still holds from its previous invocation
+    // is not loaded again.
+    int numAccels = getNumAccelerators();
+    std::vector<int> lastReadInputTileIdx(numAccels, -1);
+    std::vector<int> lastReadWeightTileIdx(numAccels, -1);
+    if (getFusedProducer() != nullptr)
+        lastReadInputTileIdx[0] = 0;
+    uint64_t bytes = 0;
+    forEachTileInvocation(
+            order, inputs, weights, outputs,
+            [&](int accelIdx, int inputTileIdx, int weightTileIdx, int) {
+                int spadOwner = getSpadOwner(accelIdx);
+                if (inputTileIdx != lastReadInputTileIdx[spadOwner]) {
+                    bytes += inputs[inputTileIdx]->getShape().storageSize() *
+                             sizeof(float16);
+                    lastReadInputTileIdx[spadOwner] = inputTileIdx;
+                }
+                if (weightTileIdx != lastReadWeightTileIdx[spadOwner]) {
+                    bytes += weights[weightTileIdx]->getShape().storageSize() *
+                             sizeof(float16);
+                    lastReadWeightTileIdx[spadOwner] = weightTileIdx;
+                }
+            });
+    return bytes;
+}
+
+smv::TileLoopOrder SmvConvolutionOp::chooseTileLoopOrder(TiledTensor& inputs,
+                                                         TiledTensor& weights,
+                                                         TiledTensor& outputs) {
+    uint64_t inputStationaryBytes = estimateTileLoadBytes(
+            smv::InputStationary, inputs, weights, outputs);
+    uint64_t weightStationaryBytes = estimateTileLoadBytes(
+            smv::WeightStationary, inputs, weights, outputs);
+    dout(1) << "Estimated tile loads: " << inputStationaryBytes
+            << " bytes input stationary, " << weightStationaryBytes
+            << " bytes weight stationary.\n";
+    // Ties keep the input stationary order, which is the plain N -> H -> W
+    // order apart from the serpentine W.
+    return weightStationaryBytes < inputStationaryBytes ? smv::WeightStationary
+                                                        : smv::InputStationary;
 }
 
 std::unique_ptr<volatile int> SmvConvolutionOp::invokeSystolicArrayKernel(
@@ -262,8 +459,6 @@ std::unique_ptr<volatile int> SmvConvolutionOp::invokeSystolicArrayKernel(
         ActivationInfo* actInfo) {
     // Note that if we are in trace mode, we should skip this gem5 accelerator.
 #ifndef TRACE_MODE
-    assert(runningInSimulation && "The systolic array must be invoked in "
-                                  "simuation.");
     systolic_array_params_t params;
     params.input_base_addr = inputs;
     params.weight_base_addr = weights;
@@ -286,6 +481,11 @@ std::unique_ptr<volatile int> SmvConvolutionOp::invokeSystolicArrayKernel(
     // activation type/params structures.
     memcpy(&params.act_type, &(actInfo->function), sizeof(activation_type));
     memcpy(&params.act_params, &(actInfo->params), sizeof(activation_param_t));
+    if (!runningInSimulation) {
+        // Outside of simulation, the functional model computes the results.
+        systolicArrayModel.run(accelId, params);
+        return nullptr;
+    }
     return std::unique_ptr<volatile int>(
             invokeSystolicArrayAndReturn(accelId, params));
 #else
@@ -296,16 +496,40 @@ std::unique_ptr<volatile int> SmvConvolutionOp::invokeSystolicArrayKernel(
 void SmvConvolutionOp::tile() {
     // This function will tile (if necessary) the input/weight/output tensors
     // of the convolution operator into smaller tensor tiles so that each tile
-    // can fit in the corresponding scratchpad of the accelerator.
-    // TODO: A lot of networks have back to back convolutional layers, it would
-    // be much more efficient not to retile in between them. That can be
-    // achieved by directly sending the output tiles to the next convolutional
-    // layer instead of merging them into a single output tensor first. It's
-    // sort of operator fusing that two back-to-back convolution operators are
-    // tiled only once.
+    // can fit in the corresponding scratchpad of the accelerator. If the
+    // output fits in a single tile, it can be forwarded on-chip to the next
+    // operator (see Scheduler::fuseOperators()).
     tiledTensors = smaug::smv::conv::TilingOptimizer::doTiling(this);
 }
 
+std::vector<std::vector<int>> SmvConvolutionOp::getTileInvocations() {
+    smv::TileLoopOrder order = tileLoopOrder;
+    if (order == smv::AutoTileLoopOrder) {
+        order = chooseTileLoopOrder(
+                tiledTensors[0], tiledTensors[1], tiledTensors[2]);
+    }
+    std::vector<std::vector<int>> invocations;
+    forEachTileInvocation(
+            order, tiledTensors[0], tiledTensors[1], tiledTensors[2],
+            [&](int, int inputTileIdx, int weightTileIdx, int outputTileIdx) {
+                invocations.push_back(
+                        { inputTileIdx, weightTileIdx, outputTileIdx });
+            });
+    return invocations;
+}
+
+bool SmvConvolutionOp::canForwardOutputOnChip() const {
+    // The output must be finished in the results spad of a single accelerator
+    // in one piece. The systolic array has its own spads.
+    return !useSystolicArrayWhenAvailable && getNumAccelerators() == 1 &&
+           tiledTensors[2].size() == 1;
+}
+
+bool SmvConvolutionOp::canReadInputOnChip(TensorBase* input) const {
+    return !useSystolicArrayWhenAvailable && getNumAccelerators() == 1 &&
+           input == inputs.at(Inputs) && tiledTensors[0].size() == 1;
+}
+
 void SmvConvolutionOp::run() {
     auto input = getInput(Inputs);
     auto kernels = getInput(Kernels);
@@ -1,9 +1,15 @@
 #ifndef _OPERATORS_SMV_SMV_CONVOLUTION_OP_H_
 #define _OPERATORS_SMV_SMV_CONVOLUTION_OP_H_
 
+#include <functional>
+
 #include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
 #include "smaug/operators/common.h"
 #include "smaug/operators/convolution_op.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
+#include "smaug/operators/smv/smv_systolic_array_model.h"
+#include "smaug/operators/smv/smv_tiling_common.h"
 
 namespace smaug {
 
@@ -29,8 +35,31 @@ class SmvConvolutionOp : public ConvolutionOp<SmvBackend> {
     using ConvolutionOp<SmvBackend>::ConvolutionOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
+    std::vector<std::vector<int>> getTileInvocations() override;
+    bool canForwardOutputOnChip() const override;
+    bool canReadInputOnChip(TensorBase* input) const override;
     friend class smv::conv::TilingOptimizer;
 
+    /**
+     * Sets the order of the independent work units. By default, the order is
+     * picked per layer to load the fewest input and weight bytes.
+     */
+    void setTileLoopOrder(smv::TileLoopOrder order) { tileLoopOrder = order; }
+
+    /**
+     * Returns true if the kernels double-buffer the scratchpads, so the tiles
+     * may only take half a scratchpad. Fused operators hand their data over
+     * in whole scratchpads, so they don't.
+     */
+    bool isDoubleBuffered() const {
+        return doubleBufferSpadsWhenPossible &&
+               !useSystolicArrayWhenAvailable && !getFusedProducer() &&
+               !getFusedConsumer();
+    }
+
   protected:
    /**
     * Tiling scheduler for this operator.
@@ -38,7 +67,51 @@ class SmvConvolutionOp : public ConvolutionOp<SmvBackend> {
    void runNHWC(TiledTensor& inputs,
                 TiledTensor& weights,
                 TiledTensor& outputs);
-   std::unique_ptr<volatile int> invokeSystolicArrayKernel(
+   /**
+    * Returns the index of the scratchpads the given accelerator computes on.
+    * Outside of simulation, the DLA kernels of all the accelerators run on
+    * the same scratchpads, whereas the systolic array model keeps its own
+    * ones for every accelerator.
+    */
+   int getSpadOwner(int accelIdx) const {
+       return runningInSimulation || useSystolicArrayWhenAvailable ? accelIdx
+                                                                   : 0;
+   }
+   /**
+    * Returns the work of the accelerator that computes the output tiles of
+    * the given batch-wise, rowwise and weight N-wise tile.
+    */
+   AcceleratorWork getAcceleratorWork(TiledTensor& weights,
+                                      TiledTensor& outputs,
+                                      int N,
+                                      int H,
+                                      int W);
+   /**
+    * Calls the given function with the accelerator and the input, weight and
+    * output tile indices of every kernel invocation of runNHWC() with the
+    * given loop order, dispatching the work units to the accelerators the
+    * same way.
+    */
+   void forEachTileInvocation(
+           smv::TileLoopOrder order,
+           TiledTensor& inputs,
+           TiledTensor& weights,
+           TiledTensor& outputs,
+           const std::function<void(int, int, int, int)>& visit);
+   /**
+    * Estimates the bytes of input and weight tiles that runNHWC() loads into
+    * the scratchpads with the given loop order. A tile that an accelerator
+    * still holds from its previous invocation is not loaded again.
+    */
+   uint64_t estimateTileLoadBytes(smv::TileLoopOrder order,
+                                  TiledTensor& inputs,
+                                  TiledTensor& weights,
+                                  TiledTensor& outputs);
+   /** Returns the loop order with the fewest estimated bytes loaded. */
+   smv::TileLoopOrder chooseTileLoopOrder(TiledTensor& inputs,
+                                          TiledTensor& weights,
+                                          TiledTensor& outputs);
+   virtual std::unique_ptr<volatile int> invokeSystolicArrayKernel(
            unsigned accelId,
            float16* inputs,
            float16* weights,
@@ -60,6 +133,9 @@ class SmvConvolutionOp : public ConvolutionOp<SmvBackend> {
            ActivationInfo* actInfo);
 
    std::array<TiledTensor, 3> tiledTensors;
+   smv::TileLoopOrder tileLoopOrder = smv::AutoTileLoopOrder;
+   /** Runs the systolic array invocations outside of simulation. */
+   SmvSystolicArrayModel systolicArrayModel;
 };
 
 }  // namespace smaug
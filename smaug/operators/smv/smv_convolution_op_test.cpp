@@ -5,6 +5,7 @@
 #include "smaug/operators/smv/smv_test_common.h"
 #include "smaug/operators/smv/smv_convolution_op.h"
 #include "smaug/operators/smv/smv_convolution_tiling.h"
+#include "smaug/utility/thread_pool.h"
 
 using namespace smaug;
 
@@ -40,10 +41,12 @@ class SmvConvolutionOpTest : public SmaugTest {
     void doTest(std::vector<int> inputDims,
                 std::vector<int> kernelDims,
                 PaddingType padding = SamePadding,
-                std::vector<int> strides = { 1, 1 }) {
+                std::vector<int> strides = { 1, 1 },
+                smv::TileLoopOrder order = smv::AutoTileLoopOrder) {
         auto convOp = new SmvConvolutionOp("conv", workspace());
         convOp->setStride(strides[0], strides[1]);
         convOp->setPadding(padding);
+        convOp->setTileLoopOrder(order);
         TensorShape inputShape(inputDims, NHWC, SmvBackend::Alignment);
         Tensor* inputs = new Tensor("input", inputShape);
         inputs->allocateStorage<float16>();
@@ -83,6 +86,52 @@ class SmvConvolutionOpTest : public SmaugTest {
     }
 };
 
+// Records the tiles of every systolic array invocation that runs.
+class RecordingConvolutionOp : public SmvConvolutionOp {
+   public:
+    using SmvConvolutionOp::SmvConvolutionOp;
+
+    std::vector<std::vector<int>> executed;
+
+   protected:
+    std::unique_ptr<volatile int> invokeSystolicArrayKernel(
+            unsigned accelId,
+            float16* inputs,
+            float16* weights,
+            float16* outputs,
+            int inputsDims[4],
+            int weightsDims[4],
+            int outputsDims[4],
+            int inputsPad,
+            int weightsPad,
+            int outputPad,
+            int inputHaloPad[4],
+            int stride,
+            int ifmapStart,
+            int kernStart,
+            bool accumulate,
+            bool readInputs,
+            bool readWeights,
+            bool sendResults,
+            ActivationInfo* actInfo) override {
+        auto findTile = [](TiledTensor& tiledTensor, float16* data) {
+            for (int i = 0; i < tiledTensor.size(); i++) {
+                if (tiledTensor[i]->data<float16>() == data)
+                    return i;
+            }
+            return -1;
+        };
+        executed.push_back({ findTile(tiledTensors[0], inputs),
+                             findTile(tiledTensors[1], weights),
+                             findTile(tiledTensors[2], outputs) });
+        return SmvConvolutionOp::invokeSystolicArrayKernel(
+                accelId, inputs, weights, outputs, inputsDims, weightsDims,
+                outputsDims, inputsPad, weightsPad, outputPad, inputHaloPad,
+                stride, ifmapStart, kernStart, accumulate, readInputs,
+                readWeights, sendResults, actInfo);
+    }
+};
+
 }  // namespace smaug
 
 TEST_CASE_METHOD(SmvConvolutionOpTest,
@@ -340,3 +389,137 @@ TEST_CASE_METHOD(SmvConvolutionOpTest, "Stride size tests", "[smvconv]") {
         }
     }
 }
+
+TEST_CASE_METHOD(SmvConvolutionOpTest, "Tile loop orders", "[smvconv]") {
+    // Both the rows and the weights are tiled, and the channelwise steps can
+    // go either way.
+    std::vector<int> inputDims = { 1, 64, 64, 192 };
+    std::vector<int> kernelDims = { 64, 2, 2, 192 };
+    SECTION("Input stationary") {
+        doTest(inputDims, kernelDims, SamePadding, { 1, 1 },
+               smv::InputStationary);
+    }
+    SECTION("Weight stationary") {
+        doTest(inputDims, kernelDims, SamePadding, { 1, 1 },
+               smv::WeightStationary);
+    }
+}
+
+TEST_CASE_METHOD(SmvConvolutionOpTest,
+                 "Systolic array functional model",
+                 "[smvconv]") {
+    useSystolicArrayWhenAvailable = true;
+    SECTION("No tiling required") {
+        doTest({ 1, 8, 8, 8 }, { 8, 3, 3, 8 });
+        doTest({ 1, 8, 8, 8 }, { 8, 3, 3, 8 }, ValidPadding);
+    }
+    SECTION("Strided") {
+        doTest({ 1, 16, 16, 8 }, { 8, 3, 3, 8 }, ValidPadding, { 2, 2 });
+    }
+    SECTION("Fused activation") {
+        doFusionTest({ 1, 8, 8, 8 }, { 8, 3, 3, 8 });
+    }
+    SECTION("DimNH tiled inputs, DimN tiled weights") {
+        doTest({ 1, 32, 32, 32 }, { 128, 4, 4, 32 });
+    }
+    SECTION("Weight channelwise tiles accumulate") {
+        doTest({ 1, 8, 8, 256 }, { 8, 3, 3, 256 });
+        doTest({ 1, 32, 32, 192 }, { 32, 4, 4, 192 });
+    }
+    SECTION("Outputs DimNC tiled") {
+        doTest({ 1, 32, 32, 8 }, { 128, 2, 2, 8 });
+    }
+    SECTION("Multiple accelerators") {
+        numAcceleratorsAvailable = 3;
+        doTest({ 1, 32, 32, 32 }, { 128, 4, 4, 32 });
+    }
+    SECTION("Thread pool") {
+        threadPool = new ThreadPool(3);
+        threadPool->initThreadPool();
+        fastForwardMode = false;
+        doTest({ 1, 32, 32, 32 }, { 128, 4, 4, 32 });
+        fastForwardMode = true;
+        delete threadPool;
+        threadPool = nullptr;
+    }
+}
+
+TEST_CASE_METHOD(SmvConvolutionOpTest,
+                 "Multiple accelerators",
+                 "[smvconv]") {
+    // Outside of simulation, the accelerators share the scratchpads, so a
+    // tile one of them read may have been overwritten by another.
+    numAcceleratorsAvailable = 3;
+    SECTION("DimNH tiled inputs, DimN tiled weights") {
+        doTest({ 1, 32, 32, 32 }, { 128, 4, 4, 32 });
+    }
+    SECTION("Weight channelwise tiles accumulate") {
+        doTest({ 1, 32, 32, 192 }, { 32, 4, 4, 192 });
+    }
+    SECTION("Input stationary") {
+        doTest({ 1, 64, 64, 192 }, { 64, 2, 2, 192 }, SamePadding, { 1, 1 },
+               smv::InputStationary);
+    }
+    SECTION("Weight stationary") {
+        doTest({ 1, 64, 64, 192 }, { 64, 2, 2, 192 }, SamePadding, { 1, 1 },
+               smv::WeightStationary);
+    }
+}
+
+TEST_CASE_METHOD(SmvConvolutionOpTest,
+                 "Double-buffered scratchpads",
+                 "[smvconv]") {
+    doubleBufferSpadsWhenPossible = true;
+    SECTION("No tiling required") {
+        doTest({ 1, 8, 8, 8 }, { 8, 3, 3, 8 });
+    }
+    SECTION("DimNH tiled inputs, DimN tiled weights") {
+        doTest({ 1, 32, 32, 32 }, { 128, 4, 4, 32 });
+    }
+    SECTION("Weight channelwise tiles accumulate into the same half") {
+        doTest({ 1, 64, 64, 192 }, { 32, 2, 2, 192 });
+    }
+    SECTION("Multiple accelerators") {
+        numAcceleratorsAvailable = 3;
+        doTest({ 1, 32, 32, 32 }, { 128, 4, 4, 32 });
+    }
+}
+
+TEST_CASE("Serpentine work unit order", "[smvconv]") {
+    using Units = std::vector<std::pair<int, int>>;
+    REQUIRE(smv::getWorkUnitOrder(smv::InputStationary, 2, 3) ==
+            Units({ { 0, 0 }, { 0, 1 }, { 0, 2 }, { 1, 2 }, { 1, 1 },
+                    { 1, 0 } }));
+    REQUIRE(smv::getWorkUnitOrder(smv::WeightStationary, 2, 3) ==
+            Units({ { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { 0, 2 },
+                    { 1, 2 } }));
+}
+
+TEST_CASE_METHOD(SmvConvolutionOpTest,
+                 "Tile invocations follow the dispatch policy",
+                 "[smvconv]") {
+    // Each systolic array has its own scratchpads, so the accelerator that
+    // gets a work unit decides which tiles it still holds.
+    useSystolicArrayWhenAvailable = true;
+    numAcceleratorsAvailable = 3;
+    // The weight tiles have 56 and 24 kernels, so the work units are uneven.
+    auto convOp = new RecordingConvolutionOp("conv", workspace());
+    convOp->setStride(1, 1);
+    convOp->setPadding(SamePadding);
+    TensorShape inputShape({ 1, 32, 32, 192 }, NHWC, SmvBackend::Alignment);
+    Tensor* inputs = new Tensor("input", inputShape);
+    inputs->allocateStorage<float16>();
+    workspace()->addTensor(inputs);
+    convOp->setInput(inputs, 0);
+    convOp->setWeightDims(3, 3, 80);
+    createAndFillTensorsWithData<float16>(convOp, fillTensorWithRandomData);
+    convOp->tile();
+    std::vector<std::vector<int>> roundRobin = convOp->getTileInvocations();
+
+    accelDispatchPolicy = LeastWorkDispatch;
+    std::vector<std::vector<int>> leastWork = convOp->getTileInvocations();
+    REQUIRE(leastWork != roundRobin);
+    convOp->run();
+    REQUIRE(convOp->executed == leastWork);
+    verifyOutputs<float16>(convOp->getOutput(0), getReferenceOutput(convOp));
+}
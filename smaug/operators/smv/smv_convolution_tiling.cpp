@@ -59,6 +59,8 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
     Tensor* weights = op->getInput(op->Kernels);
     Tensor* outputs = op->getOutput(op->Outputs);
     int maxTileSize = SmvBackend::SpadSize() / inputs->getDataTypeSize();
+    if (op->isDoubleBuffered())
+        maxTileSize /= 2;
     std::array<TilingDims, 3> strategies =
             determineBestTilingDims(inputs, weights, outputs, maxTileSize);
     TilingDims inputTilingDims = strategies[0];
@@ -228,6 +230,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
                 break;
         }
     }
+    tilingSearchStats.configs += fullConfigs.size();
     dout(2) << "  Number of possible tiling configs: " << fullConfigs.size()
             << "\n";
     for (auto& config : fullConfigs)
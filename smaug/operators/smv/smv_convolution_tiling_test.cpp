@@ -45,6 +45,24 @@ TEST_CASE_METHOD(SmaugTest, "Basic tiling tests", "[smvtiling]") {
         REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 32, 32, 8 });
     }
 
+    SECTION("No tiling needed with larger scratchpads") {
+        SmvBackend::freeGlobals();
+        SmvBackend::initGlobals(64 * 1024, 4);
+        REQUIRE(SmvBackend::NumSpads() == 4);
+        TensorShape inputShape(
+                { 1, 32, 64, 16 }, DataLayout::NHWC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("inputs", inputShape);
+        workspace()->addTensor(inputs);
+        convOp->setInput(inputs, 0);
+        convOp->setWeightDims(3, 3, 8);
+        convOp->createAllTensors();
+        allocateAllTensors<float16>(convOp);
+        TilingConfig config = TilingOptimizer::computeBasicTileShapes(convOp);
+        REQUIRE(config.inputs == inputShape);
+        REQUIRE(config.weights.dims() == std::vector<int>{ 8, 3, 3, 16 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 32, 64, 8 });
+    }
+
     SECTION("DimNH tiling on inputs when less than 32 channels") {
         TensorShape inputShape(
                 { 1, 32, 64, 16 }, DataLayout::NHWC, SmvBackend::Alignment);
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cmath>
+
+#include "smaug/operators/common.h"
+#include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_cycle_model.h"
+#include "smaug/operators/smv/smv_depthwise_convolution_op.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+
+namespace smaug {
+namespace smv {
+
+double dmaBytesPerCycle = kDefaultDmaBytesPerCycle;
+
+uint64_t InvocationCost::getCycles() const {
+    return getDmaCycles(loadBytes) +
+           std::max(computeCycles, getDmaCycles(overlappedBytes)) +
+           getDmaCycles(storeBytes);
+}
+
+uint64_t getDmaCycles(uint64_t bytes) {
+    return std::ceil(bytes / dmaBytesPerCycle);
+}
+
+uint64_t getTileBytes(const TensorShape& shape) {
+    return shape.storageSize() * sizeof(float16);
+}
+
+InvocationCost getInvocationCost(const SpadAssignment& spads,
+                                 const TensorShape& inputs,
+                                 const TensorShape& weights,
+                                 const TensorShape& outputs,
+                                 uint64_t computeCycles) {
+    InvocationCost cost;
+    cost.computeCycles = computeCycles;
+    if (spads.readInputs)
+        cost.loadBytes += getTileBytes(inputs);
+    if (spads.readWeights)
+        cost.loadBytes += getTileBytes(weights);
+    if (spads.sendResults)
+        cost.storeBytes += getTileBytes(outputs);
+    for (int size : spads.transferSizes)
+        cost.overlappedBytes += size * sizeof(float16);
+    return cost;
+}
+
+namespace conv {
+
+uint64_t getComputeCycles(const TensorShape& weights,
+                          const TensorShape& outputs) {
+    // The weight tile may hold more kernels than the output tile has
+    // channels, in which case only some of them are used.
+    int numEffKernels = std::min(weights[0], outputs[3]);
+    uint64_t numPixels = (uint64_t)outputs[0] * outputs[1] * outputs[2];
+    return numPixels * FRAC_CEIL(numEffKernels, kNumPEs) * weights[1] *
+           weights[2] * FRAC_CEIL(weights[3], kNumMaccsPerPE);
+}
+
+}  // namespace conv
+
+namespace fc {
+
+uint64_t getComputeCycles(const TensorShape& inputs,
+                          const TensorShape& weights) {
+    return (uint64_t)inputs[0] * FRAC_CEIL(weights[0], kNumPEs) *
+           FRAC_CEIL(weights[1], kNumMaccsPerPE);
+}
+
+}  // namespace fc
+
+namespace dwconv {
+
+uint64_t getComputeCycles(const TensorShape& weights,
+                          const TensorShape& outputs) {
+    uint64_t numPixels = (uint64_t)outputs[0] * outputs[1] * outputs[2];
+    return numPixels * FRAC_CEIL(outputs[3], kVectorSize) * weights[1] *
+           weights[2];
+}
+
+}  // namespace dwconv
+
+namespace systolic {
+
+uint64_t getComputeCycles(const TensorShape& weights,
+                          const TensorShape& outputs) {
+    int numEffKernels = std::min(weights[0], outputs[3]);
+    uint64_t numPixels = (uint64_t)outputs[0] * outputs[1] * outputs[2];
+    uint64_t numFolds = (uint64_t)weights[1] * weights[2] *
+                        FRAC_CEIL(weights[3], kPeArrayRows) *
+                        FRAC_CEIL(numEffKernels, kPeArrayCols);
+    return numFolds * (numPixels + kPeArrayRows + kPeArrayCols);
+}
+
+}  // namespace systolic
+
+}  // namespace smv
+}  // namespace smaug
@@ -0,0 +1,120 @@
+#ifndef _OPERATORS_SMV_SMV_CYCLE_MODEL_H_
+#define _OPERATORS_SMV_SMV_CYCLE_MODEL_H_
+
+#include <cstdint>
+
+#include "smaug/core/tensor.h"
+#include "smaug/operators/smv/smv_double_buffer.h"
+
+namespace smaug {
+namespace smv {
+
+/**
+ * The bandwidth of the DMA between host memory and the scratchpads, in bytes
+ * per accelerator cycle, that the cycle model assumes.
+ */
+extern double dmaBytesPerCycle;
+const double kDefaultDmaBytesPerCycle = 16;
+
+/**
+ * Models the latency of one SMV kernel invocation analytically, so that
+ * design points can be compared without simulating them in gem5-Aladdin.
+ *
+ * The kernel first loads its tiles into the scratchpads, then computes, then
+ * stores its results, and each phase waits for the one before. The transfers
+ * of a double-buffered invocation (see SmvDoubleBuffer) have no dependency on
+ * its computation, so they are modeled as overlapped with it.
+ *
+ * This is a first-order model: it ignores the DMA setup latency, contention
+ * between accelerators for the memory bandwidth, and the activation
+ * functions.
+ */
+struct InvocationCost {
+    /** The cycles the datapath is busy, see getComputeCycles(). */
+    uint64_t computeCycles = 0;
+    /** Bytes loaded into the scratchpads before the computation. */
+    uint64_t loadBytes = 0;
+    /** Bytes stored to host memory after the computation. */
+    uint64_t storeBytes = 0;
+    /** Bytes transferred while the datapath computes. */
+    uint64_t overlappedBytes = 0;
+
+    /** Returns the estimated cycles of the invocation. */
+    uint64_t getCycles() const;
+};
+
+/** Returns the cycles the DMA takes to transfer this many bytes. */
+uint64_t getDmaCycles(uint64_t bytes);
+
+/** Returns the bytes of a tile's storage, including its alignment padding. */
+uint64_t getTileBytes(const TensorShape& shape);
+
+/**
+ * Returns the cost of an invocation on these tiles, which loads and stores
+ * them and overlaps its transfers as the scratchpad assignment says.
+ */
+InvocationCost getInvocationCost(const SpadAssignment& spads,
+                                 const TensorShape& inputs,
+                                 const TensorShape& weights,
+                                 const TensorShape& outputs,
+                                 uint64_t computeCycles);
+
+namespace conv {
+
+/**
+ * Returns the compute cycles of smv_conv3d_nhwc_vec_fxp(). Every cycle, each
+ * of the kNumPEs PEs reduces kNumMaccsPerPE channels of one kernel at one
+ * output pixel.
+ */
+uint64_t getComputeCycles(const TensorShape& weights,
+                          const TensorShape& outputs);
+
+}  // namespace conv
+
+namespace fc {
+
+/**
+ * Returns the compute cycles of smv_matrix_multiply_transpose_nc_vec_fxp().
+ * Every cycle, each of the kNumPEs PEs reduces kNumMaccsPerPE activations of
+ * one neuron for one input row.
+ */
+uint64_t getComputeCycles(const TensorShape& inputs,
+                          const TensorShape& weights);
+
+}  // namespace fc
+
+namespace dwconv {
+
+/**
+ * Returns the compute cycles of smv_depthwise_conv2d_nhwc_vec_fxp(). Every
+ * cycle, the datapath multiplies one vector of kVectorSize channels.
+ */
+uint64_t getComputeCycles(const TensorShape& weights,
+                          const TensorShape& outputs);
+
+}  // namespace dwconv
+
+/** Contains the cycle model of the systolic array. */
+namespace systolic {
+
+/**
+ * The geometry of the weight-stationary PE array that the estimates assume:
+ * the rows reduce input channels and the columns produce output channels.
+ */
+const int kPeArrayRows = 8;
+const int kPeArrayCols = 8;
+
+/**
+ * Returns the compute cycles of a systolic array invocation. The array holds
+ * one block of weights of one kernel tap at a time, and streams all the
+ * output pixels through it, plus the cycles to fill and drain the array.
+ */
+uint64_t getComputeCycles(const TensorShape& weights,
+                          const TensorShape& outputs);
+
+}  // namespace systolic
+
+}  // namespace smv
+}  // namespace smaug
+
+#endif
@@ -0,0 +1,95 @@
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
+#include "smaug/operators/smv/smv_cycle_model.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+
+using namespace smaug;
+
+TEST_CASE_METHOD(SmaugTest, "SMV cycle model", "[smvcycles]") {
+    SECTION("Compute cycles") {
+        // 16x16 output pixels, 2 blocks of 8 kernels, 3x3 taps and 2 blocks
+        // of 32 channels.
+        TensorShape convWeights({ 16, 3, 3, 64 }, NHWC);
+        TensorShape convOutputs({ 1, 16, 16, 16 }, NHWC);
+        REQUIRE(smv::conv::getComputeCycles(convWeights, convOutputs) ==
+                16 * 16 * 2 * 9 * 2);
+        // Only the kernels the output tile has channels for are used, and
+        // the partial blocks take whole cycles.
+        TensorShape partialOutputs({ 1, 16, 16, 4 }, NHWC);
+        TensorShape partialWeights({ 16, 1, 1, 40 }, NHWC);
+        REQUIRE(smv::conv::getComputeCycles(partialWeights, partialOutputs) ==
+                16 * 16 * 1 * 1 * 2);
+
+        TensorShape fcInputs({ 2, 256 }, NC);
+        TensorShape fcWeights({ 128, 256 }, NC);
+        REQUIRE(smv::fc::getComputeCycles(fcInputs, fcWeights) == 2 * 16 * 8);
+
+        TensorShape dwWeights({ 1, 3, 3, 32 }, NHWC);
+        TensorShape dwOutputs({ 1, 8, 8, 32 }, NHWC);
+        REQUIRE(smv::dwconv::getComputeCycles(dwWeights, dwOutputs) ==
+                8 * 8 * 4 * 9);
+
+        // 9 taps x 8 channel blocks x 2 kernel blocks, each streaming 16x16
+        // pixels through the 8x8 array.
+        REQUIRE(smv::systolic::getComputeCycles(convWeights, convOutputs) ==
+                9 * 8 * 2 * (16 * 16 + 8 + 8));
+    }
+
+    SECTION("Invocation cycles") {
+        TensorShape shape({ 1, 64 }, NC);
+        SpadAssignment spads(
+                smv::spad0, smv::spad1, smv::spad2, true, false, true);
+        smv::InvocationCost cost =
+                smv::getInvocationCost(spads, shape, shape, shape, 100);
+        REQUIRE(cost.loadBytes == 128);
+        REQUIRE(cost.storeBytes == 128);
+        REQUIRE(cost.getCycles() == 8 + 100 + 8);
+
+        // The double-buffered transfers only count when they take longer
+        // than the computation.
+        spads.transferSizes[0] = 512;
+        spads.transferSizes[2] = 64;
+        cost = smv::getInvocationCost(spads, shape, shape, shape, 100);
+        REQUIRE(cost.overlappedBytes == 1152);
+        REQUIRE(cost.getCycles() == 8 + 100 + 8);
+        cost.computeCycles = 10;
+        REQUIRE(cost.getCycles() == 8 + 72 + 8);
+
+        smv::dmaBytesPerCycle = 32;
+        REQUIRE(cost.getCycles() == 4 + 36 + 4);
+        smv::dmaBytesPerCycle = smv::kDefaultDmaBytesPerCycle;
+    }
+
+    SECTION("Accelerators run in parallel") {
+        SmvAcceleratorPool pool(2);
+        pool.addEstimatedCycles(0, 100);
+        pool.addEstimatedCycles(1, 30);
+        pool.addEstimatedCycles(1, 50);
+        REQUIRE(pool.getEstimatedCycles() == 100);
+        pool.addEstimatedCycles(1, 50);
+        REQUIRE(pool.getEstimatedCycles() == 130);
+    }
+
+    SECTION("Inner product operator") {
+        auto fcOp = new SmvInnerProductOp("fc", workspace());
+        TensorShape inputShape({ 1, 256 }, NC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("input", inputShape);
+        inputs->allocateStorage<float16>();
+        workspace()->addTensor(inputs);
+        fcOp->setInput(inputs, 0);
+        fcOp->setNumOutputs(128);
+        createAndFillTensorsWithData<float16>(fcOp, fillTensorWithRandomData);
+        fcOp->tile();
+        fcOp->run();
+        // One invocation loads the inputs and the weights, computes 16 blocks
+        // of 8 neurons on 8 blocks of 32 activations, and stores the
+        // results.
+        uint64_t loadBytes = (256 + 128 * 256) * sizeof(float16);
+        uint64_t storeBytes = 128 * sizeof(float16);
+        REQUIRE(fcOp->getEstimatedCycles() ==
+                loadBytes / 16 + 16 * 8 + storeBytes / 16);
+    }
+}
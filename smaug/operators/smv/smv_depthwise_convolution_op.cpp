@@ -0,0 +1,201 @@
+#include "smaug/core/backend.h"
+#include "smaug/operators/common.h"
+#include "smaug/operators/smv/smv_depthwise_convolution_op.h"
+#include "smaug/operators/smv/smv_depthwise_convolution_tiling.h"
+#include "smaug/operators/smv/smv_kernels.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
+#include "smaug/operators/smv/smv_cycle_model.h"
+#include "smaug/utility/debug_stream.h"
+
+namespace smaug {
+namespace smv {
+namespace dwconv {
+
+const int kVectorSize = 8;
+
+}  // namespace dwconv
+}  // namespace smv
+
+void SmvDepthwiseConvolutionOp::runNHWC(TiledTensor& inputs,
+                                        TiledTensor& weights,
+                                        TiledTensor& outputs) {
+    int inputIfmapTiles = inputs.getShape()[0];
+    int inputRowTiles = inputs.getShape()[1];
+    int inputChanTiles = inputs.getShape()[3];
+    int weightChanTiles = weights.getShape()[3];
+    int outputRowTiles = outputs.getShape()[1];
+    int outputChanTiles = outputs.getShape()[3];
+    assert(inputChanTiles == weightChanTiles &&
+           inputChanTiles == outputChanTiles &&
+           "Depthwise convolution tiles must have the same channels!");
+    auto inputIdx = inputs.startIndex();
+    auto weightIdx = weights.startIndex();
+    auto outputIdx = outputs.startIndex();
+    std::vector<int> inputPadding = getInputPadding();
+    int topPad = inputPadding[0];
+    int bottomPad = inputPadding[1];
+    int leftPad = inputPadding[2];
+    int rightPad = inputPadding[3];
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = smv::kDepthwiseConvolutionHw + firstAccelIdx;
+    SmvAcceleratorPool accelPool(numAccels);
+    std::vector<int> lastReadWeightTileIdx(numAccels, -1);
+    accelPool.setLastReadWeightTiles(&lastReadWeightTileIdx);
+    for (int i = 0; i < numAccels; i++) {
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_weights", getWeightsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_results", getOutputsMemType());
+    }
+    // There is no reduction across channels, so every (N, H, C) tile is an
+    // independent work unit that produces one output tile. The channelwise
+    // tiles are the outermost loop so that an accelerator can keep the same
+    // weight tile for all the rows and batches of its channels.
+    for (int C = 0; C < inputChanTiles; C++) {
+        int weightTileIdx = weightIdx(0, 0, 0, C);
+        Tensor* weightsTile = weights.getTileWithData(weightTileIdx);
+        const TensorShape& weightsShape = weightsTile->getShape();
+        for (int N = 0; N < inputIfmapTiles; N++) {
+            for (int H = 0; H < outputRowTiles; H++) {
+                int currentTileTopPad = topPad;
+                int currentTileBottomPad = bottomPad;
+                if (inputRowTiles > 1) {
+                    if (H == 0) {
+                        currentTileBottomPad = 0;
+                    } else if (H == inputRowTiles - 1) {
+                        currentTileTopPad = 0;
+                    } else {
+                        currentTileTopPad = 0;
+                        currentTileBottomPad = 0;
+                    }
+                }
+                int inputHaloPad[4] = { currentTileTopPad,
+                                        currentTileBottomPad, leftPad,
+                                        rightPad };
+                int inputTileIdx = inputIdx(N, H, 0, C);
+                int outputTileIdx = outputIdx(N, H, 0, C);
+                Tensor* inputTile = inputs.getTileWithData(inputTileIdx);
+                Tensor* outputTile = outputs[outputTileIdx];
+                const TensorShape& inputShape = inputTile->getShape();
+                const TensorShape& outputShape = outputTile->getShape();
+                AcceleratorWork work;
+                work.cost = outputShape.size();
+                work.weightTileIdx = weightTileIdx;
+                int currAccelIdx = accelPool.getNextAvailableAccelerator(work);
+                dout(1) << "Input: " << inputTileIdx
+                        << ", weights: " << weightTileIdx
+                        << ", output: " << outputTileIdx << "\n";
+                mapArrayToAccel(accelId + currAccelIdx, "host_inputs",
+                                inputTile->data<float16>(),
+                                inputShape.storageSize() * sizeof(float16));
+                mapArrayToAccel(accelId + currAccelIdx, "host_weights",
+                                weightsTile->data<float16>(),
+                                weightsShape.storageSize() * sizeof(float16));
+                mapArrayToAccel(accelId + currAccelIdx, "host_results",
+                                outputTile->data<float16>(),
+                                outputShape.storageSize() * sizeof(float16));
+                int inputDims[4] = { inputShape[0], inputShape[1],
+                                     inputShape[2], inputShape[3] };
+                int weightsDims[4] = { weightsShape[0], weightsShape[1],
+                                       weightsShape[2], weightsShape[3] };
+                int outputDims[4] = { outputShape[0], outputShape[1],
+                                      outputShape[2], outputShape[3] };
+                // Outside of simulation, the kernels of all the accelerators
+                // run on the same scratchpads, so the weights are only still
+                // there if the last kernel of any accelerator read them.
+                int spadOwner = runningInSimulation ? currAccelIdx : 0;
+                bool readWeights = false;
+                if (weightTileIdx != lastReadWeightTileIdx[spadOwner]) {
+                    readWeights = true;
+                    lastReadWeightTileIdx[spadOwner] = weightTileIdx;
+                }
+                SpadAssignment spads(smv::spad0, smv::spad1, smv::spad2,
+                                     true, readWeights, true);
+                accelPool.addEstimatedCycles(
+                        currAccelIdx,
+                        smv::getInvocationCost(spads, inputShape,
+                                               weightsShape, outputShape,
+                                               smv::dwconv::getComputeCycles(
+                                                       weightsShape,
+                                                       outputShape))
+                                .getCycles());
+                std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
+                        firstAccelIdx + currAccelIdx, accelId + currAccelIdx,
+                        smv_depthwise_conv2d_nhwc_vec_fxp,
+                        inputTile->data<float16>(),
+                        weightsTile->data<float16>(),
+                        outputTile->data<float16>(), smv::spad0, smv::spad1,
+                        smv::spad2, inputDims, weightsDims, outputDims,
+                        inputShape.getPadding(3), weightsShape.getPadding(3),
+                        outputShape.getPadding(3), inputHaloPad,
+                        getRowStride(), getColStride(), readWeights,
+                        actInfo.function, actInfo.params);
+                accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
+            }
+        }
+    }
+    // Before we leave, make sure all the accelerators have finished.
+    accelPool.joinAll();
+    setEstimatedCycles(accelPool.getEstimatedCycles());
+}
+
+std::vector<std::vector<int>> SmvDepthwiseConvolutionOp::getTileInvocations() {
+    // This follows runNHWC(): the channelwise tiles are the outermost loop.
+    TiledTensor& inputs = tiledTensors[0];
+    TiledTensor& weights = tiledTensors[1];
+    TiledTensor& outputs = tiledTensors[2];
+    auto inputIdx = inputs.startIndex();
+    auto weightIdx = weights.startIndex();
+    auto outputIdx = outputs.startIndex();
+    std::vector<std::vector<int>> invocations;
+    for (int C = 0; C < inputs.getShape()[3]; C++) {
+        for (int N = 0; N < inputs.getShape()[0]; N++) {
+            for (int H = 0; H < outputs.getShape()[1]; H++) {
+                invocations.push_back({ inputIdx(N, H, 0, C),
+                                        weightIdx(0, 0, 0, C),
+                                        outputIdx(N, H, 0, C) });
+            }
+        }
+    }
+    return invocations;
+}
+
+void SmvDepthwiseConvolutionOp::tile() {
+    // This function will tile (if necessary) the input/weight/output tensors
+    // of the depthwise convolution operator into smaller tensor tiles so that
+    // each tile can fit in the corresponding scratchpad of the accelerator.
+    tiledTensors = smaug::smv::dwconv::TilingOptimizer::doTiling(this);
+}
+
+void SmvDepthwiseConvolutionOp::run() {
+    auto input = getInput(Inputs);
+    auto kernels = getInput(Kernels);
+    auto output = getOutput(Outputs);
+    const TensorShape& inputShape = input->getShape();
+    const TensorShape& kernelShape = kernels->getShape();
+    const TensorShape& outputShape = output->getShape();
+    assert(inputShape.getLayout() == DataLayout::NHWC);
+    assert(kernelShape.getLayout() == DataLayout::NHWC);
+    assert(outputShape.getLayout() == DataLayout::NHWC);
+    dout(2) << *kernels << "\n";
+
+    {
+        auto stats = gem5::ScopedStats(
+                stats::kTensorPrepStart, stats::kTensorPrepEnd);
+        tiledTensors[0].copyDataToAllTiles();
+        tiledTensors[1].copyDataToAllTiles();
+    }
+
+    runNHWC(tiledTensors[0], tiledTensors[1], tiledTensors[2]);
+
+    {
+        auto stats = gem5::ScopedStats(
+                stats::kTensorFinalStart, stats::kTensorFinalEnd);
+        tiledTensors[2].untile();
+    }
+}
+
+}  // namespace smaug
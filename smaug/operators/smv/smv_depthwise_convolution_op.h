@@ -0,0 +1,56 @@
+#ifndef _OPERATORS_SMV_SMV_DEPTHWISE_CONVOLUTION_OP_H_
+#define _OPERATORS_SMV_SMV_DEPTHWISE_CONVOLUTION_OP_H_
+
+#include "smaug/core/backend.h"
+#include "smaug/operators/common.h"
+#include "smaug/operators/depthwise_convolution_op.h"
+
+namespace smaug {
+
+namespace smv {
+/**
+ * Contains depthwise convolution implementations and tiling optimizers for
+ * SMV.
+ */
+namespace dwconv {
+
+extern const int kVectorSize;
+
+class TilingOptimizer;
+
+}  // namespace dwconv
+}  // namespace smv
+
+/**
+ * SMV backend implementation of depthwise convolution.
+ *
+ * Every channel is convolved with its own filter, so the channelwise tiles are
+ * independent work units and the results never need to be accumulated across
+ * tiles.
+ */
+class SmvDepthwiseConvolutionOp
+        : public DepthwiseConvolutionOp<SmvBackend> {
+  public:
+    using DepthwiseConvolutionOp<SmvBackend>::DepthwiseConvolutionOp;
+    void tile() override;
+    void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
+    std::vector<std::vector<int>> getTileInvocations() override;
+    friend class smv::dwconv::TilingOptimizer;
+
+  protected:
+   /**
+    * Tiling scheduler for this operator.
+    */
+   void runNHWC(TiledTensor& inputs,
+                TiledTensor& weights,
+                TiledTensor& outputs);
+
+   std::array<TiledTensor, 3> tiledTensors;
+};
+
+}  // namespace smaug
+
+#endif
@@ -0,0 +1,156 @@
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
+#include "smaug/core/tensor.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/operators/reorder_op_impl.h"
+#include "smaug/operators/smv/smv_test_common.h"
+#include "smaug/operators/smv/smv_depthwise_convolution_op.h"
+#include "smaug/operators/smv/smv_depthwise_convolution_tiling.h"
+
+using namespace smaug;
+using namespace smaug::smv;
+
+namespace smaug {
+
+class SmvDepthwiseConvolutionOpTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    // The reference depthwise convolution only supports NCHW, so the tensors
+    // are reordered around it.
+    Tensor* getReferenceOutput(SmvDepthwiseConvolutionOp* convOp) {
+        auto input32 =
+                convertFp16ToFp32Tensor(convOp->getInput(0), workspace());
+        auto kernels32 =
+                convertFp16ToFp32Tensor(convOp->getInput(1), workspace());
+        auto inputNchw = toNchw(input32);
+        auto kernelsNchw = toNchw(kernels32);
+
+        auto refConvOp = new DepthwiseConvolutionOp<ReferenceBackend>(
+                "ref_dwconv", workspace());
+        refConvOp->setPadding(convOp->getPadding());
+        refConvOp->setWeightDims(
+                convOp->getWeightRows(), convOp->getWeightCols(), 1);
+        refConvOp->setStride(convOp->getRowStride(), convOp->getColStride());
+        refConvOp->setInput(inputNchw, 0);
+        refConvOp->setInput(kernelsNchw, 1);
+        refConvOp->createAllTensors();
+        refConvOp->getOutput(0)->allocateStorage<float>();
+        refConvOp->run();
+
+        Tensor* refOutput = refConvOp->getOutput(0);
+        const TensorShape& shape = refOutput->getShape();
+        Tensor* output32 = new Tensor(
+                "ref_output_nhwc",
+                TensorShape({ shape[0], shape[2], shape[3], shape[1] }, NHWC,
+                            SmvBackend::Alignment));
+        output32->allocateStorage<float>();
+        workspace()->addTensor(output32);
+        convertNchwToNhwc(refOutput, output32);
+        return convertFp32ToFp16Tensor(output32, workspace());
+    }
+
+    void doTest(std::vector<int> inputDims,
+                std::vector<int> kernelDims,
+                PaddingType padding = SamePadding,
+                std::vector<int> strides = { 1, 1 }) {
+        auto convOp = new SmvDepthwiseConvolutionOp("dwconv", workspace());
+        convOp->setStride(strides[0], strides[1]);
+        convOp->setPadding(padding);
+        TensorShape inputShape(inputDims, NHWC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("input", inputShape);
+        inputs->allocateStorage<float16>();
+        workspace()->addTensor(inputs);
+        convOp->setInput(inputs, 0);
+        convOp->setWeightDims(kernelDims[0], kernelDims[1], 1);
+        createAndFillTensorsWithData<float16>(convOp, fillTensorWithRandomData);
+        convOp->tile();
+        convOp->run();
+        auto outputs = convOp->getOutput(0);
+        auto refOutputs = getReferenceOutput(convOp);
+        verifyOutputs<float16>(outputs, refOutputs);
+    }
+
+   protected:
+    Tensor* toNchw(Tensor* tensor) {
+        const TensorShape& shape = tensor->getShape();
+        Tensor* nchw = new Tensor(
+                tensor->getName() + "_nchw",
+                TensorShape({ shape[0], shape[3], shape[1], shape[2] }, NCHW));
+        nchw->allocateStorage<float>();
+        workspace()->addTensor(nchw);
+        convertNhwcToNchw(tensor, nchw);
+        return nchw;
+    }
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(SmvDepthwiseConvolutionOpTest,
+                 "SMV Tiled Depthwise Convolution",
+                 "[smvdwconv]") {
+    SECTION("No tiling required") { doTest({ 1, 8, 8, 8 }, { 3, 3 }); }
+    SECTION("Unaligned channels") { doTest({ 1, 8, 8, 13 }, { 3, 3 }); }
+    SECTION("Channelwise tiling") { doTest({ 1, 16, 16, 128 }, { 3, 3 }); }
+    SECTION("Rowwise tiling") { doTest({ 1, 128, 128, 8 }, { 3, 3 }); }
+    SECTION("Rowwise and channelwise tiling") {
+        doTest({ 1, 64, 64, 64 }, { 3, 3 });
+    }
+    SECTION("5x5 kernel") { doTest({ 1, 64, 64, 32 }, { 5, 5 }); }
+    SECTION("Valid padding, stride 2") {
+        doTest({ 1, 64, 64, 32 }, { 3, 3 }, ValidPadding, { 2, 2 });
+    }
+    SECTION("Same padding, stride 2") {
+        doTest({ 1, 64, 64, 32 }, { 3, 3 }, SamePadding, { 2, 2 });
+    }
+    SECTION("Multiple batches") { doTest({ 2, 32, 32, 32 }, { 3, 3 }); }
+    SECTION("Multiple batches in one tile") {
+        doTest({ 2, 8, 8, 8 }, { 3, 3 });
+    }
+    SECTION("Multiple accelerators") {
+        numAcceleratorsAvailable = 3;
+        doTest({ 1, 64, 64, 64 }, { 3, 3 });
+    }
+}
+
+TEST_CASE_METHOD(SmaugTest, "SMV depthwise convolution tiling", "[smvdwconv]") {
+    auto convOp = new SmvDepthwiseConvolutionOp("dwconv", workspace());
+    convOp->setStride(1, 1);
+    convOp->setPadding(SamePadding);
+    convOp->setWeightDims(3, 3, 1);
+
+    SECTION("Channelwise tiles take the same channels") {
+        TensorShape inputShape({ 1, 16, 16, 128 }, NHWC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("inputs", inputShape);
+        inputs->allocateStorage<float16>();
+        workspace()->addTensor(inputs);
+        convOp->setInput(inputs, 0);
+        convOp->createAllTensors();
+        auto config = dwconv::TilingOptimizer::computeBasicTileShapes(
+                convOp);
+        REQUIRE(config.inputTilingDims == DimNC);
+        REQUIRE(config.weightTilingDims == DimNC);
+        REQUIRE(config.outputTilingDims == DimNC);
+        REQUIRE(config.inputs.dims() == std::vector<int>{ 1, 16, 16, 64 });
+        REQUIRE(config.weights.dims() == std::vector<int>{ 1, 3, 3, 64 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 16, 16, 64 });
+    }
+
+    SECTION("Rowwise tiles") {
+        TensorShape inputShape({ 1, 128, 128, 8 }, NHWC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("inputs", inputShape);
+        inputs->allocateStorage<float16>();
+        workspace()->addTensor(inputs);
+        convOp->setInput(inputs, 0);
+        convOp->createAllTensors();
+        auto config = dwconv::TilingOptimizer::computeBasicTileShapes(
+                convOp);
+        REQUIRE(config.inputTilingDims == DimNH);
+        REQUIRE(config.weightTilingDims == None);
+        REQUIRE(config.outputTilingDims == DimNH);
+        REQUIRE(config.inputs.dims() == std::vector<int>{ 1, 16, 128, 8 });
+        REQUIRE(config.weights.dims() == std::vector<int>{ 1, 3, 3, 8 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 15, 128, 8 });
+    }
+}
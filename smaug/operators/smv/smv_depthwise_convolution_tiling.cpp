@@ -0,0 +1,221 @@
+#include <algorithm>
+
+#include "smaug/core/backend.h"
+#include "smaug/operators/common.h"
+#include "smaug/operators/smv/smv_depthwise_convolution_op.h"
+#include "smaug/operators/smv/smv_depthwise_convolution_tiling.h"
+#include "smaug/utility/debug_stream.h"
+
+namespace smaug {
+namespace smv {
+namespace dwconv {
+
+TilingConfig TilingOptimizer::computeBasicTileShapes(
+        SmvDepthwiseConvolutionOp* op) {
+    Tensor* inputs = op->getInput(op->Inputs);
+    Tensor* weights = op->getInput(op->Kernels);
+    Tensor* outputs = op->getOutput(op->Outputs);
+    int maxTileSize = SmvBackend::SpadSize() / inputs->getDataTypeSize();
+    TensorShape inputsShape = inputs->getShape();
+    TensorShape weightsShape = weights->getShape();
+    TensorShape outputsShape = outputs->getShape();
+    int minChannels = std::min(inputsShape[3], kVectorSize);
+    int minRows = std::min(inputsShape[1], weightsShape[1]);
+    TilingDims inputTilingDims = findBestTilingDims(
+            inputsShape, maxTileSize,
+            { 1, minRows, inputsShape[2], minChannels });
+    assert(!needsWwiseTiling(inputTilingDims) &&
+           "Inputs cannot be tiled columnwise!");
+    // The weights only need to follow the channels of the inputs, and the
+    // outputs follow the inputs altogether.
+    TilingDims weightTilingDims =
+            needsCwiseTiling(inputTilingDims) ? DimNC : None;
+    TilingDims outputTilingDims = inputTilingDims;
+
+    dout(2) << "  Tiling dimensions chosen:\n"
+            << "    input: " << inputTilingDims
+            << ", weight: " << weightTilingDims
+            << ", output: " << outputTilingDims << "\n";
+
+    std::vector<TensorShape> inputConfigs;
+    if (inputTilingDims == None) {
+        inputConfigs.push_back(inputsShape);
+    } else {
+        std::vector<int> minShape = inputsShape.dims();
+        std::vector<int> strides = { 1, 1, 1, 1 };
+        minShape[0] = 1;
+        if (needsHwiseTiling(inputTilingDims)) {
+            minShape[1] = minRows;
+            strides[1] = op->getRowStride();
+        }
+        if (needsCwiseTiling(inputTilingDims)) {
+            minShape[3] = minChannels;
+            strides[3] = kVectorSize;
+        }
+        enum4DTensorTilingConfigs(
+                inputsShape, maxTileSize, minShape, strides, inputConfigs);
+    }
+    assert(!inputConfigs.empty() && "No tiling configurations found!");
+
+    std::vector<TilingConfig> fullConfigs;
+    for (auto& inputsShape : inputConfigs) {
+        TilingConfig config;
+        config.inputs = inputsShape;
+        config.weights = weightsShape;
+        config.weights[3] = inputsShape[3];
+        config.outputs = outputsShape;
+        config.outputs[0] = inputsShape[0];
+        config.outputs[3] = inputsShape[3];
+        if (needsHwiseTiling(outputTilingDims)) {
+            int padding = op->getPadding() == SamePadding
+                                  ? FRAC_CEIL(config.weights[1] - 1, 2)
+                                  : 0;
+            config.outputs[1] = op->computeOutputDim(inputsShape[1],
+                                                     config.weights[1],
+                                                     op->getRowStride(),
+                                                     padding);
+        }
+        if (config.weights.storageSize() <= maxTileSize &&
+            config.outputs.storageSize() <= maxTileSize) {
+            fullConfigs.push_back(config);
+        }
+    }
+    tilingSearchStats.configs += fullConfigs.size();
+    dout(2) << "  Number of possible tiling configs: " << fullConfigs.size()
+            << "\n";
+    for (auto& config : fullConfigs)
+        dout(2) << "    " << config << "\n";
+    auto maxIt = std::max_element(
+            fullConfigs.begin(),
+            fullConfigs.end(),
+            [](const TilingConfig& c1, const TilingConfig& c2) {
+                return c1.getTotalSize() < c2.getTotalSize();
+            });
+    assert(maxIt != fullConfigs.end() && "Failed to get best tiling config!");
+    // Fill in the tiling dims.
+    (*maxIt).inputTilingDims = inputTilingDims;
+    (*maxIt).weightTilingDims = weightTilingDims;
+    (*maxIt).outputTilingDims = outputTilingDims;
+    return *maxIt;
+}
+
+TiledTensor TilingOptimizer::generateRowwiseOutputTiledTensor(
+        SmvDepthwiseConvolutionOp* op,
+        const TiledTensor& inputTiledTensor,
+        const TensorShape& maxOutputTileSize,
+        Tensor* outputTensor,
+        bool copyData) {
+    const TensorShape& inputShape = inputTiledTensor.getShape();
+    const TensorShape& outputShape = outputTensor->getShape();
+    int weightRows = op->getWeightRows();
+    int weightCols = op->getWeightCols();
+    std::vector<int> inputPadding = op->getInputPadding();
+    int topRowPad = inputPadding[0];
+    int bottomRowPad = inputPadding[1];
+    int leftColPad = inputPadding[2];
+    int rightColPad = inputPadding[3];
+    std::vector<int> numBlocksInDim{ inputShape[0], inputShape[1],
+                                     inputShape[2], inputShape[3] };
+    // Due to stride > 1, there is a case where the last rowwise tile doesn't
+    // have enough rows for convolution. If so, we need to decrease the row
+    // dimension by 1 in the output tiled tensor.
+    int lastTileRows =
+            inputTiledTensor[inputTiledTensor.size() - 1]->getShape()[1];
+    if (lastTileRows + bottomRowPad < weightRows)
+        numBlocksInDim[1]--;
+    TiledTensor outputTiledTensor(
+            TensorShape(numBlocksInDim, inputShape.getLayout()), outputTensor);
+    const int ndims = outputShape.ndims();
+    std::vector<int> currentOrigin(ndims, 0);
+    auto inputIndex = inputTiledTensor.startIndex();
+    auto outputIndex = outputTiledTensor.startIndex();
+    for (int n = 0; n < numBlocksInDim[0]; n++) {
+        for (int h = 0; h < numBlocksInDim[1]; h++) {
+            for (int w = 0; w < numBlocksInDim[2]; w++) {
+                for (int c = 0; c < numBlocksInDim[3]; c++) {
+                    const Tensor* inputTile =
+                            inputTiledTensor[inputIndex(n, h, w, c)];
+                    const TensorShape& inputTileShape = inputTile->getShape();
+
+                    // DimNH tiling only affects rows, not columns.
+                    int effInputRows = inputTileShape[1];
+                    if (h == 0)
+                        effInputRows += topRowPad;
+                    else if (h == numBlocksInDim[1] - 1)
+                        effInputRows += bottomRowPad;
+                    int effInputCols =
+                            inputTileShape[2] + leftColPad + rightColPad;
+                    int outputRows = op->computeOutputDim(effInputRows,
+                                                          weightRows,
+                                                          op->getRowStride(),
+                                                          ValidPadding);
+                    int outputCols = op->computeOutputDim(effInputCols,
+                                                          weightCols,
+                                                          op->getColStride(),
+                                                          ValidPadding);
+                    TensorShape outputTileShape(
+                            { inputTileShape[0], outputRows, outputCols,
+                              inputTileShape[3] },
+                            outputTensor->getShape().getLayout(),
+                            SmvBackend::Alignment);
+                    assert(outputTileShape.storageSize() <=
+                                   maxOutputTileSize.storageSize() &&
+                           "DimNH input tiling results in output tile sizes "
+                           "larger than the max tile size!");
+                    int oi = outputIndex(n, h, w, c);
+                    std::string tileName = op->getName() + ":" +
+                                           outputTensor->getName() +
+                                           "/tile:" + std::to_string((int)oi);
+                    Tensor* outputTile = new Tensor(tileName, outputTileShape);
+                    outputTile->allocateStorage(outputTensor->getDataType());
+                    outputTiledTensor.setTile(
+                            oi, currentOrigin, outputTile, copyData);
+                    for (int i = ndims - 1; i >= 0; i--) {
+                        currentOrigin[i] += outputTileShape[i];
+                        if (currentOrigin[i] >= outputShape[i])
+                            currentOrigin[i] = 0;
+                        else
+                            break;
+                    }
+                }
+            }
+        }
+    }
+    op->getWorkspace()->addTiledTensor(outputTiledTensor);
+    dout(1) << "  Tiled Tensor " << outputTensor->getName() << "(rowwise):\n"
+            << "    original tensor shape: " << outputTensor->getShape() << "\n"
+            << "    number of tiles: " << outputTiledTensor.size() << "\n";
+    return outputTiledTensor;
+}
+
+std::array<TiledTensor, 3> TilingOptimizer::doTiling(
+        SmvDepthwiseConvolutionOp* op) {
+    auto input = op->getInput(SmvDepthwiseConvolutionOp::Inputs);
+    auto kernels = op->getInput(SmvDepthwiseConvolutionOp::Kernels);
+    auto output = op->getOutput(SmvDepthwiseConvolutionOp::Outputs);
+    TilingConfig tileConfig = TilingOptimizer::computeBasicTileShapes(op);
+    TiledTensor tiledInputs =
+            generateTiledTensorWithStrideAndPadding(input,
+                                                    tileConfig.inputs,
+                                                    op,
+                                                    op->getWeightRows(),
+                                                    op->getWeightCols(),
+                                                    op->getRowStride(),
+                                                    op->getColStride(),
+                                                    op->getPadding());
+    // Copy data for the weight tiles since the data is read-only.
+    TiledTensor tiledWeights = generateTiledTensor(
+            kernels, tileConfig.weights, op, /* copyData */ true);
+    TiledTensor tiledOutputs;
+    if (needsHwiseTiling(tileConfig.outputTilingDims)) {
+        tiledOutputs = TilingOptimizer::generateRowwiseOutputTiledTensor(
+                op, tiledInputs, tileConfig.outputs, output, false);
+    } else {
+        tiledOutputs = generateTiledTensor(output, tileConfig.outputs, op);
+    }
+    return { tiledInputs, tiledWeights, tiledOutputs };
+}
+
+}  // namespace dwconv
+}  // namespace smv
+}  // namespace smaug
@@ -0,0 +1,61 @@
+#ifndef _OPERATORS_SMV_SMV_DEPTHWISE_CONVOLUTION_TILING_H_
+#define _OPERATORS_SMV_SMV_DEPTHWISE_CONVOLUTION_TILING_H_
+
+#include "smaug/core/backend.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/smv/smv_tiling_common.h"
+#include "smaug/operators/smv/smv_tiling_base.h"
+
+namespace smaug {
+
+class SmvDepthwiseConvolutionOp;
+
+namespace smv {
+namespace dwconv {
+
+/**
+ * Tiling optimizer for the SMV depthwise convolution kernel.
+ *
+ * Every channel of the outputs only depends on the same channel of the inputs
+ * and the weights, so the three tensors are always tiled along the same
+ * channels, and no tile has to be accumulated over another.
+ */
+class TilingOptimizer : public TilingOptimizerBase {
+   public:
+    static std::array<TiledTensor, 3> doTiling(SmvDepthwiseConvolutionOp* op);
+
+    /**
+     * Determine the best basic tiling shape for this depthwise convolution
+     * layer.
+     *
+     * Only the inputs have a free tiling shape: the weight and output tiles
+     * take the channels of the input tile, and the output tile takes the rows
+     * the input tile produces. Input channels are enumerated in multiples of
+     * the vector size of the kernel. The TilingConfig that maximizes the total
+     * combined size of input, weights, and output tiles is chosen as the best.
+     *
+     * @param op The SMV depthwise convolution operator. All tensors must have
+     * been created with createAllTensors() prior to calling this function.
+     * @returns The TilingConfig that describes the best tiling shapes.
+     */
+    static TilingConfig computeBasicTileShapes(SmvDepthwiseConvolutionOp* op);
+
+    /**
+     * A specialized output tiling function when the output is tiled rowwise.
+     *
+     * Like the one of the convolution, but there is an output tile for every
+     * input tile, with the channels of the input tile.
+     */
+    static TiledTensor generateRowwiseOutputTiledTensor(
+            SmvDepthwiseConvolutionOp* op,
+            const TiledTensor& inputTiledTensor,
+            const TensorShape& maxOutputTileSize,
+            Tensor* outputTensor,
+            bool copyData = false);
+};
+
+}  // namespace dwconv
+}  // namespace smv
+}  // namespace smaug
+
+#endif
@@ -0,0 +1,131 @@
+#include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
+#include "smaug/operators/common.h"
+#include "smaug/operators/smv/smv_double_buffer.h"
+
+namespace smaug {
+
+void mapDoubleBufferArrays(unsigned reqCode,
+                           const SpadAssignment& spads,
+                           const char* nextInputsName,
+                           const char* nextWeightsName) {
+    if (spads.transferSizes[0] > 0) {
+        mapArrayToAccel(reqCode, nextInputsName, spads.hostNextInputs,
+                        spads.transferSizes[0] * sizeof(float16));
+    }
+    if (spads.transferSizes[1] > 0) {
+        mapArrayToAccel(reqCode, nextWeightsName, spads.hostNextWeights,
+                        spads.transferSizes[1] * sizeof(float16));
+    }
+    if (spads.transferSizes[2] > 0) {
+        mapArrayToAccel(reqCode, "host_last_results", spads.hostLastResults,
+                        spads.transferSizes[2] * sizeof(float16));
+    }
+}
+
+SmvDoubleBuffer::SmvDoubleBuffer(SmvAcceleratorPool* _accelPool,
+                                 int numAccels,
+                                 float* _inputsSpad,
+                                 float* _weightsSpad,
+                                 float* _resultsSpad)
+        : accelPool(_accelPool), inputsSpad(_inputsSpad),
+          weightsSpad(_weightsSpad), resultsSpad(_resultsSpad),
+          accelHalves(runningInSimulation ? numAccels : 1) {}
+
+float* SmvDoubleBuffer::getHalf(float* spad, int half) {
+    // The scratchpads hold SpadSize() bytes of float16 data as float32.
+    return spad + half * SmvBackend::SpadSize() / sizeof(float16) / 2;
+}
+
+void SmvDoubleBuffer::submit(int accelIdx,
+                             Tile inputs,
+                             Tile weights,
+                             Tile results,
+                             bool sendResults,
+                             Launcher launch) {
+    std::unique_ptr<Invocation> inv(new Invocation{
+            accelIdx, inputs, weights, results, sendResults, launch });
+    Halves& halves = accelHalves[runningInSimulation ? accelIdx : 0];
+    if (halves.pending)
+        this->launch(halves, *halves.pending, inv.get());
+    halves.pending = std::move(inv);
+}
+
+void SmvDoubleBuffer::flush() {
+    for (auto& halves : accelHalves) {
+        if (halves.pending) {
+            launch(halves, *halves.pending, nullptr);
+            halves.pending.reset();
+        }
+    }
+}
+
+void SmvDoubleBuffer::launch(Halves& halves,
+                             Invocation& inv,
+                             const Invocation* next) {
+    // Use the half that holds a tile if there is one. Otherwise, load the
+    // tile into the half that the last invocation didn't use.
+    auto place = [](int (&tiles)[2], int& currHalf, int tileIdx) {
+        bool read = false;
+        if (tiles[currHalf] != tileIdx) {
+            currHalf = 1 - currHalf;
+            if (tiles[currHalf] != tileIdx) {
+                tiles[currHalf] = tileIdx;
+                read = true;
+            }
+        }
+        return read;
+    };
+    bool readInputs = place(halves.inputs, halves.inputsHalf, inv.inputs.idx);
+    bool readWeights =
+            place(halves.weights, halves.weightsHalf, inv.weights.idx);
+    // A new results tile goes to the other half, which is free as the last
+    // results tile was finished.
+    if (inv.results.idx != halves.resultsTile)
+        halves.resultsHalf = 1 - halves.resultsHalf;
+    halves.resultsTile = inv.results.idx;
+    SpadAssignment spads(getHalf(inputsSpad, halves.inputsHalf),
+                         getHalf(weightsSpad, halves.weightsHalf),
+                         getHalf(resultsSpad, halves.resultsHalf),
+                         readInputs,
+                         readWeights,
+                         inv.sendResults && !next);
+
+    // Prefetch the tiles of the next invocation that no half holds.
+    if (next) {
+        int otherInputsHalf = 1 - halves.inputsHalf;
+        if (halves.inputs[halves.inputsHalf] != next->inputs.idx &&
+            halves.inputs[otherInputsHalf] != next->inputs.idx) {
+            halves.inputs[otherInputsHalf] = next->inputs.idx;
+            spads.hostNextInputs = next->inputs.tensor->data<float16>();
+            spads.nextInputs = getHalf(inputsSpad, otherInputsHalf);
+            spads.transferSizes[0] =
+                    next->inputs.tensor->getShape().storageSize();
+        }
+        int otherWeightsHalf = 1 - halves.weightsHalf;
+        if (halves.weights[halves.weightsHalf] != next->weights.idx &&
+            halves.weights[otherWeightsHalf] != next->weights.idx) {
+            halves.weights[otherWeightsHalf] = next->weights.idx;
+            spads.hostNextWeights = next->weights.tensor->data<float16>();
+            spads.nextWeights = getHalf(weightsSpad, otherWeightsHalf);
+            spads.transferSizes[1] =
+                    next->weights.tensor->getShape().storageSize();
+        }
+    }
+    // Drain the results of the last invocation.
+    if (halves.drain) {
+        spads.hostLastResults = halves.drain->data<float16>();
+        spads.lastResults = getHalf(resultsSpad, 1 - halves.resultsHalf);
+        spads.transferSizes[2] = halves.drain->getShape().storageSize();
+        halves.drain = nullptr;
+    }
+    // Finished results are drained by the next invocation.
+    if (inv.sendResults) {
+        if (next)
+            halves.drain = inv.results.tensor;
+        halves.resultsTile = -1;
+    }
+    accelPool->addFinishFlag(inv.accelIdx, inv.launch(spads));
+}
+
+}  // namespace smaug
@@ -0,0 +1,158 @@
+#ifndef _OPERATORS_SMV_SMV_DOUBLE_BUFFER_H_
+#define _OPERATORS_SMV_SMV_DOUBLE_BUFFER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "smaug/core/tensor.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
+
+namespace smaug {
+
+/**
+ * The scratchpads a kernel invocation computes on, what it loads into them,
+ * and the double-buffered transfers it overlaps with its computation (see
+ * host_double_buffer_fp16()).
+ */
+struct SpadAssignment {
+    SpadAssignment(float* _inputs,
+                   float* _weights,
+                   float* _results,
+                   bool _readInputs,
+                   bool _readWeights,
+                   bool _sendResults)
+            : inputs(_inputs), weights(_weights), results(_results),
+              readInputs(_readInputs), readWeights(_readWeights),
+              sendResults(_sendResults) {}
+
+    float* inputs;
+    float* weights;
+    float* results;
+    bool readInputs;
+    bool readWeights;
+    bool sendResults;
+
+    float16* hostNextInputs = nullptr;
+    float16* hostNextWeights = nullptr;
+    float16* hostLastResults = nullptr;
+    float* nextInputs = nullptr;
+    float* nextWeights = nullptr;
+    float* lastResults = nullptr;
+    /** Elements of the next inputs, next weights and last results. */
+    int transferSizes[3] = { 0, 0, 0 };
+};
+
+/**
+ * Maps the host buffers of the double-buffered transfers of an invocation to
+ * the accelerator. The last results are always called "host_last_results".
+ */
+void mapDoubleBufferArrays(unsigned reqCode,
+                           const SpadAssignment& spads,
+                           const char* nextInputsName,
+                           const char* nextWeightsName);
+
+/**
+ * SmvDoubleBuffer overlaps the data transfers of an operator's kernel
+ * invocations with their computation, by splitting the inputs, weights and
+ * results scratchpads into ping and pong halves.
+ *
+ * While an invocation computes on its tiles in one half of each scratchpad,
+ * it prefetches the input and weight tiles of the next invocation on the same
+ * accelerator into the other halves, and drains the results of the previous
+ * invocation from the other half of the results scratchpad. The tiles must
+ * therefore fit in half a scratchpad.
+ *
+ * An invocation can only be launched once the next one on the same
+ * accelerator is known, so submit() holds every invocation back until then.
+ * flush() launches the ones still held back, without anything to prefetch.
+ *
+ * Outside of simulation, the kernels of all the accelerators run one after
+ * another on the same scratchpads, so they share a single set of halves.
+ */
+class SmvDoubleBuffer {
+   public:
+    /** A tile that an invocation reads or writes. */
+    struct Tile {
+        int idx;
+        Tensor* tensor;
+    };
+
+    /** Launches the kernel of an invocation with the given scratchpads. */
+    typedef std::function<std::unique_ptr<volatile int>(
+            SpadAssignment&)>
+            Launcher;
+
+    SmvDoubleBuffer(SmvAcceleratorPool* _accelPool,
+                    int numAccels,
+                    float* _inputsSpad,
+                    float* _weightsSpad,
+                    float* _resultsSpad);
+
+    /**
+     * Submits an invocation on the given accelerator.
+     *
+     * @param accelIdx The accelerator, which must have been picked by the
+     * accelerator pool.
+     * @param inputs The input tile.
+     * @param weights The weight tile.
+     * @param results The results tile. Consecutive invocations on the same
+     * results tile accumulate into the same half of the results scratchpad.
+     * @param sendResults The results tile is finished after this invocation
+     * and goes back to the host.
+     * @param launch Launches the kernel. It must also map the host buffers,
+     * as it may run after the next invocation has been submitted.
+     */
+    void submit(int accelIdx,
+                Tile inputs,
+                Tile weights,
+                Tile results,
+                bool sendResults,
+                Launcher launch);
+
+    /** Launches all the invocations that are held back. */
+    void flush();
+
+    /** Returns the given half of a scratchpad. */
+    static float* getHalf(float* spad, int half);
+
+   protected:
+    struct Invocation {
+        int accelIdx;
+        Tile inputs;
+        Tile weights;
+        Tile results;
+        bool sendResults;
+        Launcher launch;
+    };
+
+    /** The contents of the scratchpad halves that one set of kernels uses. */
+    struct Halves {
+        /** The input and weight tiles in each half, or -1. */
+        int inputs[2] = { -1, -1 };
+        int weights[2] = { -1, -1 };
+        /** The halves the last invocation computed on. */
+        int inputsHalf = 1;
+        int weightsHalf = 1;
+        int resultsHalf = 1;
+        /** The unfinished results tile in resultsHalf, or -1. */
+        int resultsTile = -1;
+        /** Finished results in the other half, waiting to be drained. */
+        Tensor* drain = nullptr;
+        /** The invocation that waits for the next one. */
+        std::unique_ptr<Invocation> pending;
+    };
+
+    /** Launches an invocation, prefetching the tiles of the next one. */
+    void launch(Halves& halves, Invocation& inv, const Invocation* next);
+
+    SmvAcceleratorPool* accelPool;
+    float* inputsSpad;
+    float* weightsSpad;
+    float* resultsSpad;
+    std::vector<Halves> accelHalves;
+};
+
+}  // namespace smaug
+
+#endif
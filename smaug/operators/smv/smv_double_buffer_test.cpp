@@ -0,0 +1,131 @@
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/operators/common.h"
+#include "smaug/operators/smv/smv_double_buffer.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class SmvDoubleBufferTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    SmvDoubleBuffer::Tile makeTile(int idx) {
+        TensorShape shape({ 1, 8 * (idx + 1) }, NC, SmvBackend::Alignment);
+        Tensor* tensor = new Tensor("tile" + std::to_string(idx), shape);
+        tensor->allocateStorage<float16>();
+        workspace()->addTensor(tensor);
+        return { idx, tensor };
+    }
+
+    // Records the scratchpads of the launched invocations.
+    SmvDoubleBuffer::Launcher record(int id) {
+        return [this, id](SpadAssignment& spads) {
+            launched.push_back(id);
+            assignments.push_back(spads);
+            return std::unique_ptr<volatile int>(new int(IS_COMPLETED));
+        };
+    }
+
+    std::vector<int> launched;
+    std::vector<SpadAssignment> assignments;
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(SmvDoubleBufferTest, "SMV double buffer", "[smvdb]") {
+    float* half0 = SmvDoubleBuffer::getHalf(smv::spad0, 0);
+    float* half1 = SmvDoubleBuffer::getHalf(smv::spad0, 1);
+    REQUIRE(half0 == smv::spad0);
+    REQUIRE(half1 - half0 == SmvBackend::SpadSize() / 4);
+
+    SECTION("Prefetch and drain") {
+        SmvAcceleratorPool pool(1);
+        SmvDoubleBuffer buffer(&pool, 1, smv::spad0, smv::spad1, smv::spad2);
+        auto in0 = makeTile(0), in1 = makeTile(1);
+        auto w0 = makeTile(0), w1 = makeTile(1), w2 = makeTile(2);
+        auto out0 = makeTile(0), out1 = makeTile(1);
+        // The second and third invocations accumulate into the same results.
+        buffer.submit(0, in0, w0, out0, true, record(0));
+        REQUIRE(launched.empty());
+        buffer.submit(0, in1, w1, out1, false, record(1));
+        buffer.submit(0, in1, w2, out1, true, record(2));
+        REQUIRE(launched == std::vector<int>{ 0, 1 });
+        buffer.flush();
+        pool.joinAll();
+        REQUIRE(launched == std::vector<int>{ 0, 1, 2 });
+
+        // The first invocation loads its own tiles and prefetches the next
+        // ones into the other halves. Its results wait to be drained.
+        SpadAssignment& first = assignments[0];
+        REQUIRE(first.inputs == smv::spad0);
+        REQUIRE(first.weights == smv::spad1);
+        REQUIRE(first.results == smv::spad2);
+        REQUIRE(first.readInputs);
+        REQUIRE(first.readWeights);
+        REQUIRE(!first.sendResults);
+        REQUIRE(first.nextInputs == SmvDoubleBuffer::getHalf(smv::spad0, 1));
+        REQUIRE(first.hostNextInputs == in1.tensor->data<float16>());
+        REQUIRE(first.transferSizes[0] == 16);
+        REQUIRE(first.nextWeights == SmvDoubleBuffer::getHalf(smv::spad1, 1));
+        REQUIRE(first.transferSizes[1] == 16);
+        REQUIRE(first.transferSizes[2] == 0);
+
+        // The second one finds its tiles prefetched, and only prefetches the
+        // weights as it keeps the inputs. It drains the first results.
+        SpadAssignment& second = assignments[1];
+        REQUIRE(second.inputs == SmvDoubleBuffer::getHalf(smv::spad0, 1));
+        REQUIRE(second.weights == SmvDoubleBuffer::getHalf(smv::spad1, 1));
+        REQUIRE(second.results == SmvDoubleBuffer::getHalf(smv::spad2, 1));
+        REQUIRE(!second.readInputs);
+        REQUIRE(!second.readWeights);
+        REQUIRE(!second.sendResults);
+        REQUIRE(second.transferSizes[0] == 0);
+        REQUIRE(second.nextWeights == smv::spad1);
+        REQUIRE(second.transferSizes[1] == 24);
+        REQUIRE(second.lastResults == smv::spad2);
+        REQUIRE(second.hostLastResults == out0.tensor->data<float16>());
+        REQUIRE(second.transferSizes[2] == 8);
+
+        // The last one accumulates into the same half and sends its own
+        // results, as nothing comes after it.
+        SpadAssignment& third = assignments[2];
+        REQUIRE(third.inputs == SmvDoubleBuffer::getHalf(smv::spad0, 1));
+        REQUIRE(third.weights == smv::spad1);
+        REQUIRE(third.results == SmvDoubleBuffer::getHalf(smv::spad2, 1));
+        REQUIRE(!third.readInputs);
+        REQUIRE(!third.readWeights);
+        REQUIRE(third.sendResults);
+        REQUIRE(third.transferSizes[0] == 0);
+        REQUIRE(third.transferSizes[1] == 0);
+        REQUIRE(third.transferSizes[2] == 0);
+    }
+
+    SECTION("Halves per accelerator in simulation") {
+        runningInSimulation = true;
+        SmvAcceleratorPool pool(2);
+        SmvDoubleBuffer buffer(&pool, 2, smv::spad0, smv::spad1, smv::spad2);
+        auto w0 = makeTile(0);
+        buffer.submit(0, makeTile(0), w0, makeTile(0), true, record(0));
+        buffer.submit(1, makeTile(1), w0, makeTile(1), true, record(1));
+        auto in2 = makeTile(2);
+        buffer.submit(0, in2, w0, makeTile(2), true, record(2));
+        buffer.flush();
+        pool.joinAll();
+        REQUIRE(launched == std::vector<int>{ 0, 2, 1 });
+        // The first invocation on accelerator 0 prefetches the inputs of the
+        // next one on the same accelerator.
+        REQUIRE(assignments[0].hostNextInputs == in2.tensor->data<float16>());
+        REQUIRE(assignments[0].transferSizes[1] == 0);
+        REQUIRE(!assignments[1].readInputs);
+        REQUIRE(assignments[1].sendResults);
+        REQUIRE(assignments[1].transferSizes[2] == 8);
+        // Accelerator 1 has its own halves, so it loads everything itself.
+        REQUIRE(assignments[2].readInputs);
+        REQUIRE(assignments[2].readWeights);
+        REQUIRE(assignments[2].inputs == smv::spad0);
+    }
+}
@@ -4,6 +4,7 @@
 #include "smaug/operators/smv/smv_eltwise_add_op.h"
 #include "smaug/operators/smv/smv_unary_op_common.h"
 #include "smaug/operators/smv/smv_kernels.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
@@ -14,13 +15,24 @@ void SmvEltwiseAddOp::runX(TiledTensor& inputs0,
                            TiledTensor& outputs) {
     assert(inputs0.size() == inputs1.size() &&
            inputs0.size() == outputs.size());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_inputs0", getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_inputs1", getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_results", getOutputsMemType());
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = smv::kEltwiseOpHw + firstAccelIdx;
+    // The tiles are independent, so they are spread over all the available
+    // accelerators.
+    for (int i = 0; i < numAccels; i++) {
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs0", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs1", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_results", getOutputsMemType());
+    }
+    SmvAcceleratorPool accelPool(numAccels);
     for (int i = 0; i < inputs0.size(); i++) {
+        AcceleratorWork work;
+        work.cost = outputs[i]->getShape().size();
+        int currAccelIdx = accelPool.getNextAvailableAccelerator(work);
         dout(1) << "Input0: " << i << ", input1: " << i << ", output: " << i
                 << "\n";
         Tensor* input0Tile = inputs0.getTileWithData(i);
@@ -28,21 +40,25 @@ void SmvEltwiseAddOp::runX(TiledTensor& inputs0,
         Tensor* outputTile = outputs[i];
         const TensorShape& inputShape = input0Tile->getShape();
         const TensorShape& outputShape = outputTile->getShape();
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_inputs0",
+        mapArrayToAccel(accelId + currAccelIdx, "host_inputs0",
                         input0Tile->data<float16>(),
                         inputShape.storageSize() * sizeof(float16));
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_inputs1",
+        mapArrayToAccel(accelId + currAccelIdx, "host_inputs1",
                         input1Tile->data<float16>(),
                         inputShape.storageSize() * sizeof(float16));
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_results",
+        mapArrayToAccel(accelId + currAccelIdx, "host_results",
                         outputTile->data<float16>(),
                         outputShape.storageSize() * sizeof(float16));
 
-        invokeKernel(smv::kEltwiseOpHw, smv_eltwise_add_nc_vec_fxp,
-                     input0Tile->data<float16>(), input1Tile->data<float16>(),
-                     outputTile->data<float16>(), smv::spad0, smv::spad1,
-                     smv::spad2, inputShape.storageSize());
+        std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
+                firstAccelIdx + currAccelIdx, accelId + currAccelIdx,
+                smv_eltwise_add_nc_vec_fxp,
+                input0Tile->data<float16>(), input1Tile->data<float16>(),
+                outputTile->data<float16>(), smv::spad0, smv::spad1,
+                smv::spad2, inputShape.storageSize());
+        accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
     }
+    accelPool.joinAll();
 }
 
 void SmvEltwiseAddOp::tile() {
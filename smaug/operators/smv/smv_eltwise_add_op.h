@@ -13,6 +13,9 @@ class SmvEltwiseAddOp : public EltwiseAddOp<SmvBackend> {
     using EltwiseAddOp<SmvBackend>::EltwiseAddOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
 
   protected:
    void runX(TiledTensor& inputs0, TiledTensor& inputs1, TiledTensor& outputs);
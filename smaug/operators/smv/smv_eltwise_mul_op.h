@@ -13,6 +13,9 @@ class SmvEltwiseMulOp : public EltwiseMulOp<SmvBackend> {
     using EltwiseMulOp<SmvBackend>::EltwiseMulOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
 
   protected:
    void runX(TiledTensor& inputs0, TiledTensor& inputs1, TiledTensor& outputs);
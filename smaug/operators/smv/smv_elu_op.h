@@ -14,6 +14,12 @@ class SmvEluOp : public EluOp<SmvBackend> {
     using EluOp<SmvBackend>::EluOp;
     void tile() override { tiledTensors = smv::unary::doTiling(this, false); }
     void run() override { smv::unary::run(this, tiledTensors); };
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1] };
+    }
+    bool canReadInputOnChip(TensorBase* input) const override {
+        return smv::unary::canReadInputOnChip(this, input, tiledTensors);
+    }
 
    protected:
     std::array<TiledTensor, 2> tiledTensors;
@@ -25,6 +31,12 @@ class SmvSeluOp : public SeluOp<SmvBackend> {
     using SeluOp<SmvBackend>::SeluOp;
     void tile() override { tiledTensors = smv::unary::doTiling(this, false); }
     void run() override { smv::unary::run(this, tiledTensors); };
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1] };
+    }
+    bool canReadInputOnChip(TensorBase* input) const override {
+        return smv::unary::canReadInputOnChip(this, input, tiledTensors);
+    }
 
    protected:
     std::array<TiledTensor, 2> tiledTensors;
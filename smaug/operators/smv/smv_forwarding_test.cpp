@@ -0,0 +1,202 @@
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/tensor.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/operators/smv/smv_test_common.h"
+#include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_pooling_op.h"
+#include "smaug/operators/smv/smv_relu_op.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class SmvForwardingTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    SmvConvolutionOp* addConvOp(const std::string& name,
+                                Tensor* input,
+                                int numOfmaps,
+                                ActivationInfo actInfo = ActivationInfo()) {
+        auto convOp = new SmvConvolutionOp(name, workspace());
+        convOp->setActivation(actInfo);
+        convOp->setStride(1, 1);
+        convOp->setPadding(SamePadding);
+        convOp->setInput(input, 0);
+        convOp->setWeightDims(3, 3, numOfmaps);
+        addOp(convOp);
+        return convOp;
+    }
+
+    SmvInnerProductOp* addFcOp(const std::string& name,
+                               Tensor* input,
+                               int numNeurons,
+                               ActivationInfo actInfo = ActivationInfo()) {
+        auto fcOp = new SmvInnerProductOp(name, workspace());
+        fcOp->setActivation(actInfo);
+        fcOp->setInput(input, 0);
+        fcOp->setNumOutputs(numNeurons);
+        addOp(fcOp);
+        return fcOp;
+    }
+
+    // Creates the tensors the operator owns and fills its parameters.
+    void addOp(Operator* op) {
+        op->createAllTensors();
+        for (int i = 1; i < op->getInputs().size(); i++) {
+            op->getInput(i)->allocateStorage<float16>();
+            fillTensorWithRandomData(op->getInput(i));
+        }
+        op->getOutput(0)->allocateStorage<float16>();
+    }
+
+    Tensor* createInput(const std::vector<int>& dims, DataLayout layout) {
+        TensorShape shape(dims, layout, SmvBackend::Alignment);
+        Tensor* input = new Tensor("input", shape);
+        input->allocateStorage<float16>();
+        fillTensorWithRandomData(input);
+        workspace()->addTensor(input);
+        return input;
+    }
+
+    // Runs producer -> consumer with forwarding enabled, then reruns both
+    // operators through host memory and checks the results are the same.
+    void doTest(Operator* producer, Operator* consumer) {
+        network()->addOperator(producer);
+        network()->addOperator(consumer);
+        network()->addEdge(producer, consumer, { 0, 0 });
+
+        fuseOperatorsWhenPossible = true;
+        Scheduler scheduler(network(), workspace());
+        Tensor* output = scheduler.runNetwork();
+        REQUIRE(producer->getFusedConsumer() == consumer);
+        REQUIRE(consumer->getFusedProducer() == producer);
+        Tensor* forwarded = new Tensor("forwarded", output->getShape());
+        forwarded->allocateStorage<float16>();
+        copyRawTensorData(
+                forwarded, output, 0, 0, output->getShape().storageSize());
+        workspace()->addTensor(forwarded);
+
+        producer->setFusedConsumer(nullptr);
+        consumer->setFusedProducer(nullptr);
+        producer->run();
+        consumer->run();
+        verifyOutputs<float16>(consumer->getOutput(0), forwarded);
+    }
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(SmvForwardingTest,
+                 "SMV on-chip forwarding between operators",
+                 "[smvforward]") {
+    SECTION("Conv -> conv") {
+        auto conv0 = addConvOp(
+                "conv0", createInput({ 1, 8, 8, 16 }, NHWC), 16,
+                ActivationInfo(activation_type::RELU));
+        auto conv1 = addConvOp("conv1", conv0->getOutput(0), 8);
+        doTest(conv0, conv1);
+    }
+    SECTION("Conv -> pool") {
+        auto conv = addConvOp("conv", createInput({ 1, 8, 8, 16 }, NHWC), 16);
+        auto pool = new SmvMaxPoolingOp("pool", workspace());
+        pool->setPoolingSize(2, 2);
+        pool->setPoolingStride(2, 2);
+        pool->setInput(conv->getOutput(0), 0);
+        addOp(pool);
+        doTest(conv, pool);
+    }
+    SECTION("Conv -> relu") {
+        auto conv = addConvOp("conv", createInput({ 1, 8, 8, 16 }, NHWC), 16);
+        auto relu = new SmvReluOp("relu", workspace());
+        relu->setInput(conv->getOutput(0), 0);
+        addOp(relu);
+        doTest(conv, relu);
+    }
+    SECTION("FC -> FC") {
+        auto fc0 = addFcOp("fc0", createInput({ 1, 256 }, NC), 128,
+                           ActivationInfo(activation_type::RELU));
+        auto fc1 = addFcOp("fc1", fc0->getOutput(0), 32);
+        doTest(fc0, fc1);
+    }
+    SECTION("Conv -> conv -> conv") {
+        // Only the first pair is fused, as a fused consumer doesn't leave
+        // its results where the next consumer would read them.
+        auto conv0 = addConvOp(
+                "conv0", createInput({ 1, 8, 8, 16 }, NHWC), 16);
+        auto conv1 = addConvOp("conv1", conv0->getOutput(0), 16);
+        auto conv2 = addConvOp("conv2", conv1->getOutput(0), 8);
+        network()->addOperator(conv0);
+        network()->addOperator(conv1);
+        network()->addOperator(conv2);
+        network()->addEdge(conv0, conv1, { 0, 0 });
+        network()->addEdge(conv1, conv2, { 0, 0 });
+        fuseOperatorsWhenPossible = true;
+        Scheduler scheduler(network(), workspace());
+        Tensor* output = scheduler.runNetwork();
+        REQUIRE(conv0->getFusedConsumer() == conv1);
+        REQUIRE(conv1->getFusedProducer() == conv0);
+        REQUIRE(conv1->getFusedConsumer() == nullptr);
+        REQUIRE(conv2->getFusedProducer() == nullptr);
+        Tensor* forwarded = new Tensor("forwarded", output->getShape());
+        forwarded->allocateStorage<float16>();
+        copyRawTensorData(
+                forwarded, output, 0, 0, output->getShape().storageSize());
+        workspace()->addTensor(forwarded);
+
+        conv0->setFusedConsumer(nullptr);
+        conv1->setFusedProducer(nullptr);
+        conv0->run();
+        conv1->run();
+        conv2->run();
+        verifyOutputs<float16>(conv2->getOutput(0), forwarded);
+    }
+    SECTION("Fused operators use whole scratchpads with double buffering") {
+        // The weights of fc0 fit in a scratchpad, but not in half of one.
+        doubleBufferSpadsWhenPossible = true;
+        auto fc0 = addFcOp("fc0", createInput({ 1, 256 }, NC), 48);
+        auto fc1 = addFcOp("fc1", fc0->getOutput(0), 32);
+        fc0->tile();
+        REQUIRE(fc0->getTiledTensors()[1]->size() > 1);
+        network()->addOperator(fc0);
+        network()->addOperator(fc1);
+        network()->addEdge(fc0, fc1, { 0, 0 });
+        fuseOperatorsWhenPossible = true;
+        Scheduler scheduler(network(), workspace());
+        Tensor* output = scheduler.runNetwork();
+        REQUIRE(fc0->getFusedConsumer() == fc1);
+        REQUIRE(fc0->getTiledTensors()[1]->size() == 1);
+        Tensor* forwarded = new Tensor("forwarded", output->getShape());
+        forwarded->allocateStorage<float16>();
+        copyRawTensorData(
+                forwarded, output, 0, 0, output->getShape().storageSize());
+        workspace()->addTensor(forwarded);
+
+        // Unfused, the operators double-buffer again with their first tiling.
+        fc0->setFusedConsumer(nullptr);
+        fc1->setFusedProducer(nullptr);
+        fc0->tile();
+        fc1->tile();
+        fc0->run();
+        fc1->run();
+        verifyOutputs<float16>(fc1->getOutput(0), forwarded);
+    }
+    SECTION("Tiled outputs are not forwarded") {
+        // The conv output doesn't fit in a single spad.
+        auto conv = addConvOp("conv", createInput({ 1, 64, 64, 8 }, NHWC), 8);
+        auto relu = new SmvReluOp("relu", workspace());
+        relu->setInput(conv->getOutput(0), 0);
+        addOp(relu);
+        network()->addOperator(conv);
+        network()->addOperator(relu);
+        network()->addEdge(conv, relu, { 0, 0 });
+        fuseOperatorsWhenPossible = true;
+        Scheduler scheduler(network(), workspace());
+        scheduler.runNetwork();
+        REQUIRE(conv->getFusedConsumer() == nullptr);
+        REQUIRE(relu->getFusedProducer() == nullptr);
+    }
+}
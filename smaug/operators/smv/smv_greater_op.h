@@ -13,6 +13,9 @@ class SmvGreaterOp : public GreaterOp<SmvBackend> {
     using GreaterOp<SmvBackend>::GreaterOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
 
   protected:
    void runX(TiledTensor& inputs0, TiledTensor& inputs1, TiledTensor& outputs);
@@ -26,6 +29,9 @@ class SmvGreaterEqualOp : public GreaterEqualOp<SmvBackend> {
     using GreaterEqualOp<SmvBackend>::GreaterEqualOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
 
   protected:
    void runX(TiledTensor& inputs0, TiledTensor& inputs1, TiledTensor& outputs);
@@ -1,9 +1,14 @@
+#include <algorithm>
+
 #include "smaug/core/backend.h"
 #include "smaug/operators/common.h"
 #include "smaug/operators/smv/smv_inner_product_op.h"
 #include "smaug/operators/smv/smv_inner_product_tiling.h"
 #include "smaug/operators/smv/smv_kernels.h"
 #include "smaug/operators/smv/smv_accel_pool.h"
+#include "smaug/operators/smv/smv_cycle_model.h"
+#include "smaug/operators/smv/smv_double_buffer.h"
+#include "smaug/operators/smv/smv_tiling_common.h"
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
@@ -20,131 +25,227 @@ const int kNumMaccsPerPE = 32;
 // tile triplet to the hardware kernel for computation. The tile iteration is in
 // the following order:
 // 1) N: batch-wise tiles in the inputs.
-// 2) W: neuron-wise tiles in the weights.
-// 3) A: activation-wise tiles in the inputs/weights.
+// 2) W: neuron-wise tiles in the weights, and the outputs if they are tiled.
+// 3) A: activation-wise tiles in the inputs/weights, forwards or backwards
+//    depending on the tiles that the accelerator holds.
+// If the outputs are tiled, N and W are independent and may be swapped, so
+// that every weight tile is used for all the batch-wise tiles in a row.
 void SmvInnerProductOp::runNWA(TiledTensor& inputs,
                                TiledTensor& weights,
                                TiledTensor& outputs) {
-    // Ordinarily, we don't need to tile the outputs. If this fails, it means
-    // the inner product has uncommonly large outputs, let's add the output
-    // iteration when that happens.
-    assert(outputs.size() == 1 &&
-           "Inner product outputs tiling not implemented yet!");
     int inputNumTiles = inputs.getShape()[0];
     int inputActTiles = inputs.getShape()[1];
     int weightActTiles = weights.getShape()[1];
     int weightNeuronTiles = weights.getShape()[0];
+    // Usually the outputs fit in the scratchpad. Otherwise, the tiling
+    // optimizer tiles them neuron-wise in the same way as the weights, so that
+    // every weight tile produces its own output tile.
+    int outputNeuronTiles = outputs.getShape()[1];
+    assert(outputs.getShape()[0] == inputNumTiles);
+    assert(outputNeuronTiles == 1 || outputNeuronTiles == weightNeuronTiles);
+    bool outputsTiled = outputNeuronTiles > 1;
     auto inputIdx = inputs.startIndex();
     auto weightIdx = weights.startIndex();
     auto outputIdx = outputs.startIndex();
-    for (int i = 0; i < numAcceleratorsAvailable; i++) {
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = smv::kInnerProductHw + firstAccelIdx;
+    SmvAcceleratorPool accelPool(numAccels);
+    std::vector<int> lastReadInputTileIdx(numAccels, -1);
+    std::vector<int> lastReadWeightTileIdx(numAccels, -1);
+    accelPool.setLastReadWeightTiles(&lastReadWeightTileIdx);
+    // If the inputs are forwarded from the previous operator, the only input
+    // tile is already in that operator's results spad, so we use it as our
+    // input spad and put our results in spad0 instead.
+    bool inputsOnChip = getFusedProducer() != nullptr;
+    bool outputsOnChip = getFusedConsumer() != nullptr;
+    float* inputsSpad = inputsOnChip ? smv::spad2 : smv::spad0;
+    float* resultsSpad = inputsOnChip ? smv::spad0 : smv::spad2;
+    if (inputsOnChip)
+        lastReadInputTileIdx[0] = 0;
+    bool doubleBuffered = isDoubleBuffered();
+    SmvDoubleBuffer doubleBuffer(
+            &accelPool, numAccels, inputsSpad, smv::spad1, resultsSpad);
+    for (int i = 0; i < numAccels; i++) {
         setArrayMemTypeIfSimulating(
-                smv::kInnerProductHw + i, "host_a", getInputsMemType());
+                accelId + i, "host_a", getInputsMemType());
         setArrayMemTypeIfSimulating(
-                smv::kInnerProductHw + i, "host_b", getWeightsMemType());
+                accelId + i, "host_b", getWeightsMemType());
         setArrayMemTypeIfSimulating(
-                smv::kInnerProductHw + i, "host_results", getOutputsMemType());
+                accelId + i, "host_results", getOutputsMemType());
+        if (doubleBuffered) {
+            setArrayMemTypeIfSimulating(
+                    accelId + i, "host_next_a", getInputsMemType());
+            setArrayMemTypeIfSimulating(
+                    accelId + i, "host_next_b", getWeightsMemType());
+            setArrayMemTypeIfSimulating(
+                    accelId + i, "host_last_results", getOutputsMemType());
+        }
     }
-    SmvAcceleratorPool accelPool(numAcceleratorsAvailable);
-    std::vector<int> lastReadInputTileIdx(numAcceleratorsAvailable, -1);
+    smv::TileLoopOrder order = tileLoopOrder;
+    if (order == smv::AutoTileLoopOrder)
+        order = chooseTileLoopOrder(inputs, weights, outputs);
+    dout(1) << "Tile loop order: " << order << "\n";
+    // If the outputs are not tiled, all the neuron-wise tiles of the weights
+    // put their results in the same output tile. This keeps track of finished
+    // neurons and will be used by the kernel for correct offset in the
+    // outputs scratchpad.
+    int finishedNeurons = 0;
     int currAccelIdx = 0;
-    for (int N = 0; N < inputNumTiles; N++) {
-        // Usually we are constrained by weights whereas outputs can fit in the
-        // scratchpad. This keeps track of finished neurons and will be used by
-        // the kernel for correct offset in the outputs scratchpad.
-        int finishedNeurons = 0;
-        for (int W = 0; W < weightNeuronTiles; W++) {
-            // Up to this point, the loop nests do not have data dependency
-            // among themselves, and therefore we can run them in parallel. The
-            // loop nests beyond this level will need to run in serial, because
-            // the input/weight channelwise tiles iteration accumulate results
-            // to the same output tile.
-            int outputTileIdx = outputIdx(N, 0);
-            Tensor* outputTile = outputs[outputTileIdx];
-            const TensorShape& outputShape = outputTile->getShape();
-            mapArrayToAccel(smv::kInnerProductHw + currAccelIdx, "host_results",
-                            outputTile->data<float16>(),
-                            outputShape.storageSize() * sizeof(float16));
-            int iC = 0, wC = 0;
-            // This keeps track of the activation offset of the inputs.
-            int actOffset = 0;
-            while (iC < inputActTiles && wC < weightActTiles) {
-                int inputTileIdx = inputIdx(N, iC);
-                int weightTileIdx = weightIdx(W, wC);
-                // There is one condition on which the input tile has different
-                // number of activations from the weight tile: the inputs don't
-                // need tiling on activations while the weights do. In that
-                // case, we send the input tile once and keep the input tile
-                // stationary in the scrachpad, finishing the weight
-                // activation-wise tiles with multiple invocations.
-                dout(1) << "Input: " << inputTileIdx
-                        << ", weights: " << weightTileIdx
-                        << ", output: " << outputTileIdx << "\n";
-                Tensor* inputTile = inputs.getTileWithData(inputTileIdx);
-                Tensor* weightsTile = weights.getTileWithData(weightTileIdx);
-                const TensorShape& inputShape = inputTile->getShape();
-                const TensorShape& weightsShape = weightsTile->getShape();
-                mapArrayToAccel(smv::kInnerProductHw + currAccelIdx, "host_a",
+    for (const auto& unit : getWorkUnits(order, inputs, weights, outputs)) {
+        int N = unit.first;
+        int W = unit.second;
+        // The work units do not have data dependency among themselves if
+        // every neuron-wise tile has its own output tile, and therefore we
+        // can run them in parallel. Otherwise, the
+        // output tile is only finished in the results spad of one
+        // accelerator, so it gets all the neuron-wise tiles. The loop
+        // nests beyond this level will need to run in serial, because the
+        // input/weight channelwise tiles iteration accumulate results to
+        // the same output tile.
+        if (outputsTiled || W == 0) {
+            currAccelIdx = accelPool.getNextAvailableAccelerator(
+                    getAcceleratorWork(weights, outputsTiled, W));
+            finishedNeurons = 0;
+        }
+        // Outside of simulation, the kernels of all the accelerators run
+        // on the same scratchpads, so a tile is only still there if the
+        // last kernel of any accelerator read it.
+        int spadOwner = getSpadOwner(currAccelIdx);
+        int outputTileIdx = outputIdx(N, outputsTiled ? W : 0);
+        Tensor* outputTile = outputs[outputTileIdx];
+        const TensorShape& outputShape = outputTile->getShape();
+        // This keeps track of the activation offset of the inputs.
+        int actOffset = 0;
+        // There is one condition on which the input tile has different
+        // number of activations from the weight tile: the inputs don't
+        // need tiling on activations while the weights do. In that case,
+        // we send the input tile once and keep the input tile stationary
+        // in the scrachpad, finishing the weight activation-wise tiles
+        // with multiple invocations. Otherwise, the steps can go in
+        // either order, and we go backwards if this accelerator still
+        // holds the tiles of the last step from its previous work unit.
+        std::vector<std::pair<int, int>> steps =
+                smv::getChannelSteps(inputActTiles, weightActTiles);
+        if (inputActTiles == weightActTiles &&
+            smv::reverseChannelSteps(
+                    { inputIdx(N, steps.front().first),
+                      weightIdx(W, steps.front().second) },
+                    { inputIdx(N, steps.back().first),
+                      weightIdx(W, steps.back().second) },
+                    { lastReadInputTileIdx[spadOwner],
+                      lastReadWeightTileIdx[spadOwner] })) {
+            std::reverse(steps.begin(), steps.end());
+        }
+        for (int step = 0; step < steps.size(); step++) {
+            int iC = steps[step].first;
+            int wC = steps[step].second;
+            int inputTileIdx = inputIdx(N, iC);
+            int weightTileIdx = weightIdx(W, wC);
+            dout(1) << "Input: " << inputTileIdx
+                    << ", weights: " << weightTileIdx
+                    << ", output: " << outputTileIdx << "\n";
+            Tensor* inputTile = inputs.getTileWithData(inputTileIdx);
+            Tensor* weightsTile = weights.getTileWithData(weightTileIdx);
+            const TensorShape& inputShape = inputTile->getShape();
+            const TensorShape& weightsShape = weightsTile->getShape();
+            int inputDims[2] = { inputShape[0], inputShape[1] };
+            int weightsDims[2] = { weightsShape[0], weightsShape[1] };
+            int outputDims[2] = { outputShape[0], outputShape[1] };
+            // If the input and weight tiles belong to the same channel
+            // group, then their data will be loaded at the same time into
+            // the spads, so we start from the beginning of the tile.
+            // Otherwise, we start from the last place we left off from.
+            int actStart = (iC == wC) ? 0 : actOffset;
+            // If the weights are tiled on activations, this should be set
+            // to true for non-first steps to avoid resetting the result
+            // buffer.
+            bool accumulate = step > 0;
+            // If this is a new input/weight tile, then we need to read it.
+            bool readInputs = false;
+            if (inputTileIdx != lastReadInputTileIdx[spadOwner]) {
+                readInputs = true;
+                lastReadInputTileIdx[spadOwner] = inputTileIdx;
+            }
+            bool readWeights = false;
+            if (weightTileIdx != lastReadWeightTileIdx[spadOwner]) {
+                readWeights = true;
+                lastReadWeightTileIdx[spadOwner] = weightTileIdx;
+            }
+            // We only need to send the results back to host memory in the
+            // last invocation for the output tile, and not at all if the
+            // next operator reads them from the results spad.
+            bool finishOutputs =
+                    (outputsTiled || W == weightNeuronTiles - 1) &&
+                    (step == steps.size() - 1);
+            bool sendOutputs = finishOutputs && !outputsOnChip;
+
+            // This maps the tiles to the accelerator and invokes the
+            // kernel. With double buffering, it only runs once the next
+            // invocation on this accelerator is known.
+            auto launch = [=, &accelPool](SpadAssignment& spads) mutable {
+                unsigned reqCode = accelId + currAccelIdx;
+                mapArrayToAccel(reqCode, "host_a",
                                 inputTile->data<float16>(),
                                 inputShape.storageSize() * sizeof(float16));
-                mapArrayToAccel(smv::kInnerProductHw + currAccelIdx, "host_b",
-                                weightsTile->data<float16>(),
-                                weightsShape.storageSize() * sizeof(float16));
-                int inputDims[2] = { inputShape[0], inputShape[1] };
-                int weightsDims[2] = { weightsShape[0], weightsShape[1] };
-                int outputDims[2] = { outputShape[0], outputShape[1] };
-                // If the input and weight tiles belong to the same channel
-                // group, then their data will be loaded at the same time into
-                // the spads, so we start from the beginning of the tile.
-                // Otherwise, we start from the last place we left off from.
-                int actStart = (iC == wC) ? 0 : actOffset;
-                // If the weights are tiled on activations, this should be set
-                // to true for non-first weight tiles to avoid resetting the
-                // result buffer.
-                bool accumulate = wC > 0;
-                // If this is a new input tile, then we need to read it.
-                bool readInputs = false;
-                if (inputTileIdx != lastReadInputTileIdx[currAccelIdx]) {
-                    readInputs = true;
-                    lastReadInputTileIdx[currAccelIdx] = inputTileIdx;
-                }
-                // We only need to send the results back to host memory in the
-                // very last invocation.
-                bool sendOutputs = (N == inputNumTiles - 1) &&
-                                   (W == weightNeuronTiles - 1) &&
-                                   (wC == weightActTiles - 1);
-
-                std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
-                        currAccelIdx, smv::kInnerProductHw + currAccelIdx,
+                mapArrayToAccel(
+                        reqCode, "host_b", weightsTile->data<float16>(),
+                        weightsShape.storageSize() * sizeof(float16));
+                mapArrayToAccel(
+                        reqCode, "host_results",
+                        outputTile->data<float16>(),
+                        outputShape.storageSize() * sizeof(float16));
+                mapDoubleBufferArrays(
+                        reqCode, spads, "host_next_a", "host_next_b");
+                accelPool.addEstimatedCycles(
+                        currAccelIdx,
+                        smv::getInvocationCost(
+                                spads, inputShape, weightsShape,
+                                outputShape,
+                                smv::fc::getComputeCycles(inputShape,
+                                                          weightsShape))
+                                .getCycles());
+                return invokeKernelNoBlock(
+                        firstAccelIdx + currAccelIdx, reqCode,
                         smv_matrix_multiply_transpose_nc_vec_fxp,
                         inputTile->data<float16>(),
                         weightsTile->data<float16>(),
-                        outputTile->data<float16>(), smv::spad0, smv::spad1,
-                        smv::spad2, inputDims, weightsDims, outputDims,
-                        inputShape.getPadding(1), weightsShape.getPadding(1),
-                        outputShape.getPadding(1), actStart, finishedNeurons,
-                        accumulate, readInputs, sendOutputs, actInfo.function,
-                        actInfo.params, &sampling);
-                accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
-
-                actOffset += weightsTile->getShape()[1];
-                if (inputActTiles == weightActTiles) {
-                    iC++;
-                    wC++;
-                } else if (inputActTiles == 1) {
-                    wC++;
-                } else {
-                    assert(false && "The input/weight tiles can have different "
-                                    "number of channels only when the inputs "
-                                    "don't need activation-wise tiling.");
-                }
+                        outputTile->data<float16>(), spads.inputs,
+                        spads.weights, spads.results, inputDims,
+                        weightsDims, outputDims, inputShape.getPadding(1),
+                        weightsShape.getPadding(1),
+                        outputShape.getPadding(1), actStart,
+                        finishedNeurons, accumulate, spads.readInputs,
+                        spads.readWeights, finishOutputs,
+                        spads.sendResults, actInfo.function,
+                        actInfo.params, spads.hostNextInputs,
+                        spads.hostNextWeights, spads.hostLastResults,
+                        spads.nextInputs, spads.nextWeights,
+                        spads.lastResults, spads.transferSizes,
+                        &sampling);
+            };
+            if (doubleBuffered) {
+                doubleBuffer.submit(currAccelIdx,
+                                    { inputTileIdx, inputTile },
+                                    { weightTileIdx, weightsTile },
+                                    { outputTileIdx, outputTile },
+                                    sendOutputs,
+                                    launch);
+            } else {
+                SpadAssignment spads(inputsSpad, smv::spad1, resultsSpad,
+                                     readInputs, readWeights, sendOutputs);
+                accelPool.addFinishFlag(currAccelIdx, launch(spads));
             }
-            finishedNeurons += weights[weightIdx(W, 0)]->getShape()[0];
-            currAccelIdx = accelPool.getNextAvailableAccelerator(currAccelIdx);
+
+            actOffset += weightsTile->getShape()[1];
         }
+        finishedNeurons += weights[weightIdx(W, 0)]->getShape()[0];
     }
     // Before we leave, make sure all the accelerators have finished.
+    if (doubleBuffered)
+        doubleBuffer.flush();
     accelPool.joinAll();
+    setEstimatedCycles(accelPool.getEstimatedCycles());
 }
 
 void SmvInnerProductOp::tile() {
@@ -154,6 +255,170 @@ void SmvInnerProductOp::tile() {
     tiledTensors = smaug::smv::fc::TilingOptimizer::doTiling(this);
 }
 
+std::vector<std::pair<int, int>> SmvInnerProductOp::getWorkUnits(
+        smv::TileLoopOrder order,
+        TiledTensor& inputs,
+        TiledTensor& weights,
+        TiledTensor& outputs) {
+    int inputNumTiles = inputs.getShape()[0];
+    int weightNeuronTiles = weights.getShape()[0];
+    if (outputs.getShape()[1] > 1)
+        return smv::getWorkUnitOrder(order, inputNumTiles, weightNeuronTiles);
+    std::vector<std::pair<int, int>> units;
+    for (int N = 0; N < inputNumTiles; N++) {
+        for (int W = 0; W < weightNeuronTiles; W++)
+            units.emplace_back(N, W);
+    }
+    return units;
+}
+
+AcceleratorWork SmvInnerProductOp::getAcceleratorWork(TiledTensor& weights,
+                                                      bool outputsTiled,
+                                                      int W) {
+    auto weightIdx = weights.startIndex();
+    int weightActTiles = weights.getShape()[1];
+    int lastW = outputsTiled ? W + 1 : weights.getShape()[0];
+    // Every weight is used once per input row, so the weight tiles this
+    // accelerator will read give the cost.
+    AcceleratorWork work;
+    work.cost = 0;
+    for (int w = W; w < lastW; w++) {
+        for (int wC = 0; wC < weightActTiles; wC++)
+            work.cost += weights[weightIdx(w, wC)]->getShape().size();
+    }
+    work.weightTileIdx = weightIdx(W, 0);
+    return work;
+}
+
+void SmvInnerProductOp::forEachTileInvocation(
+        smv::TileLoopOrder order,
+        TiledTensor& inputs,
+        TiledTensor& weights,
+        TiledTensor& outputs,
+        const std::function<void(int, int, int, int)>& visit) {
+    // This follows runNWA() without running the kernels.
+    int inputActTiles = inputs.getShape()[1];
+    int weightActTiles = weights.getShape()[1];
+    bool outputsTiled = outputs.getShape()[1] > 1;
+    auto inputIdx = inputs.startIndex();
+    auto weightIdx = weights.startIndex();
+    auto outputIdx = outputs.startIndex();
+    int numAccels = getNumAccelerators();
+    // The work units go to the accelerators through a pool with the same
+    // dispatch policy and work costs as in runNWA(). No accelerator is ever
+    // busy here, so the polling policy hands out the work in turn, as it
+    // does outside of simulation.
+    SmvAcceleratorPool accelPool(numAccels);
+    std::vector<int> lastReadInputTileIdx(numAccels, -1);
+    std::vector<int> lastReadWeightTileIdx(numAccels, -1);
+    accelPool.setLastReadWeightTiles(&lastReadWeightTileIdx);
+    if (getFusedProducer() != nullptr)
+        lastReadInputTileIdx[0] = 0;
+    int currAccelIdx = 0;
+    for (const auto& unit : getWorkUnits(order, inputs, weights, outputs)) {
+        int N = unit.first;
+        int W = unit.second;
+        if (outputsTiled || W == 0) {
+            currAccelIdx = accelPool.getNextAvailableAccelerator(
+                    getAcceleratorWork(weights, outputsTiled, W));
+        }
+        int spadOwner = getSpadOwner(currAccelIdx);
+        int outputTileIdx = outputIdx(N, outputsTiled ? W : 0);
+        std::vector<std::pair<int, int>> steps =
+                smv::getChannelSteps(inputActTiles, weightActTiles);
+        if (inputActTiles == weightActTiles &&
+            smv::reverseChannelSteps(
+                    { inputIdx(N, steps.front().first),
+                      weightIdx(W, steps.front().second) },
+                    { inputIdx(N, steps.back().first),
+                      weightIdx(W, steps.back().second) },
+                    { lastReadInputTileIdx[spadOwner],
+                      lastReadWeightTileIdx[spadOwner] })) {
+            std::reverse(steps.begin(), steps.end());
+        }
+        for (const auto& step : steps) {
+            int inputTileIdx = inputIdx(N, step.first);
+            int weightTileIdx = weightIdx(W, step.second);
+            visit(currAccelIdx, inputTileIdx, weightTileIdx, outputTileIdx);
+            lastReadInputTileIdx[spadOwner] = inputTileIdx;
+            lastReadWeightTileIdx[spadOwner] = weightTileIdx;
+        }
+    }
+}
+
+uint64_t SmvInnerProductOp::estimateTileLoadBytes(smv::TileLoopOrder order,
+                                                  TiledTensor& inputs,
+                                                  TiledTensor& weights,
+                                                  TiledTensor& outputs) {
+    // A tile that the accelerator still holds from its previous invocation
+    // is not loaded again.
+    int numAccels = getNumAccelerators();
+    std::vector<int> lastReadInputTileIdx(numAccels, -1);
+    std::vector<int> lastReadWeightTileIdx(numAccels, -1);
+    if (getFusedProducer() != nullptr)
+        lastReadInputTileIdx[0] = 0;
+    uint64_t bytes = 0;
+    forEachTileInvocation(
+            order, inputs, weights, outputs,
+            [&](int accelIdx, int inputTileIdx, int weightTileIdx, int) {
+                int spadOwner = getSpadOwner(accelIdx);
+                if (inputTileIdx != lastReadInputTileIdx[spadOwner]) {
+                    bytes += inputs[inputTileIdx]->getShape().storageSize() *
+                             sizeof(float16);
+                    lastReadInputTileIdx[spadOwner] = inputTileIdx;
+                }
+                if (weightTileIdx != lastReadWeightTileIdx[spadOwner]) {
+                    bytes += weights[weightTileIdx]->getShape().storageSize() *
+                             sizeof(float16);
+                    lastReadWeightTileIdx[spadOwner] = weightTileIdx;
+                }
+            });
+    return bytes;
+}
+
+smv::TileLoopOrder SmvInnerProductOp::chooseTileLoopOrder(
+        TiledTensor& inputs, TiledTensor& weights, TiledTensor& outputs) {
+    uint64_t inputStationaryBytes = estimateTileLoadBytes(
+            smv::InputStationary, inputs, weights, outputs);
+    uint64_t weightStationaryBytes = estimateTileLoadBytes(
+            smv::WeightStationary, inputs, weights, outputs);
+    dout(1) << "Estimated tile loads: " << inputStationaryBytes
+            << " bytes input stationary, " << weightStationaryBytes
+            << " bytes weight stationary.\n";
+    // Ties keep the input stationary order, which is the plain N -> W order
+    // apart from the serpentine W.
+    return weightStationaryBytes < inputStationaryBytes ? smv::WeightStationary
+                                                        : smv::InputStationary;
+}
+
+std::vector<std::vector<int>> SmvInnerProductOp::getTileInvocations() {
+    smv::TileLoopOrder order = tileLoopOrder;
+    if (order == smv::AutoTileLoopOrder) {
+        order = chooseTileLoopOrder(
+                tiledTensors[0], tiledTensors[1], tiledTensors[2]);
+    }
+    std::vector<std::vector<int>> invocations;
+    forEachTileInvocation(
+            order, tiledTensors[0], tiledTensors[1], tiledTensors[2],
+            [&](int, int inputTileIdx, int weightTileIdx, int outputTileIdx) {
+                invocations.push_back(
+                        { inputTileIdx, weightTileIdx, outputTileIdx });
+            });
+    return invocations;
+}
+
+bool SmvInnerProductOp::canForwardOutputOnChip() const {
+    // The output must be in one tile, and the results of different
+    // neuron-wise weight tiles only end up in the same spad on a single
+    // accelerator.
+    return getNumAccelerators() == 1 && tiledTensors[2].size() == 1;
+}
+
+bool SmvInnerProductOp::canReadInputOnChip(TensorBase* input) const {
+    return getNumAccelerators() == 1 && input == inputs.at(Inputs) &&
+           tiledTensors[0].size() == 1;
+}
+
 void SmvInnerProductOp::run() {
     auto inputs = getInput(Inputs);
     auto weights = getInput(Weights);
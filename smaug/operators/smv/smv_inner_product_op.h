@@ -1,9 +1,14 @@
 #ifndef _OPERATORS_SMV_SMV_INNER_PRODUCT_OP_H_
 #define _OPERATORS_SMV_SMV_INNER_PRODUCT_OP_H_
 
+#include <functional>
+
 #include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
 #include "smaug/operators/common.h"
 #include "smaug/operators/inner_product_op.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
+#include "smaug/operators/smv/smv_tiling_common.h"
 
 namespace smaug {
 
@@ -30,12 +35,84 @@ class SmvInnerProductOp : public InnerProductOp<SmvBackend> {
     using InnerProductOp<SmvBackend>::InnerProductOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
+    std::vector<std::vector<int>> getTileInvocations() override;
+    bool canForwardOutputOnChip() const override;
+    bool canReadInputOnChip(TensorBase* input) const override;
     friend class smv::fc::TilingOptimizer;
 
+    /**
+     * Sets the order of the independent work units. By default, the order is
+     * picked per layer to load the fewest input and weight bytes.
+     */
+    void setTileLoopOrder(smv::TileLoopOrder order) { tileLoopOrder = order; }
+
+    /**
+     * Returns true if the kernels double-buffer the scratchpads, so the tiles
+     * may only take half a scratchpad. Fused operators hand their data over
+     * in whole scratchpads, so they don't.
+     */
+    bool isDoubleBuffered() const {
+        return doubleBufferSpadsWhenPossible && !getFusedProducer() &&
+               !getFusedConsumer();
+    }
+
   protected:
    void runNWA(TiledTensor& inputs, TiledTensor& weights, TiledTensor& outputs);
+   /**
+    * Returns the index of the scratchpads the given accelerator computes on.
+    * Outside of simulation, the kernels of all the accelerators run on the
+    * same scratchpads.
+    */
+   int getSpadOwner(int accelIdx) const {
+       return runningInSimulation ? accelIdx : 0;
+   }
+   /**
+    * Returns the (batch-wise, neuron-wise) tile indices of the work units in
+    * the given loop order. Only tiled outputs make the neuron-wise tiles of
+    * different batch-wise tiles independent; otherwise all the neuron-wise
+    * tiles of a batch-wise tile finish one output tile in turn.
+    */
+   std::vector<std::pair<int, int>> getWorkUnits(smv::TileLoopOrder order,
+                                                 TiledTensor& inputs,
+                                                 TiledTensor& weights,
+                                                 TiledTensor& outputs);
+   /**
+    * Returns the work of the accelerator that starts at the given
+    * neuron-wise tile.
+    */
+   AcceleratorWork getAcceleratorWork(TiledTensor& weights,
+                                      bool outputsTiled,
+                                      int W);
+   /**
+    * Calls the given function with the accelerator and the input, weight and
+    * output tile indices of every kernel invocation of runNWA() with the
+    * given loop order, dispatching the work units to the accelerators the
+    * same way.
+    */
+   void forEachTileInvocation(
+           smv::TileLoopOrder order,
+           TiledTensor& inputs,
+           TiledTensor& weights,
+           TiledTensor& outputs,
+           const std::function<void(int, int, int, int)>& visit);
+   /**
+    * Estimates the bytes of input and weight tiles that runNWA() loads into
+    * the scratchpads with the given loop order.
+    */
+   uint64_t estimateTileLoadBytes(smv::TileLoopOrder order,
+                                  TiledTensor& inputs,
+                                  TiledTensor& weights,
+                                  TiledTensor& outputs);
+   /** Returns the loop order with the fewest estimated bytes loaded. */
+   smv::TileLoopOrder chooseTileLoopOrder(TiledTensor& inputs,
+                                          TiledTensor& weights,
+                                          TiledTensor& outputs);
 
    std::array<TiledTensor, 3> tiledTensors;
+   smv::TileLoopOrder tileLoopOrder = smv::AutoTileLoopOrder;
 };
 
 }  // namespace smaug
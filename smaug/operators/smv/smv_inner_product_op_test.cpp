@@ -36,8 +36,12 @@ class SmvInnerProductOpTest : public SmaugTest {
         return convertFp32ToFp16Tensor(refOutput, workspace());
     }
 
-    void doTest(std::vector<int> inputDims, int numNeurons) {
+    SmvInnerProductOp* doTest(
+            std::vector<int> inputDims,
+            int numNeurons,
+            smv::TileLoopOrder order = smv::AutoTileLoopOrder) {
         auto fcOp = new SmvInnerProductOp("fc", workspace());
+        fcOp->setTileLoopOrder(order);
         TensorShape inputShape(
                 inputDims, DataLayout::NC, SmvBackend::Alignment);
         Tensor* inputs = new Tensor("input", inputShape);
@@ -51,6 +55,7 @@ class SmvInnerProductOpTest : public SmaugTest {
         auto outputs = fcOp->getOutput(0);
         auto refOutputs = getReferenceOutput(fcOp);
         verifyOutputs<float16>(outputs, refOutputs);
+        return fcOp;
     }
 
     void doFusionTest(
@@ -98,6 +103,89 @@ TEST_CASE_METHOD(SmvInnerProductOpTest, "SMV tiled inner product", "[smvfc]") {
         // also tiled into 32 neuron-wise tiles.
         doTest({ 1, 32768 }, 256);
     }
+
+    SECTION("DimNC tiling for outputs") {
+        // The outputs don't fit, so they are tiled along with the 512
+        // neuron-wise weight tiles.
+        doTest({ 1, 256 }, 32768);
+    }
+
+    SECTION("DimNC tiling for outputs on 4 accelerators") {
+        numAcceleratorsAvailable = 4;
+        doTest({ 2, 256 }, 16384);
+    }
+}
+
+TEST_CASE_METHOD(SmvInnerProductOpTest,
+                 "SMV inner product on multiple accelerators",
+                 "[smvfc]") {
+    // Outside of simulation, the accelerators share the scratchpads, so an
+    // input tile one of them read may have been overwritten by another.
+    numAcceleratorsAvailable = 3;
+    SECTION("DimNC tiling for weights, None for inputs") {
+        doTest({ 1, 4096 }, 128);
+    }
+    SECTION("DimNC tiling for weights and inputs") {
+        doTest({ 2, 32768 }, 256);
+    }
+    SECTION("DimNC tiling for outputs") { doTest({ 2, 256 }, 16384); }
+    SECTION("DimNC tiling for inputs and outputs") {
+        // With small scratchpads, the input tile of one accelerator is
+        // replaced by another one's before it is read again.
+        SmvBackend::freeGlobals();
+        SmvBackend::initGlobals(4 * 1024);
+        doTest({ 1, 4096 }, 4096);
+    }
+}
+
+TEST_CASE_METHOD(SmvInnerProductOpTest,
+                 "SMV inner product tile loop orders",
+                 "[smvfc]") {
+    // The inputs have an 8-row and a 2-row batch-wise tile, and the weights
+    // and outputs 128 neuron-wise tiles of 8 neurons.
+    SmvBackend::freeGlobals();
+    SmvBackend::initGlobals(4 * 1024);
+    SECTION("Input stationary") {
+        doTest({ 10, 256 }, 1024, smv::InputStationary);
+    }
+    SECTION("Weight stationary") {
+        doTest({ 10, 256 }, 1024, smv::WeightStationary);
+    }
+    SECTION("Weight stationary on multiple accelerators") {
+        numAcceleratorsAvailable = 3;
+        doTest({ 10, 256 }, 1024, smv::WeightStationary);
+    }
+    SECTION("Weight stationary with double-buffered scratchpads") {
+        doubleBufferSpadsWhenPossible = true;
+        doTest({ 10, 256 }, 1024, smv::WeightStationary);
+    }
+    SECTION("The order that loads fewer bytes is picked") {
+        // The weight tiles are larger than the average input tile, so every
+        // weight tile is used for both batch-wise tiles in a row.
+        SmvInnerProductOp* fcOp = doTest({ 10, 256 }, 1024);
+        int numWeightTiles = fcOp->getTiledTensors()[1]->size();
+        std::vector<std::vector<int>> invocations = fcOp->getTileInvocations();
+        REQUIRE(invocations.size() == 2 * numWeightTiles);
+        int weightTileChanges = 0;
+        for (int i = 1; i < invocations.size(); i++) {
+            if (invocations[i][1] != invocations[i - 1][1])
+                weightTileChanges++;
+        }
+        REQUIRE(weightTileChanges == numWeightTiles - 1);
+    }
+}
+
+TEST_CASE_METHOD(SmvInnerProductOpTest,
+                 "SMV inner product with double-buffered scratchpads",
+                 "[smvfc]") {
+    doubleBufferSpadsWhenPossible = true;
+    SECTION("DimN tiling for weights, None for inputs") {
+        doTest({ 1, 256 }, 128);
+    }
+    SECTION("DimNC tiling for weights and inputs") {
+        doTest({ 1, 32768 }, 256);
+    }
+    SECTION("DimNC tiling for outputs") { doTest({ 2, 256 }, 16384); }
 }
 
 TEST_CASE_METHOD(SmvInnerProductOpTest,
@@ -23,6 +23,10 @@ std::array<TilingDims, 3> TilingOptimizer::determineBestTilingDims(
 
     // Apply some constraints to simplify tiling logic.
     //
+    // If outputs require tiling, then weights must be tiled on neurons, so
+    // that every weight tile produces the neurons of one output tile.
+    if (bestOutputTilingDims != None && bestWeightTilingDims == None)
+        bestWeightTilingDims = DimN;
     // If weights require tiling on neurons, then outputs must be DimNC (if
     // outputs require tiling), so that we will copy out C neurons of outputs
     // after every tile.
@@ -37,6 +41,8 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
     Tensor* weights = op->getInput(op->Weights);
     Tensor* outputs = op->getOutput(op->Outputs);
     int maxTileSize = SmvBackend::SpadSize() / inputs->getDataTypeSize();
+    if (op->isDoubleBuffered())
+        maxTileSize /= 2;
     std::array<TilingDims, 3> strategies =
             determineBestTilingDims(inputs, weights, outputs, maxTileSize);
     TilingDims inputTilingDims = strategies[0];
@@ -58,9 +64,8 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
     // 1. Start with inputs. Enumerate all shapes that fit.
     // 2. Move on to weights. Enumerate all shapes that are compatible with
     //    the input shape and fit.
-    // 3. Move on to outputs. If the weights don't need tiling, the outputs
-    //    can be tiled independently; otherwise, based on the input and weights
-    //    tile shapes, the output tile shape is completely determined.
+    // 3. Move on to outputs. Based on the input and weights tile shapes, the
+    //    output tile shape is completely determined.
     // For all tiling strategy, compute the total SRAM utilization. The highest
     // one is the chosen one.
     std::vector<TensorShape> inputConfigs;
@@ -148,35 +153,20 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
     }
     assert(!inputWeightConfigs.empty() && "No tiling configurations found!");
 
-    // Fill in outputs.
+    // Fill in outputs. The output tile takes the batch size of the input tile
+    // and, if the outputs need tiling, the neurons of the weight tile.
     std::vector<TilingConfig> fullConfigs;
     for (auto it = inputWeightConfigs.begin(); it != inputWeightConfigs.end();
          ++it) {
-        int minChannels = std::min(it->weights[0], kNumPEs);
-        bool weightsNeedTiling = (weightTilingDims != None);
-        bool outputsNeedTiling = (outputTilingDims != None);
-        for (int c = minChannels; c <= weightsShape[0]; c += kNumPEs) {
-            TilingConfig config = *it;
-            config.outputs = outputsShape;
-            config.outputs[0] = config.inputs[0];
-            if (weightsNeedTiling && outputsNeedTiling) {
-                config.outputs[1] = config.weights[0];
-            } else if (outputsNeedTiling) {
-                // This could rarely happen, but for completeness let's keep it.
-                // If the weights don't need tiling and the outputs need tiling,
-                // the channel size of the output tile size can be determined
-                // independently.
-                config.outputs[1] = c;
-            }
-            if (config.outputs.storageSize() <= maxTileSize) {
-                fullConfigs.push_back(config);
-            }
-            // This means the output shape is uniquely determined, so we don't
-            // need to explore any other output channel values.
-            if (weightsNeedTiling || outputTilingDims == None)
-                break;
-        }
+        TilingConfig config = *it;
+        config.outputs = outputsShape;
+        config.outputs[0] = config.inputs[0];
+        if (outputTilingDims != None)
+            config.outputs[1] = config.weights[0];
+        if (config.outputs.storageSize() <= maxTileSize)
+            fullConfigs.push_back(config);
     }
+    tilingSearchStats.configs += fullConfigs.size();
     dout(2) << "  Number of possible tiling configs: " << fullConfigs.size()
             << "\n";
     for (auto& config : fullConfigs)
@@ -202,10 +192,12 @@ std::array<TiledTensor, 3> TilingOptimizer::doTiling(SmvInnerProductOp* op) {
     TilingConfig tileConfig = TilingOptimizer::computeBasicTileShapes(op);
     TiledTensor tiledInputs =
             generateTiledTensor(input, tileConfig.inputs, op, /* copy_data*/ false);
-    // Copy data for the weight tiles since the data is read-only.
+    // Copy data for the weight tiles since the data is read-only, unless it
+    // is loaded on demand or compressed.
     TiledTensor tiledWeights =
             generateTiledTensor(kernels, tileConfig.weights, op);
-    tiledWeights.copyDataToAllTiles();
+    if (!kernels->isDataDeferred())
+        tiledWeights.copyDataToAllTiles();
     TiledTensor tiledOutputs =
             generateTiledTensor(output, tileConfig.outputs, op, /* copy_data */ false);
     return { tiledInputs, tiledWeights, tiledOutputs };
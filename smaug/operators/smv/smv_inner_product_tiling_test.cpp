@@ -71,6 +71,24 @@ TEST_CASE_METHOD(SmaugTest, "Basic tiling tests", "[smvtiling]") {
         }
     }
 
+    SECTION("DimNC tiling for outputs") {
+        TensorShape inputShape(
+                { 1, 256 }, DataLayout::NC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("inputs", inputShape);
+        workspace()->addTensor(inputs);
+        fcOp->setInput(inputs, 0);
+        // The outputs don't fit either, so every weight tile gets its own
+        // output tile.
+        fcOp->setNumOutputs(32768);
+        fcOp->createAllTensors();
+        allocateAllTensors<float16>(fcOp);
+        TilingConfig config = TilingOptimizer::computeBasicTileShapes(fcOp);
+        REQUIRE(config.inputs == inputShape);
+        REQUIRE(config.weights.dims() == std::vector<int>{ 64, 256 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 64 });
+        REQUIRE(config.outputTilingDims == DimNC);
+    }
+
     SECTION("DimNC tiling for weights, None for inputs") {
         // Inputs can all fit.
         TensorShape inputShape(
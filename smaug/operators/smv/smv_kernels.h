@@ -27,11 +27,38 @@ void smv_conv3d_nhwc_vec_fxp(float16* host_inputs,
                              bool accumulate,
                              bool read_inputs,
                              bool read_weights,
+                             bool finish_results,
                              bool send_results,
                              activation_type act_function,
                              activation_param_t act_params,
+                             float16* host_next_inputs,
+                             float16* host_next_weights,
+                             float16* host_last_results,
+                             float* next_inputs,
+                             float* next_weights,
+                             float* last_results,
+                             int transfer_sizes[3],
                              SamplingInfo* sampling);
 
+void smv_depthwise_conv2d_nhwc_vec_fxp(float16* host_inputs,
+                                       float16* host_weights,
+                                       float16* host_results,
+                                       float* inputs,
+                                       float* weights,
+                                       float* results,
+                                       int inputs_dims[4],
+                                       int weights_dims[4],
+                                       int results_dims[4],
+                                       int inputs_align_pad,
+                                       int weights_pad,
+                                       int results_pad,
+                                       int inputs_halo_pad[4],
+                                       int row_stride,
+                                       int col_stride,
+                                       bool read_weights,
+                                       activation_type act_function,
+                                       activation_param_t act_params);
+
 void smv_matrix_multiply_transpose_nc_vec_fxp(float16* host_a,
                                               float16* host_b,
                                               float16* host_results,
@@ -48,9 +75,18 @@ void smv_matrix_multiply_transpose_nc_vec_fxp(float16* host_a,
                                               int result_start,
                                               bool accumulate,
                                               bool read_inputs,
+                                              bool read_weights,
+                                              bool finish_results,
                                               bool send_results,
                                               activation_type act_function,
                                               activation_param_t act_params,
+                                              float16* host_next_a,
+                                              float16* host_next_b,
+                                              float16* host_last_results,
+                                              float* next_a,
+                                              float* next_b,
+                                              float* last_results,
+                                              int transfer_sizes[3],
                                               SamplingInfo* sampling);
 
 void smv_maxpooling_nhwc_vec_fxp(float16* host_inputs,
@@ -66,6 +102,7 @@ void smv_maxpooling_nhwc_vec_fxp(float16* host_inputs,
                                  int row_stride,
                                  int col_stride,
                                  int ofmap_start,
+                                 bool read_inputs,
                                  SamplingInfo* sampling);
 
 void smv_avgpooling_nhwc_vec_fxp(float16* host_inputs,
@@ -81,6 +118,7 @@ void smv_avgpooling_nhwc_vec_fxp(float16* host_inputs,
                                  int row_stride,
                                  int col_stride,
                                  int ofmap_start,
+                                 bool read_inputs,
                                  SamplingInfo* sampling);
 
 void smv_batch_norm_post_fc_nc_vec_fxp(float16* host_inputs,
@@ -132,7 +170,8 @@ void smv_activation_fun_nc_vec_fxp(float16* host_inputs,
                                    float* results,
                                    int inputs_size,
                                    activation_type function,
-                                   activation_param_t params);
+                                   activation_param_t params,
+                                   bool read_inputs);
 
 void smv_softmax_nc_vec_fxp(float16* host_inputs,
                             float16* host_results,
@@ -142,6 +181,23 @@ void smv_softmax_nc_vec_fxp(float16* host_inputs,
                             int input_size,
                             int input_pad);
 
+void smv_softmax_reduce_nc_vec_fxp(float16* host_inputs,
+                                   float* inputs,
+                                   float* stats,
+                                   int input_num,
+                                   int input_size,
+                                   int input_pad,
+                                   bool init_stats);
+
+void smv_softmax_normalize_nc_vec_fxp(float16* host_inputs,
+                                      float16* host_results,
+                                      float* inputs,
+                                      float* results,
+                                      float* stats,
+                                      int input_num,
+                                      int input_size,
+                                      int input_pad);
+
 void smv_eltwise_add_nc_vec_fxp(float16* host_inputs0,
                                 float16* host_inputs1,
                                 float16* host_results,
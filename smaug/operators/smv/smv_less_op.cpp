@@ -2,6 +2,7 @@
 #include "smaug/core/backend.h"
 #include "smaug/operators/common.h"
 #include "smaug/operators/smv/smv_kernels.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
 #include "smaug/operators/smv/smv_unary_op_common.h"
 #include "smaug/utility/debug_stream.h"
 
@@ -12,13 +13,22 @@ void SmvLessOp::runX(TiledTensor& inputs0,
                      TiledTensor& outputs) {
     assert(inputs0.size() == inputs1.size() &&
            inputs0.size() == outputs.size());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_inputs0", getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_inputs1", getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_results", getOutputsMemType());
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = smv::kEltwiseOpHw + firstAccelIdx;
+    for (int i = 0; i < numAccels; i++) {
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs0", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs1", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_results", getOutputsMemType());
+    }
+    SmvAcceleratorPool accelPool(numAccels);
     for (int i = 0; i < inputs0.size(); i++) {
+        AcceleratorWork work;
+        work.cost = outputs[i]->getShape().size();
+        int currAccelIdx = accelPool.getNextAvailableAccelerator(work);
         dout(1) << "Input0: " << i << ", input1: " << i << ", output: " << i
                 << "\n";
         Tensor* input0Tile = inputs0.getTileWithData(i);
@@ -26,22 +36,26 @@ void SmvLessOp::runX(TiledTensor& inputs0,
         Tensor* outputTile = outputs[i];
         const TensorShape& inputShape = input0Tile->getShape();
         const TensorShape& outputShape = outputTile->getShape();
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_inputs0",
+        mapArrayToAccel(accelId + currAccelIdx, "host_inputs0",
                         input0Tile->data<float16>(),
                         inputShape.storageSize() * sizeof(float16));
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_inputs1",
+        mapArrayToAccel(accelId + currAccelIdx, "host_inputs1",
                         input1Tile->data<float16>(),
                         inputShape.storageSize() * sizeof(float16));
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_results",
+        mapArrayToAccel(accelId + currAccelIdx, "host_results",
                         outputTile->data<bool>(),
                         outputShape.storageSize() * sizeof(bool));
 
-        invokeKernel(smv::kEltwiseOpHw, smv_less_nc_vec_fxp,
-                     input0Tile->data<float16>(), input1Tile->data<float16>(),
-                     outputTile->data<bool>(), smv::spad0, smv::spad1,
-                     reinterpret_cast<bool*>(smv::spad2),
-                     inputShape.storageSize());
+        std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
+                firstAccelIdx + currAccelIdx, accelId + currAccelIdx,
+                smv_less_nc_vec_fxp,
+                input0Tile->data<float16>(), input1Tile->data<float16>(),
+                outputTile->data<bool>(), smv::spad0, smv::spad1,
+                reinterpret_cast<bool*>(smv::spad2),
+                inputShape.storageSize());
+        accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
     }
+    accelPool.joinAll();
 }
 
 void SmvLessOp::tile() {
@@ -93,13 +107,22 @@ void SmvLessEqualOp::runX(TiledTensor& inputs0,
                           TiledTensor& outputs) {
     assert(inputs0.size() == inputs1.size() &&
            inputs0.size() == outputs.size());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_inputs0", getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_inputs1", getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_results", getOutputsMemType());
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = smv::kEltwiseOpHw + firstAccelIdx;
+    for (int i = 0; i < numAccels; i++) {
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs0", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs1", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_results", getOutputsMemType());
+    }
+    SmvAcceleratorPool accelPool(numAccels);
     for (int i = 0; i < inputs0.size(); i++) {
+        AcceleratorWork work;
+        work.cost = outputs[i]->getShape().size();
+        int currAccelIdx = accelPool.getNextAvailableAccelerator(work);
         dout(1) << "Input0: " << i << ", input1: " << i << ", output: " << i
                 << "\n";
         Tensor* input0Tile = inputs0.getTileWithData(i);
@@ -107,22 +130,26 @@ void SmvLessEqualOp::runX(TiledTensor& inputs0,
         Tensor* outputTile = outputs[i];
         const TensorShape& inputShape = input0Tile->getShape();
         const TensorShape& outputShape = outputTile->getShape();
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_inputs0",
+        mapArrayToAccel(accelId + currAccelIdx, "host_inputs0",
                         input0Tile->data<float16>(),
                         inputShape.storageSize() * sizeof(float16));
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_inputs1",
+        mapArrayToAccel(accelId + currAccelIdx, "host_inputs1",
                         input1Tile->data<float16>(),
                         inputShape.storageSize() * sizeof(float16));
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_results",
+        mapArrayToAccel(accelId + currAccelIdx, "host_results",
                         outputTile->data<bool>(),
                         outputShape.storageSize() * sizeof(bool));
 
-        invokeKernel(smv::kEltwiseOpHw, smv_less_equal_nc_vec_fxp,
-                     input0Tile->data<float16>(), input1Tile->data<float16>(),
-                     outputTile->data<bool>(), smv::spad0, smv::spad1,
-                     reinterpret_cast<bool*>(smv::spad2),
-                     inputShape.storageSize());
+        std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
+                firstAccelIdx + currAccelIdx, accelId + currAccelIdx,
+                smv_less_equal_nc_vec_fxp,
+                input0Tile->data<float16>(), input1Tile->data<float16>(),
+                outputTile->data<bool>(), smv::spad0, smv::spad1,
+                reinterpret_cast<bool*>(smv::spad2),
+                inputShape.storageSize());
+        accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
     }
+    accelPool.joinAll();
 }
 
 void SmvLessEqualOp::tile() {
@@ -13,6 +13,9 @@ class SmvLessOp : public LessOp<SmvBackend> {
     using LessOp<SmvBackend>::LessOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
 
   protected:
    void runX(TiledTensor& inputs0, TiledTensor& inputs1, TiledTensor& outputs);
@@ -26,6 +29,9 @@ class SmvLessEqualOp : public LessEqualOp<SmvBackend> {
     using LessEqualOp<SmvBackend>::LessEqualOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1], &tiledTensors[2] };
+    }
 
   protected:
    void runX(TiledTensor& inputs0, TiledTensor& inputs1, TiledTensor& outputs);
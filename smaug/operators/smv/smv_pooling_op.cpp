@@ -3,6 +3,7 @@
 #include "smaug/operators/smv/smv_pooling_op.h"
 #include "smaug/operators/smv/smv_pooling_tiling.h"
 #include "smaug/operators/smv/smv_kernels.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
@@ -29,13 +30,33 @@ void SmvPoolingOp::runNHWC(TiledTensor& inputs, TiledTensor& outputs) {
     int outputChanTiles = outputs.getShape()[3];
     auto inputIdx = inputs.startIndex();
     auto outputIdx = outputs.startIndex();
-    setArrayMemTypeIfSimulating(
-            smv::kPoolingHw, "host_inputs", getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kPoolingHw, "host_results", getOutputsMemType());
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = smv::kPoolingHw + firstAccelIdx;
+    for (int i = 0; i < numAccels; i++) {
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_results", getOutputsMemType());
+    }
+    // If the inputs are forwarded from the previous operator, the only input
+    // tile is already in that operator's results spad.
+    bool inputsOnChip = getFusedProducer() != nullptr;
+    float* inputsSpad = inputsOnChip ? smv::spad2 : smv::spad0;
+    SmvAcceleratorPool accelPool(numAccels);
     for (int N = 0; N < inputIfmapTiles; N++) {
         for (int H = 0; H < inputRowTiles; H++) {
             for (int W = 0; W < inputColTiles; W++) {
+                // The spatial tiles are independent and run in parallel. The
+                // channelwise tiles are run on the same accelerator, as they
+                // may all produce channels of the same output tile, which is
+                // only sent back to the host once it's complete.
+                AcceleratorWork work;
+                work.cost = 0;
+                for (int C = 0; C < inputChanTiles; C++)
+                    work.cost +=
+                            inputs[inputIdx(N, H, W, C)]->getShape().size();
+                int currAccelIdx = accelPool.getNextAvailableAccelerator(work);
                 int iC = 0, oC = 0;
                 // This keeps track of the channel offset of the outputs.
                 int ofmapOffset = 0;
@@ -52,11 +73,11 @@ void SmvPoolingOp::runNHWC(TiledTensor& inputs, TiledTensor& outputs) {
                     Tensor* outputTile = outputs[outputTileIdx];
                     const TensorShape& inputShape = inputTile->getShape();
                     const TensorShape& outputShape = outputTile->getShape();
-                    mapArrayToAccel(smv::kPoolingHw, "host_inputs",
-                                    inputTile->data<float16>(),
+                    mapArrayToAccel(accelId + currAccelIdx,
+                                    "host_inputs", inputTile->data<float16>(),
                                     inputShape.storageSize() * sizeof(float16));
                     mapArrayToAccel(
-                            smv::kPoolingHw, "host_results",
+                            accelId + currAccelIdx, "host_results",
                             outputTile->data<float16>(),
                             outputShape.storageSize() * sizeof(float16));
                     int inputDims[4] = { inputShape[0], inputShape[1],
@@ -70,16 +91,25 @@ void SmvPoolingOp::runNHWC(TiledTensor& inputs, TiledTensor& outputs) {
                     // from.
                     int ofmapStart = (iC == oC) ? 0 : ofmapOffset;
 
-                    invokeKernel(
-                            smv::kPoolingHw,
-                            opType == MaxPooling ? smv_maxpooling_nhwc_vec_fxp
-                                                 : smv_avgpooling_nhwc_vec_fxp,
-                            inputTile->data<float16>(),
-                            outputTile->data<float16>(), smv::spad0, smv::spad1,
-                            inputDims, outputDims, inputShape.getPadding(3),
-                            outputShape.getPadding(3), getPoolingSize().first,
-                            getPoolingSize().second, getPoolingStride().first,
-                            getPoolingStride().second, ofmapStart, &sampling);
+                    std::unique_ptr<volatile int> finishFlag =
+                            invokeKernelNoBlock(
+                                    firstAccelIdx + currAccelIdx,
+                                    accelId + currAccelIdx,
+                                    opType == MaxPooling
+                                            ? smv_maxpooling_nhwc_vec_fxp
+                                            : smv_avgpooling_nhwc_vec_fxp,
+                                    inputTile->data<float16>(),
+                                    outputTile->data<float16>(), inputsSpad,
+                                    smv::spad1, inputDims, outputDims,
+                                    inputShape.getPadding(3),
+                                    outputShape.getPadding(3),
+                                    getPoolingSize().first,
+                                    getPoolingSize().second,
+                                    getPoolingStride().first,
+                                    getPoolingStride().second, ofmapStart,
+                                    !inputsOnChip, &sampling);
+                    accelPool.addFinishFlag(
+                            currAccelIdx, std::move(finishFlag));
 
                     ofmapOffset += inputTile->getShape()[3];
                     if (inputChanTiles == outputChanTiles) {
@@ -97,6 +127,7 @@ void SmvPoolingOp::runNHWC(TiledTensor& inputs, TiledTensor& outputs) {
             }
         }
     }
+    accelPool.joinAll();
 }
 
 void SmvPoolingOp::tile() {
@@ -106,6 +137,10 @@ void SmvPoolingOp::tile() {
     tiledTensors = smaug::smv::pool::TilingOptimizer::doTiling(this);
 }
 
+bool SmvPoolingOp::canReadInputOnChip(TensorBase* input) const {
+    return input == inputs.at(Inputs) && tiledTensors[0].size() == 1;
+}
+
 void SmvPoolingOp::run() {
     auto input = getInput(Inputs);
     auto output = getOutput(Outputs);
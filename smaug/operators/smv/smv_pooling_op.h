@@ -25,6 +25,10 @@ class SmvPoolingOp : public PoolingOp<SmvBackend> {
     using PoolingOp<SmvBackend>::PoolingOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1] };
+    }
+    bool canReadInputOnChip(TensorBase* input) const override;
     friend class smv::pool::TilingOptimizer;
 
    protected:
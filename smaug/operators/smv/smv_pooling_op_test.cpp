@@ -125,3 +125,21 @@ TEST_CASE_METHOD(SmvPoolingOpTest, "SMV Tiled Pooling", "[smvpool]") {
     }
 }
 
+
+TEST_CASE_METHOD(SmvPoolingOpTest,
+                 "SMV Tiled Pooling on multiple accelerators",
+                 "[smvpool]") {
+    numAcceleratorsAvailable = 3;
+    auto poolOp = new SmvMaxPoolingOp("pool", workspace());
+    SECTION("DimNH tiling") {
+        poolOp->setPoolingSize(2, 2);
+        poolOp->setPoolingStride(2, 2);
+        doTest(poolOp, { 1, 68, 68, 32 });
+    }
+    SECTION("Channelwise tiling") {
+        // The channelwise tiles of an output tile stay on one accelerator.
+        poolOp->setPoolingSize(16, 16);
+        poolOp->setPoolingStride(16, 16);
+        doTest(poolOp, { 1, 64, 64, 128 });
+    }
+}
@@ -157,6 +157,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvPoolingOp* op) {
             fullConfigs.push_back(config);
         }
     }
+    tilingSearchStats.configs += fullConfigs.size();
     dout(2) << "  Number of possible tiling configs: " << fullConfigs.size()
             << "\n";
     for (auto& config : fullConfigs)
@@ -1,5 +1,6 @@
 #include "smaug/operators/smv/smv_softmax_op.h"
 #include "smaug/operators/smv/smv_kernels.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
@@ -8,47 +9,132 @@ void SmvSoftmaxOp::tile() {
     auto inputs = getInput(0);
     auto outputs = getOutput(0);
     const TensorShape& shape = inputs->getShape();
-    if (shape.getStorageDim(1) >
-        SmvBackend::SpadSize() / inputs->getDataTypeSize()) {
-        assert(false && "For softmax, a single tile must fit in the local "
-                        "scratchpad size!");
+    int spadSize = SmvBackend::SpadSize() / inputs->getDataTypeSize();
+    TensorShape tileShape;
+    if (shape.getStorageDim(1) <= spadSize) {
+        // We only need to tile on the N dimension.
+        int maxInputs =
+                std::min(spadSize / shape.getStorageDim(1), shape[0]);
+        tileShape = TensorShape(
+                { maxInputs, shape[1] }, DataLayout::NC, SmvBackend::Alignment);
+    } else {
+        // A single row doesn't fit, so we also tile on the C dimension, into
+        // column tiles of about the same size. See run() for how the rows
+        // are put back together.
+        int numColTiles = FRAC_CEIL(shape.getStorageDim(1), spadSize);
+        int cols = FRAC_CEIL(shape[1], numColTiles);
+        cols += calc_padding(cols, SmvBackend::Alignment);
+        int maxInputs = std::min(spadSize / cols, shape[0]);
+        tileShape = TensorShape(
+                { maxInputs, cols }, DataLayout::NC, SmvBackend::Alignment);
     }
-    // We can only tile on the N dimension.
-    int maxInputs =
-            std::min(SmvBackend::SpadSize() / inputs->getDataTypeSize() /
-                             shape.getStorageDim(1),
-                     shape[0]);
-    TensorShape tileShape(
-            { maxInputs, shape[1] }, DataLayout::NC, SmvBackend::Alignment);
     tiledTensors[0] = generateTiledTensor(inputs, tileShape, this);
     tiledTensors[1] = generateTiledTensor(outputs, tileShape, this);
 }
 
+void SmvSoftmaxOp::runColumnTiles(TiledTensor& inputs,
+                                  TiledTensor& outputs,
+                                  SmvAcceleratorPool& accelPool) {
+    // The rows are too large for the spads, so this makes two passes over
+    // their column tiles on the same accelerator. The first computes the max
+    // and the sum of the exponentials of every row in a streaming manner,
+    // keeping them in spad2, and the second normalizes the tiles with them.
+    int firstAccelIdx = getFirstAccelerator();
+    unsigned accelId = smv::kEltwiseOpHw + firstAccelIdx;
+    int rowTiles = inputs.getShape()[0];
+    int colTiles = inputs.getShape()[1];
+    auto tileIdx = inputs.startIndex();
+    assert(2 * inputs[0]->getShape()[0] <=
+                   SmvBackend::SpadSize() / sizeof(float) &&
+           "The stats of a row tile must fit in the scratchpad!");
+    for (int N = 0; N < rowTiles; N++) {
+        AcceleratorWork work;
+        work.cost = 0;
+        for (int C = 0; C < colTiles; C++)
+            work.cost += outputs[tileIdx(N, C)]->getShape().size();
+        int currAccelIdx = accelPool.getNextAvailableAccelerator(work);
+        for (int C = 0; C < colTiles; C++) {
+            int i = tileIdx(N, C);
+            dout(1) << "Input: " << i << "\n";
+            Tensor* inputTile = inputs.getTileWithData(i);
+            const TensorShape& inputShape = inputTile->getShape();
+            mapArrayToAccel(accelId + currAccelIdx, "host_inputs",
+                            inputTile->data<float16>(),
+                            inputShape.storageSize() * sizeof(float16));
+            std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
+                    firstAccelIdx + currAccelIdx, accelId + currAccelIdx,
+                    smv_softmax_reduce_nc_vec_fxp, inputTile->data<float16>(),
+                    smv::spad0, smv::spad2, inputShape[0], inputShape[1],
+                    inputShape.getPadding(1), C == 0);
+            accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
+        }
+        for (int C = 0; C < colTiles; C++) {
+            int i = tileIdx(N, C);
+            dout(1) << "Input: " << i << ", output: " << i << "\n";
+            Tensor* inputTile = inputs.getTileWithData(i);
+            Tensor* outputTile = outputs[i];
+            const TensorShape& inputShape = inputTile->getShape();
+            const TensorShape& outputShape = outputTile->getShape();
+            mapArrayToAccel(accelId + currAccelIdx, "host_inputs",
+                            inputTile->data<float16>(),
+                            inputShape.storageSize() * sizeof(float16));
+            mapArrayToAccel(accelId + currAccelIdx, "host_results",
+                            outputTile->data<float16>(),
+                            outputShape.storageSize() * sizeof(float16));
+            std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
+                    firstAccelIdx + currAccelIdx, accelId + currAccelIdx,
+                    smv_softmax_normalize_nc_vec_fxp,
+                    inputTile->data<float16>(), outputTile->data<float16>(),
+                    smv::spad0, smv::spad1, smv::spad2, inputShape[0],
+                    inputShape[1], inputShape.getPadding(1));
+            accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
+        }
+    }
+}
+
 void SmvSoftmaxOp::run() {
     TiledTensor& inputs = tiledTensors[0];
     TiledTensor& outputs = tiledTensors[1];
     assert(inputs.size() == outputs.size());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_inputs", getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_results", getOutputsMemType());
-    for (int i = 0; i < inputs.size(); i++) {
-        dout(1) << "Input: " << i << ", output: " << i << "\n";
-        Tensor* inputTile = inputs.getTileWithData(i);
-        Tensor* outputTile = outputs[i];
-        const TensorShape& inputShape = inputTile->getShape();
-        const TensorShape& outputShape = outputTile->getShape();
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_inputs",
-                        inputTile->data<float16>(),
-                        inputShape.storageSize() * sizeof(float16));
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_results",
-                        outputTile->data<float16>(),
-                        outputShape.storageSize() * sizeof(float16));
-        invokeKernel(smv::kEltwiseOpHw, smv_softmax_nc_vec_fxp,
-                     inputTile->data<float16>(), outputTile->data<float16>(),
-                     smv::spad0, smv::spad1, inputShape[0], inputShape[1],
-                     inputShape.getPadding(1));
+    int firstAccelIdx = getFirstAccelerator();
+    int numAccels = getNumAccelerators();
+    unsigned accelId = smv::kEltwiseOpHw + firstAccelIdx;
+    // The batch-wise tiles are independent, so they are spread over all the
+    // available accelerators.
+    for (int i = 0; i < numAccels; i++) {
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_inputs", getInputsMemType());
+        setArrayMemTypeIfSimulating(
+                accelId + i, "host_results", getOutputsMemType());
+    }
+    SmvAcceleratorPool accelPool(numAccels);
+    if (inputs.getShape()[1] > 1) {
+        runColumnTiles(inputs, outputs, accelPool);
+    } else {
+        for (int i = 0; i < inputs.size(); i++) {
+            AcceleratorWork work;
+            work.cost = outputs[i]->getShape().size();
+            int currAccelIdx = accelPool.getNextAvailableAccelerator(work);
+            dout(1) << "Input: " << i << ", output: " << i << "\n";
+            Tensor* inputTile = inputs.getTileWithData(i);
+            Tensor* outputTile = outputs[i];
+            const TensorShape& inputShape = inputTile->getShape();
+            const TensorShape& outputShape = outputTile->getShape();
+            mapArrayToAccel(accelId + currAccelIdx, "host_inputs",
+                            inputTile->data<float16>(),
+                            inputShape.storageSize() * sizeof(float16));
+            mapArrayToAccel(accelId + currAccelIdx, "host_results",
+                            outputTile->data<float16>(),
+                            outputShape.storageSize() * sizeof(float16));
+            std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
+                    firstAccelIdx + currAccelIdx, accelId + currAccelIdx,
+                    smv_softmax_nc_vec_fxp, inputTile->data<float16>(),
+                    outputTile->data<float16>(), smv::spad0, smv::spad1,
+                    inputShape[0], inputShape[1], inputShape.getPadding(1));
+            accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
+        }
     }
+    accelPool.joinAll();
     {
         auto stats = gem5::ScopedStats(
                 stats::kTensorFinalStart, stats::kTensorFinalEnd);
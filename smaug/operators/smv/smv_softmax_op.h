@@ -4,17 +4,31 @@
 #include "smaug/core/backend.h"
 #include "smaug/operators/common.h"
 #include "smaug/operators/softmax_op.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
 
 namespace smaug {
 
-/** Softmax operator on SMV. */
+/**
+ * Softmax operator on SMV.
+ *
+ * If a row doesn't fit in a scratchpad, the rows are tiled by columns and
+ * the softmax is computed in two passes over the tiles, see runColumnTiles().
+ */
 class SmvSoftmaxOp : public SoftmaxOp<SmvBackend> {
    public:
     using SoftmaxOp<SmvBackend>::SoftmaxOp;
     void tile() override;
     void run() override;
+    std::vector<TiledTensor*> getTiledTensors() override {
+        return { &tiledTensors[0], &tiledTensors[1] };
+    }
 
    protected:
+    /** Runs the softmax over rows that are tiled by columns. */
+    void runColumnTiles(TiledTensor& inputs,
+                        TiledTensor& outputs,
+                        SmvAcceleratorPool& accelPool);
+
     std::array<TiledTensor, 2> tiledTensors;
 };
 
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "smaug/core/globals.h"
+#include "smaug/operators/smv/kernels/activation_functions_simd.h"
+#include "smaug/operators/smv/kernels/load_store_fp16_data.h"
+#include "smaug/operators/smv/smv_systolic_array_model.h"
+#include "smaug/utility/thread_pool.h"
+
+namespace smaug {
+
+namespace {
+
+int getNumElems(const int dims[4]) {
+    return dims[0] * dims[1] * dims[2] * dims[3];
+}
+
+// The fp16 loads and stores move whole cachelines, so the scratchpads are
+// rounded up to them.
+void resizeSpad(std::vector<v8fp_t>& spad, int numElems) {
+    const int cachelineElems = CACHELINE_SIZE / sizeof(float16);
+    spad.resize(next_multiple(numElems, cachelineElems) / VECTOR_SIZE);
+}
+
+}  // namespace
+
+void* SmvSystolicArrayModel::computeRows(void* _args) {
+    auto args = reinterpret_cast<RowsArgs*>(_args);
+    const systolic_array_params_t& p = *args->params;
+    Spads* spads = args->spads;
+    int aRows = p.input_dims[1];
+    int aCols = p.input_dims[2];
+    int aVecs = p.input_dims[3] / VECTOR_SIZE;
+    int kRows = p.weight_dims[1];
+    int kCols = p.weight_dims[2];
+    int kVecs = p.weight_dims[3] / VECTOR_SIZE;
+    int resultRows = p.output_dims[1];
+    int resultCols = p.output_dims[2];
+    int resultChans = p.output_dims[3];
+    int topPad = p.input_halo_pad[0];
+    int leftPad = p.input_halo_pad[2];
+    int ifmapVecOffset = p.ifmap_start / VECTOR_SIZE;
+    // The padding of the output channels, if any, gets no kernel.
+    int numKernels = std::min(resultChans, p.weight_dims[0] - p.kern_start);
+    const v8fp_t* inputs = spads->inputs.data();
+    const v8fp_t* weights = spads->weights.data();
+    float* results = reinterpret_cast<float*>(spads->outputs.data());
+    const v8fp_t zero = { 0, 0, 0, 0, 0, 0, 0, 0 };
+
+    for (int row = args->startRow; row < args->startRow + args->numRows;
+         row++) {
+        int n = row / resultRows;
+        int outRow = row % resultRows;
+        for (int outCol = 0; outCol < resultCols; outCol++) {
+            float* result =
+                    &results[((n * resultRows + outRow) * resultCols + outCol) *
+                             resultChans];
+            for (int k = 0; k < resultChans; k++) {
+                if (!p.accum_results)
+                    result[k] = 0;
+            }
+            for (int k = 0; k < numKernels; k++) {
+                v8fp_t accum = zero;
+                for (int kRow = 0; kRow < kRows; kRow++) {
+                    int inRow = outRow * p.stride - topPad + kRow;
+                    if (inRow < 0 || inRow >= aRows)
+                        continue;
+                    for (int kCol = 0; kCol < kCols; kCol++) {
+                        int inCol = outCol * p.stride - leftPad + kCol;
+                        if (inCol < 0 || inCol >= aCols)
+                            continue;
+                        const v8fp_t* act =
+                                &inputs[((n * aRows + inRow) * aCols + inCol) *
+                                                aVecs +
+                                        ifmapVecOffset];
+                        const v8fp_t* kern =
+                                &weights[(((p.kern_start + k) * kRows + kRow) *
+                                                  kCols +
+                                          kCol) *
+                                         kVecs];
+                        for (int v = 0; v < kVecs; v++)
+                            accum += kern[v] * act[v];
+                    }
+                }
+                float sum = 0;
+                for (int i = 0; i < VECTOR_SIZE; i++)
+                    sum += accum[i];
+                result[k] += sum;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void SmvSystolicArrayModel::run(unsigned accelId,
+                                const systolic_array_params_t& params) {
+    Spads& spads = accelSpads[accelId];
+    int inputsSize = getNumElems(params.input_dims);
+    int weightsSize = getNumElems(params.weight_dims);
+    int outputsSize = getNumElems(params.output_dims);
+    if (params.read_inputs) {
+        resizeSpad(spads.inputs, inputsSize);
+        host_load_fp16(reinterpret_cast<float*>(spads.inputs.data()),
+                       reinterpret_cast<float16*>(params.input_base_addr),
+                       inputsSize, 0, 0);
+    }
+    if (params.read_weights) {
+        resizeSpad(spads.weights, weightsSize);
+        host_load_fp16(reinterpret_cast<float*>(spads.weights.data()),
+                       reinterpret_cast<float16*>(params.weight_base_addr),
+                       weightsSize, 0, 0);
+    }
+    assert(spads.inputs.size() * VECTOR_SIZE >= inputsSize &&
+           spads.weights.size() * VECTOR_SIZE >= weightsSize &&
+           "The systolic array doesn't hold the tiles it didn't read!");
+    assert((!params.accum_results ||
+            spads.outputs.size() * VECTOR_SIZE >= outputsSize) &&
+           "The systolic array has no results to accumulate into!");
+    resizeSpad(spads.outputs, outputsSize);
+
+    int totalRows = params.output_dims[0] * params.output_dims[1];
+    if (fastForwardMode || !threadPool || totalRows == 1) {
+        RowsArgs args = { &params, &spads, 0, totalRows };
+        computeRows(&args);
+    } else {
+        int rowsPerThread = std::ceil(totalRows * 1.0 / threadPool->size());
+        std::vector<RowsArgs> args;
+        for (int row = 0; row < totalRows; row += rowsPerThread) {
+            args.push_back({ &params, &spads, row,
+                             std::min(rowsPerThread, totalRows - row) });
+        }
+        for (auto& arg : args) {
+            int cpuid = threadPool->dispatchThread(computeRows, (void*)&arg);
+            assert(cpuid != -1 && "Failed to dispatch thread!");
+        }
+        threadPool->joinThreadPool();
+    }
+
+    if (params.send_results) {
+        float* results = reinterpret_cast<float*>(spads.outputs.data());
+        // The systolic array uses the same activation structures.
+        activation_type function;
+        activation_param_t actParams;
+        memcpy(&function, &params.act_type, sizeof(activation_type));
+        memcpy(&actParams, &params.act_params, sizeof(activation_param_t));
+        if (function != NO_ACTIVATION) {
+            activation_fun_vec(
+                    results, results, outputsSize, function, actParams);
+        }
+        host_store_fp16(results,
+                        reinterpret_cast<float16*>(params.output_base_addr),
+                        outputsSize, 0, 0);
+    }
+}
+
+}  // namespace smaug
@@ -0,0 +1,61 @@
+#ifndef _OPERATORS_SMV_SMV_SYSTOLIC_ARRAY_MODEL_H_
+#define _OPERATORS_SMV_SMV_SYSTOLIC_ARRAY_MODEL_H_
+
+#include <map>
+#include <vector>
+
+#include "smaug/operators/common.h"
+
+namespace smaug {
+
+/**
+ * A functional model of the gem5 systolic array convolution, so that networks
+ * that use the systolic array also run outside of simulation.
+ *
+ * An invocation takes the same systolic_array_params_t as the gem5 device:
+ * it loads the input and weight tiles if read_inputs/read_weights are set,
+ * convolves the weight channels with the input channels starting at
+ * ifmap_start, producing the output channels from the kernel kern_start on,
+ * and accumulates into the results of the last invocation if accum_results is
+ * set. Like the DLA kernel, the padding of the tiles' last dimensions must be
+ * zero, and the input halo padding is implicit zeros. The fused activation is
+ * applied when the results are sent back to the host.
+ *
+ * Every accelerator has its own scratchpads, which keep their tiles across
+ * invocations. The output rows are computed in parallel on the thread pool,
+ * if there is one.
+ */
+class SmvSystolicArrayModel {
+   public:
+    /**
+     * Runs an invocation on the systolic array with the given ID.
+     *
+     * The dims of the params include the alignment padding, as they do for
+     * the gem5 device.
+     */
+    void run(unsigned accelId, const systolic_array_params_t& params);
+
+   protected:
+    struct Spads {
+        std::vector<v8fp_t> inputs;
+        std::vector<v8fp_t> weights;
+        std::vector<v8fp_t> outputs;
+    };
+
+    /** The arguments of a worker thread that computes some output rows. */
+    struct RowsArgs {
+        const systolic_array_params_t* params;
+        Spads* spads;
+        int startRow;
+        int numRows;
+    };
+
+    /** Computes the output rows given by the args. */
+    static void* computeRows(void* args);
+
+    std::map<unsigned, Spads> accelSpads;
+};
+
+}  // namespace smaug
+
+#endif
@@ -67,6 +67,7 @@ void TilingOptimizerBase::enum2DTensorTilingConfigs(
         for (int c = minC; c <= shape[1]; c += strideC) {
             TensorShape config(
                     { n, c }, shape.getLayout(), shape.getAlignment());
+            tilingSearchStats.tileShapes++;
             if (config.storageSize() <= maxTileSize)
                 configs.push_back(config);
             else
@@ -107,6 +108,7 @@ void TilingOptimizerBase::enum4DTensorTilingConfigs(
                                              shape.getLayout(),
                                              shape.getAlignment());
                     }
+                    tilingSearchStats.tileShapes++;
                     if (config.storageSize() <= maxTileSize)
                         configs.push_back(config);
                     else
@@ -4,6 +4,8 @@
 namespace smaug {
 namespace smv {
 
+TilingSearchStats tilingSearchStats;
+
 std::ostream& operator<<(std::ostream& os, const TilingDims& dims) {
   switch (dims) {
       case None:
@@ -67,5 +69,61 @@ bool needsWwiseTiling(TilingDims dim) {
     return (dim == DimNW) || (dim == DimNHW) || (dim == DimNCW);
 }
 
+std::ostream& operator<<(std::ostream& os, const TileLoopOrder& order) {
+    switch (order) {
+        case AutoTileLoopOrder:
+            os << "Auto";
+            break;
+        case InputStationary:
+            os << "InputStationary";
+            break;
+        case WeightStationary:
+            os << "WeightStationary";
+            break;
+    }
+    return os;
+}
+
+std::vector<std::pair<int, int>> getWorkUnitOrder(TileLoopOrder order,
+                                                  int numActTiles,
+                                                  int numWeightTiles) {
+    assert(order != AutoTileLoopOrder);
+    bool weightsOuter = order == WeightStationary;
+    int numOuter = weightsOuter ? numWeightTiles : numActTiles;
+    int numInner = weightsOuter ? numActTiles : numWeightTiles;
+    std::vector<std::pair<int, int>> units;
+    for (int outer = 0; outer < numOuter; outer++) {
+        for (int i = 0; i < numInner; i++) {
+            int inner = outer % 2 == 0 ? i : numInner - 1 - i;
+            if (weightsOuter)
+                units.emplace_back(inner, outer);
+            else
+                units.emplace_back(outer, inner);
+        }
+    }
+    return units;
+}
+
+std::vector<std::pair<int, int>> getChannelSteps(int inputChanTiles,
+                                                 int weightChanTiles) {
+    assert((inputChanTiles == weightChanTiles || inputChanTiles == 1) &&
+           "The input/weight tiles can have different number of channels "
+           "only when the inputs don't need channelwise tiling.");
+    std::vector<std::pair<int, int>> steps;
+    for (int wC = 0; wC < weightChanTiles; wC++)
+        steps.emplace_back(inputChanTiles == 1 ? 0 : wC, wC);
+    return steps;
+}
+
+bool reverseChannelSteps(const std::pair<int, int>& firstTiles,
+                         const std::pair<int, int>& lastTiles,
+                         const std::pair<int, int>& heldTiles) {
+    auto holds = [&](const std::pair<int, int>& tiles) {
+        return tiles.first == heldTiles.first ||
+               tiles.second == heldTiles.second;
+    };
+    return !holds(firstTiles) && holds(lastTiles);
+}
+
 }  // namespace smv
 }  // namespace smaug
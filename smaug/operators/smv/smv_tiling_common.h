@@ -1,6 +1,10 @@
 #ifndef _OPERATORS_SMV_TILING_COMMON_H_
 #define _OPERATORS_SMV_TILING_COMMON_H_
 
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 #include "smaug/core/tensor.h"
 
 namespace smaug {
@@ -46,6 +50,20 @@ struct TilingConfig {
     TilingDims outputTilingDims;
 };
 
+/**
+ * Counts the candidates the tiling optimizers enumerate. The optimizers only
+ * ever add to it, so a profiler resets it before tiling an operator and reads
+ * it afterwards. Operators are tiled by one thread, so it isn't locked.
+ */
+struct TilingSearchStats {
+    /** Tile shapes tried by the enum*TensorTilingConfigs() helpers. */
+    uint64_t tileShapes = 0;
+    /** Complete TilingConfigs that fit, among which the best is picked. */
+    uint64_t configs = 0;
+};
+
+extern TilingSearchStats tilingSearchStats;
+
 std::ostream& operator<<(std::ostream& os, const TilingDims& dims);
 std::ostream& operator<<(std::ostream& os, const TilingConfig& config);
 
@@ -57,6 +75,47 @@ bool needsHwiseTiling(TilingDims dim);
 
 bool needsWwiseTiling(TilingDims dim);
 
+/**
+ * The orders in which an operator can visit its independent work units, each
+ * of which pairs a tile of activations with a tile of weights.
+ */
+enum TileLoopOrder {
+    /** Picks the order that loads the fewest bytes, see the operators. */
+    AutoTileLoopOrder,
+    /** The activations outermost, so every input tile is loaded once. */
+    InputStationary,
+    /** The weights outermost, so every weight tile is loaded once. */
+    WeightStationary,
+};
+
+std::ostream& operator<<(std::ostream& os, const TileLoopOrder& order);
+
+/**
+ * Returns the (activation, weight) indices of the work units in the given
+ * order. The inner loop is serpentine, so that two consecutive work units
+ * across an outer loop boundary share the tile of the inner loop.
+ */
+std::vector<std::pair<int, int>> getWorkUnitOrder(TileLoopOrder order,
+                                                  int numActTiles,
+                                                  int numWeightTiles);
+
+/**
+ * Returns the (input, weight) channelwise tile indices that accumulate into
+ * the same output tile, in order. Either both are tiled the same way, or the
+ * inputs are not tiled channelwise and stay the same for all the steps.
+ */
+std::vector<std::pair<int, int>> getChannelSteps(int inputChanTiles,
+                                                 int weightChanTiles);
+
+/**
+ * Returns true if a sweep over the channelwise tiles should run backwards,
+ * i.e. if the accelerator still holds the (input, weight) tiles of its last
+ * step but not those of its first one.
+ */
+bool reverseChannelSteps(const std::pair<int, int>& firstTiles,
+                         const std::pair<int, int>& lastTiles,
+                         const std::pair<int, int>& heldTiles);
+
 }  // namespace smv
 }  // namespace smaug
 
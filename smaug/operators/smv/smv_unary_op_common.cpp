@@ -7,6 +7,7 @@
 #include "smaug/operators/smv/smv_tanh_op.h"
 #include "smaug/operators/smv/smv_sigmoid_op.h"
 #include "smaug/operators/smv/smv_kernels.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
@@ -49,32 +50,54 @@ std::pair<activation_type, activation_param_t> getActivationParams(
     return { function, params };
 }
 
-// The tile dispatcher for activation functions.
+// The tile dispatcher for activation functions. The tiles are independent, so
+// they are spread over all the available accelerators.
 void runX(UnaryOp<SmvBackend>* op, TiledTensor& inputs, TiledTensor& outputs) {
     assert(inputs.size() == outputs.size());
     auto actParams = getActivationParams(op);
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_inputs", op->getInputsMemType());
-    setArrayMemTypeIfSimulating(
-            smv::kEltwiseOpHw, "host_results", op->getOutputsMemType());
+    int firstAccelIdx = op->getFirstAccelerator();
+    int numAccels = op->getNumAccelerators();
+    unsigned accelId = smv::kEltwiseOpHw + firstAccelIdx;
+    for (int i = 0; i < numAccels; i++) {
+        setArrayMemTypeIfSimulating(accelId + i, "host_inputs",
+                                    op->getInputsMemType());
+        setArrayMemTypeIfSimulating(accelId + i, "host_results",
+                                    op->getOutputsMemType());
+    }
+    // If the inputs are forwarded from the previous operator, the only input
+    // tile is already in that operator's results spad. The producer only
+    // forwards when there is a single accelerator, so that's where this tile
+    // runs.
+    bool inputsOnChip = op->getFusedProducer() != nullptr;
+    float* inputsSpad = inputsOnChip ? smv::spad2 : smv::spad0;
+    SmvAcceleratorPool accelPool(numAccels);
     for (int i = 0; i < inputs.size(); i++) {
+        AcceleratorWork work;
+        work.cost = outputs[i]->getShape().size();
+        int currAccelIdx = accelPool.getNextAvailableAccelerator(work);
         dout(1) << "Input: " << i << ", output: " << i << "\n";
-        Tensor* inputTile = inputs.getTileWithData(i);
+        // Forwarded inputs are never read from the host.
+        Tensor* inputTile =
+                inputsOnChip ? inputs[i] : inputs.getTileWithData(i);
         Tensor* outputTile = outputs[i];
         const TensorShape& inputShape = inputTile->getShape();
         const TensorShape& outputShape = outputTile->getShape();
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_inputs",
+        mapArrayToAccel(accelId + currAccelIdx, "host_inputs",
                         inputTile->data<float16>(),
                         inputShape.storageSize() * sizeof(float16));
-        mapArrayToAccel(smv::kEltwiseOpHw, "host_results",
+        mapArrayToAccel(accelId + currAccelIdx, "host_results",
                         outputTile->data<float16>(),
                         outputShape.storageSize() * sizeof(float16));
 
-        invokeKernel(smv::kEltwiseOpHw, smv_activation_fun_nc_vec_fxp,
-                     inputTile->data<float16>(), outputTile->data<float16>(),
-                     smv::spad0, smv::spad1, inputShape.storageSize(),
-                     actParams.first, actParams.second);
+        std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
+                firstAccelIdx + currAccelIdx, accelId + currAccelIdx,
+                smv_activation_fun_nc_vec_fxp, inputTile->data<float16>(),
+                outputTile->data<float16>(), inputsSpad, smv::spad1,
+                inputShape.storageSize(), actParams.first, actParams.second,
+                !inputsOnChip);
+        accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
     }
+    accelPool.joinAll();
 }
 
 std::array<TiledTensor, 2> doTiling(UnaryOp<SmvBackend>* op, bool copyData) {
@@ -94,6 +117,13 @@ std::array<TiledTensor, 2> doTiling(UnaryOp<SmvBackend>* op, bool copyData) {
     return { tiledInputs, tiledOutputs };
 }
 
+bool canReadInputOnChip(const UnaryOp<SmvBackend>* op,
+                        TensorBase* input,
+                        const std::array<TiledTensor, 2>& tiledTensors) {
+    return input == op->getInput(UnaryOp<SmvBackend>::Inputs) &&
+           tiledTensors[0].size() == 1;
+}
+
 void run(UnaryOp<SmvBackend>* op, std::array<TiledTensor, 2>& tiledTensors) {
     auto inputs = op->getInput(UnaryOp<SmvBackend>::Inputs);
     auto outputs = op->getOutput(UnaryOp<SmvBackend>::Outputs);
@@ -101,7 +131,8 @@ void run(UnaryOp<SmvBackend>* op, std::array<TiledTensor, 2>& tiledTensors) {
     {
         auto stats = gem5::ScopedStats(
                 stats::kTensorPrepStart, stats::kTensorPrepEnd);
-        tiledTensors[0].copyDataToAllTiles();
+        if (!op->getFusedProducer())
+            tiledTensors[0].copyDataToAllTiles();
     }
 
     runX(op, tiledTensors[0], tiledTensors[1]);
@@ -28,6 +28,14 @@ void runX(UnaryOp<SmvBackend>* op, TiledTensor& inputs, TiledTensor& outputs);
 std::array<TiledTensor, 2> doTiling(UnaryOp<SmvBackend>* op,
                                     bool copyData = true);
 
+/**
+ * Returns true if the unary operator can read its input from the previous
+ * operator's results spad, which requires the input to be a single tile.
+ */
+bool canReadInputOnChip(const UnaryOp<SmvBackend>* op,
+                        TensorBase* input,
+                        const std::array<TiledTensor, 2>& tiledTensors);
+
 void run(UnaryOp<SmvBackend>* op, std::array<TiledTensor, 2>& tiledTensors);
 
 }  // namespace unary
@@ -167,3 +167,52 @@ TEST_CASE_METHOD(SmvUnaryOpTest, "SMV Tiled 2D Activations", "[smvunary]") {
     }
 }
 
+TEST_CASE_METHOD(SmvUnaryOpTest,
+                 "SMV softmax rows larger than a scratchpad",
+                 "[smvunary]") {
+    // The outputs are too small for the absolute margin of verifyOutputs(),
+    // so they are compared relatively here.
+    auto doSoftmaxTest = [&](std::vector<int> dims) {
+        auto softmaxOp = new SmvSoftmaxOp("softmax", workspace());
+        TensorShape inputShape(dims, NC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("input", inputShape);
+        inputs->allocateStorage<float16>();
+        workspace()->addTensor(inputs);
+        softmaxOp->setInput(inputs, 0);
+        createAndFillTensorsWithData<float16>(
+                softmaxOp, fillTensorWithRandomData);
+        softmaxOp->tile();
+        REQUIRE(softmaxOp->getTiledTensors()[0]->getShape()[1] > 1);
+        softmaxOp->run();
+        auto outputs = softmaxOp->getOutput(0);
+        auto refOutputs = getReferenceOutput(softmaxOp);
+        const TensorShape& shape = outputs->getShape();
+        float16* outputPtr = outputs->data<float16>();
+        float16* refPtr = refOutputs->data<float16>();
+        for (int i = 0; i < dims[0]; i++) {
+            float rowSum = 0;
+            for (int j = 0; j < dims[1]; j++) {
+                int idx = i * shape.getStorageDim(1) + j;
+                REQUIRE(Approx(fp32(outputPtr[idx]))
+                                .epsilon(kEpsilon)
+                                .margin(1e-7) == fp32(refPtr[idx]));
+                rowSum += fp32(outputPtr[idx]);
+            }
+            REQUIRE(Approx(rowSum).epsilon(kEpsilon) == 1);
+        }
+    };
+    // Every row is tiled into 3 column tiles.
+    doSoftmaxTest({ 2, 40000 });
+    // The last column tile of every row is padded.
+    doSoftmaxTest({ 3, 20003 });
+}
+
+
+TEST_CASE_METHOD(SmvUnaryOpTest,
+                 "SMV Tiled Activations on multiple accelerators",
+                 "[smvunary]") {
+    numAcceleratorsAvailable = 2;
+    doTest(OpType::ReLU, { 2, 16, 32, 24 });
+    doTest(OpType::Sigmoid, { 2, 12288 });
+    doTest(OpType::Softmax, { 9, 4096 });
+}
@@ -182,12 +182,15 @@ class Graph:
       graph_proto.nodes.append(node.to_proto(tensor_data_array))
     return graph_proto, tensor_data_array
 
-  def write_graph(self, name=None):
+  def write_graph(self, name=None, binary_topo=False):
     """Serialize the graph to a protobuf file.
 
     Args:
       name: Name of the output protobuf file. If not specified, use the graph's
             name instead.
+      binary_topo: If true, also write the topology as a binary protobuf
+            (`<name>_topo.pb`), which is much faster to load for large graphs.
+            The text topology is still written for debugging.
     """
     graph_proto, tensor_data_array = self.to_proto()
     if name is None:
@@ -197,6 +200,9 @@ class Graph:
     with open(topo_name, "w") as f_topo, open(params_name, "wb") as f_params:
       f_topo.write(text_format.MessageToString(graph_proto))
       f_params.write(tensor_data_array.SerializeToString())
+    if binary_topo:
+      with open(name + "_topo.pb", "wb") as f_topo:
+        f_topo.write(graph_proto.SerializeToString())
 
   def print_summary(self):
     """Print the summary of the graph.
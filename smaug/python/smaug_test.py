@@ -45,8 +45,8 @@ class SmaugTest(unittest.TestCase):
   def runAndValidate(self, graph, expected_output, decimal=3):
     """ Run the test and validate the results. """
     os.chdir(self.run_dir)
-    graph.write_graph()
-    cmd = "%s %s_topo.pbtxt %s_params.pb --print-last-output=proto" % (
+    graph.write_graph(binary_topo=True)
+    cmd = "%s %s_topo.pb %s_params.pb --print-last-output=proto" % (
         self.binary, self.graph_name, self.graph_name)
     returncode = self.launchSubprocess(cmd)
     self.assertEqual(returncode, 0, msg="Test returned nonzero exit code!")
@@ -132,6 +132,20 @@ class Tensor:
     tensor_proto.data_type = self._data_type
     tensor_proto.data_format = self._data_format
     if self._tensor_data is not None and tensor_data_array is not None:
+      tensor_data = self._tensor_data
+
+      # In the CSR format, only the nonzero values are stored, row by row, with
+      # their column indices in the innermost dimension and the offsets of the
+      # rows.
+      if self._data_format == types_pb2.CSR:
+        rows = tensor_data.reshape(-1, tensor_data.shape[-1])
+        row_idx, col_idx = np.nonzero(rows)
+        row_ptr = np.searchsorted(row_idx, np.arange(rows.shape[0] + 1))
+        tensor_data = rows[row_idx, col_idx]
+      elif self._data_format == types_pb2.PackedCSR:
+        raise ValueError(
+            "Unsupported data format: %s" %
+            types_pb2.DataStorageFormat.Name(self._data_format))
 
       # Since Protobuf doesn't support float16 data type, we pack two float16
       # elements into one int32.
@@ -142,15 +156,15 @@ class Tensor:
         # odd size, we pad a zero at the end of the list. When we later
         # deserialize the tensor data, we know the correct shape of the
         # tensor, and the padded zero will be discarded.
-        self._tensor_data = self._tensor_data.flatten()
-        if self._tensor_data.size % 2 != 0:
-          self._tensor_data = np.append(self._tensor_data, np.float16(0))
-        self._tensor_data = self._tensor_data.view(np.int32)
+        tensor_data = tensor_data.flatten()
+        if tensor_data.size % 2 != 0:
+          tensor_data = np.append(tensor_data, np.float16(0))
+        tensor_data = tensor_data.view(np.int32)
 
       # Serialize the data into the proto.
       tensor_data_proto = tensor_data_array.data_array.add()
       tensor_data_proto.name = tensor_proto.name
-      data_list = [x for x in np.nditer(self._tensor_data)]
+      data_list = [x for x in np.nditer(tensor_data)]
       if self._data_type == types_pb2.Float16:
         tensor_data_proto.half_data.extend(data_list)
       elif self._data_type == types_pb2.Float32:
@@ -163,3 +177,6 @@ class Tensor:
         tensor_data_proto.int64_data.extend(data_list)
       elif self._data_type == types_pb2.Bool:
         tensor_data_proto.bool_data.extend(data_list)
+      if self._data_format == types_pb2.CSR:
+        tensor_data_proto.csr_col_idx.extend(col_idx.tolist())
+        tensor_data_proto.csr_row_ptr.extend(row_ptr.tolist())
@@ -136,5 +136,42 @@ class FP16Test(TensorTestBase):
     self.assertEqualFP16(tensor_data_proto.half_data,
                          np.append(tensor_data.flatten(), np.float16(0)))
 
+class CSRTest(TensorTestBase):
+  def test_csr_smv_padding(self):
+    """Test CSR compression of tensor data with padding."""
+    tensor_data = np.array([[0, 2.2, 0, 4.4], [0, 0, 0, 0], [5.5, 0, 0, 8.8]],
+                           dtype=np.float16)
+    with Graph("test_graph", "SMV") as test_graph:
+      input_tensor = Tensor(
+          data_layout=types_pb2.NC, data_format=types_pb2.CSR,
+          tensor_data=tensor_data)
+      act = input_data(input_tensor, "input")
+    graph_proto, tensor_data_array = test_graph.to_proto()
+    node = get_node_proto(graph_proto, "input")
+    self.assertEqual(node.input_tensors[0].data_format, types_pb2.CSR)
+    tensor_data_proto = get_tensor_data(
+        tensor_data_array, node.input_tensors[0].name)
+    self.assertEqualFP16(tensor_data_proto.half_data,
+                         np.array([2.2, 4.4, 5.5, 8.8], dtype=np.float16))
+    self.assertEqual(tensor_data_proto.csr_col_idx, [1, 3, 0, 3])
+    self.assertEqual(tensor_data_proto.csr_row_ptr, [0, 2, 2, 4])
+
+  def test_csr_float32(self):
+    """Test CSR compression of float32 tensor data."""
+    tensor_data = np.array([[[[0, 1], [2, 0]], [[0, 0], [3, 4]]]],
+                           dtype=np.float32)
+    with Graph("test_graph", "Reference") as test_graph:
+      input_tensor = Tensor(
+          data_layout=types_pb2.NHWC, data_format=types_pb2.CSR,
+          tensor_data=tensor_data)
+      act = input_data(input_tensor, "input")
+    graph_proto, tensor_data_array = test_graph.to_proto()
+    node = get_node_proto(graph_proto, "input")
+    tensor_data_proto = get_tensor_data(
+        tensor_data_array, node.input_tensors[0].name)
+    self.assertEqual(tensor_data_proto.float_data, [1, 2, 3, 4])
+    self.assertEqual(tensor_data_proto.csr_col_idx, [1, 0, 0, 1])
+    self.assertEqual(tensor_data_proto.csr_row_ptr, [0, 1, 2, 2, 4])
+
 if __name__ == "__main__":
   unittest.main()
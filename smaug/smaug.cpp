@@ -1,13 +1,22 @@
+#include <chrono>
 #include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
 #include <string>
 
 #include <boost/program_options.hpp>
 
 #include "core/backend.h"
+#include "core/checkpoint.h"
 #include "core/globals.h"
+#include "core/input_pipeline.h"
 #include "core/scheduler.h"
+#include "core/pipelined_scheduler.h"
 #include "core/network_builder.h"
+#include "core/output_writer.h"
 #include "operators/common.h"
+#include "operators/smv/smv_cycle_model.h"
 #include "utility/debug_stream.h"
 #include "utility/utils.h"
 #include "utility/thread_pool.h"
@@ -29,6 +38,27 @@ int main(int argc, char* argv[]) {
     numAcceleratorsAvailable = 1;
     int numThreads = -1;
     useSystolicArrayWhenAvailable = false;
+    fuseOperatorsWhenPossible = false;
+    doubleBufferSpadsWhenPossible = false;
+    reportEstimatedCycles = false;
+    std::string scheduleOrderFile;
+    std::string accelDispatch = "round-robin";
+    int pipelineStages = 1;
+    int pipelineBatches = 1;
+    int spadSize = smv::kDefaultSpadSize;
+    int numSpads = smv::kDefaultNumSpads;
+    double dmaBandwidth = smv::kDefaultDmaBytesPerCycle;
+    int paramMemoryMB = 0;
+    std::string inputDataset;
+    std::string inputDataOp = "data";
+    std::string inputLayout;
+    std::string dumpTensors;
+    std::string dumpFormat = "npy";
+    std::string dumpDir = ".";
+    std::string checkpointAt;
+    std::string checkpointPrefix = "checkpoint";
+    std::string resumeFrom;
+    int stopAt = -1;
     po::options_description options(
             "SMAUG Usage:  ./smaug model_topo.pbtxt model_params.pb [options]");
     // clang-format off
@@ -45,8 +75,9 @@ int main(int argc, char* argv[]) {
         ("print-last-output,p",
          po::value(&lastOutputFile)->implicit_value("stdout"),
          "Dump the output of the last layer to this file. If specified with "
-         "'proto', the output tensor is serialized to a output.pb file. By "
-         "default, it is printed to stdout.")
+         "'proto', the output tensor is serialized to a output.pb file. With "
+         "'npy' or 'raw', its data is written in that format into the "
+         "--dump-dir directory. By default, it is printed to stdout.")
         ("sample-level",
           po::value(&samplingLevel)->implicit_value("no"),
          "Set the sampling level. By default, SMAUG doesn't do any sampling. "
@@ -67,9 +98,110 @@ int main(int argc, char* argv[]) {
         ("num-threads",
          po::value(&numThreads)->implicit_value(1),
          "Number of threads in the thread pool.")
+        ("accel-dispatch",
+         po::value(&accelDispatch),
+         "How operators pick the accelerator for their next unit of work when "
+         "there are multiple accelerators. Options are round-robin, polling, "
+         "least-work and weight-affinity. Only round-robin is guaranteed to "
+         "make the same choices when generating traces and in simulation.")
         ("use-systolic-array",
          po::value(&useSystolicArrayWhenAvailable)->implicit_value(true),
-         "If the backend contains a systolic array, use it whenever possible.");
+         "If the backend contains a systolic array, use it whenever possible. "
+         "Outside of simulation, a functional model of it runs on the host.")
+        ("fuse-operators",
+         po::value(&fuseOperatorsWhenPossible)->implicit_value(true),
+         "Hand data between back-to-back operators through the accelerator "
+         "scratchpads instead of host memory, when their tilings allow it.")
+        ("double-buffer-spads",
+         po::value(&doubleBufferSpadsWhenPossible)->implicit_value(true),
+         "Split the scratchpads of the SMV convolution and inner product "
+         "kernels into two halves, to overlap loading the next tiles and "
+         "storing the last results with computation. Tiles only get half a "
+         "scratchpad.")
+        ("estimate-cycles",
+         po::value(&reportEstimatedCycles)->implicit_value(true),
+         "Report the accelerator cycles of every operator and of the whole "
+         "network, as estimated by an analytical model of the SMV "
+         "convolution and inner product datapaths. This takes seconds "
+         "instead of a gem5-Aladdin simulation. In a pipeline, the cycles "
+         "of every stage in the last batch are reported too.")
+        ("dma-bandwidth",
+         po::value(&dmaBandwidth),
+         "The DMA bandwidth in bytes per accelerator cycle that the cycle "
+         "estimates assume.")
+        ("schedule-order",
+         po::value(&scheduleOrderFile),
+         "A file listing the operator names one per line, in the order they "
+         "should run. It must be a topological order of the network, e.g. "
+         "one written by the graph analyzer's schedule optimizer.")
+        ("pipeline-stages",
+         po::value(&pipelineStages),
+         "Split the network into this many pipeline stages, each with its "
+         "own accelerators and host thread. In simulation, every stage needs "
+         "its own CPU.")
+        ("pipeline-batches",
+         po::value(&pipelineBatches),
+         "The number of batches to stream through the pipeline stages. All "
+         "of them use the same network inputs.")
+        ("spad-size",
+         po::value(&spadSize),
+         "The size of each SMV scratchpad in bytes. Tiling uses this size; "
+         "in simulation it must match the gem5 configuration.")
+        ("num-spads",
+         po::value(&numSpads),
+         "The number of SMV scratchpads, at least 3.")
+        ("param-memory-budget",
+         po::value(&paramMemoryMB),
+         "Load the network parameters from the parameters file on demand, "
+         "keeping at most this many MB of them in memory. The least recently "
+         "used ones are evicted, and those of the next operator are "
+         "prefetched while the current one runs. This allows running models "
+         "whose parameters don't fit in host memory.")
+        ("input-dataset",
+         po::value(&inputDataset),
+         "Run the network once for every sample in this dataset file, a .npy "
+         "file or raw samples of the input's data type. The file is "
+         "memory-mapped, and the next sample is converted to the input's data "
+         "type and layout while the current one runs.")
+        ("input-data-op",
+         po::value(&inputDataOp),
+         "The Data operator whose tensor the samples of the input dataset are "
+         "bound to.")
+        ("input-layout",
+         po::value(&inputLayout),
+         "The layout of the samples in the input dataset, NCHW or NHWC, if it "
+         "differs from the layout of the input tensor.")
+        ("dump-tensors",
+         po::value(&dumpTensors),
+         "Write the data of these tensors (a comma-separated list of names) "
+         "into files as soon as their operators have run, or with 'all', the "
+         "outputs of all the operators except the Data operators. The files "
+         "are written on a background thread, straight from the tensors' "
+         "storage. With an input dataset, the file names end with the sample "
+         "index.")
+        ("dump-format",
+         po::value(&dumpFormat),
+         "The format of the dumped tensor files: 'npy' or 'raw' (the "
+         "elements in the tensor's layout, without the alignment padding).")
+        ("dump-dir",
+         po::value(&dumpDir),
+         "The directory the dumped tensor files are written to.")
+        ("checkpoint-at",
+         po::value(&checkpointAt),
+         "Write a checkpoint of the live tensors at these operator boundaries "
+         "(a comma-separated list). Boundary K is after the first K operators "
+         "in schedule order have run, not counting the Data operators.")
+        ("checkpoint-prefix",
+         po::value(&checkpointPrefix),
+         "The checkpoint at boundary K is written to <prefix>_K.ckpt.")
+        ("resume-from",
+         po::value(&resumeFrom),
+         "Restore the tensors of this checkpoint and skip the operators before "
+         "its boundary. With --stop-at, this allows simulating the layers of "
+         "a network as independent jobs.")
+        ("stop-at",
+         po::value(&stopAt),
+         "Stop the network at this operator boundary.");
     // clang-format on
 
     po::options_description hidden;
@@ -142,16 +274,145 @@ int main(int argc, char* argv[]) {
                      "by 1.\n";
     }
 
+    if (spadSize <= 0 || numSpads < 3) {
+        std::cout << "SMV needs at least 3 scratchpads of a positive size!\n";
+        exit(1);
+    }
+    std::cout << "Scratchpads: " << numSpads << " x " << spadSize
+              << " bytes.\n";
+
+    if (dmaBandwidth <= 0) {
+        std::cout << "The DMA bandwidth must be positive!\n";
+        exit(1);
+    }
+    smv::dmaBytesPerCycle = dmaBandwidth;
+
+    if (accelDispatch == "round-robin") {
+        accelDispatchPolicy = RoundRobinDispatch;
+    } else if (accelDispatch == "polling") {
+        accelDispatchPolicy = PollingDispatch;
+    } else if (accelDispatch == "least-work") {
+        accelDispatchPolicy = LeastWorkDispatch;
+    } else if (accelDispatch == "weight-affinity") {
+        accelDispatchPolicy = WeightAffinityDispatch;
+    } else {
+        std::cout << "Doesn't support the specified accelerator dispatch "
+                     "policy: "
+                  << accelDispatch << "\n";
+        exit(1);
+    }
+    if (numAcceleratorsAvailable > 1) {
+        std::cout << "Accelerator dispatch policy: " << accelDispatch << "\n";
+    }
+
+    if (pipelineStages < 1 || pipelineBatches < 1) {
+        std::cout << "Need at least one pipeline stage and batch!\n";
+        exit(1);
+    }
+    if (pipelineStages > numAcceleratorsAvailable) {
+        std::cout << "Every pipeline stage needs its own accelerator!\n";
+        exit(1);
+    }
+    if (pipelineStages > 1 && numThreads != -1) {
+        std::cout << "The thread pool can't be shared by pipeline stages!\n";
+        exit(1);
+    }
+    if (pipelineStages > 1 || pipelineBatches > 1) {
+        std::cout << "Pipeline stages: " << pipelineStages
+                  << ", batches: " << pipelineBatches << "\n";
+    }
+
+    if (paramMemoryMB < 0) {
+        std::cout << "The parameter memory budget can't be negative!\n";
+        exit(1);
+    }
+    if (paramMemoryMB > 0 && (pipelineStages > 1 || pipelineBatches > 1)) {
+        std::cout << "Loading the parameters on demand doesn't support "
+                     "pipelining!\n";
+        exit(1);
+    }
+    paramMemoryBudget = (uint64_t)paramMemoryMB * 1024 * 1024;
+
+    DataLayout sampleLayout = UnknownLayout;
+    if (!inputDataset.empty() && (pipelineStages > 1 || pipelineBatches > 1)) {
+        std::cout << "Streaming an input dataset doesn't support "
+                     "pipelining!\n";
+        exit(1);
+    }
+    if (inputLayout == "NCHW") {
+        sampleLayout = NCHW;
+    } else if (inputLayout == "NHWC") {
+        sampleLayout = NHWC;
+    } else if (!inputLayout.empty()) {
+        std::cout << "Doesn't support the specified input layout: "
+                  << inputLayout << "\n";
+        exit(1);
+    }
+
+    OutputWriter::Format outputFormat;
+    if (dumpFormat == "npy") {
+        outputFormat = OutputWriter::Npy;
+    } else if (dumpFormat == "raw") {
+        outputFormat = OutputWriter::Raw;
+    } else {
+        std::cout << "Doesn't support the specified dump format: "
+                  << dumpFormat << "\n";
+        exit(1);
+    }
+    std::unique_ptr<OutputWriter> outputWriter;
+    if (!dumpTensors.empty()) {
+        if (pipelineStages > 1 || pipelineBatches > 1) {
+            std::cout << "Dumping tensors doesn't support pipelining!\n";
+            exit(1);
+        }
+        std::set<std::string> tensorNames;
+        if (dumpTensors != "all") {
+            std::stringstream names(dumpTensors);
+            std::string name;
+            while (std::getline(names, name, ','))
+                tensorNames.insert(name);
+        }
+        outputWriter.reset(
+                new OutputWriter(dumpDir, outputFormat, tensorNames));
+        std::cout << "Dumping tensors to " << dumpDir << ".\n";
+    }
+
+    std::set<int> checkpointBoundaries;
+    if (!checkpointAt.empty()) {
+        std::stringstream boundaries(checkpointAt);
+        std::string boundary;
+        while (std::getline(boundaries, boundary, ','))
+            checkpointBoundaries.insert(std::stoi(boundary));
+    }
+    if (!checkpointBoundaries.empty() || !resumeFrom.empty() ||
+        stopAt != -1) {
+        if (pipelineStages > 1 || pipelineBatches > 1 ||
+            !inputDataset.empty()) {
+            std::cout << "Checkpoints need a single run of the network!\n";
+            exit(1);
+        }
+        // Fused operators hand their data over in the scratchpads, where a
+        // checkpoint can't see it.
+        if (fuseOperatorsWhenPossible) {
+            std::cout << "Checkpoints don't support fused operators!\n";
+            exit(1);
+        }
+    }
+
     if (numThreads != -1) {
         std::cout << "Using a thread pool, size: " << numThreads << ".\n";
         threadPool = new ThreadPool(numThreads);
+        // Outside of simulation, there are no CPU IDs to get right, so the
+        // threads can start now and help build the network.
+        if (!runningInSimulation)
+            threadPool->initThreadPool();
     }
 
     Workspace* workspace = new Workspace();
     Network* network =
             buildNetwork(modelTopo, modelParams, sampling, workspace);
     ReferenceBackend::initGlobals();
-    SmvBackend::initGlobals();
+    SmvBackend::initGlobals(spadSize, numSpads);
 
     if (dumpGraph)
         network->dumpDataflowGraph();
@@ -159,12 +420,101 @@ int main(int argc, char* argv[]) {
     if (!network->validate())
         return -1;
 
-    Scheduler scheduler(network, workspace);
-    Tensor* output = scheduler.runNetwork();
+    std::unique_ptr<InputPipeline> inputPipeline;
+    if (!inputDataset.empty()) {
+        if (!network->getOperators().count(inputDataOp) ||
+            network->getOperator(inputDataOp)->getOpType() != OpType::Data) {
+            std::cout << "The network has no Data operator named "
+                      << inputDataOp << "!\n";
+            exit(1);
+        }
+        inputPipeline.reset(new InputPipeline(
+                inputDataset, network->getOperator(inputDataOp)->getOutput(0),
+                UnknownDataType, sampleLayout));
+        if (!inputPipeline->isValid())
+            exit(1);
+        std::cout << "Input dataset: " << inputDataset << ", "
+                  << inputPipeline->getNumSamples() << " samples"
+                  << (inputPipeline->isZeroCopy() ? ", bound without copying"
+                                                  : "")
+                  << ".\n";
+    }
+
+    int resumeAt = 0;
+    std::vector<std::string> skippedOps;
+    if (!resumeFrom.empty()) {
+        resumeAt = loadCheckpoint(resumeFrom, workspace, &skippedOps);
+        if (resumeAt < 0)
+            exit(1);
+        std::cout << "Resuming from the checkpoint at operator " << resumeAt
+                  << ": " << resumeFrom << "\n";
+    }
+    if (stopAt != -1 && stopAt < resumeAt) {
+        std::cout << "Cannot stop before the checkpoint!\n";
+        exit(1);
+    }
+
+    std::unique_ptr<Scheduler> scheduler;
+    if (pipelineStages > 1 || pipelineBatches > 1) {
+        scheduler.reset(new PipelinedScheduler(
+                network, workspace, pipelineStages, pipelineBatches));
+    } else {
+        scheduler.reset(new Scheduler(network, workspace));
+    }
+    if (!scheduleOrderFile.empty()) {
+        std::ifstream orderFile(scheduleOrderFile);
+        if (!orderFile) {
+            std::cout << "Cannot open the schedule order file: "
+                      << scheduleOrderFile << "\n";
+            exit(1);
+        }
+        std::vector<Operator*> order;
+        std::string opName;
+        while (std::getline(orderFile, opName)) {
+            if (opName.empty())
+                continue;
+            if (!network->getOperators().count(opName)) {
+                std::cout << "The schedule order has an unknown operator: "
+                          << opName << "\n";
+                exit(1);
+            }
+            order.push_back(network->getOperator(opName));
+        }
+        std::cout << "Schedule order: " << scheduleOrderFile << "\n";
+        scheduler->setScheduleOrder(order);
+    }
+    scheduler->setOutputWriter(outputWriter.get());
+    scheduler->setOperatorRange(resumeAt, stopAt, skippedOps);
+    scheduler->setCheckpoints(checkpointBoundaries, checkpointPrefix);
+    Tensor* output = nullptr;
+    if (inputPipeline) {
+        auto start = std::chrono::steady_clock::now();
+        while (inputPipeline->next()) {
+            if (outputWriter) {
+                int sample = inputPipeline->getCurrentSample();
+                outputWriter->setFileSuffix("_" + std::to_string(sample));
+            }
+            output = scheduler->runNetwork();
+        }
+        std::chrono::duration<double> seconds =
+                std::chrono::steady_clock::now() - start;
+        std::cout << "Ran " << inputPipeline->getNumSamples()
+                  << " samples in " << seconds.count() << " s.\n";
+    } else {
+        output = scheduler->runNetwork();
+        // The checkpoint doesn't match the schedule.
+        if (!output && !skippedOps.empty())
+            exit(1);
+    }
 
     if (!lastOutputFile.empty()) {
         if (lastOutputFile == "stdout") {
             std::cout << "Final network output:\n" << *output << "\n";
+        } else if (lastOutputFile == "npy" || lastOutputFile == "raw") {
+            OutputWriter writer(dumpDir, lastOutputFile == "npy"
+                                                 ? OutputWriter::Npy
+                                                 : OutputWriter::Raw);
+            writer.write(output);
         } else if (lastOutputFile == "proto") {
             // Serialize the output tensor into a proto buffer.
             std::fstream outfile("output.pb", std::ios::out | std::ios::trunc |
@@ -183,6 +533,9 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // Finish writing the tensors before they are freed.
+    outputWriter.reset();
+
     if (threadPool)
         delete threadPool;
 
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+#include "core/backend.h"
+#include "core/globals.h"
+#include "core/network_builder.h"
+#include "core/static_graph_analyzer.h"
+#include "utility/debug_stream.h"
+
+namespace po = boost::program_options;
+
+using namespace smaug;
+
+/** One scratchpad configuration of the sweep. */
+struct SweepPoint {
+    int numSpads;
+    int spadSize;
+    int numAccels;
+};
+
+/**
+ * The analysis results of one SweepPoint. This is sent from the process that
+ * analyzes the point back to the driver, so it has to stay trivially
+ * copyable.
+ */
+struct SweepResult {
+    SweepPoint point;
+    bool valid = false;
+    uint64_t sramBytes = 0;
+    uint32_t tileSteps = 0;
+    DmaTraffic baseline;
+    DmaTraffic pinned;
+    uint64_t baselineCycles = 0;
+    uint64_t pinnedCycles = 0;
+    bool pareto = false;
+};
+
+/**
+ * Tiles the network for the given scratchpad geometry, pins tiles and
+ * estimates the DMA traffic with and without the pins. This runs in its own
+ * process, as the scratchpad geometry is global state.
+ */
+SweepResult analyzePoint(const SweepPoint& point,
+                         const std::string& modelTopo,
+                         const std::string& modelParams,
+                         const DmaModel& dmaModel) {
+    runningInSimulation = false;
+    numAcceleratorsAvailable = point.numAccels;
+    ReferenceBackend::initGlobals();
+    SmvBackend::initGlobals(point.spadSize, point.numSpads);
+
+    SamplingInfo sampling;
+    sampling.level = NoSampling;
+    sampling.num_sample_iterations = 1;
+    Workspace* workspace = new Workspace();
+    Network* network =
+            buildNetwork(modelTopo, modelParams, sampling, workspace);
+    GraphAnalyzer analyzer(network, workspace);
+    analyzer.set_dma_model(dmaModel);
+    analyzer.dry_run_network();
+    analyzer.populate_tile_pin_map();
+    DmaReport baseline = analyzer.estimate_dma_traffic(
+            analyzer.get_baseline_spm_mapping(), "baseline");
+    DmaReport pinned = analyzer.estimate_dma_traffic(
+            analyzer.get_tile_pin_spm_mapping(), "tile_pin");
+
+    SweepResult result;
+    result.point = point;
+    result.valid = true;
+    result.sramBytes =
+            (uint64_t)point.numSpads * point.spadSize * point.numAccels;
+    result.tileSteps = baseline.per_step.size();
+    result.baseline = baseline.total;
+    result.pinned = pinned.total;
+    result.baselineCycles =
+            analyzer.get_parallel_dma_cycles(baseline, point.numAccels);
+    result.pinnedCycles =
+            analyzer.get_parallel_dma_cycles(pinned, point.numAccels);
+    return result;
+}
+
+/**
+ * Analyzes every point in a child process, running up to numJobs of them at
+ * a time. Points whose analysis fails (e.g. a spad too small to tile some
+ * operator) come back invalid.
+ */
+std::vector<SweepResult> runSweep(const std::vector<SweepPoint>& points,
+                                  const std::string& modelTopo,
+                                  const std::string& modelParams,
+                                  const DmaModel& dmaModel,
+                                  int numJobs) {
+    std::vector<SweepResult> results(points.size());
+    struct Job {
+        int index;
+        int readFd;
+    };
+    std::map<pid_t, Job> running;
+    auto waitForJob = [&]() {
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        Job job = running.at(pid);
+        running.erase(pid);
+        SweepResult result;
+        bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                  read(job.readFd, &result, sizeof(result)) == sizeof(result);
+        close(job.readFd);
+        if (ok) {
+            results[job.index] = result;
+        } else {
+            results[job.index].point = points[job.index];
+            std::cerr << "Analysis failed for " << points[job.index].numSpads
+                      << " x " << points[job.index].spadSize << " bytes, "
+                      << points[job.index].numAccels << " accelerator(s).\n";
+        }
+    };
+
+    for (int i = 0; i < points.size(); i++) {
+        if (running.size() == numJobs)
+            waitForJob();
+        int fds[2];
+        if (pipe(fds) != 0) {
+            std::cerr << "Failed to create a pipe!\n";
+            exit(1);
+        }
+        // Don't let the child inherit buffered output.
+        std::cout.flush();
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "Failed to fork!\n";
+            exit(1);
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            // The analyzer is chatty, only keep the errors.
+            if (!freopen("/dev/null", "w", stdout))
+                _exit(1);
+            SweepResult result =
+                    analyzePoint(points[i], modelTopo, modelParams, dmaModel);
+            bool ok = write(fds[1], &result, sizeof(result)) == sizeof(result);
+            _exit(ok ? 0 : 1);
+        }
+        close(fds[1]);
+        running[pid] = { i, fds[0] };
+        std::cout << "Analyzing " << points[i].numSpads << " x "
+                  << points[i].spadSize << " bytes, " << points[i].numAccels
+                  << " accelerator(s).\n";
+    }
+    while (!running.empty())
+        waitForJob();
+    return results;
+}
+
+/**
+ * Marks the results that no other result beats on both the total SRAM size
+ * and the DMA cycles with pinning.
+ */
+void markParetoFront(std::vector<SweepResult>& results) {
+    for (auto& result : results) {
+        if (!result.valid)
+            continue;
+        result.pareto = std::none_of(
+                results.begin(), results.end(), [&](const SweepResult& other) {
+                    return other.valid &&
+                           other.sramBytes <= result.sramBytes &&
+                           other.pinnedCycles <= result.pinnedCycles &&
+                           (other.sramBytes < result.sramBytes ||
+                            other.pinnedCycles < result.pinnedCycles);
+                });
+    }
+}
+
+void writeReport(const std::vector<SweepResult>& results,
+                 const std::string& fileName) {
+    std::ofstream csvFile(fileName);
+    csvFile << "num_spads,spad_size,num_accels,sram_bytes,tile_steps,"
+               "baseline_load_bytes,baseline_store_bytes,baseline_dma_cycles,"
+               "pinned_load_bytes,pinned_store_bytes,pinned_dma_cycles,"
+               "pareto\n";
+    for (const auto& result : results) {
+        if (!result.valid)
+            continue;
+        csvFile << result.point.numSpads << "," << result.point.spadSize << ","
+                << result.point.numAccels << "," << result.sramBytes << ","
+                << result.tileSteps << "," << result.baseline.load_bytes << ","
+                << result.baseline.store_bytes << ","
+                << result.baselineCycles << "," << result.pinned.load_bytes
+                << "," << result.pinned.store_bytes << ","
+                << result.pinnedCycles << "," << result.pareto << "\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string modelTopo;
+    std::string modelParams;
+    std::vector<int> spadCounts = { smv::kDefaultNumSpads };
+    std::vector<int> spadSizes = { smv::kDefaultSpadSize };
+    std::vector<int> accelCounts = { 1 };
+    int numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+    std::string outputFile = "spm_sweep.csv";
+    DmaModel dmaModel;
+    po::options_description options(
+            "SPM sweep Usage:  ./spm-sweep model_topo.pbtxt model_params.pb "
+            "[options]");
+    // clang-format off
+    options.add_options()
+        ("help", "Display this help message")
+        ("num-spads",
+         po::value(&spadCounts)->multitoken(),
+         "The numbers of SMV scratchpads to sweep, each at least 3.")
+        ("spad-sizes",
+         po::value(&spadSizes)->multitoken(),
+         "The scratchpad sizes in bytes to sweep.")
+        ("num-accels",
+         po::value(&accelCounts)->multitoken(),
+         "The numbers of accelerators to sweep. Every accelerator has its own "
+         "scratchpads and DMA engine.")
+        ("jobs",
+         po::value(&numJobs),
+         "The number of configurations analyzed in parallel. Defaults to the "
+         "number of cores.")
+        ("output",
+         po::value(&outputFile),
+         "The CSV report to write.")
+        ("dma-bytes-per-cycle",
+         po::value(&dmaModel.bytes_per_cycle),
+         "The DMA bandwidth of the cost model.")
+        ("dma-latency",
+         po::value(&dmaModel.latency_cycles),
+         "The setup latency in cycles of every DMA transfer.");
+    // clang-format on
+
+    po::options_description hidden;
+    hidden.add_options()("model-topo-file", po::value(&modelTopo),
+                         "Model topology protobuf file");
+    hidden.add_options()("model-params-file", po::value(&modelParams),
+                         "Model parameters protobuf file");
+    po::options_description all, visible;
+    all.add(options).add(hidden);
+    visible.add(options);
+
+    po::positional_options_description p;
+    p.add("model-topo-file", 1);
+    p.add("model-params-file", 1);
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv)
+                          .options(all)
+                          .positional(p)
+                          .run(),
+                  vm);
+        po::notify(vm);
+    } catch (po::error& e) {
+        std::cout << "ERROR: " << e.what() << "\n";
+        exit(1);
+    }
+
+    if (vm.count("help")) {
+        std::cout << visible << "\n";
+        return 1;
+    }
+    if (modelTopo.empty() || modelParams.empty()) {
+        std::cout << "The model protobuf files must be specified!\n";
+        exit(1);
+    }
+    if (numJobs < 1) {
+        std::cout << "At least one job must run!\n";
+        exit(1);
+    }
+
+    std::vector<SweepPoint> points;
+    for (int numSpads : spadCounts) {
+        for (int spadSize : spadSizes) {
+            for (int numAccels : accelCounts) {
+                if (numSpads < 3 || spadSize <= 0 || numAccels < 1 ||
+                    numAccels > maxNumAccelerators) {
+                    std::cout << "Skipping the invalid configuration "
+                              << numSpads << " x " << spadSize << " bytes, "
+                              << numAccels << " accelerator(s).\n";
+                    continue;
+                }
+                points.push_back({ numSpads, spadSize, numAccels });
+            }
+        }
+    }
+    std::cout << "Sweeping " << points.size() << " configurations with "
+              << numJobs << " jobs.\n";
+
+    std::vector<SweepResult> results =
+            runSweep(points, modelTopo, modelParams, dmaModel, numJobs);
+    markParetoFront(results);
+    std::sort(results.begin(), results.end(),
+              [](const SweepResult& a, const SweepResult& b) {
+                  return std::tie(a.sramBytes, a.pinnedCycles) <
+                         std::tie(b.sramBytes, b.pinnedCycles);
+              });
+    writeReport(results, outputFile);
+
+    std::cout << "Pareto front (SRAM bytes, DMA cycles):\n";
+    for (const auto& result : results) {
+        if (!result.pareto)
+            continue;
+        std::cout << "  " << result.point.numSpads << " x "
+                  << result.point.spadSize << " bytes, "
+                  << result.point.numAccels
+                  << " accelerator(s): " << result.sramBytes << ", "
+                  << result.pinnedCycles << "\n";
+    }
+    std::cout << "Report written to " << outputFile << ".\n";
+    return 0;
+}
@@ -0,0 +1,434 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+#include "core/backend.h"
+#include "core/globals.h"
+#include "core/tensor.h"
+#include "core/tensor_utils.h"
+#include "core/workspace.h"
+#include "operators/smv/smv_batch_norm_op.h"
+#include "operators/smv/smv_batch_norm_tiling.h"
+#include "operators/smv/smv_convolution_op.h"
+#include "operators/smv/smv_convolution_tiling.h"
+#include "operators/smv/smv_inner_product_op.h"
+#include "operators/smv/smv_inner_product_tiling.h"
+#include "operators/smv/smv_pooling_op.h"
+#include "operators/smv/smv_pooling_tiling.h"
+#include "operators/smv/smv_tiling_common.h"
+
+namespace po = boost::program_options;
+
+using namespace smaug;
+
+/** A layer to tile. 4D inputs are NHWC and 2D ones NC. */
+struct LayerShape {
+    std::string model;
+    std::string name;
+    /** conv, fc, max-pool or batch-norm. */
+    std::string op;
+    std::vector<int> inputDims;
+    /** The rows and columns of the conv kernels or pooling window. */
+    int kernelSize = 0;
+    int stride = 1;
+    /** The output channels of a conv or outputs of an FC. */
+    int numOutputs = 0;
+
+    std::string id() const { return model + "/" + name; }
+};
+
+/**
+ * The distinct layer shapes of the model zoo networks. Layers that only
+ * repeat a shape are left out, as they tile the same way.
+ */
+// clang-format off
+const std::vector<LayerShape> kLayerCorpus = {
+    { "minerva", "fc0", "fc", { 1, 784 }, 0, 1, 256 },
+    { "minerva", "fc1", "fc", { 1, 256 }, 0, 1, 256 },
+    { "minerva", "fc2", "fc", { 1, 256 }, 0, 1, 10 },
+    { "lstm", "gates", "fc", { 1, 256 }, 0, 1, 512 },
+    { "lenet5", "conv0", "conv", { 1, 28, 28, 1 }, 3, 1, 32 },
+    { "lenet5", "conv1", "conv", { 1, 28, 28, 32 }, 3, 1, 32 },
+    { "lenet5", "pool", "max-pool", { 1, 28, 28, 32 }, 2, 2, 0 },
+    { "lenet5", "fc0", "fc", { 1, 6272 }, 0, 1, 128 },
+    { "lenet5", "fc1", "fc", { 1, 128 }, 0, 1, 10 },
+    { "vgg", "conv0", "conv", { 1, 32, 32, 3 }, 3, 1, 64 },
+    { "vgg", "conv1", "conv", { 1, 32, 32, 64 }, 3, 1, 64 },
+    { "vgg", "bn0", "batch-norm", { 1, 32, 32, 64 }, 0, 1, 0 },
+    { "vgg", "pool0", "max-pool", { 1, 32, 32, 64 }, 2, 2, 0 },
+    { "vgg", "conv2", "conv", { 1, 16, 16, 64 }, 3, 1, 128 },
+    { "vgg", "conv3", "conv", { 1, 16, 16, 128 }, 3, 1, 128 },
+    { "vgg", "pool1", "max-pool", { 1, 16, 16, 128 }, 2, 2, 0 },
+    { "vgg", "conv4", "conv", { 1, 8, 8, 128 }, 3, 1, 256 },
+    { "vgg", "conv5", "conv", { 1, 8, 8, 256 }, 3, 1, 256 },
+    { "vgg", "pool2", "max-pool", { 1, 8, 8, 256 }, 2, 2, 0 },
+    { "vgg", "conv6", "conv", { 1, 4, 4, 256 }, 3, 1, 512 },
+    { "vgg", "conv7", "conv", { 1, 4, 4, 512 }, 3, 1, 512 },
+    { "vgg", "fc0", "fc", { 1, 2048 }, 0, 1, 512 },
+    { "vgg", "bn1", "batch-norm", { 1, 512 }, 0, 1, 0 },
+    { "vgg", "fc1", "fc", { 1, 512 }, 0, 1, 10 },
+    { "resnet", "conv0", "conv", { 1, 224, 224, 3 }, 7, 2, 64 },
+    { "resnet", "bn0", "batch-norm", { 1, 112, 112, 64 }, 0, 1, 0 },
+    { "resnet", "pool0", "max-pool", { 1, 112, 112, 64 }, 3, 2, 0 },
+    { "resnet", "res2_1x1a", "conv", { 1, 56, 56, 64 }, 1, 1, 64 },
+    { "resnet", "res2_3x3", "conv", { 1, 56, 56, 64 }, 3, 1, 64 },
+    { "resnet", "res2_1x1b", "conv", { 1, 56, 56, 64 }, 1, 1, 256 },
+    { "resnet", "res2_1x1c", "conv", { 1, 56, 56, 256 }, 1, 1, 64 },
+    { "resnet", "res2_bn", "batch-norm", { 1, 56, 56, 256 }, 0, 1, 0 },
+    { "resnet", "res3_3x3", "conv", { 1, 28, 28, 128 }, 3, 1, 128 },
+    { "resnet", "res3_1x1", "conv", { 1, 28, 28, 128 }, 1, 1, 512 },
+    { "resnet", "res4_3x3", "conv", { 1, 14, 14, 256 }, 3, 1, 256 },
+    { "resnet", "res4_1x1", "conv", { 1, 14, 14, 256 }, 1, 1, 1024 },
+    { "resnet", "res5_3x3", "conv", { 1, 7, 7, 512 }, 3, 1, 512 },
+    { "resnet", "res5_1x1", "conv", { 1, 7, 7, 512 }, 1, 1, 2048 },
+    { "resnet", "fc", "fc", { 1, 2048 }, 0, 1, 1000 },
+};
+// clang-format on
+
+/** The tiling of one layer at one scratchpad size. */
+struct LayerResult {
+    bool ok = false;
+    uint64_t tileShapes = 0;
+    uint64_t configs = 0;
+    /** The mean time of the search for the best TilingConfig. */
+    double searchTime = 0;
+    /** The time of the whole tile(), including copying data into tiles. */
+    double tileTime = 0;
+    int numTiles = 0;
+    std::string config;
+};
+
+std::string dimsToStr(const std::vector<int>& dims) {
+    std::string str = "[";
+    for (int i = 0; i < dims.size(); i++)
+        str += (i ? ", " : "") + std::to_string(dims[i]);
+    return str + "]";
+}
+
+double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+    std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+std::string configToStr(const smv::TilingConfig& config) {
+    std::ostringstream os;
+    os << config << "; dims: " << config.inputTilingDims;
+    if (config.weights.ndims() != 0)
+        os << ", " << config.weightTilingDims;
+    os << ", " << config.outputTilingDims;
+    return os.str();
+}
+
+/** Creates the SMV operator of the layer and all of its tensors. */
+Operator* createLayer(const LayerShape& layer, Workspace* workspace) {
+    DataLayout layout = layer.inputDims.size() == 4 ? NHWC : NC;
+    TensorShape shape(layer.inputDims, layout, SmvBackend::Alignment);
+    Tensor* input = new Tensor("input", shape);
+    workspace->addTensor(input);
+    Operator* op = nullptr;
+    if (layer.op == "conv") {
+        auto convOp = SmvBackend::createConvolutionOp(layer.name, workspace);
+        convOp->setWeightDims(
+                layer.kernelSize, layer.kernelSize, layer.numOutputs);
+        convOp->setStride(layer.stride, layer.stride);
+        convOp->setPadding(SamePadding);
+        op = convOp;
+    } else if (layer.op == "fc") {
+        auto fcOp = SmvBackend::createInnerProductOp(layer.name, workspace);
+        fcOp->setNumOutputs(layer.numOutputs);
+        op = fcOp;
+    } else if (layer.op == "max-pool") {
+        auto poolOp = SmvBackend::createMaxPoolingOp(layer.name, workspace);
+        poolOp->setPoolingSize(layer.kernelSize, layer.kernelSize);
+        poolOp->setPoolingStride(layer.stride, layer.stride);
+        op = poolOp;
+    } else if (layer.op == "batch-norm") {
+        op = SmvBackend::createBatchNormOp(layer.name, workspace);
+    } else {
+        return nullptr;
+    }
+    op->setInput(input, 0);
+    op->createAllTensors();
+    // Tiling copies the data into the tiles, so every tensor needs storage.
+    for (auto input : op->getInputs())
+        static_cast<Tensor*>(input)->allocateStorage<float16>();
+    for (auto output : op->getOutputs())
+        static_cast<Tensor*>(output)->allocateStorage<float16>();
+    return op;
+}
+
+/** Runs the tiling optimizer of the operator once. */
+smv::TilingConfig searchTileShapes(Operator* op, Tensor* bnWeights) {
+    if (auto convOp = dynamic_cast<SmvConvolutionOp*>(op))
+        return smv::conv::TilingOptimizer::computeBasicTileShapes(convOp);
+    if (auto fcOp = dynamic_cast<SmvInnerProductOp*>(op))
+        return smv::fc::TilingOptimizer::computeBasicTileShapes(fcOp);
+    if (auto poolOp = dynamic_cast<SmvPoolingOp*>(op))
+        return smv::pool::TilingOptimizer::computeBasicTileShapes(poolOp);
+    auto bnOp = static_cast<SmvBatchNormOp*>(op);
+    return smv::bn::TilingOptimizer::computeBasicTileShapes(
+            bnOp->getInput(SmvBatchNormOp::Inputs), bnWeights,
+            bnOp->getOutput(SmvBatchNormOp::Outputs));
+}
+
+/**
+ * Tiles the layer and writes the results to the given file as lines of
+ * "name value", the tiling config last.
+ */
+void benchmarkLayer(const LayerShape& layer, int iterations, FILE* results) {
+    Workspace* workspace = new Workspace();
+    Operator* op = createLayer(layer, workspace);
+    if (!op || !op->validate()) {
+        std::cerr << "Invalid layer: " << layer.id() << "\n";
+        _exit(1);
+    }
+    // The batch norm optimizer takes its four weights as one tensor, as in
+    // its doTiling().
+    Tensor* bnWeights = nullptr;
+    if (layer.op == "batch-norm") {
+        bnWeights = concatTensors({ op->getInput(SmvBatchNormOp::Mean),
+                                    op->getInput(SmvBatchNormOp::Variance),
+                                    op->getInput(SmvBatchNormOp::Gamma),
+                                    op->getInput(SmvBatchNormOp::Beta) },
+                                  0, workspace);
+    }
+    smv::TilingConfig config;
+    double searchTime = 0;
+    for (int i = 0; i < iterations; i++) {
+        smv::tilingSearchStats = smv::TilingSearchStats();
+        auto start = std::chrono::steady_clock::now();
+        config = searchTileShapes(op, bnWeights);
+        searchTime += elapsedSeconds(start);
+    }
+    // tile() runs the search again.
+    smv::TilingSearchStats stats = smv::tilingSearchStats;
+    auto start = std::chrono::steady_clock::now();
+    op->tile();
+    double tileTime = elapsedSeconds(start);
+    int numTiles = 0;
+    for (TiledTensor* tiledTensor : op->getTiledTensors())
+        numTiles += tiledTensor->size();
+
+    fprintf(results, "tile_shapes %lu\n",
+            (unsigned long)stats.tileShapes);
+    fprintf(results, "configs %lu\n",
+            (unsigned long)stats.configs);
+    fprintf(results, "search_s %.9g\n", searchTime / iterations);
+    fprintf(results, "tile_s %.9g\n", tileTime);
+    fprintf(results, "num_tiles %d\n", numTiles);
+    fprintf(results, "config %s\n", configToStr(config).c_str());
+}
+
+/**
+ * Tiles the layer in a child process, so that a layer the optimizers cannot
+ * tile, which exits the program, is only reported as such.
+ */
+LayerResult runLayer(const LayerShape& layer, int iterations) {
+    LayerResult result;
+    int fds[2];
+    if (pipe(fds) != 0) {
+        std::cerr << "Failed to create a pipe!\n";
+        exit(1);
+    }
+    // Don't let the child inherit buffered output.
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Failed to fork!\n";
+        exit(1);
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        if (!freopen("/dev/null", "w", stdout))
+            _exit(1);
+        FILE* results = fdopen(fds[1], "w");
+        benchmarkLayer(layer, iterations, results);
+        _exit(fclose(results) == 0 ? 0 : 1);
+    }
+    close(fds[1]);
+    std::string output;
+    char buffer[4096];
+    ssize_t bytes;
+    while ((bytes = read(fds[0], buffer, sizeof(buffer))) > 0)
+        output.append(buffer, bytes);
+    close(fds[0]);
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return result;
+    std::istringstream lines(output);
+    std::string name;
+    while (lines >> name) {
+        if (name == "config") {
+            lines >> std::ws;
+            std::getline(lines, result.config);
+        } else if (name == "tile_shapes") {
+            lines >> result.tileShapes;
+        } else if (name == "configs") {
+            lines >> result.configs;
+        } else if (name == "search_s") {
+            lines >> result.searchTime;
+        } else if (name == "tile_s") {
+            lines >> result.tileTime;
+        } else if (name == "num_tiles") {
+            lines >> result.numTiles;
+        }
+    }
+    result.ok = true;
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> spadSizes = { smv::kDefaultSpadSize };
+    std::vector<std::string> filters;
+    int iterations = 10;
+    int numSlowest = 5;
+    std::string outputFile;
+    po::options_description options(
+            "Tiling optimizer benchmark Usage:  ./smaug-tiling-bench "
+            "[options]");
+    // clang-format off
+    options.add_options()
+        ("help", "Display this help message")
+        ("spad-sizes",
+         po::value(&spadSizes)->multitoken(),
+         "The sizes of the SMV scratchpads in bytes to tile the layers for.")
+        ("layers",
+         po::value(&filters)->multitoken(),
+         "Only tile the layers whose model/name contains one of these, e.g. "
+         "resnet or vgg/conv.")
+        ("iterations",
+         po::value(&iterations),
+         "The number of times the tiling search is run per layer.")
+        ("slowest",
+         po::value(&numSlowest),
+         "The number of slowest layers to list at the end.")
+        ("list", "List the layer corpus and exit.")
+        ("output",
+         po::value(&outputFile),
+         "A CSV file to write the results to.");
+    // clang-format on
+
+    po::variables_map vm;
+    try {
+        po::store(po::parse_command_line(argc, argv, options), vm);
+        po::notify(vm);
+    } catch (po::error& e) {
+        std::cout << "ERROR: " << e.what() << "\n";
+        exit(1);
+    }
+
+    if (vm.count("help")) {
+        std::cout << options << "\n";
+        return 1;
+    }
+    if (iterations < 1) {
+        std::cout << "At least one iteration must run!\n";
+        exit(1);
+    }
+    for (int spadSize : spadSizes) {
+        if (spadSize <= 0) {
+            std::cout << "Invalid scratchpad size: " << spadSize << "\n";
+            exit(1);
+        }
+    }
+    std::vector<LayerShape> layers;
+    for (const LayerShape& layer : kLayerCorpus) {
+        bool selected = filters.empty();
+        for (const std::string& filter : filters)
+            selected |= layer.id().find(filter) != std::string::npos;
+        if (selected)
+            layers.push_back(layer);
+    }
+    if (vm.count("list")) {
+        for (const LayerShape& layer : layers) {
+            std::cout << layer.id() << ": " << layer.op << ", input "
+                      << dimsToStr(layer.inputDims) << "\n";
+        }
+        return 0;
+    }
+    if (layers.empty()) {
+        std::cout << "No layer matches the given names!\n";
+        exit(1);
+    }
+
+    std::ofstream csvFile;
+    if (!outputFile.empty()) {
+        csvFile.open(outputFile);
+        csvFile << "spad_size,layer,op,input_dims,tile_shapes,configs,"
+                   "search_s,tile_s,num_tiles,config\n";
+    }
+    runningInSimulation = false;
+    std::vector<std::tuple<double, int, const LayerShape*>> slowest;
+    int numFailed = 0;
+    for (int spadSize : spadSizes) {
+        // The optimizers only read the scratchpad size, which the children
+        // inherit.
+        SmvBackend::initGlobals(spadSize);
+        std::cout << "Scratchpad size " << spadSize << " bytes:\n";
+        for (const LayerShape& layer : layers) {
+            LayerResult result = runLayer(layer, iterations);
+            std::cout << "  " << std::left << std::setw(20) << layer.id()
+                      << std::right;
+            if (!result.ok) {
+                std::cout << "cannot be tiled\n";
+                numFailed++;
+            } else {
+                std::cout << std::fixed << std::setprecision(3)
+                          << result.searchTime * 1e3 << " ms search, "
+                          << result.tileTime * 1e3 << " ms tile, "
+                          << result.tileShapes << " tile shapes, "
+                          << result.configs << " configs, "
+                          << result.numTiles << " tiles\n"
+                          << "    " << result.config << "\n";
+                std::cout.unsetf(std::ios::fixed);
+                slowest.emplace_back(result.searchTime, spadSize, &layer);
+            }
+            if (csvFile.is_open()) {
+                csvFile << spadSize << "," << layer.id() << "," << layer.op
+                        << ",\"" << dimsToStr(layer.inputDims) << "\",";
+                if (result.ok) {
+                    csvFile << result.tileShapes << "," << result.configs
+                            << "," << result.searchTime << ","
+                            << result.tileTime << "," << result.numTiles
+                            << ",\"" << result.config << "\"\n";
+                } else {
+                    csvFile << ",,,,,\n";
+                }
+            }
+        }
+        SmvBackend::freeGlobals();
+    }
+
+    std::sort(slowest.begin(), slowest.end(),
+              [](const auto& a, const auto& b) {
+                  return std::get<0>(a) > std::get<0>(b);
+              });
+    if (numSlowest > 0 && !slowest.empty()) {
+        std::cout << "Slowest tiling searches:\n";
+        for (int i = 0; i < std::min<int>(numSlowest, slowest.size()); i++) {
+            std::cout << "  " << std::get<2>(slowest[i])->id() << " at "
+                      << std::get<1>(slowest[i]) << " bytes: " << std::fixed
+                      << std::setprecision(3)
+                      << std::get<0>(slowest[i]) * 1e3 << " ms\n";
+            std::cout.unsetf(std::ios::fixed);
+        }
+    }
+    if (csvFile.is_open())
+        std::cout << "Results written to " << outputFile << ".\n";
+    if (numFailed > 0)
+        std::cout << numFailed << " layer(s) could not be tiled.\n";
+    return 0;
+}
@@ -5,7 +5,8 @@
 
 namespace smaug {
 
-ThreadPool::ThreadPool(int nthreads) : workers(nthreads) {}
+ThreadPool::ThreadPool(int nthreads)
+        : workers(nthreads), initialized(false) {}
 
 ThreadPool::~ThreadPool() {
     // Shutdown the thread pool and free all resources.
@@ -64,6 +65,8 @@ void* ThreadPool::workerLoop(void* args) {
 }
 
 void ThreadPool::initThreadPool() {
+    assert(!initialized && "The thread pool can only be initialized once!");
+    initialized = true;
     // Initialize the CPU ID for each worker thread.
     for (int i = 0; i < workers.size(); i++) {
         WorkerThread* worker = &workers[i];
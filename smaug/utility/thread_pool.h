@@ -47,6 +47,9 @@ class ThreadPool {
      */
     void initThreadPool();
 
+    /** Returns true once the thread pool has been initialized. */
+    bool isInitialized() const { return initialized; }
+
     /** Dispatch the function to a worker in the thread pool. */
     int dispatchThread(WorkerThreadFunc func, void* args);
 
@@ -118,6 +121,9 @@ class ThreadPool {
 
     /** Worker threads. */
     std::vector<WorkerThread> workers;
+
+    /** True if initThreadPool() has been called. */
+    bool initialized;
 };
 
 }  // namespace smaug
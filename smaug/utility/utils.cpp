@@ -1,4 +1,5 @@
 #include <cassert>
+#include <mutex>
 
 #include "smaug/core/datatypes.h"
 #include "smaug/operators/common.h"
@@ -83,6 +84,14 @@ void wakeCpu(int id) {}
 int getCpuId() { return 0; }
 #endif
 
+namespace {
+
+bool sectionTimingEnabled = false;
+std::mutex sectionTimesMutex;
+std::map<std::string, double> sectionTimes;
+
+}  // namespace
+
 ScopedStats::ScopedStats(const char* _startLabel,
                          const char* _endLabel,
                          bool _resetStats)
@@ -92,15 +101,32 @@ ScopedStats::ScopedStats(const char* _startLabel,
         dumpResetStats(startLabel, 0);
     else
         dumpStats(startLabel, 0);
+    if (sectionTimingEnabled)
+        startTime = std::chrono::steady_clock::now();
 }
 
 ScopedStats::~ScopedStats() {
+    if (sectionTimingEnabled) {
+        std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - startTime;
+        std::lock_guard<std::mutex> lock(sectionTimesMutex);
+        sectionTimes[startLabel] += elapsed.count();
+    }
     if (resetStats)
         dumpResetStats(endLabel, 0);
     else
         dumpStats(endLabel, 0);
 }
 
+void setSectionTimingEnabled(bool enabled) { sectionTimingEnabled = enabled; }
+
+std::map<std::string, double> takeSectionTimes() {
+    std::lock_guard<std::mutex> lock(sectionTimesMutex);
+    std::map<std::string, double> times;
+    times.swap(sectionTimes);
+    return times;
+}
+
 }  // namespace gem5
 
 }  // namespace smaug
@@ -2,6 +2,8 @@
 #define _UTILITY_UTILS_H_
 
 #include <array>
+#include <chrono>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -113,7 +115,8 @@ int getCpuId();
 
 /**
  * A RAII helper class which dumps and/or resets gem5 stats at construction and
- * destruction.
+ * destruction. If section timing is enabled, it also adds the host time spent
+ * in its scope to the section named by its start label.
  */
 class ScopedStats {
    public:
@@ -126,8 +129,21 @@ class ScopedStats {
     const char* startLabel;
     const char* endLabel;
     bool resetStats;
+    std::chrono::steady_clock::time_point startTime;
 };
 
+/**
+ * Enables or disables accumulating the host time of every ScopedStats
+ * section. This is meant for host-side benchmarking and is off by default.
+ */
+void setSectionTimingEnabled(bool enabled);
+
+/**
+ * Returns the accumulated time in seconds of every ScopedStats section, keyed
+ * by its start label, and resets them.
+ */
+std::map<std::string, double> takeSectionTimes();
+
 }  // namespace gem5
 
 namespace stats {